@@ -9,7 +9,14 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstring>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
 #include <dmlc/memory_io.h>
 #include <sys/stat.h>
 #include "./file.h"
@@ -24,21 +31,23 @@ using namespace raf::value;
 
 using PackedMetricMap = Map<String, Integer>;
 
-#define RAF_APPEND_BYTES(type, nbytes, value)                               \
-  {                                                                         \
-    constexpr int NUM_BYTES = nbytes;                                       \
-    union UNION {                                                           \
-      type v;                                                               \
-      struct {                                                              \
-        uint8_t bytes[NUM_BYTES];                                           \
-      };                                                                    \
-    } u;                                                                    \
-    u.v = value;                                                            \
-    static_assert(sizeof(UNION) == sizeof(uint8_t) * NUM_BYTES, "invalid"); \
-    static_assert(sizeof(UNION) == sizeof(type), "invalid");                \
-    for (int i = 0; i < NUM_BYTES; ++i) {                                   \
-      byte_vector.push_back(u.bytes[i]);                                    \
-    }                                                                       \
+/*! \brief The offset basis of the 64-bit FNV-1a hash. */
+constexpr uint64_t kFNV1aOffsetBasis = 14695981039346656037ULL;
+
+/*! \brief Continue the 64-bit FNV-1a hash of a byte sequence with more bytes. */
+inline uint64_t FNV1aHash(const void* data, size_t size, uint64_t hash = kFNV1aOffsetBasis) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+#define RAF_APPEND_BYTES(type, nbytes, value)                   \
+  {                                                             \
+    static_assert(sizeof(type) == nbytes, "invalid");           \
+    const type _v = value;                                      \
+    Append(&_v, nbytes);                                        \
   }
 
 #define RAF_DEF_PRIMITIVE(type_code, type, nbytes)                              \
@@ -49,6 +58,11 @@ using PackedMetricMap = Map<String, Integer>;
     return *this;                                                               \
   }
 
+/*!
+ * \brief The byte string key of caches. Typical keys fit in the inline buffer, so building a key
+ * does not touch the heap. The FNV-1a digest of the bytes is updated as they are appended, so
+ * cache lookups do not hash the key again.
+ */
 class HashKey {
  public:
   RAF_DEF_PRIMITIVE(0, bool, 1);
@@ -74,17 +88,15 @@ class HashKey {
   }
 
   inline HashKey& operator<<(const std::vector<int64_t>& v) {
-    byte_vector.push_back(13);
-    for (int i = 0, n = v.size(); i < n; ++i) {
-      RAF_APPEND_BYTES(int64_t, 8, v[i]);
-    }
+    AppendByte(13);
+    Append(v.data(), v.size() * sizeof(int64_t));
     RAF_APPEND_BYTES(int64_t, 8, 0);
     return *this;
   }
 
   inline HashKey& operator<<(const tvm::runtime::Optional<ir::Array<value::IntValue>> v) {
     CHECK(v.defined());
-    byte_vector.push_back(13);
+    AppendByte(13);
     tvm::runtime::Array<IntValue> value = v.value();
     for (int i = 0, n = value.size(); i < n; ++i) {
       RAF_APPEND_BYTES(int64_t, 8, value[i]->value);
@@ -94,11 +106,11 @@ class HashKey {
   }
 
   inline HashKey& operator<<(const ir::TensorType& v) {
-    byte_vector.push_back(14);
+    AppendByte(14);
     RAF_APPEND_BYTES(DLDataType, 4, v->dtype);
     for (int i = 0, n = v->shape.size(); i < n; ++i) {
       int64_t dim_i;
-      if (v->shape.as<ir::AnyNode>()) {
+      if (v->shape[i].as<ir::AnyNode>()) {
         dim_i = -1;
       } else {
         dim_i = ir::Downcast<ir::Integer>(v->shape[i]).IntValue();
@@ -111,11 +123,9 @@ class HashKey {
 
   inline HashKey& operator<<(const DLTensor& v) {
     // N.B.: stride and ctx are not taken into consideration
-    byte_vector.push_back(15);
+    AppendByte(15);
     RAF_APPEND_BYTES(DLDataType, 4, v.dtype);
-    for (int i = 0, n = v.ndim; i < n; ++i) {
-      RAF_APPEND_BYTES(int64_t, 8, v.shape[i]);
-    }
+    Append(v.shape, v.ndim * sizeof(int64_t));
     RAF_APPEND_BYTES(int64_t, 8, 0);
     return *this;
   }
@@ -126,56 +136,132 @@ class HashKey {
   }
 
   inline HashKey& operator<<(const std::string& v) {
-    byte_vector.push_back(16);
-    for (int i = 0, n = v.size(); i < n; ++i) {
-      RAF_APPEND_BYTES(int8_t, 1, v[i]);
-    }
+    AppendByte(16);
+    Append(v.data(), v.size());
     RAF_APPEND_BYTES(int64_t, 8, 0);
     return *this;
   }
 
   inline HashKey& operator<<(const HashKey& other) {
-    byte_vector.insert(byte_vector.end(), other.byte_vector.begin(), other.byte_vector.end());
+    Append(other.data(), other.size());
+    return *this;
+  }
+
+  HashKey() = default;
+
+  HashKey(const HashKey& other) {
+    Append(other.data(), other.size());
+  }
+
+  HashKey& operator=(const HashKey& other) {
+    if (this != &other) {
+      size_ = 0;
+      digest_ = kFNV1aOffsetBasis;
+      Append(other.data(), other.size());
+    }
     return *this;
   }
 
-  HashKey() {
-    byte_vector.reserve(1024);
+  /*! \brief The bytes of the key. */
+  const uint8_t* data() const {
+    return data_;
+  }
+
+  /*! \brief The number of bytes of the key. */
+  size_t size() const {
+    return size_;
+  }
+
+  /*! \brief The FNV-1a hash of the bytes, i.e., FNV1aHash(data(), size()). */
+  uint64_t digest() const {
+    return digest_;
+  }
+
+  /*! \brief Copy the bytes to a string. */
+  std::string str() const {
+    return std::string(reinterpret_cast<const char*>(data_), size_);
   }
 
-  std::vector<uint8_t> byte_vector;
+ private:
+  /*! \brief The size of the inline buffer, which holds the keys of most ops. */
+  static constexpr size_t kInlineSize = 256;
+
+  inline void AppendByte(uint8_t byte) {
+    Append(&byte, 1);
+  }
+
+  inline void Append(const void* bytes, size_t nbytes) {
+    if (size_ + nbytes > capacity_) {
+      Grow(size_ + nbytes);
+    }
+    std::memcpy(data_ + size_, bytes, nbytes);
+    digest_ = FNV1aHash(bytes, nbytes, digest_);
+    size_ += nbytes;
+  }
+
+  void Grow(size_t min_capacity) {
+    size_t capacity = std::max(capacity_ * 2, min_capacity);
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[capacity]);
+    std::memcpy(buffer.get(), data_, size_);
+    heap_buffer_ = std::move(buffer);
+    data_ = heap_buffer_.get();
+    capacity_ = capacity;
+  }
+
+  /*! \brief The inline buffer. */
+  uint8_t inline_buffer_[kInlineSize];
+  /*! \brief The heap buffer used once the key outgrows the inline buffer. */
+  std::unique_ptr<uint8_t[]> heap_buffer_;
+  /*! \brief The buffer in use, which is either the inline or the heap buffer. */
+  uint8_t* data_ = inline_buffer_;
+  /*! \brief The number of bytes of the key. */
+  size_t size_ = 0;
+  /*! \brief The capacity of the buffer in use. */
+  size_t capacity_ = kInlineSize;
+  /*! \brief The digest of the bytes appended so far. */
+  uint64_t digest_ = kFNV1aOffsetBasis;
 };
 
 #undef RAF_DEF_PRIMITIVE
 #undef RAF_APPEND_BYTES
 
+/*!
+ * \brief A thread-safe cache. The entries are spread over shards by the hash of their keys, and
+ * lookups only take the shared lock of a shard, so concurrent readers do not block each other.
+ * Keys are compared as byte spans after their digests, so looking up a HashKey neither copies nor
+ * rehashes its bytes.
+ */
 template <typename T>
 class MetaCache {
  public:
   ~MetaCache() = default;
 
+  bool Has(const HashKey& key) {
+    return Find(key.digest(), key.data(), key.size()) != nullptr;
+  }
+
   bool Has(const std::vector<uint8_t>& key) {
-    const std::string key_str(key.begin(), key.end());
-    return Has(key_str);
+    return Find(key.data(), key.size()) != nullptr;
   }
 
   bool Has(const std::string& key) {
-    std::lock_guard<std::mutex> lock(mu_);
-    return cached_.count(key);
+    return Find(key.data(), key.size()) != nullptr;
+  }
+
+  const T* Get(const HashKey& key) {
+    return Find(key.digest(), key.data(), key.size());
   }
 
   const T* Get(const std::vector<uint8_t>& key) {
-    const std::string key_str(key.begin(), key.end());
-    return Get(key_str);
+    return Find(key.data(), key.size());
   }
 
   const T* Get(const std::string& key) {
-    std::lock_guard<std::mutex> lock(mu_);
-    auto iter = cached_.find(key);
-    if (iter == cached_.end()) {
-      return nullptr;
-    }
-    return &iter->second;
+    return Find(key.data(), key.size());
+  }
+
+  void Set(const HashKey& key, T val) {
+    Set(key.str(), val);
   }
 
   void Set(const std::vector<uint8_t>& key, T val) {
@@ -184,20 +270,71 @@ class MetaCache {
   }
 
   void Set(const std::string& key, T val) {
-    std::lock_guard<std::mutex> lock(mu_);
-    auto iter = cached_.find(key);
-    if (iter != cached_.end()) {
+    bool inserted = false;
+    SetIfAbsent(key, val, &inserted);
+    if (!inserted) {
       LOG(FATAL) << "KeyError: The key is already cached!";
       throw;
     }
-    cached_.emplace(key, val);
+  }
+
+  /*!
+   * \brief Cache the value if the key is not cached yet. Unlike Set, it is not an error when the
+   * key has been cached, which happens when multiple threads miss the same key concurrently.
+   * \param key The key.
+   * \param val The value.
+   * \param inserted Whether the value is inserted.
+   * \return The cached value, which is the existing one if the key has been cached.
+   */
+  const T* SetIfAbsent(const std::string& key, T val, bool* inserted = nullptr) {
+    const size_t hash = FNV1aHash(key.data(), key.size());
+    Shard& shard = shards_[hash % kNumShards];
+    std::unique_lock<std::shared_timed_mutex> lock(shard.mu);
+    const T* cached = FindInShard(shard, hash, key.data(), key.size());
+    if (inserted != nullptr) {
+      *inserted = cached == nullptr;
+    }
+    if (cached != nullptr) {
+      return cached;
+    }
+    auto iter = shard.entries.emplace(hash, std::make_pair(key, std::move(val)));
+    return &iter->second.second;
   }
 
  private:
-  /*! \brief The cache mapping from string key to value. */
-  std::unordered_map<std::string, T> cached_;
-  /*! \brief The thread-safe lock. */
-  std::mutex mu_;
+  /*! \brief The number of shards, which bounds the number of writers running concurrently. */
+  static constexpr size_t kNumShards = 16;
+
+  struct Shard {
+    /*! \brief The cached keys and values, indexed by the hash of the keys. */
+    std::unordered_multimap<size_t, std::pair<std::string, T>> entries;
+    /*! \brief The lock of this shard. */
+    std::shared_timed_mutex mu;
+  };
+
+  static const T* FindInShard(const Shard& shard, size_t hash, const void* data, size_t size) {
+    auto range = shard.entries.equal_range(hash);
+    for (auto iter = range.first; iter != range.second; ++iter) {
+      const std::string& key = iter->second.first;
+      if (key.size() == size && std::memcmp(key.data(), data, size) == 0) {
+        return &iter->second.second;
+      }
+    }
+    return nullptr;
+  }
+
+  const T* Find(const void* data, size_t size) {
+    return Find(FNV1aHash(data, size), data, size);
+  }
+
+  const T* Find(size_t hash, const void* data, size_t size) {
+    Shard& shard = shards_[hash % kNumShards];
+    std::shared_lock<std::shared_timed_mutex> lock(shard.mu);
+    return FindInShard(shard, hash, data, size);
+  }
+
+  /*! \brief The shards of the cache. */
+  std::array<Shard, kNumShards> shards_;
 };
 
 class MetaCacheMetric {
@@ -205,6 +342,23 @@ class MetaCacheMetric {
   virtual std::unordered_map<std::string, size_t> GetMetric() = 0;
 };
 
+/*!
+ * \brief A MetaCache whose entries are also persisted to disk, so that they are reused by later
+ * processes. Persistence is enabled by RAF_PERSIST_CACHE=1.
+ *
+ * Each entry is a directory under $RAF_PERSIST_CACHE_PATH/<name> (default ~/.raf_cache/<name>)
+ * named after the hash of its key. Besides the files written by T::Save, an entry records its
+ * full key, its size in bytes and the time it was last used, which together form the index of
+ * the cache. The recorded key is compared on load so that hash collisions are never served, and
+ * a colliding key probes the next few slots.
+ *
+ * An entry is saved to a private staging directory and published with an atomic rename. The
+ * processes sharing a cache directory serialize publishing and eviction with an exclusive lock on
+ * its lock file, and hold a shared lock while loading, so no process observes a partial entry.
+ * When RAF_PERSIST_CACHE_MAX_BYTES is set, the least recently used entries are evicted after
+ * each publish until the cache fits in the budget. A hit in memory also marks the entry as used,
+ * at most once per RAF_PERSIST_CACHE_TOUCH_INTERVAL_MS milliseconds (1000 by default).
+ */
 template <typename T>
 class MetaPersistCache : public MetaCache<T>, public MetaCacheMetric {
  public:
@@ -233,107 +387,394 @@ class MetaPersistCache : public MetaCache<T>, public MetaCacheMetric {
 
     // Create the directory for this cache.
     CreateDir(path_);
+    lock_path_ = path_ + "/" + kLockFile;
+
+    const char* max_bytes = getenv("RAF_PERSIST_CACHE_MAX_BYTES");
+    if (max_bytes != nullptr) {
+      max_bytes_ = atoll(max_bytes);
+    }
+    const char* touch_interval = getenv("RAF_PERSIST_CACHE_TOUCH_INTERVAL_MS");
+    if (touch_interval != nullptr) {
+      touch_interval_ms_ = atoll(touch_interval);
+    }
+  }
+
+  const T* Get(const HashKey& key) {
+    AddMetric(kCacheGet);
+    // Cache hit. The key is neither rehashed nor copied.
+    if (auto val = MetaCache<T>::Get(key)) {
+      AddMetric(kCacheHit);
+      if (evict_enabled()) {
+        TouchOnHit(key.str());
+      }
+      return val;
+    }
+    AddMetric(kCacheMiss);
+    if (!persist_) {
+      return nullptr;
+    }
+    return LoadPersisted(key.str());
   }
 
   const T* Get(const std::vector<uint8_t>& key) {
+    AddMetric(kCacheGet);
+    // Cache hit. The byte key is only copied to a string on a miss.
+    if (auto val = MetaCache<T>::Get(key)) {
+      AddMetric(kCacheHit);
+      if (evict_enabled()) {
+        TouchOnHit(std::string(key.begin(), key.end()));
+      }
+      return val;
+    }
+    AddMetric(kCacheMiss);
+    if (!persist_) {
+      return nullptr;
+    }
     const std::string key_str(key.begin(), key.end());
-    return Get(key_str);
+    return LoadPersisted(key_str);
   }
 
   const T* Get(const std::string& key) {
-    AddMetric("CacheGet", 1);
+    AddMetric(kCacheGet);
 
     // Cache hit.
     if (auto val = MetaCache<T>::Get(key)) {
-      AddMetric("CacheHit", 1);
+      AddMetric(kCacheHit);
+      if (evict_enabled()) {
+        TouchOnHit(key);
+      }
       return val;
     }
-    AddMetric("CacheMiss", 1);
+    AddMetric(kCacheMiss);
     if (!persist_) {
       return nullptr;
     }
+    return LoadPersisted(key);
+  }
+
+  void Set(const HashKey& key, T val) {
+    Set(key.str(), val);
+  }
+
+  void Set(const std::vector<uint8_t>& key, T val) {
+    const std::string key_str(key.begin(), key.end());
+    Set(key_str, val);
+  }
+
+  void Set(const std::string& key, T val) {
+    AddMetric(kCacheSet);
+    // Another thread may have built and cached the same key concurrently. In this case the
+    // existing value is kept and it has been persisted by that thread.
+    bool inserted = false;
+    MetaCache<T>::SetIfAbsent(key, val, &inserted);
+    if (!persist_ || !inserted) {
+      return;
+    }
 
-    // Cache miss, try to load from the persistent cache.
     std::lock_guard<std::mutex> lock(mu_);
 
-    auto persist_path = GetPersistPath(key);
+    // Save the value to a private staging directory without holding the file lock, since saving
+    // may take a while (e.g., exporting a shared library).
+    auto staging_path = path_ + "/" + kStagingPrefix + std::to_string(getpid()) + "." +
+                        std::to_string(num_staged_++);
+    CreateDir(staging_path);
+    bool saved = false;
+    try {
+      saved = val.Save(staging_path);
+    } catch (dmlc::Error& e) {
+      LOG(WARNING) << "Failed to persist cache entry to " << path_ << ": " << e.what();
+    }
+    if (saved) {
+      TouchEntry(staging_path);
+      saved = WriteFile(staging_path + "/" + kKeyFile, key);
+    }
+    if (saved) {
+      // The recorded size includes the size file itself.
+      const int64_t size = DirSize(staging_path);
+      int64_t total_size = size + std::to_string(size).size();
+      total_size = size + std::to_string(total_size).size();
+      saved = WriteFile(staging_path + "/" + kSizeFile, std::to_string(total_size));
+    }
+    if (!saved) {
+      AddMetric(kPersistCacheSaveFailure);
+      RemoveDir(staging_path);
+      return;
+    }
+
+    // Publish the entry. The rename is atomic, so other processes either see the complete entry
+    // or no entry at all.
+    FileLock file_lock(lock_path_, true);
+    std::string persist_path;
+    if (FindEntry(key, &persist_path)) {
+      // Another process has published the same key.
+      RemoveDir(staging_path);
+      RecordPersisted(key, persist_path);
+      return;
+    }
+    if (persist_path.empty()) {
+      // All probed slots are taken by other keys. Replace the first one.
+      persist_path = GetPersistPath(key, 0);
+      RemoveDir(persist_path);
+    }
+    if (rename(staging_path.c_str(), persist_path.c_str()) != 0) {
+      AddMetric(kPersistCacheSaveFailure);
+      LOG(WARNING) << "Failed to publish cache entry to " << persist_path << ": "
+                   << strerror(errno);
+      RemoveDir(staging_path);
+      return;
+    }
+    RecordPersisted(key, persist_path);
+    Evict(persist_path);
+  }
+
+  std::unordered_map<std::string, size_t> GetMetric() override {
+    static const char* names[kNumMetrics] = {
+        "CacheGet",
+        "CacheHit",
+        "CacheMiss",
+        "CacheSet",
+        "PersistCacheHit",
+        "PersistCacheMiss",
+        "PersistCacheLoadFailure",
+        "PersistCacheSaveFailure",
+        "PersistCacheCollision",
+        "PersistCacheEviction",
+    };
+    std::unordered_map<std::string, size_t> ret;
+    for (int i = 0; i < kNumMetrics; ++i) {
+      size_t count = metrics_[i].load(std::memory_order_relaxed);
+      // Only the metrics that have been recorded are reported.
+      if (count > 0) {
+        ret[names[i]] = count;
+      }
+    }
+    return ret;
+  }
+
+ private:
+  enum Metric {
+    kCacheGet = 0,
+    kCacheHit,
+    kCacheMiss,
+    kCacheSet,
+    kPersistCacheHit,
+    kPersistCacheMiss,
+    kPersistCacheLoadFailure,
+    kPersistCacheSaveFailure,
+    kPersistCacheCollision,
+    kPersistCacheEviction,
+    kNumMetrics
+  };
+
+  /*! \brief The number of slots probed for a key whose hash collides with other keys. */
+  static constexpr int kNumProbes = 4;
+  /*! \brief Staged stale entries of crashed processes are removed after this many seconds. */
+  static constexpr int64_t kStaleStagingSeconds = 3600;
+  static constexpr const char* kLockFile = "lock";
+  static constexpr const char* kStagingPrefix = ".staging.";
+  static constexpr const char* kKeyFile = "key";
+  static constexpr const char* kSizeFile = "size";
+  static constexpr const char* kTimestampFile = "timestamp";
+
+  /*! \brief Load the value of a key missed in memory from the persistent cache. */
+  const T* LoadPersisted(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mu_);
+    FileLock file_lock(lock_path_, false);
 
+    std::string persist_path;
     // Persistent cache miss.
-    if (!DirExists(persist_path)) {
-      AddMetric("PersistCacheMiss", 1);
+    if (!FindEntry(key, &persist_path)) {
+      AddMetric(kPersistCacheMiss);
       return nullptr;
     }
-    AddMetric("PersistCacheHit", 1);
+    AddMetric(kPersistCacheHit);
 
     try {
-      MetaCache<T>::Set(key, T::Load(persist_path));
-      return MetaCache<T>::Get(key);
+      const T* ret = MetaCache<T>::SetIfAbsent(key, T::Load(persist_path));
+      TouchEntry(persist_path);
+      RecordPersisted(key, persist_path);
+      return ret;
     } catch (dmlc::Error& e) {
-      AddMetric("PersistCacheLoadFailure", 1);
+      AddMetric(kPersistCacheLoadFailure);
       LOG(WARNING) << "Failed to load persist entry " << path_ << ": " << e.what();
       return nullptr;
     }
     return nullptr;
   }
 
-  void Set(const std::vector<uint8_t>& key, T val) {
-    const std::string key_str(key.begin(), key.end());
-    Set(key_str, val);
+  inline std::string GetPersistPath(const std::string& key, int probe) {
+    const size_t hashed_key = std::hash<std::string>{}(key);
+    std::string path = path_ + "/" + std::to_string(hashed_key);
+    return probe == 0 ? path : path + "." + std::to_string(probe);
   }
 
-  void Set(const std::string& key, T val) {
-    AddMetric("CacheSet", 1);
-    MetaCache<T>::Set(key, val);
-    if (!persist_) {
-      return;
+  /*!
+   * \brief Find the persisted entry of the key. The caller must hold the file lock.
+   * \param key The key to be found.
+   * \param path The path of the entry if found. Otherwise, the first free slot of the key, or an
+   * empty string if all slots are taken by other keys.
+   * \return Whether the entry is found.
+   */
+  bool FindEntry(const std::string& key, std::string* path) {
+    path->clear();
+    for (int probe = 0; probe < kNumProbes; ++probe) {
+      auto persist_path = GetPersistPath(key, probe);
+      if (!DirExists(persist_path)) {
+        if (path->empty()) {
+          *path = persist_path;
+        }
+        continue;
+      }
+      std::string persisted_key;
+      if (ReadFile(persist_path + "/" + kKeyFile, &persisted_key) && persisted_key == key) {
+        *path = persist_path;
+        return true;
+      }
+      AddMetric(kPersistCacheCollision);
     }
+    return false;
+  }
 
-    std::lock_guard<std::mutex> lock(mu_);
+  /*! \brief Mark the entry as recently used. */
+  void TouchEntry(const std::string& persist_path) {
+    auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    WriteFile(persist_path + "/" + kTimestampFile, std::to_string(now) + "\n");
+  }
 
-    auto persist_path = GetPersistPath(key);
-    CreateDir(persist_path);
+  /*! \brief Whether the persisted entries are evicted, so that their use must be recorded. */
+  inline bool evict_enabled() const {
+    return persist_ && max_bytes_ > 0;
+  }
 
-    // Persist the cache value.
-    try {
-      if (!val.Save(persist_path)) {
-        throw;
-      }
-    } catch (dmlc::Error& e) {
-      AddMetric("PersistCacheSaveFailure", 1);
-      LOG(WARNING) << "Failed to persist cache entry to " << path_ << ": " << e.what();
+  /*! \brief Remember where an entry in memory is persisted, so that a hit can touch it. */
+  void RecordPersisted(const std::string& key, const std::string& persist_path) {
+    if (!evict_enabled()) {
       return;
     }
-
-    std::ofstream metadata_file(persist_path + "/timestamp");
-    metadata_file << std::chrono::system_clock::to_time_t(std::chrono::system_clock::now())
-                  << std::endl;
-    metadata_file.close();
+    std::lock_guard<std::mutex> lock(touch_mu_);
+    persisted_[key] = {persist_path, std::chrono::steady_clock::now()};
   }
 
-  std::unordered_map<std::string, size_t> GetMetric() override {
-    return metrics_;
+  /*!
+   * \brief Mark the persisted entry of a key hit in memory as recently used. Otherwise the hot
+   * entries, which are only read from memory, would look the least recently used and be evicted
+   * first. To keep the hit path cheap, an entry is touched at most once per touch interval.
+   */
+  void TouchOnHit(const std::string& key) {
+    const auto now = std::chrono::steady_clock::now();
+    std::string persist_path;
+    {
+      std::lock_guard<std::mutex> lock(touch_mu_);
+      auto it = persisted_.find(key);
+      if (it == persisted_.end() ||
+          now - it->second.second < std::chrono::milliseconds(touch_interval_ms_)) {
+        return;
+      }
+      it->second.second = now;
+      persist_path = it->second.first;
+    }
+    FileLock file_lock(lock_path_, false);
+    // The entry may have been evicted, and its slot taken by another key, by another process.
+    std::string persisted_key;
+    if (ReadFile(persist_path + "/" + kKeyFile, &persisted_key) && persisted_key == key) {
+      TouchEntry(persist_path);
+    }
   }
 
- private:
-  inline std::string GetPersistPath(const std::string& key) {
-    const size_t hashed_key = std::hash<std::string>{}(key);
-    return path_ + "/" + std::to_string(hashed_key);
+  /*!
+   * \brief Evict the least recently used entries until the cache fits in the budget. The
+   * caller must hold the exclusive file lock.
+   * \param keep_path The entry that must not be evicted, which is the one just published.
+   */
+  void Evict(const std::string& keep_path) {
+    if (max_bytes_ <= 0) {
+      return;
+    }
+    struct EntryInfo {
+      /*! \brief The last use time in nanoseconds, taken from the timestamp file. */
+      int64_t last_use;
+      int64_t size;
+      std::string path;
+    };
+    const std::string staging_prefix(kStagingPrefix);
+    const int64_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::vector<EntryInfo> entries;
+    int64_t total_size = 0;
+    for (const auto& name : ListDir(path_)) {
+      auto entry_path = path_ + "/" + name;
+      struct stat st;
+      if (name == kLockFile || stat(entry_path.c_str(), &st) != 0) {
+        continue;
+      }
+      if (name.compare(0, staging_prefix.size(), staging_prefix) == 0) {
+        // The entry staged by a process that crashed before publishing it.
+        if (now - st.st_mtime > kStaleStagingSeconds) {
+          RemoveDir(entry_path);
+        }
+        continue;
+      }
+      EntryInfo info{0, 0, entry_path};
+      std::string size;
+      if (ReadFile(entry_path + "/" + kSizeFile, &size) && !size.empty()) {
+        info.size = atoll(size.c_str());
+      } else {
+        // The entry persisted before sizes were recorded.
+        info.size = DirSize(entry_path);
+      }
+      struct stat ts;
+      if (stat((entry_path + "/" + kTimestampFile).c_str(), &ts) == 0) {
+        info.last_use = static_cast<int64_t>(ts.st_mtim.tv_sec) * 1000000000 + ts.st_mtim.tv_nsec;
+      }
+      total_size += info.size;
+      entries.push_back(std::move(info));
+    }
+    if (total_size <= max_bytes_) {
+      return;
+    }
+    std::sort(entries.begin(), entries.end(), [](const EntryInfo& lhs, const EntryInfo& rhs) {
+      return lhs.last_use < rhs.last_use;
+    });
+    for (const auto& entry : entries) {
+      if (total_size <= max_bytes_) {
+        break;
+      }
+      if (entry.path == keep_path) {
+        continue;
+      }
+      RemoveDir(entry.path);
+      total_size -= entry.size;
+      AddMetric(kPersistCacheEviction);
+    }
   }
 
-  inline void AddMetric(const std::string name, size_t val) {
-    metrics_[name] += val;
+  inline void AddMetric(Metric metric) {
+    metrics_[metric].fetch_add(1, std::memory_order_relaxed);
   }
 
-  /*! \brief The cache metrics for analysis. */
-  std::unordered_map<std::string, size_t> metrics_;
+  /*! \brief The cache metrics for analysis, which are updated without locks. */
+  std::array<std::atomic<size_t>, kNumMetrics> metrics_{};
   /*! \brief Persist directory name. */
   std::string persist_name_;
   /*! \brief Persist directory path. */
   std::string path_;
+  /*! \brief The path of the lock file shared by all processes using this cache. */
+  std::string lock_path_;
+  /*! \brief The budget of the persisted entries in bytes. 0 means no limit. */
+  int64_t max_bytes_ = 0;
+  /*! \brief The number of entries staged by this cache, used to name staging directories. */
+  int64_t num_staged_ = 0;
+  /*! \brief The minimum interval between two touches of an entry hit in memory. */
+  int64_t touch_interval_ms_ = 1000;
   /*! \brief Whether to presist values. */
   bool persist_ = false;
   /*! \brief The thread-safe lock. */
   std::mutex mu_;
+  /*! \brief The persisted path and the last touch time of each entry in memory. */
+  std::unordered_map<std::string,
+                     std::pair<std::string, std::chrono::steady_clock::time_point>>
+      persisted_;
+  /*! \brief The lock of persisted_, which is not held while saving an entry. */
+  std::mutex touch_mu_;
 };
 
 PackedMetricMap DumpMetric(const std::string& cache_name);
@@ -0,0 +1,148 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file cpu_communicator.h
+ * \brief The interface of the Communicators implementing the collectives on CPU.
+ */
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "raf/communicator.h"
+
+namespace raf {
+namespace distributed {
+namespace communicator {
+
+/*! \brief The reduction of a collective. */
+enum class CPUReduceOp : int {
+  kSum = 0,
+  kProd,
+  kMin,
+  kMax,
+  kAvg,
+};
+
+/*! \brief The algorithm of a collective. */
+enum class CollectiveAlgo : int {
+  /*! \brief Bandwidth-optimal ring. */
+  kRing = 0,
+  /*! \brief Binomial tree, which takes log(size) steps, so it wins on small messages. */
+  kTree,
+  /*! \brief Recursive halving of a reduce-scatter on a power-of-two group. */
+  kHalving,
+  /*! \brief Intra-host reduce, inter-host allreduce among one rank per host, then intra-host
+   * broadcast, so that only 1 / local_size of the ranks use the network. */
+  kHierarchical,
+};
+
+CPUReduceOp CPUReduceOpFromString(const std::string& computation);
+
+/*! \brief Whether the CPU collectives can reduce this dtype. */
+bool CPUCanReduce(DType dtype);
+
+/*!
+ * \brief The name of the Communicator of the CPU collectives. It is RAF_CPU_COMMUNICATOR if set,
+ * "tcp" if a TCP rendezvous is configured, or "shm" otherwise.
+ */
+std::string GetCPUCommunicatorName();
+
+/*!
+ * \brief A Communicator that moves host memory, so that the CPU dialect of the collectives can
+ * run on any of them. Like the other communicators, all the ranks must invoke the collectives in
+ * the same order.
+ */
+class CPUCommunicatorObj : public CommunicatorObj {
+ public:
+  /*! \brief recv = op(send of every rank), with count elements each. send may be recv. */
+  virtual void AllReduce(const void* send, void* recv, int64_t count, DType dtype,
+                         CPUReduceOp op) = 0;
+  /*! \brief recv is the concatenation of send of every rank, with bytes each. */
+  virtual void AllGather(const void* send, void* recv, int64_t bytes) = 0;
+  /*! \brief recv = op(the rank-th block of send of every rank), with count elements per block. */
+  virtual void ReduceScatter(const void* send, void* recv, int64_t count, DType dtype,
+                             CPUReduceOp op) = 0;
+  /*! \brief recv = send of the root. */
+  virtual void Broadcast(const void* send, void* recv, int64_t bytes, int root) = 0;
+  /*! \brief The i-th block of recv is the rank-th block of send of rank i, with bytes per block. */
+  virtual void AllToAll(const void* send, void* recv, int64_t bytes) = 0;
+  /*! \brief Send bytes to the peer, which must receive them with Recv. */
+  virtual void Send(const void* data, int64_t bytes, int peer) = 0;
+  virtual void Recv(void* data, int64_t bytes, int peer) = 0;
+  /*! \brief Block until all the ranks arrive. */
+  virtual void Barrier() = 0;
+
+  static constexpr const char* _type_key = "raf.distributed.CPUCommunicator";
+  RAF_BASE_OBJECT(CPUCommunicatorObj, CommunicatorObj);
+};
+
+class CPUCommunicator : public Communicator {
+ public:
+  RAF_MUTABLE_OBJECT_REF(CPUCommunicator, Communicator, CPUCommunicatorObj);
+};
+
+/*!
+ * \brief The thread running the asynchronous CPU collectives, so that they overlap with the
+ * compute on the main thread. The tasks run one at a time in the order of submission, so the
+ * ranks keep the same order of collectives as long as they submit in the same order.
+ */
+class CPUCommWorker {
+ public:
+  ~CPUCommWorker();
+
+  static CPUCommWorker* Get();
+
+  /*!
+   * \brief Run the task on the worker thread.
+   * \param task The task, which usually runs a collective.
+   * \param result The buffer the task writes, which is kept alive until the task is waited.
+   * \return The ticket to wait for the task.
+   */
+  int64_t Submit(std::function<void()> task, std::shared_ptr<void> result = nullptr);
+
+  /*!
+   * \brief Block until the task of the ticket finishes, and rethrow its error if any.
+   * \return The result buffer of the task.
+   */
+  std::shared_ptr<void> Wait(int64_t ticket);
+
+  /*!
+   * \brief Block until all the submitted tasks finish. The synchronous collectives call it
+   * before they run, so that they never interleave with the asynchronous ones.
+   */
+  void Flush();
+
+ private:
+  CPUCommWorker() = default;
+  void Run();
+
+  struct Pending {
+    std::shared_future<void> future;
+    std::shared_ptr<void> result;
+  };
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  /*! \brief The tasks to run. */
+  std::deque<std::packaged_task<void()>> queue_;
+  /*! \brief The submitted tasks that are not waited yet. */
+  std::unordered_map<int64_t, Pending> pending_;
+  int64_t num_submitted_ = 0;
+  int64_t num_finished_ = 0;
+  bool stop_ = false;
+  /*! \brief Started by the first task. */
+  std::thread thread_;
+};
+
+}  // namespace communicator
+}  // namespace distributed
+}  // namespace raf
@@ -8,6 +8,7 @@
  * \brief Config of Distributed Settings.
  */
 #pragma once
+#include <string>
 #include "./ir.h"
 #include "./communicator.h"
 
@@ -23,7 +24,20 @@ class DistConfigObj : public ir::Object {
   bool enable_auto_dp_profiling = false;
   int auto_dp_profiling_start_iter = 2;
   int auto_dp_profiling_end_iter = 4;
+  /*!
+   * \brief The number of elements of a bucket of the grouped collectives, e.g., the allreduces
+   * launched together by AsyncDataParallelSchedule.
+   */
   int64_t group_bucket_size = 5000000000;
+  /*!
+   * \brief The compression of the gradients that AutoDataParallel aggregates: "none", "fp16",
+   * "bf16", "topk", "onebit" or "powersgd".
+   */
+  std::string grad_compression = "none";
+  /*! \brief The fraction of the elements of a gradient that "topk" sends. */
+  double grad_compression_topk_ratio = 0.01;
+  /*! \brief The rank of the low-rank approximation of "powersgd". */
+  int grad_compression_powersgd_rank = 4;
 
   void VisitAttrs(tvm::AttrVisitor* v) {
     v->Visit("enable_data_parallel", &enable_data_parallel);
@@ -32,6 +46,9 @@ class DistConfigObj : public ir::Object {
     v->Visit("auto_dp_profiling_start_iter", &auto_dp_profiling_start_iter);
     v->Visit("auto_dp_profiling_end_iter", &auto_dp_profiling_end_iter);
     v->Visit("group_bucket_size", &group_bucket_size);
+    v->Visit("grad_compression", &grad_compression);
+    v->Visit("grad_compression_topk_ratio", &grad_compression_topk_ratio);
+    v->Visit("grad_compression_powersgd_rank", &grad_compression_powersgd_rank);
   }
 
  public:
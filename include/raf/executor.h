@@ -8,6 +8,9 @@
  * \brief Executor API
  */
 #pragma once
+#include <functional>
+#include <ostream>
+#include <string>
 #include "./memory_pool.h"
 #include "./op.h"
 #include "./stream_pool.h"
@@ -36,6 +39,23 @@ class Executor {
 namespace interpreter {
 value::Value Interpret(ir::Expr expr, ir::Optional<ir::IRModule> mod = {});
 value::Value InvokePrimitive(const op::CallValues& call);
+/*!
+ * \brief Invoke a primitive with a key of its arguments, which allows the interpreter to reuse the
+ * OpEnv of a previous call with the same op, attributes and input shapes.
+ * \param call The call values.
+ * \param args_key The key of the arguments, built by AppendOpEnvCacheKey.
+ * \param make_args Convert the arguments to values. It is only called when the OpEnv is created.
+ * \return The output.
+ */
+value::Value InvokePrimitive(const op::CallValues& call, const std::string& args_key,
+                             const std::function<ir::Array<value::Value>()>& make_args);
+/*!
+ * \brief Append a value to the key of the interpreter OpEnv cache. Tensors are represented by
+ * their shapes, strides, byte offsets, data types and devices, and other values by their content.
+ * \param os The stream of the key.
+ * \param value The value.
+ */
+void AppendOpEnvCacheKey(std::ostream* os, const value::Value& value);
 value::Value InvokeClosure(const op::CallValues& call);
 }  // namespace interpreter
 }  // namespace executor
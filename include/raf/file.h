@@ -9,10 +9,17 @@
  */
 #pragma once
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <fstream>
 #include <cerrno>
 #include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
 #include "dmlc/logging.h"
 
 namespace raf {
@@ -31,4 +38,108 @@ inline bool DirExists(const std::string& path) {
   ifs.close();
   return ret;
 }
+
+/*! \brief List the names of the entries in a directory, excluding "." and "..". */
+inline std::vector<std::string> ListDir(const std::string& path) {
+  std::vector<std::string> names;
+  DIR* dir = opendir(path.c_str());
+  if (dir == nullptr) {
+    return names;
+  }
+  while (struct dirent* entry = readdir(dir)) {
+    std::string name(entry->d_name);
+    if (name != "." && name != "..") {
+      names.push_back(name);
+    }
+  }
+  closedir(dir);
+  return names;
+}
+
+/*! \brief Remove a file or a directory with all its contents. */
+inline void RemoveDir(const std::string& path) {
+  struct stat st;
+  if (lstat(path.c_str(), &st) != 0) {
+    return;
+  }
+  if (S_ISDIR(st.st_mode)) {
+    for (const auto& name : ListDir(path)) {
+      RemoveDir(path + "/" + name);
+    }
+    rmdir(path.c_str());
+  } else {
+    unlink(path.c_str());
+  }
+}
+
+/*! \brief The total size in bytes of the regular files under a directory. */
+inline int64_t DirSize(const std::string& path) {
+  struct stat st;
+  if (lstat(path.c_str(), &st) != 0) {
+    return 0;
+  }
+  if (!S_ISDIR(st.st_mode)) {
+    return S_ISREG(st.st_mode) ? static_cast<int64_t>(st.st_size) : 0;
+  }
+  int64_t size = 0;
+  for (const auto& name : ListDir(path)) {
+    size += DirSize(path + "/" + name);
+  }
+  return size;
+}
+
+/*! \brief Read the whole content of a file. Return false if the file cannot be opened. */
+inline bool ReadFile(const std::string& path, std::string* content) {
+  std::ifstream ifs(path, std::ios::in | std::ios::binary);
+  if (!ifs.is_open()) {
+    return false;
+  }
+  std::ostringstream oss;
+  oss << ifs.rdbuf();
+  *content = oss.str();
+  return true;
+}
+
+/*! \brief Write the content to a file. Return false on failure. */
+inline bool WriteFile(const std::string& path, const std::string& content) {
+  std::ofstream ofs(path, std::ios::out | std::ios::binary | std::ios::trunc);
+  ofs.write(content.data(), content.size());
+  ofs.close();
+  return ofs.good();
+}
+
+/*!
+ * \brief A scoped advisory lock on a file, which is shared by all processes that lock the same
+ * path. The file is created if it does not exist.
+ */
+class FileLock {
+ public:
+  FileLock(const std::string& path, bool exclusive) {
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+    if (fd_ == -1) {
+      LOG(WARNING) << "Failed to open lock file " << path << ": " << strerror(errno);
+      return;
+    }
+    while (flock(fd_, exclusive ? LOCK_EX : LOCK_SH) == -1) {
+      if (errno != EINTR) {
+        LOG(WARNING) << "Failed to lock " << path << ": " << strerror(errno);
+        break;
+      }
+    }
+  }
+
+  ~FileLock() {
+    if (fd_ != -1) {
+      flock(fd_, LOCK_UN);
+      close(fd_);
+    }
+  }
+
+  FileLock(const FileLock&) = delete;
+  FileLock& operator=(const FileLock&) = delete;
+
+ private:
+  /*! \brief The file descriptor of the lock file. */
+  int fd_ = -1;
+};
 }  // namespace raf
@@ -0,0 +1,41 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file grad_compression.h
+ * \brief The shapes of the compressed gradients of data parallelism.
+ */
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace raf {
+namespace distributed {
+
+/*! \brief The number of elements that top-k compression keeps out of n. */
+inline int64_t TopKCount(int64_t n, double ratio) {
+  int64_t k = static_cast<int64_t>(std::ceil(n * ratio));
+  return std::max<int64_t>(1, std::min(k, n));
+}
+
+/*! \brief The number of bytes of the packed signs of n elements. */
+inline int64_t OneBitBytes(int64_t n) {
+  return (n + 7) / 8;
+}
+
+/*! \brief The matrix that PowerSGD factorizes a gradient as, i.e., dim 0 by the other dims. */
+inline std::pair<int64_t, int64_t> PowerSGDMatrixShape(const std::vector<int64_t>& shape) {
+  int64_t rows = shape.empty() ? 1 : shape[0];
+  int64_t cols = 1;
+  for (size_t i = 1; i < shape.size(); ++i) {
+    cols *= shape[i];
+  }
+  return {rows, cols};
+}
+
+}  // namespace distributed
+}  // namespace raf
@@ -190,6 +190,8 @@ using tvm::relay::attr::kSkipOptimization;
 constexpr const char* kDialect = "Dialect";
 /*! \brief Mark the fusion pattern name. */
 constexpr const char* kPatternName = "PatternName";
+/*! \brief The number of inputs received from the previous pipeline stage. */
+constexpr const char* kPipelineInputs = "PipelineInputs";
 }  // namespace attr
 
 }  // namespace ir
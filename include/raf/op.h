@@ -194,6 +194,23 @@ inline T GetOpAttrOrDefault(const ir::Op& op, const std::string attr_name, T def
  */
 std::shared_ptr<OpEnv> Dispatch(const CallValues& call);
 
+/*!
+ * \brief Dispatch (fused or un-fused) ops to backend implementation with the arguments the call
+ * values are made from. When RAF_DISPATCH_BY_PROFILING=1, all eligible dialects of an un-fused op
+ * are built and profiled with dummy data, and the fastest one is used. The dummy data is
+ * uninitialized, so the decision may not reflect the real data for kernels whose latency depends
+ * on it. The decision is cached by the op as well as the shapes and data types of the arguments,
+ * and is persisted so that later processes can reuse it without profiling. Otherwise, it is the
+ * same as Dispatch(call).
+ * \param call The call values.
+ * \param args The arguments of the call.
+ * \return The created OpEnv.
+ */
+std::shared_ptr<OpEnv> Dispatch(const CallValues& call, const ir::Array<value::Value>& args);
+
+/*! \brief Whether un-fused ops are dispatched by profiling, i.e., RAF_DISPATCH_BY_PROFILING=1. */
+bool DispatchByProfilingEnabled();
+
 /*!
  * \brief Create a dummy call_values from a call expression. The inputs and output of the call
  * values are dummy values created according to the inferred type of the call expression.
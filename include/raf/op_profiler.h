@@ -14,6 +14,7 @@
 #include "raf/ir_ext.h"
 #include "op.h"
 #include "op_utils.h"
+#include <memory>
 #include <unordered_map>
 
 #ifdef RAF_USE_CUDA
@@ -32,6 +33,34 @@ using LatencyAndWorkspaceMapT =
     std::unordered_map<std::string, std::pair<std::vector<float>, int64_t>>;
 using OpEnvMapT = std::unordered_map<std::string, OpEnvPtr>;
 
+/*!
+ * \brief The version of the profiling database. Bump it whenever the key or the value format,
+ * or the way ops are measured, is changed, so that stale results are not reused.
+ */
+constexpr int kProfileDBVersion = 2;
+
+/*! \brief The latency samples and workspace size of an op or a group of ops in the database. */
+class ProfileCacheEntry {
+ public:
+  ProfileCacheEntry() {
+  }
+
+  ProfileCacheEntry(const std::vector<float>& latency, int64_t workspace_size)
+      : latency(latency), workspace_size(workspace_size) {
+  }
+
+  static ProfileCacheEntry Load(const std::string& path);
+
+  bool Save(const std::string& path);
+
+  /*! \brief The latency in microseconds of each repeat. */
+  std::vector<float> latency;
+  /*! \brief The workspace size in bytes. */
+  int64_t workspace_size = 0;
+};
+
+using ProfileDBT = MetaPersistCache<ProfileCacheEntry>;
+
 /*! \brief A class to JIT op, create dummy input data, and allocate memory buffers for profiling. */
 class OpWithData {
  public:
@@ -43,11 +72,18 @@ class OpWithData {
 
   OpWithData(const Device device, const Expr& op, const int stream_id = -1);
 
+  /*! \brief Use a built OpEnv with the given inputs and output. */
+  OpWithData(const OpEnvPtr& op_env, const std::vector<Value>& inputs, const Value& output);
+
   ~OpWithData();
 
   bool profilable() const {
     return op_env != nullptr;
   }
+
+ private:
+  /*! \brief Allocate the workspace requested by the OpEnv. */
+  void AllocWorkspace();
 };
 
 using OpWithDataPtr = std::shared_ptr<OpWithData>;
@@ -97,6 +133,21 @@ class OpProfiler {
                                                       int32_t warmup = 10, int32_t exec_number = 10,
                                                       int32_t repeat = 1);
 
+  /*!
+   * \brief Profile a built OpEnv with the given inputs and output, and return its latency in
+   * microseconds. The result is not cached, because the OpEnv is not identified by an expression.
+   * \param op_env The OpEnv to be profiled.
+   * \param inputs The input values of the OpEnv.
+   * \param output The output value of the OpEnv.
+   * \param warmup The number of warmup iterations. Default 10.
+   * \param exec_number The number of execution iterations. Default 10.
+   * \param repeat The number of repeat iterations. Default 1.
+   * \return The latency in microseconds of each repeat.
+   */
+  std::vector<float> ProfileOpEnv(const OpEnvPtr& op_env, const std::vector<Value>& inputs,
+                                  const Value& output, int32_t warmup = 10,
+                                  int32_t exec_number = 10, int32_t repeat = 1);
+
   /*!
    * \brief Return the OpEnv of the given op if it has been profiled.
    * \param op The op to be queried.
@@ -112,11 +163,22 @@ class OpProfiler {
   }
 
   /*!
-   * \brief Reset the latency cache.
+   * \brief Reset the latency cache. The results persisted to the profiling database are kept on
+   * disk and reloaded on demand.
    */
   void Reset() {
     latency_and_workspace_size_cache_.clear();
     op_env_cache_.clear();
+    profile_db_.reset();
+  }
+
+  /*!
+   * \brief Get the metrics of the profiling database.
+   */
+  std::unordered_map<std::string, size_t> GetDBMetric() {
+    auto profile_db = GetProfileDB();
+    return profile_db != nullptr ? profile_db->GetMetric()
+                                 : std::unordered_map<std::string, size_t>();
   }
 
  protected:
@@ -130,24 +192,64 @@ class OpProfiler {
   LatencyAndWorkspaceMapT latency_and_workspace_size_cache_;
   /*! \brief A cache to store built OpEnv. */
   OpEnvMapT op_env_cache_;
+  /*!
+   * \brief The profiling results of previous processes on the same class of device, which are
+   * persisted when RAF_PERSIST_CACHE=1. Keys are stable across processes. Created on demand,
+   * and only if the persistence is enabled.
+   */
+  std::unique_ptr<ProfileDBT> profile_db_;
 
  private:
   /*!
-   * \brief Generate a byte string hash for the given call node using its op as well as
-   * argument and return types.
+   * \brief The name of the device model, such as the GPU or CPU model, which identifies the
+   * database of the profiling results.
+   */
+  virtual std::string GetDeviceName() = 0;
+
+  /*!
+   * \brief Get the profiling database of this device, and create it if needed.
+   * \return The database, or nullptr if RAF_PERSIST_CACHE is not enabled, in which case it would
+   * only duplicate the latency cache.
+   */
+  ProfileDBT* GetProfileDB();
+
+  /*!
+   * \brief Look up the results in the profiling database, and add them to the latency cache
+   * if found.
+   * \param db_key The key in the database.
+   * \param key The key in the latency cache.
+   * \return Whether the results are found.
+   */
+  bool LookupProfileDB(const HashKey& db_key, const std::string& key);
+
+  /*!
+   * \brief Generate a byte string hash for the given call node using its op, the dialects the op
+   * may be dispatched to, as well as argument and return types.
    *
    * \param call The call node to be hashed.
+   * \param structural Whether to hash closures structurally, which gives keys that are stable
+   * across processes. Otherwise, closures are hashed by their addresses.
    * \return The hashed key.
    */
-  HashKey HashCall(const Call& call) {
+  HashKey HashCall(const Call& call, bool structural = false) {
     HashKey key;
 
     // Hash op name. Note that we directly use the object address as the key
     // because all fused op closures have the same name at this stage.
     if (auto op_node = call->op.as<OpNode>()) {
       key << op_node->name;
+      // The profiled OpEnv is built by the first dialect in the dispatch list, which depends on
+      // the dialect preference.
+      auto op = GetRef<ir::Op>(op_node);
+      if (!IsDialectOp(op)) {
+        for (const auto& entry : OpDialect::GetDispatchList(op, device_.device_type())) {
+          key << entry.dialect;
+        }
+      }
+      key << DispatchByProfilingEnabled();
     } else if (auto fn_node = call->op.as<FunctionNode>()) {
-      key << uint64_t(ObjectPtrHash()(GetRef<Function>(fn_node)));
+      auto fn = GetRef<Function>(fn_node);
+      key << uint64_t(structural ? tvm::StructuralHash()(fn) : ObjectPtrHash()(fn));
     } else {
       LOG(FATAL) << "OpProfiler does not deal with " << call->op->GetTypeKey();
       throw;
@@ -167,9 +269,11 @@ class OpProfiler {
    *
    * \param ops The group to be hashed.
    * \param stream_ids The stream IDs.
+   * \param structural Whether to hash closures structurally.
    * \return The hashed key.
    */
-  HashKey HashGroup(const std::vector<Expr>& ops, const std::vector<int> stream_ids = {}) {
+  HashKey HashGroup(const std::vector<Expr>& ops, const std::vector<int> stream_ids = {},
+                    bool structural = false) {
     HashKey key;
     std::vector<int> processed_stream_ids = stream_ids;
 
@@ -184,7 +288,7 @@ class OpProfiler {
     for (size_t i = 0; i < ops.size(); ++i) {
       auto op = ops[i];
       if (auto call_node = op.as<CallNode>()) {
-        key << HashCall(GetRef<Call>(call_node));
+        key << HashCall(GetRef<Call>(call_node), structural);
       } else {
         // For non-call nodes, we simply hash their type.
         key << raf::ir::AsText(op->checked_type(), false);
@@ -195,7 +299,7 @@ class OpProfiler {
   }
 
   inline std::string HashKeyToStr(const HashKey& key) {
-    return std::string(key.byte_vector.begin(), key.byte_vector.end());
+    return key.str();
   }
 
   /*!
@@ -233,6 +337,8 @@ class CPUOpProfiler : public OpProfiler {
   }
 
  private:
+  virtual std::string GetDeviceName();
+
   /*!
    * \brief The function that actually executes the op on the device.
    * \param op_with_data The executable op with data.
@@ -281,6 +387,8 @@ class CUDAOpProfiler : public OpProfiler {
   }
 
  private:
+  virtual std::string GetDeviceName();
+
   /*!
    * \brief The function that actually executes the op on the device.
    * \param op_with_data The executable op with data.
@@ -163,6 +163,24 @@ Pass AutoCast();
  */
 Pass Rematerialization();
 
+/*!
+ * \brief A pass that partitions the function into the given number of partition functions with
+ * balanced cost.
+ * \param num_partitions The number of partitions.
+ * \param use_profiler Whether to use the profiled latency instead of the estimated FLOPS as cost.
+ * \return The created pass.
+ */
+Pass PartitionANFByCost(int num_partitions, bool use_profiler = false);
+
+/*!
+ * \brief A pass that keeps one stage of the function cut into pipeline stages.
+ * \param num_stages The number of pipeline stages.
+ * \param stage The stage to be kept.
+ * \param use_profiler Whether to use the profiled latency instead of the estimated FLOPS as cost.
+ * \return The created pass.
+ */
+Pass PipelineStage(int num_stages, int stage, bool use_profiler = false);
+
 /*!
  * \brief A pass that schedules ANF for memory optimization.
  * \return The created pass.
@@ -349,6 +367,15 @@ Pass ASAPStreamSchedule();
  */
 Pass DataParallelSchedule();
 
+/*!
+ * \brief This pass works in ANF and overlaps the gradient allreduces with the backward on CPU. The
+ * allreduces are grouped into buckets of DistConfig::group_bucket_size elements, launched with
+ * _allreduce_async as soon as the bucket is produced, and waited with _wait_async as late as
+ * possible.
+ * \return The created pass.
+ */
+Pass AsyncDataParallelSchedule();
+
 /*!
  * \brief This pass works in ANF and adds necessary synchronization ops (i.e., raf.op.set_stream,
  * raf.op.add_event, and raf.op.wait_event) between communication ops and computation ops to
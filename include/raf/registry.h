@@ -46,7 +46,12 @@ class PerDevTypeStore {
  public:
   using EntryPtr = std::shared_ptr<EntryType>;
 
-  PerDevTypeStore() = default;
+  /*!
+   * \brief The entries are allocated up front, so that Get never resizes the storage while
+   * another thread reads it, and the returned references stay valid.
+   */
+  PerDevTypeStore() : entries_(kMaxDevTypes) {
+  }
 
   ~PerDevTypeStore() DMLC_THROW_EXCEPTION {
     for (EntryPtr& entry : entries_) {
@@ -56,7 +61,8 @@ class PerDevTypeStore {
 
   EntryPtr& Get(DevType dev_type) {
     int dev_type_int = dev_type.operator int();
-    EnsureCapacity(dev_type_int);
+    CHECK(dev_type_int >= 0 && dev_type_int < kMaxDevTypes)
+        << "Unsupported device type: " << dev_type_int;
     EntryPtr& ret = entries_[dev_type_int];
     if (create_default) {
       CreateMissing(&ret);
@@ -79,16 +85,9 @@ class PerDevTypeStore {
   void CreateMissing(EntryPtr* p, typename std::enable_if_t<!b, int> = 0) {
   }
 
-  void EnsureCapacity(int i) {
-    if (i >= static_cast<int>(entries_.size())) {
-      std::lock_guard<std::mutex> lock(mutex_);
-      if (i >= static_cast<int>(entries_.size())) {
-        entries_.resize(i + 1);
-      }
-    }
-  }
-
  public:
+  /*! \brief The upper bound of the integer values of the device types. */
+  static constexpr int kMaxDevTypes = 32;
   std::vector<EntryPtr> entries_;
   std::mutex mutex_;
 };
@@ -104,7 +103,12 @@ class PerDeviceStore {
  public:
   using EntryPtr = std::shared_ptr<EntryType>;
 
-  PerDeviceStore() = default;
+  /*!
+   * \brief The entries are allocated up front, so that Get never resizes the storage while
+   * another thread reads it, and the returned references stay valid.
+   */
+  PerDeviceStore() : entries_(kMaxDevTypes, std::vector<EntryPtr>(kMaxDevicesPerType)) {
+  }
 
   ~PerDeviceStore() DMLC_THROW_EXCEPTION {
     for (auto& outer : entries_) {
@@ -116,7 +120,10 @@ class PerDeviceStore {
 
   EntryPtr& Get(Device dev) {
     int dev_type_int = dev.device_type();
-    EnsureCapacity(dev_type_int, dev.device_id());
+    CHECK(dev_type_int >= 0 && dev_type_int < kMaxDevTypes)
+        << "Unsupported device type: " << dev_type_int;
+    CHECK(dev.device_id() >= 0 && dev.device_id() < kMaxDevicesPerType)
+        << "Unsupported device id: " << dev.device_id();
     EntryPtr& ret = entries_[dev_type_int][dev.device_id()];
     if (create_default) {
       CreateMissing(&ret);
@@ -139,18 +146,11 @@ class PerDeviceStore {
   void CreateMissing(EntryPtr* p, typename std::enable_if_t<!b, int> = 0) {
   }
 
-  void EnsureCapacity(int i, int j) {
-    if (i >= static_cast<int>(entries_.size()) || j >= static_cast<int>(entries_[i].size())) {
-      if (i >= static_cast<int>(entries_.size())) {
-        entries_.resize(i + 1);
-      }
-      if (j >= static_cast<int>(entries_[i].size())) {
-        entries_[i].resize(j + 1);
-      }
-    }
-  }
-
  public:
+  /*! \brief The upper bound of the integer values of the device types. */
+  static constexpr int kMaxDevTypes = 32;
+  /*! \brief The upper bound of the device ids of a device type. */
+  static constexpr int kMaxDevicesPerType = 64;
   std::vector<std::vector<EntryPtr> > entries_;
   std::mutex mutex_;
 };
@@ -0,0 +1,56 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file shm_communicator.h
+ * \brief Shared-memory Communicator for the processes on one host.
+ */
+#pragma once
+#include "raf/cpu_communicator.h"
+
+namespace raf {
+namespace distributed {
+namespace communicator {
+
+struct ShmSegment;
+
+/*!
+ * \brief A communicator of the processes on one host, which exchange data through a POSIX
+ * shared-memory segment. Every rank owns a slot in the segment. A collective moves the data in
+ * chunks of one slot, and every rank reduces its own share of each chunk in place, so the ranks
+ * work in parallel. The slots are double-buffered, so a rank can fill the next chunk while slower
+ * ranks still read the previous one.
+ */
+class ShmCommunicatorObj final : public CPUCommunicatorObj {
+ public:
+  Communicator parent_comm;  // Prevent the global communicator from releasing in advance
+  /*! \brief The segment, or nullptr if this rank runs in standalone mode. */
+  ShmSegment* segment = nullptr;
+
+  void AllReduce(const void* send, void* recv, int64_t count, DType dtype,
+                 CPUReduceOp op) override;
+  void AllGather(const void* send, void* recv, int64_t bytes) override;
+  void ReduceScatter(const void* send, void* recv, int64_t count, DType dtype,
+                     CPUReduceOp op) override;
+  void Broadcast(const void* send, void* recv, int64_t bytes, int root) override;
+  void AllToAll(const void* send, void* recv, int64_t bytes) override;
+  void Send(const void* data, int64_t bytes, int peer) override;
+  void Recv(void* data, int64_t bytes, int peer) override;
+  void Barrier() override;
+
+  static constexpr const char* _type_key = "raf.distributed.ShmCommunicator";
+  ~ShmCommunicatorObj();
+  RAF_FINAL_OBJECT(ShmCommunicatorObj, CPUCommunicatorObj);
+};
+
+class ShmCommunicator final : public CPUCommunicator {
+ public:
+  static ShmCommunicator make(Value rank_list);
+  RAF_MUTABLE_OBJECT_REF(ShmCommunicator, CPUCommunicator, ShmCommunicatorObj);
+};
+
+}  // namespace communicator
+}  // namespace distributed
+}  // namespace raf
@@ -38,7 +38,7 @@ enum StreamTag {
   kCudaCommunicate = 4,
   kMemCpyCudaToCuda1 = 5,
   kMemCpyCudaToCuda2 = 6,
-  kReserved1 = 7,
+  kCpuCompute = 7,
   kReserved2 = 8,
   kReserved3 = 9,
   kReserved4 = 10,
@@ -64,7 +64,7 @@ class StreamTagEnum : public EnumBase<StreamTagEnum, 16, int32_t, StreamTag> {
                            "Memcopy from CUDA to CUDA");
   ENUM_DEF_ENTRY_WITH_NAME(StreamTagEnum, 6, MemCudaToCuda2, kMemCpyCudaToCuda2,
                            "Memcopy from CUDA to CUDA");
-  ENUM_DEF_ENTRY_WITH_NAME(StreamTagEnum, 7, Reserved1, kReserved1, "Reserved for other devices");
+  ENUM_DEF_ENTRY_WITH_NAME(StreamTagEnum, 7, CpuCompute, kCpuCompute, "Cpu compute");
   ENUM_DEF_ENTRY_WITH_NAME(StreamTagEnum, 8, Reserved2, kReserved2, "Reserved for other devices");
   ENUM_DEF_ENTRY_WITH_NAME(StreamTagEnum, 9, Reserved3, kReserved3, "Reserved for other devices");
   ENUM_DEF_ENTRY_WITH_NAME(StreamTagEnum, 10, Reserved4, kReserved4, "Reserved for other devices");
@@ -93,6 +93,9 @@ class Stream final {
 
   static std::shared_ptr<Stream> Get(const Device& dev, int tag_idx, int index);
 
+  /*! \brief Create a stream owned by the caller instead of the stream pool. */
+  static std::shared_ptr<Stream> Create(const Device& dev);
+
   void Wait() const;
 
  private:
@@ -0,0 +1,94 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file tcp_communicator.h
+ * \brief TCP socket Communicator for CPU clusters.
+ */
+#pragma once
+#include <functional>
+#include <memory>
+#include <vector>
+#include "raf/cpu_communicator.h"
+
+namespace raf {
+namespace distributed {
+namespace communicator {
+
+struct TcpMesh;
+
+/*!
+ * \brief A communicator of the processes on any hosts, which exchange data over TCP sockets. The
+ * ranks find each other once per process through a rendezvous, which is either the store of rank 0
+ * at RAF_TCP_ADDR ("host:port") or the files in RAF_TCP_RENDEZVOUS_DIR, and connect to each other.
+ * The sub-communicators share these connections.
+ *
+ * AllReduce and ReduceScatter pick their algorithm per call from the message size and the topology
+ * with the CollectivePlanner: AllReduce runs a ring (a ring reduce-scatter followed by a ring
+ * allgather), a binomial tree, or a hierarchy of intra-host trees around an inter-host allreduce,
+ * and ReduceScatter runs a ring or halves recursively. AllGather is a ring, and Broadcast is a
+ * binomial tree. The data move in chunks, so a rank reduces or forwards a chunk while the next one
+ * is on the wire.
+ */
+class TcpCommunicatorObj final : public CPUCommunicatorObj {
+ public:
+  Communicator parent_comm;  // Prevent the global communicator from releasing in advance
+  std::shared_ptr<TcpMesh> mesh;
+  /*! \brief The socket to each rank of the group, which is -1 for this rank. */
+  std::vector<int> sockets;
+  std::vector<uint8_t> workspace;
+  /*! \brief The ranks on the host of this rank, and the ranks of its local rank on every host. */
+  Communicator intra_host, inter_host;
+
+  void AllReduce(const void* send, void* recv, int64_t count, DType dtype,
+                 CPUReduceOp op) override;
+  void AllGather(const void* send, void* recv, int64_t bytes) override;
+  void ReduceScatter(const void* send, void* recv, int64_t count, DType dtype,
+                     CPUReduceOp op) override;
+  void Broadcast(const void* send, void* recv, int64_t bytes, int root) override;
+  void AllToAll(const void* send, void* recv, int64_t bytes) override;
+  void Send(const void* data, int64_t bytes, int peer) override;
+  void Recv(void* data, int64_t bytes, int peer) override;
+  void Barrier() override;
+
+  /*! \brief Run the given algorithm in place. All the ranks must pass the same algorithm. */
+  void AllReduce(uint8_t* data, int64_t count, DType dtype, CPUReduceOp op, CollectiveAlgo algo);
+  void ReduceScatter(const void* send, void* recv, int64_t count, DType dtype, CPUReduceOp op,
+                     CollectiveAlgo algo);
+  /*! \brief The algorithms that apply to this group. */
+  std::vector<CollectiveAlgo> AllReduceAlgos() const;
+  std::vector<CollectiveAlgo> ReduceScatterAlgos() const;
+  int NumHosts() const;
+
+  void RingAllReduce(uint8_t* data, int64_t count, DType dtype, CPUReduceOp op);
+  void HierarchicalAllReduce(uint8_t* data, int64_t count, DType dtype, CPUReduceOp op);
+  /*! \brief Reduce data into the root with a binomial tree, which leaves avg undivided. */
+  void TreeReduce(uint8_t* data, int64_t count, DType dtype, CPUReduceOp op, int root);
+  /*!
+   * \brief Reduce the blocks of data, whose element offsets are offsets, in a ring. At step s, this
+   * rank sends the block (rank - s + shift) to the next rank and reduces the block
+   * (rank - s - 1 + shift) from the previous one, so it ends up with the block (rank + 1 + shift).
+   * scratch holds the largest block.
+   */
+  void RingReduceScatter(uint8_t* data, const std::vector<int64_t>& offsets, DType dtype,
+                         CPUReduceOp op, int shift, uint8_t* scratch);
+  /*! \brief The buffer of at least bytes, which grows on demand. */
+  uint8_t* Workspace(int64_t bytes);
+  /*! \brief The sub-communicator of the ranks that satisfy pred, which is cached in cache. */
+  TcpCommunicatorObj* Subgroup(Communicator* cache, const std::function<bool(int)>& pred);
+
+  static constexpr const char* _type_key = "raf.distributed.TcpCommunicator";
+  RAF_FINAL_OBJECT(TcpCommunicatorObj, CPUCommunicatorObj);
+};
+
+class TcpCommunicator final : public CPUCommunicator {
+ public:
+  static TcpCommunicator make(Value rank_list);
+  RAF_MUTABLE_OBJECT_REF(TcpCommunicator, CPUCommunicator, TcpCommunicatorObj);
+};
+
+}  // namespace communicator
+}  // namespace distributed
+}  // namespace raf
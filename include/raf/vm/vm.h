@@ -9,7 +9,9 @@
  */
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -110,6 +112,33 @@ struct VMFrame {
   }
 };
 
+/*!
+ * \brief The operands of an InvokeJit instruction in a context. They are kept across the
+ * executions of the instruction, so that preparing its OpEnv on an inline cache hit does not
+ * allocate memory.
+ */
+struct InvokeJitOperands {
+  /*! \brief The inputs of the OpEnv. */
+  std::vector<Value> inputs;
+  /*! \brief The output. It is a tuple if the instruction has multiple outputs. */
+  Value output;
+  /*! \brief The resolved OpEnv. It points into the inline cache entry on a hit. */
+  const OpEnvPtr* op_env{nullptr};
+  /*! \brief The key of the OpEnv in the OpEnvCache. It points like op_env. */
+  const std::shared_ptr<const std::string>* op_env_cache_key{nullptr};
+  /*! \brief The OpEnv resolved on an inline cache miss. */
+  OpEnvPtr miss_op_env;
+  /*! \brief The key of the OpEnv resolved on an inline cache miss. */
+  std::shared_ptr<const std::string> miss_op_env_cache_key;
+  /*! \brief The shared OpEnv that context_op_env is created for. */
+  const OpEnv* shared_op_env{nullptr};
+  /*!
+   * \brief The instance of the OpEnv owned by the context, which is used instead of the shared
+   * one if it requests workspace. It is nullptr otherwise.
+   */
+  OpEnvPtr context_op_env;
+};
+
 /*!
  * \brief VMContextObj holds the runtime data for an execution in the VM.
  */
@@ -143,6 +172,13 @@ class VMContextObj : public ValueObj {
   Index current_device_id{0};
   /*! \brief The index of current working stream into cuda_streams. 0 indicates default stream. */
   Index current_stream_id{0};
+  /*!
+   * \brief Whether the kernels on CPU are launched to CPU streams. It is set once the schedule
+   * switches the working stream, and is reset at the beginning of each run.
+   */
+  bool use_cpu_streams{false};
+  /*! \brief The operands of the InvokeJit instructions, indexed by function and pc. */
+  std::vector<std::vector<InvokeJitOperands>> invoke_jit_operands;
 
   void VisitAttrs(tvm::AttrVisitor* v) {
     v->Visit("func_index", &func_index);
@@ -159,7 +195,8 @@ class VMContextObj : public ValueObj {
  * \brief VMContext is the wrapper for the VMContextObj and provides additional
  *   APIs to access and update the runtime context.
  *
- * The APIs in the VMContext are NOT thread safe.
+ * The APIs in the VMContext are NOT thread safe. To execute concurrently, each thread
+ * should run its own context, e.g., acquired from VirtualMachine::AcquireVMContext.
  */
 class VMContext : public Value {
  public:
@@ -212,9 +249,70 @@ class VMContext : public Value {
 
 using OpEnvCache = MetaCache<OpEnvPtr>;
 
-/*! \brief The OpEnv cache for a VM function. */
+/*!
+ * \brief A compact signature of the shapes and dtypes of the non-constant inputs and the outputs
+ * of an InvokeJit instruction. It has a fixed size so that building and comparing it never
+ * allocates memory.
+ */
+struct OpEnvSignature {
+  /*! \brief The maximum number of words in a signature. */
+  static constexpr int kMaxWords = 64;
+  /*! \brief The number of used words, or -1 if the signature does not fit. */
+  int size{0};
+  /*! \brief The signature words. */
+  int64_t words[kMaxWords];
+
+  /*! \brief Append a word to the signature. Return false if it overflows. */
+  inline bool Append(int64_t word) {
+    if (size < 0 || size >= kMaxWords) {
+      size = -1;
+      return false;
+    }
+    words[size++] = word;
+    return true;
+  }
+
+  inline bool operator==(const OpEnvSignature& other) const {
+    if (size != other.size) {
+      return false;
+    }
+    for (int i = 0; i < size; ++i) {
+      if (words[i] != other.words[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+/*! \brief An entry in the per-instruction inline cache. */
+struct InlineCacheEntry {
+  /*! \brief The signature of the call that resolved this entry. */
+  OpEnvSignature signature;
+  /*! \brief The resolved OpEnv. */
+  OpEnvPtr op_env;
+  /*!
+   * \brief The key of the OpEnv in the string-keyed OpEnvCache. It is shared so that a hit does
+   * not copy the string.
+   */
+  std::shared_ptr<const std::string> key;
+};
+
+/*!
+ * \brief The OpEnv cache for a VM function.
+ *
+ * Each instruction has a monomorphic inline cache that remembers the signature and OpEnv of the
+ * last resolved call. Looking it up takes no lock. The string-keyed OpEnvCache is only used on
+ * an inline cache miss.
+ */
 class VMFuncOpEnvCache {
  public:
+  /*!
+   * \brief Create the cache for a VM function.
+   * \param num_instructions The number of instructions in the function.
+   */
+  explicit VMFuncOpEnvCache(size_t num_instructions = 0);
+
   /*!
    * \brief Get the OpEnv cache for a given instruction.
    * \param pc The program counter
@@ -223,17 +321,65 @@ class VMFuncOpEnvCache {
   std::shared_ptr<OpEnvCache> Get(Index pc);
 
   /*!
-   * \brief Clear the OpEnv cache.
+   * \brief Look up the inline cache of a given instruction.
+   * \param pc The program counter.
+   * \param signature The signature of the current call.
+   * \return The cached entry, or nullptr if the signature does not match.
+   */
+  inline const InlineCacheEntry* LookupInlineCache(Index pc,
+                                                   const OpEnvSignature& signature) const {
+    if (static_cast<size_t>(pc) >= num_instructions_) {
+      return nullptr;
+    }
+    const InlineCacheEntry* entry = inline_cache_[pc].load(std::memory_order_acquire);
+    if (entry != nullptr && entry->signature == signature) {
+      return entry;
+    }
+    return nullptr;
+  }
+
+  /*!
+   * \brief Update the inline cache of a given instruction after a miss.
+   * \param pc The program counter.
+   * \param signature The signature of the current call.
+   * \param op_env The resolved OpEnv.
+   * \param key The key of the OpEnv in the string-keyed cache.
+   */
+  void UpdateInlineCache(Index pc, const OpEnvSignature& signature, const OpEnvPtr& op_env,
+                         const std::shared_ptr<const std::string>& key);
+
+  /*!
+   * \brief Clear the OpEnv cache. This must not be called when the VM is running.
    */
   void Clear();
 
+  /*!
+   * \brief The maximum number of times an inline cache slot can be updated. After that, the
+   * instruction is treated as polymorphic and only uses the string-keyed cache.
+   */
+  static constexpr int kMaxInlineCacheUpdates = 4;
+
  private:
   /*! \brief Cache map from instruction index to OpEnv cache. */
   std::unordered_map<Index, std::shared_ptr<OpEnvCache>> cache_map_;
-  /*! \brief The mutex for the cache_map_. */
+  /*! \brief The number of instructions in the function. */
+  size_t num_instructions_;
+  /*! \brief The inline cache slot of each instruction. */
+  std::unique_ptr<std::atomic<const InlineCacheEntry*>[]> inline_cache_;
+  /*! \brief The number of updates of each inline cache slot. */
+  std::vector<int> inline_cache_updates_;
+  /*!
+   * \brief All installed inline cache entries. Replaced entries are kept alive, because other
+   * threads may still be reading them.
+   */
+  std::vector<std::unique_ptr<InlineCacheEntry>> inline_cache_entries_;
+  /*! \brief The mutex for the cache_map_ and the inline cache updates. */
   std::mutex mu_;
 };
 
+/*! \brief The thread pool that builds the OpEnvs of a VM in the background. */
+class CompileService;
+
 /*!
  * \brief The virtual machine.
  *
@@ -244,11 +390,19 @@ class VMFuncOpEnvCache {
  * enabling one to easily pass around VMs, execute them on
  * multiple threads, or serialize them to disk or over the
  * wire.
+ *
+ * Multiple threads can run the VM concurrently as long as each of them
+ * runs its own VMContext. OpEnvs, the constant pool and the memory pool
+ * are shared by all contexts. Concurrent execution is not supported in
+ * CUDA graph mode or when the profiler is enabled.
  */
 class VirtualMachine : public tvm::runtime::ModuleNode {
  public:
-  VirtualMachine(bool enable_cuda_graph, bool dryrun)
-      : exec_(nullptr), dryrun_(dryrun), enable_cuda_graph_(enable_cuda_graph) {
+  VirtualMachine(bool enable_cuda_graph, bool dryrun, bool enable_inline_cache = true)
+      : exec_(nullptr),
+        dryrun_(dryrun),
+        enable_cuda_graph_(enable_cuda_graph),
+        enable_inline_cache_(enable_inline_cache) {
 #ifndef RAF_USE_CUDA
     if (enable_cuda_graph) {
       LOG(WARNING) << "Because CUDA is not enabled in RAF, CUDA graph will be disabled in the VM.";
@@ -292,6 +446,14 @@ class VirtualMachine : public tvm::runtime::ModuleNode {
    * \param devices The set of devices.
    */
   void SetDevices(const std::vector<Device>& devices);
+  /*!
+   * \brief Compile the kernels of the InvokeJit instructions whose shapes are statically known on
+   * a pool of background threads, and add their OpEnvs to the OpEnv cache. A run that reaches such
+   * an instruction before its kernel is built waits for the compilation instead of starting
+   * another one.
+   * \param num_threads The number of compile threads.
+   */
+  void Precompile(int num_threads);
   /*!
    * \brief Prepare a VM runtime context.
    * \param func_name The entry function name.
@@ -299,12 +461,36 @@ class VirtualMachine : public tvm::runtime::ModuleNode {
    * \return The VM context.
    */
   VMContext PrepareVMContext(const std::string& func_name, const std::vector<Value>& inputs);
+  /*!
+   * \brief Acquire a VM runtime context from the context pool. A released context of the same
+   * function is reused if available, otherwise a new context is prepared.
+   * \param func_name The entry function name.
+   * \param inputs The inputs to the function.
+   * \return The VM context, which should be returned by ReleaseVMContext after the run.
+   */
+  VMContext AcquireVMContext(const std::string& func_name, const std::vector<Value>& inputs);
+  /*!
+   * \brief Return a VM runtime context to the context pool.
+   * \param ctx The runtime context.
+   */
+  void ReleaseVMContext(VMContext ctx);
   /*!
    * \brief Run the virtual machine.
    * \param ctx The runtime context.
    * \return The return value.
    */
   Value Run(VMContext ctx);
+  /*!
+   * \brief Measure the throughput of concurrent execution. Each of the worker threads
+   * repeatedly acquires a context from the context pool, runs it and releases it.
+   * \param func_name The entry function name.
+   * \param inputs The inputs to the function.
+   * \param num_threads The number of worker threads.
+   * \param number The number of requests each thread runs.
+   * \return The throughput in requests per second.
+   */
+  double ProfileThroughput(const std::string& func_name, const std::vector<Value>& inputs,
+                           int num_threads, int number);
   /*!
    * \brief Profile the end-to-end execution latency using virtual machine.
 
@@ -350,11 +536,74 @@ class VirtualMachine : public tvm::runtime::ModuleNode {
   inline std::shared_ptr<Memory> Alloc(const VMContext& ctx, Device dev, int64_t nbytes,
                                        int64_t alignment = kDefaultMemoryAlignment,
                                        bool alloc_async = true) const;
+  /*!
+   * \brief Allocate the workspace requested by an OpEnv. An OpEnv that requests workspace is
+   * owned by a context, so contexts do not wait for each other.
+   * \param ctx The VM context.
+   * \param op_env The OpEnv.
+   */
+  void AllocWorkspace(const VMContext& ctx, const OpEnvPtr& op_env) const;
+  /*!
+   * \brief Release the workspace requested by an OpEnv.
+   * \param op_env The OpEnv.
+   */
+  void ReleaseWorkspace(const OpEnvPtr& op_env) const;
+  /*!
+   * \brief Launch an OpEnv to the current CPU stream of the context. The OpEnv is executed
+   * asynchronously by the worker thread of the stream.
+   * \param ctx The VM context.
+   * \param op_env The OpEnv.
+   * \param inputs The inputs of the OpEnv.
+   * \param output The output of the OpEnv.
+   * \param op_env_cache_key The key of the OpEnv in the cache, which annotates the profile.
+   */
+  void LaunchOnCPUStream(const VMContext& ctx, const OpEnvPtr& op_env,
+                         const std::vector<Value>& inputs, const Value& output,
+                         const std::shared_ptr<const std::string>& op_env_cache_key);
   /*! \brief Run VM dispatch loop. */
   virtual void RunLoop(VMContext& ctx);
-  /*! \brief Prepare an OpEnv with its inputs and output */
-  virtual std::tuple<OpEnvPtr, std::vector<Value>, Value, std::string> PrepareOpEnv(
-      const VMContext& ctx, const Instruction& instr);
+  /*!
+   * \brief Prepare an OpEnv with its inputs and output in the operands of the instruction. On an
+   * inline cache hit, the operands point into the cache entry and reuse their storage.
+   * \param ctx The VM context.
+   * \param instr The InvokeJit instruction.
+   * \return The operands, which must be released by ReleaseOperands after the execution.
+   */
+  virtual InvokeJitOperands& PrepareOpEnv(VMContext& ctx, const Instruction& instr);
+  /*!
+   * \brief Release the values held by the operands of an instruction, so that the Free
+   * instruction can release their memory. The storage is kept for the next execution.
+   * \param operands The operands.
+   */
+  void ReleaseOperands(InvokeJitOperands* operands) const;
+  /*!
+   * \brief Resolve the OpEnv through the string-keyed OpEnvCache, and create it on a cache miss.
+   * \param ctx The VM context.
+   * \param instr The InvokeJit instruction.
+   * \param args The input arguments.
+   * \param output The output value.
+   * \param op_env_cache_key The key of the OpEnv in the cache.
+   * \return The OpEnv.
+   */
+  OpEnvPtr PrepareOpEnvSlow(const VMContext& ctx, const Instruction& instr,
+                            const Array<Value>& args, const Value& output,
+                            std::string* op_env_cache_key);
+  /*!
+   * \brief Dispatch a new OpEnv for an InvokeJit instruction and prepare its requests.
+   * \param ctx The VM context.
+   * \param instr The InvokeJit instruction.
+   * \param args The input arguments.
+   * \param output The output value.
+   * \return The OpEnv.
+   */
+  OpEnvPtr CreateOpEnv(const VMContext& ctx, const Instruction& instr, const Array<Value>& args,
+                       const Value& output);
+  /*!
+   * \brief Get a constant on the device, which is copied when it is first loaded.
+   * \param const_index The index of the constant.
+   * \return The constant.
+   */
+  const Value& GetConstant(Index const_index);
   /*! \brief Handle Move instruction*/
   virtual void HandleMove(VMContext& ctx, const Instruction& instr);
   /*! \brief Handle LoadConst instruction*/
@@ -412,6 +661,15 @@ class VirtualMachine : public tvm::runtime::ModuleNode {
    * object to avoid rellocation of constants during inference.
    */
   std::vector<Value> const_pool_;
+  /*! \brief The flags to copy each constant to the device once. */
+  std::unique_ptr<std::once_flag[]> const_pool_once_;
+  /*!
+   * \brief Released contexts that can be reused. It maps from the entry function index to the
+   * contexts of that function.
+   */
+  std::unordered_map<Index, std::vector<VMContext>> context_pool_;
+  /*! \brief The mutex for the context_pool_. */
+  std::mutex context_pool_mu_;
   /*!
    * \brief OpEnv cache. Each element in the vector stores the cache for the
    * corresponding VM function. It's a map from pc to the OpEnv cache.
@@ -423,6 +681,10 @@ class VirtualMachine : public tvm::runtime::ModuleNode {
   bool use_cuda_ = false;
   /*! \brief Indicates whether CUDA Graph is enabled when VM is initialized. */
   bool enable_cuda_graph_ = false;
+  /*! \brief Indicates whether to use the per-instruction OpEnv inline cache. */
+  bool enable_inline_cache_ = true;
+  /*! \brief The background compilation started by Precompile. */
+  std::shared_ptr<CompileService> compile_service_;
 
 #ifdef RAF_USE_CUDA
   /*!
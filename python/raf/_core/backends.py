@@ -24,3 +24,21 @@ class CUDNNConfig:  # pylint: disable=too-few-public-methods
 
 
 cudnn = CUDNNConfig()
+
+
+class CPUConfig:  # pylint: disable=too-few-public-methods
+    """Native CPU dialect configuration."""
+
+    @property
+    def isa(self):
+        """Get the instruction set used by the CPU kernels. One of scalar, sse4.1, avx2 and
+        avx512."""
+        return _ffi.backend.cpu.GetISA()
+
+    @isa.setter
+    def isa(self, isa):
+        """Set the instruction set. It is capped by what the host supports."""
+        _ffi.backend.cpu.SetISA(isa)
+
+
+cpu = CPUConfig()
@@ -31,6 +31,18 @@ def interpret(expr, module=None):
     return _ffi.executor.Interpret(expr, module)
 
 
+def set_interpreter_sync(sync):
+    """Set whether the interpreter of the calling thread waits for each primitive op to finish.
+    Disabling the synchronization lets eager ops be launched back to back.
+
+    Parameters
+    ----------
+    sync : bool
+        Whether to synchronize after each primitive op. The default is True.
+    """
+    _ffi.executor.SetInterpreterSync(sync)
+
+
 class MetaFallbackContext(ApplyHistoryBest):
     """
     The RAF fallback dispatch context, which queries the builtin schedules and outputs
@@ -119,9 +131,23 @@ class VMExecutor:
 
     dryrun: bool
         Whether to create a dryrun VM that skips the op execution.
+
+    enable_inline_cache: bool
+        Whether to enable the per-instruction OpEnv inline cache in the VM.
+
+    num_compile_threads: int
+        The number of threads to compile the kernels in the background when the VM is created.
     """
 
-    def __init__(self, mod, device, enable_cuda_graph=False, dryrun=False):
+    def __init__(
+        self,
+        mod,
+        device,
+        enable_cuda_graph=False,
+        dryrun=False,
+        enable_inline_cache=True,
+        num_compile_threads=0,
+    ):
         if mod is None:
             raise RuntimeError("Must provide module to get VM executor.")
         if "gpu" not in device and "cuda" not in device:
@@ -129,7 +155,12 @@ class VMExecutor:
         self.device = Device(device)
         self.executable = vm.compile(mod, self.device)
         self.vm = vm.VirtualMachine(
-            self.executable, self.device, enable_cuda_graph=enable_cuda_graph, dryrun=dryrun
+            self.executable,
+            self.device,
+            enable_cuda_graph=enable_cuda_graph,
+            dryrun=dryrun,
+            enable_inline_cache=enable_inline_cache,
+            num_compile_threads=num_compile_threads,
         )
 
     @staticmethod
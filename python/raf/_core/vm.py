@@ -436,20 +436,41 @@ class VirtualMachine:
 
     dryrun: bool
         Whether to create a dryrun VM that skips the op execution.
+
+    enable_inline_cache: bool
+        Whether to cache the OpEnv of the last call at each instruction, which skips the OpEnv
+        cache lookup when shapes do not change.
+
+    num_compile_threads: int
+        The number of background threads that compile the kernels with static shapes once the
+        VM is created. 0 disables the background compilation.
     """
 
-    def __init__(self, exe, device, enable_cuda_graph=False, dryrun=False):
+    def __init__(
+        self,
+        exe,
+        device,
+        enable_cuda_graph=False,
+        dryrun=False,
+        enable_inline_cache=True,
+        num_compile_threads=0,
+    ):
         if not isinstance(exe, Executable):
             raise TypeError(
                 "mod is expected to be the type of Executable, but received {}".format(type(exe))
             )
-        self.module = _ffi.vm.VirtualMachine(exe.module, enable_cuda_graph, dryrun)
+        self.module = _ffi.vm.VirtualMachine(
+            exe.module, enable_cuda_graph, dryrun, enable_inline_cache
+        )
         self._exec = exe
         self._set_devices = self.module["set_devices"]
         self._prepare_context = self.module["prepare_context"]
         self._run = self.module["run"]
         self._profile = self.module["profile"]
+        self._profile_throughput = self.module["profile_throughput"]
         self._set_devices(device)
+        if num_compile_threads > 0:
+            self.module["precompile"](num_compile_threads)
 
     def prepare_context(self, func_name, *args, **kwargs):
         """Create and initiliaze a VM Context given the name of function to invoke and arguments.
@@ -543,3 +564,31 @@ class VirtualMachine:
         ctx = self.prepare_context(func_name, *args, **kwargs)
         result = [v.value for v in self._profile(ctx, warmup, number, repeat)]
         return result
+
+    def profile_throughput(self, *args, func_name="main", num_threads=1, number=10):
+        """Measure the throughput of the virtual machine under concurrent execution.
+
+        Each of the `num_threads` worker threads runs the function `number` times with its own
+        VM context. The contexts are reused through the context pool of the virtual machine.
+
+        Parameters
+        ----------
+        args : list[raf.ndarray] or list[np.ndarray]
+            The arguments to the function.
+
+        func_name : str
+            The name of function to run.
+
+        num_threads : int
+            The number of worker threads. Default 1.
+
+        number : int
+            The number of runs of each worker thread. Default 10.
+
+        Returns
+        -------
+        result : float
+            The throughput in requests per second.
+        """
+        cargs = _convert_args(args)
+        return self._profile_throughput(func_name, num_threads, number, *cargs)
@@ -2,7 +2,7 @@
 # SPDX-License-Identifier: Apache-2.0
 
 """Utils for distributed training, e.g., collective communication operators."""
-from raf._ffi.distributed import RemoveCommunicator
+from raf._ffi.distributed import RemoveCommunicator, ResetGradCompression
 from .op import (
     allreduce,
     allgather,
@@ -17,3 +17,4 @@ from .op import (
 )
 from .config import DistConfig, get_config
 from .communicator import get_communicator, set_default_communicator
+from .moe import expert_capacity, moe_layer
@@ -21,6 +21,21 @@ if with_mpi():
         pass
 
 
+@register_node("raf.distributed.CPUCommunicator")
+class CPUCommunicator(Communicator):
+    pass
+
+
+@register_node("raf.distributed.ShmCommunicator")
+class ShmCommunicator(CPUCommunicator):
+    pass
+
+
+@register_node("raf.distributed.TcpCommunicator")
+class TcpCommunicator(CPUCommunicator):
+    pass
+
+
 @register_node("raf.distributed.VoidCommunicator")
 class VoidCommunicator(Communicator):
     @property
@@ -55,6 +55,42 @@ class DistConfig(Object):
         self.auto_dp_profiling_end_iter_ = value
         ffi.AutoDPProfilingEndIter(value)
 
+    @property
+    def group_bucket_size(self):
+        return self.group_bucket_size_
+
+    @group_bucket_size.setter
+    def group_bucket_size(self, value):
+        self.group_bucket_size_ = value
+        ffi.GroupBucketSize(value)
+
+    @property
+    def grad_compression(self):
+        return self.grad_compression_
+
+    @grad_compression.setter
+    def grad_compression(self, value):
+        self.grad_compression_ = value
+        ffi.GradCompression(value)
+
+    @property
+    def grad_compression_topk_ratio(self):
+        return self.grad_compression_topk_ratio_
+
+    @grad_compression_topk_ratio.setter
+    def grad_compression_topk_ratio(self, value):
+        self.grad_compression_topk_ratio_ = value
+        ffi.GradCompressionTopKRatio(value)
+
+    @property
+    def grad_compression_powersgd_rank(self):
+        return self.grad_compression_powersgd_rank_
+
+    @grad_compression_powersgd_rank.setter
+    def grad_compression_powersgd_rank(self, value):
+        self.grad_compression_powersgd_rank_ = value
+        ffi.GradCompressionPowerSGDRank(value)
+
     def dumps(self):
         attr_keys = [
             "enable_data_parallel",
@@ -62,6 +98,10 @@ class DistConfig(Object):
             "enable_auto_dp_profiling",
             "auto_dp_profiling_start_iter",
             "auto_dp_profiling_end_iter",
+            "group_bucket_size",
+            "grad_compression",
+            "grad_compression_topk_ratio",
+            "grad_compression_powersgd_rank",
         ]
         return {attr: getattr(self, attr) for attr in attr_keys}
 
@@ -0,0 +1,88 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# pylint: disable=protected-access, too-many-arguments
+"""Expert-parallel mixture-of-experts layers. The experts are evenly partitioned across the ranks
+of the global communicator. Each token is routed to the experts of its top-k gate probabilities,
+and an expert processes at most `capacity` tokens from each rank; the overflowing tokens are
+dropped and contribute zeros. The tokens are packed per expert with `_moe_dispatch`, exchanged
+with `_all_to_all` so that each rank receives the tokens of its local experts from all the ranks,
+and sent back and unpacked with `_moe_combine` after the experts.
+"""
+import math
+
+from .._op import sym
+from .communicator import get_communicator
+
+
+def expert_capacity(num_tokens, num_experts, k=1, capacity_factor=1.0):
+    """The number of tokens an expert accepts from a rank, such that the experts have room for
+    capacity_factor times the tokens if the routing is balanced."""
+    return max(1, int(math.ceil(k * num_tokens * capacity_factor / num_experts)))
+
+
+def moe_layer(x, gate_logits, expert_fn, num_experts, capacity, k=1):
+    """Apply a mixture-of-experts layer in a traced forward.
+
+    Parameters
+    ----------
+    x: Tensor
+        The tokens of this rank, in the shape of (tokens, hidden).
+
+    gate_logits: Tensor
+        The gate logits of the tokens, in the shape of (tokens, num_experts).
+
+    expert_fn: Callable[[Tensor], Tensor]
+        Apply the local experts of this rank. It takes the tokens of shape
+        (local experts, size * capacity, hidden), where size is the number of ranks, and returns
+        the outputs of shape (local experts, size * capacity, output hidden). The local experts
+        of rank r are the experts [r * local experts, (r + 1) * local experts).
+
+    num_experts: int
+        The total number of experts, which must be divisible by the number of ranks.
+
+    capacity: int
+        The number of tokens an expert accepts from each rank.
+
+    k: int
+        The number of experts of each token.
+
+    Returns
+    -------
+    ret: Tensor
+        The sum of the outputs of the chosen experts weighted by their gate probabilities, in the
+        shape of (tokens, output hidden).
+    """
+    size = get_communicator().size
+    assert num_experts % size == 0, "%d experts cannot be evenly partitioned across %d ranks" % (
+        num_experts,
+        size,
+    )
+    num_local_experts = num_experts // size
+
+    # The routing is not differentiable, but the gates are gathered from the probabilities so that
+    # the gate logits receive the gradient.
+    probs = sym.softmax(gate_logits, axis=-1)
+    routing = sym._moe_gate(probs, capacity, k)
+    indices, locations = routing[0], routing[1]
+    gates = sym.gather(probs, 1, indices)
+
+    # (experts, capacity, hidden) -> (local experts, size * capacity, hidden)
+    buf = sym._moe_dispatch(x, indices, locations, num_experts, capacity)
+    buf = sym._all_to_all(buf)
+    buf = sym.reshape(buf, (size, num_local_experts, capacity, -1))
+    buf = sym.transpose(buf, (1, 0, 2, 3))
+    buf = sym.reshape(buf, (num_local_experts, size * capacity, -1))
+
+    out = expert_fn(buf)
+
+    # (local experts, size * capacity, output hidden) -> (experts, capacity, output hidden)
+    out = sym.reshape(out, (num_local_experts, size, capacity, -1))
+    out = sym.transpose(out, (1, 0, 2, 3))
+    out = sym.reshape(out, (num_experts, capacity, -1))
+    out = sym._all_to_all(out)
+
+    # (tokens, k, output hidden) weighted by the gates of (tokens, k, 1)
+    out = sym._moe_combine(out, indices, locations)
+    out = sym.multiply(out, sym.expand_dims(gates, axis=-1))
+    return sym.sum(out, axis=1)
@@ -0,0 +1,205 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# pylint: disable=protected-access
+"""Pipeline-parallel training. The model is cut into as many stages as the ranks of the
+communicator with balanced cost (estimated FLOPS or profiled latency), and each rank runs one
+stage. The stages pass the activations forward and their gradients backward with send/recv.
+
+The micro-batches are scheduled in the 1F1B order (https://arxiv.org/abs/1806.03377): a stage
+first runs the forwards of (number of stages - stage - 1) micro-batches, and then alternates
+between the forward of a new micro-batch and the backward of the oldest one. The forward of a
+stage only keeps the activations used by its backward (i.e., the stash), so that at most
+(number of stages - stage) stashes are alive at a time.
+
+On each link between two adjacent stages, the lower stage sends before it receives and the upper
+stage receives before it sends, so that the blocking send/recv of the CPU communicators never
+deadlock.
+"""
+from collections import deque
+import numpy as np
+
+from raf._core.device import Device
+from raf._core.executor import VMExecutor
+from raf._core.ndarray import ndarray
+from raf._core.value import TensorValue, TupleValue
+from raf._ffi.pass_ import AutoDiff, DeadCodeElimination, FoldConstant, InferType
+from raf._ffi.pass_ import InlineBackward, PipelineStage, SplitForwardBackward
+from raf._op import imp
+from raf.ir import IRModule, RAFSequential
+from raf.model.trace import _get_func_inputs
+from .communicator import get_communicator
+
+
+def _to_ndarray(value):
+    if isinstance(value, TupleValue):
+        return [_to_ndarray(value[i]) for i in range(len(value))]
+    return ndarray.from_tensor_value(value)
+
+
+def _shape_dtype(ty):
+    return [int(dim) for dim in ty.shape], ty.dtype
+
+
+class PipelineParallel:
+    """Train a model with pipeline parallelism. Every rank creates this object with the same
+    model and calls it with the same micro-batches, and each rank runs the stage of its rank.
+
+    Parameters
+    ----------
+    model: Model
+        The model that outputs a loss tensor.
+
+    num_micro_batches: int
+        The number of micro-batches per step.
+
+    device: str
+        The device to run the stage.
+
+    use_profiler: bool
+        Whether to balance the stages by the profiled latency instead of the estimated FLOPS.
+    """
+
+    def __init__(self, model, num_micro_batches, device="cpu", use_profiler=False):
+        comm = get_communicator()
+        self.model = model
+        self.num_micro_batches = num_micro_batches
+        self.device = device
+        self.use_profiler = use_profiler
+        self.num_stages = comm.size
+        self.stage = comm.rank
+        self._record = None
+        self._fwd, self._bwd = None, None
+        self._param_names, self._param_index, self._requires_grads = [], [], []
+        self._recv_types, self._grad_types = [], []
+
+    def _build(self, args):
+        self._record = self.model._internal(*args)
+        mod = self._record.mod
+        inputs = _get_func_inputs(self._record, args, {}, get_handle=False)
+        index = {param.name_hint: i for i, param in enumerate(mod["main"].params)}
+        with Device(self.device):
+            mod = PipelineStage(self.num_stages, self.stage, self.use_profiler)(mod)
+        func = mod["main"]
+        num_inputs = int(func.attrs["PipelineInputs"])
+        self._param_names = [param.name_hint for param in func.params[num_inputs:]]
+        self._param_index = [index[name] for name in self._param_names]
+        self._recv_types = [_shape_dtype(param.checked_type) for param in func.params[:num_inputs]]
+        if self.stage < self.num_stages - 1:
+            self._grad_types = [_shape_dtype(ty) for ty in func.checked_type.ret_type.fields]
+        # The tensors received from the previous stage always require gradients.
+        requires_grads = [True] * num_inputs
+        requires_grads += [inputs[i].requires_grad for i in self._param_index]
+        self._requires_grads = requires_grads
+        seq = RAFSequential(
+            [
+                InferType(),
+                AutoDiff(requires_grads),
+                InferType(),
+                FoldConstant(),
+                DeadCodeElimination(),
+                InlineBackward(),
+                InferType(),
+            ],
+            name="pipeline_autodiff",
+        )
+        fwd, bwd = SplitForwardBackward(seq(mod)["main"])
+        self._fwd = VMExecutor(IRModule.from_expr(fwd), self.device).make_executor()
+        self._bwd = VMExecutor(IRModule.from_expr(bwd), self.device).make_executor()
+
+    def _recv_forward(self):
+        if self.stage == 0:
+            return []
+        peer = self.stage - 1
+        return [imp._recv(peer, shape, dtype) for shape, dtype in self._recv_types]
+
+    def _send_forward(self, outs):
+        if self.stage == self.num_stages - 1:
+            return
+        for out in outs:
+            imp._send(out, self.stage + 1)
+
+    def _recv_backward(self, outs):
+        if self.stage == self.num_stages - 1:
+            # The loss of each micro-batch contributes 1 / num_micro_batches to the mean loss.
+            return np.full(outs.shape, 1.0 / self.num_micro_batches, dtype=outs.dtype)
+        peer = self.stage + 1
+        return [imp._recv(peer, shape, dtype) for shape, dtype in self._grad_types]
+
+    def _send_backward(self, grads):
+        if self.stage == 0:
+            return
+        for grad in grads:
+            imp._send(grad, self.stage - 1)
+
+    def _forward(self, micro_batch, recvd, stashes):
+        inputs = _get_func_inputs(self._record, micro_batch, {}, get_handle=False)
+        args = recvd + [inputs[i] for i in self._param_index]
+        out = self._fwd(*args)
+        stashes.append(([_to_ndarray(out[i]) for i in range(1, len(out))], args))
+        return _to_ndarray(out[0])
+
+    def _backward(self, dy, stashes, grads):
+        stash, args = stashes.popleft()
+        out = self._bwd(*stash, dy, *args)
+        out = [out[i] for i in range(len(out))] if len(args) > 1 else [out]
+        num_inputs = len(self._recv_types)
+        for name, grad, requires_grad in zip(
+            self._param_names, out[num_inputs:], self._requires_grads[num_inputs:]
+        ):
+            if not requires_grad or not isinstance(grad, TensorValue):
+                continue
+            grad = _to_ndarray(grad)
+            grads[name] = grad if name not in grads else imp.add(grads[name], grad)
+        dxs = []
+        for grad, (shape, dtype) in zip(out[:num_inputs], self._recv_types):
+            if isinstance(grad, TensorValue):
+                dxs.append(_to_ndarray(grad))
+            else:
+                dxs.append(ndarray(np.zeros(shape, dtype=dtype), device=self.device))
+        return dxs
+
+    def __call__(self, micro_batches):
+        """Run the forward and backward of the micro-batches.
+
+        Parameters
+        ----------
+        micro_batches: List[Tuple[ndarray]]
+            The inputs of the model for each micro-batch.
+
+        Returns
+        -------
+        ret: Tuple[Optional[List[ndarray]], Dict[str, ndarray]]
+            The loss of each micro-batch, which is only available at the last stage, and the
+            gradients of the parameters of this stage w.r.t. the mean loss of the micro-batches.
+        """
+        assert len(micro_batches) == self.num_micro_batches
+        if self._record is None:
+            self._build(micro_batches[0])
+        num_warmup = min(self.num_stages - self.stage - 1, self.num_micro_batches)
+        num_remaining = self.num_micro_batches - num_warmup
+        stashes = deque()
+        losses, grads = [], {}
+
+        for i in range(num_warmup):
+            outs = self._forward(micro_batches[i], self._recv_forward(), stashes)
+            self._send_forward(outs)
+
+        recvd = self._recv_forward() if num_remaining > 0 else None
+        for i in range(num_remaining):
+            outs = self._forward(micro_batches[num_warmup + i], recvd, stashes)
+            if self.stage == self.num_stages - 1:
+                losses.append(outs)
+            self._send_forward(outs)
+            dxs = self._backward(self._recv_backward(outs), stashes, grads)
+            if i == num_remaining - 1:
+                self._send_backward(dxs)
+            else:
+                recvd = self._recv_forward()
+                self._send_backward(dxs)
+
+        for _ in range(num_warmup):
+            dxs = self._backward(self._recv_backward(None), stashes, grads)
+            self._send_backward(dxs)
+
+        return (losses if self.stage == self.num_stages - 1 else None), grads
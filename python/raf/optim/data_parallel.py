@@ -12,11 +12,16 @@ The methodologies includes:
                  optimizer can have a partitioned optimizer status. Note that optimizers must
                  consider gradient partitioning if applied; otherwise the result will be incorrect.
    2.2 (ZeRO-2): Use reduce instead of all-reduce in (1) to obtain only a partition of gradients.
+   2.3 (ZeRO-3): Based on (2.2), also partition the trainable parameters. Each device only keeps
+                 a partition of every parameter, and the full parameter is all-gathered right
+                 before its use in the forward and in the backward.
 """
 from raf.ir import RAFSequential
+from raf._core.ndarray import ndarray
 from .optim import inline
+from .utils import split_ndarray_with_padding
 from .. import distributed as dist
-from .._ffi.pass_ import PartitionGradient, InferType
+from .._ffi.pass_ import PartitionGradient, PartitionParameter, InferType
 from ..model import Model, trace
 from ..model.trace import _get_func_inputs
 
@@ -37,6 +42,28 @@ def with_data_parallel(model):
             # pylint: disable=attribute-defined-outside-init, missing-function-docstring
             self.model = model
 
+            # ZeRO-3: Keep a partition of each trainable parameter. The parameters of the model
+            # are only used to trace the model from now on, so they are rebound to the partitions
+            # to release the memory of the full parameters.
+            self.shards = {}
+            self.grad_index = {}
+            dcfg = dist.get_config()
+            if dcfg.zero_opt_level > 2:
+                comm = dist.get_communicator()
+                for name, param in model.state().items():
+                    if not param.requires_grad:
+                        continue
+                    param_nd = param.to(device="cpu")
+                    shard = ndarray(
+                        split_ndarray_with_padding(param_nd, comm.size)[comm.rank],
+                        device=param.device,
+                        name=f"{name}.zero3",
+                        dtype=param.dtype,
+                    )
+                    setattr(self, f"{name}.zero3", shard)
+                    self.shards[param._ndarray__handle] = (f"{name}.zero3", shard)
+                    param.update(shard)
+
         @trace
         def forward(self, *args, **kwargs):
             # pylint: disable=protected-access, missing-function-docstring
@@ -49,17 +76,33 @@ def with_data_parallel(model):
             # so that it can be applied here.
             # if dcfg.enable_data_parallel:
             #     passes.append(AutoDataParallel())
+            inputs = _get_func_inputs(record, args, kwargs)
             if dcfg.zero_opt_level > 0:
+                # ZeRO-3 reduce-scatters each gradient right away instead of grouping them,
+                # so that the full gradient is released as soon as possible.
+                bucket_size = dcfg.group_bucket_size if dcfg.zero_opt_level < 3 else 1
                 passes = []
                 passes.append(InferType())
                 passes.append(
-                    PartitionGradient(
-                        dcfg.zero_opt_level, comm.size, comm.rank, dcfg.group_bucket_size
-                    )
+                    PartitionGradient(dcfg.zero_opt_level, comm.size, comm.rank, bucket_size)
                 )
+                if dcfg.zero_opt_level > 2:
+                    func_params = mod["main"].params
+                    names = [
+                        func_params[i].name_hint
+                        for i, arg in enumerate(inputs)
+                        if arg in self.shards
+                    ]
+                    passes.append(PartitionParameter(comm.size, names))
+                    # Feed the partitions instead of the full parameters, and record the gradient
+                    # index of each input, which excludes dy.
+                    inputs = [
+                        self.shards[arg][1]._ndarray__handle if arg in self.shards else arg
+                        for arg in inputs
+                    ]
+                    self.grad_index = {arg: i - 1 for i, arg in enumerate(inputs) if i > 0}
                 seq = RAFSequential(passes, name="with_data_parallel")
                 mod = seq(mod)
-            inputs = _get_func_inputs(record, args, kwargs)
             out = inline(mod["main"], inputs)
             y = out[0]
             dxs = out[1]
@@ -162,6 +162,7 @@ def with_lans(
 
             # pylint: disable=attribute-defined-outside-init
             def build(self, model):
+                assert dist.get_config().zero_opt_level < 3, "LANS does not support ZeRO-3 yet"
                 self.model = model
                 self.ad_model = with_data_parallel(with_autodiff(model))
                 self.bias_correction = bias_correction
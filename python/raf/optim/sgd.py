@@ -128,7 +128,24 @@ def with_sgd(learning_rate=0.1, momentum=0.01):
                         v_w = param
 
                         status_shape = param.shape
-                        if dcfg.zero_opt_level:
+                        key, attr_name = param._ndarray__handle, name
+                        if dcfg.zero_opt_level > 2:
+                            # ZeRO-3: The parameter is partitioned by the data parallel wrapper,
+                            # so the SGD weight is the partition itself, or its float32 copy.
+                            attr_name, param = self.ad_model.shards[key]
+                            key = param._ndarray__handle
+                            if "float" in param.dtype and param.dtype != "float32":
+                                v_w = ndarray(
+                                    param.to(dtype="float32"),
+                                    device=param.device,
+                                    name=f"{name}.sgd_w",
+                                    dtype="float32",
+                                )
+                                self.has_sgd_w = True
+                            else:
+                                v_w = param
+                            status_shape = param.shape
+                        elif dcfg.zero_opt_level:
                             # If optimizer status partitioning is enable, then the first axis of
                             # variant and weight is partitioned to 1/n. Accordingly, we have to
                             # also keep a param.w (size 1/n) locally.
@@ -169,7 +186,7 @@ def with_sgd(learning_rate=0.1, momentum=0.01):
                             name=f"{name}.sgd_v",
                         )
                         setattr(self, f"{name}.sgd_v", v_i)
-                        self.params[param._ndarray__handle] = (name, param, v_w, v_i)
+                        self.params[key] = (attr_name, param, v_w, v_i)
 
                 if self.has_sgd_w:
                     # TODO(issue 758): Remove this and in-place update parameters.
@@ -184,7 +201,9 @@ def with_sgd(learning_rate=0.1, momentum=0.01):
                 dcfg = dist.get_config()
                 comm = dist.get_communicator()
                 for i, param in enumerate(inputs):
-                    dxi = dxs[i] if len(inputs) > 1 else dxs
+                    # The partitioned parameters of ZeRO-3 are not ordered as their gradients.
+                    idx = self.ad_model.grad_index.get(param, i) if dcfg.zero_opt_level > 2 else i
+                    dxi = dxs[idx] if len(inputs) > 1 else dxs
                     if param in self.params and has_grad(dxi):
                         name, weight, sgd_w, sgd_v = self.params[param]
                         assert "float" in sgd_w.dtype, "Non-float parameter is not learnable"
@@ -205,7 +224,7 @@ def with_sgd(learning_rate=0.1, momentum=0.01):
 
                         # If the SGD status is partitioned, use all-gather to sync
                         # the updated weights.
-                        if dcfg.zero_opt_level > 0:
+                        if 0 < dcfg.zero_opt_level < 3:
                             new_sgd_w = allgather(new_sgd_w, axis=0)
                             # Slice to remove the zero-padding if needed.
                             if sgd_w.shape[0] * comm.size > weight.shape[0]:
@@ -217,8 +236,11 @@ def with_sgd(learning_rate=0.1, momentum=0.01):
                         )
 
                         # Put the updated weight to the model output to avoid being dead code.
-                        param_model = get_chained_attr(self.model, name.split(".")[:-1])
-                        trace_mutate_attr(param_model, name.split(".")[-1], new_weight)
+                        if dcfg.zero_opt_level > 2:
+                            trace_mutate_attr(self.ad_model, name, new_weight)
+                        else:
+                            param_model = get_chained_attr(self.model, name.split(".")[:-1])
+                            trace_mutate_attr(param_model, name.split(".")[-1], new_weight)
                 return y
 
         return SGDWrapper(model)
@@ -0,0 +1,120 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+"""Bandwidth and latency benchmark of the CPU collectives across message sizes.
+
+The benchmark runs each collective of a CPU communicator (shm or tcp) on float32 buffers and
+reports the latency of the slowest rank, the algorithm bandwidth (the bytes of a rank over the
+latency) and the bus bandwidth (the algorithm bandwidth scaled by the bytes each link carries in
+the optimal algorithm), which is comparable across the number of ranks.
+
+With --tune PATH, the benchmark instead measures every algorithm of the planned collectives of the
+tcp communicator, and saves the table that RAF_CPU_COLLECTIVE_TABLE=PATH feeds to the planner.
+
+By default, the benchmark spawns the ranks on this host, which talk over loopback for tcp. To
+measure a cluster, launch one process per rank with --rank and --size, and point RAF_TCP_ADDR
+(or RAF_TCP_RENDEZVOUS_DIR) to the rendezvous of the job.
+
+Usage: python3 scripts/benchmark/cpu_collective_bandwidth.py [--communicator tcp] [--nproc 4]
+"""
+import argparse
+import multiprocessing as mp
+import os
+import socket
+
+COLLECTIVES = ["allreduce", "allgather", "reduce_scatter", "broadcast", "all_to_all"]
+
+
+def bus_factor(collective, size):
+    """The bytes each link carries in the optimal algorithm, relative to the bytes of a rank."""
+    if collective == "allreduce":
+        return 2.0 * (size - 1) / size
+    if collective == "broadcast":
+        return 1.0
+    return float(size - 1)
+
+
+def run(rank, size, args):
+    """Measure every collective on every message size as one rank of the job."""
+    from raf import distributed as dist
+    from raf._ffi.distributed import BenchmarkCPUCollective, TuneCPUCollectives
+
+    comm = dist.get_communicator()
+    comm.size = size
+    comm.rank = rank
+    if args.tune:
+        TuneCPUCollectives(args.tune, args.max_bytes, args.min_number)
+        if rank == 0:
+            print("Saved the collective table to %s" % args.tune)
+        return
+    collectives = args.collectives or COLLECTIVES
+    if rank == 0:
+        header = ("Collective", "Bytes", "Latency (us)", "AlgBW (GB/s)", "BusBW (GB/s)")
+        print("%-16s %12s %14s %14s %14s" % header)
+    for collective in collectives:
+        nbytes = args.min_bytes
+        while nbytes <= args.max_bytes:
+            number = max(args.min_number, min(args.number, int(args.budget_bytes // nbytes)))
+            latency = BenchmarkCPUCollective(
+                args.communicator, collective, nbytes, args.warmup, number
+            )
+            if rank == 0:
+                algbw = nbytes / latency / 1e9
+                busbw = algbw * bus_factor(collective, size)
+                print(
+                    "%-16s %12d %14.2f %14.3f %14.3f"
+                    % (collective, nbytes, latency * 1e6, algbw, busbw)
+                )
+            nbytes *= args.step_factor
+
+
+def worker(rank, size, env, args):
+    os.environ.update(env)
+    run(rank, size, args)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--communicator", type=str, default="tcp", choices=["shm", "tcp"])
+    parser.add_argument("--nproc", type=int, default=4, help="The ranks to spawn on this host")
+    parser.add_argument("--rank", type=int, default=None, help="The rank of a launched process")
+    parser.add_argument("--size", type=int, default=None, help="The ranks of a launched job")
+    parser.add_argument("--collectives", type=str, nargs="+", choices=COLLECTIVES)
+    parser.add_argument("--tune", type=str, default=None, help="Save the algorithm table to a path")
+    parser.add_argument("--min-bytes", type=int, default=8)
+    parser.add_argument("--max-bytes", type=int, default=64 << 20)
+    parser.add_argument("--step-factor", type=int, default=4)
+    parser.add_argument("--warmup", type=int, default=5)
+    parser.add_argument("--number", type=int, default=200)
+    parser.add_argument("--min-number", type=int, default=5)
+    parser.add_argument(
+        "--budget-bytes", type=float, default=1 << 30, help="Bound the bytes moved per size"
+    )
+    args = parser.parse_args()
+    assert not args.tune or args.communicator == "tcp", "Only the tcp communicator is planned"
+
+    if args.rank is not None:
+        assert args.size is not None, "--rank requires --size"
+        run(args.rank, args.size, args)
+        return
+
+    env = {}
+    if args.communicator == "tcp" and "RAF_TCP_RENDEZVOUS_DIR" not in os.environ:
+        with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as sock:
+            sock.bind(("127.0.0.1", 0))
+            env["RAF_TCP_ADDR"] = "127.0.0.1:%d" % sock.getsockname()[1]
+    if args.communicator == "shm":
+        env["RAF_SHM_SESSION"] = "bench_%d" % os.getpid()
+    ctx = mp.get_context("spawn")
+    procs = [
+        ctx.Process(target=worker, args=(rank, args.nproc, env, args))
+        for rank in range(args.nproc)
+    ]
+    for proc in procs:
+        proc.start()
+    for proc in procs:
+        proc.join()
+
+
+if __name__ == "__main__":
+    main()
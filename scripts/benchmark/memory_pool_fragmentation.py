@@ -0,0 +1,77 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+"""Fragmentation benchmark of the memory pools on a variable-shape workload.
+
+A small MLP is executed with a random sequence length at each step, so the size of every
+activation changes from step to step. The benchmark reports, for each memory pool, the peak
+memory used by tensors, the peak memory reserved from the device, and the fragmentation defined
+as 1 - peak used / peak reserved.
+
+Usage: python3 scripts/benchmark/memory_pool_fragmentation.py [--steps 200] [--device cpu]
+"""
+# pylint: disable=attribute-defined-outside-init,protected-access,no-self-use
+import argparse
+import random
+
+import raf
+from raf._core.executor import VMExecutor
+from raf._ffi.memory_pool import InitPool
+from raf.testing import randn
+
+
+class MLP(raf.Model):
+    def build(self, hidden):
+        self.w1, _ = randn([hidden, 4 * hidden])
+        self.w2, _ = randn([4 * hidden, hidden])
+
+    @raf.model.trace
+    def forward(self, x):
+        y = raf.matmul(x, self.w1)
+        y = raf.relu(y)
+        y = raf.matmul(y, self.w2)
+        return raf.softmax(y)
+
+
+def measure(pool_name, device, args):
+    """Return the peak used and peak reserved memory in MBs."""
+    InitPool(raf.Device(device), pool_name)
+    model = MLP(args.hidden)
+    model.to(device=device)
+    model.infer_mode()
+    executors = {}
+    rng = random.Random(args.seed)
+    raf.utils.memory_profiler.reset()
+    raf.utils.memory_profiler.start()
+    for _ in range(args.steps):
+        seq_len = rng.randint(1, args.max_seq_len)
+        m_x, _ = randn([seq_len, args.hidden], device=device)
+        if seq_len not in executors:
+            mod = model._internal(m_x).mod
+            executors[seq_len] = VMExecutor(mod, device).make_executor()
+        executors[seq_len](m_x)
+    raf.utils.memory_profiler.stop()
+    info = raf.utils.memory_profiler.get_max_memory_info(raf.Device(device))
+    return info["max_used"].value, info["max_allocated"].value
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--pools", type=str, nargs="+", default=["page_unit_pool", "bfc_pool"])
+    parser.add_argument("--steps", type=int, default=200)
+    parser.add_argument("--hidden", type=int, default=512)
+    parser.add_argument("--max-seq-len", type=int, default=512)
+    parser.add_argument("--seed", type=int, default=0)
+    parser.add_argument("--device", type=str, default="cpu")
+    args = parser.parse_args()
+
+    header = ("Pool", "Peak used (MB)", "Peak reserved (MB)", "Fragmentation")
+    print("%-16s %14s %18s %15s" % header)
+    for pool_name in args.pools:
+        used, reserved = measure(pool_name, args.device, args)
+        fragmentation = 1.0 - used / reserved if reserved > 0 else 0.0
+        print("%-16s %14.2f %18.2f %14.1f%%" % (pool_name, used, reserved, fragmentation * 100))
+
+
+if __name__ == "__main__":
+    main()
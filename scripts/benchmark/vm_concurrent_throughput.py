@@ -0,0 +1,58 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+"""Throughput benchmark of concurrent VM execution.
+
+One executable is loaded into one VM, and N worker threads each run their own VM context
+against it. The benchmark reports requests per second for each number of threads.
+
+Usage: python3 scripts/benchmark/vm_concurrent_throughput.py [--model mlp] [--batch 1]
+"""
+# pylint: disable=protected-access
+import argparse
+
+from raf._core.executor import VMExecutor
+from raf.testing import randn
+from raf.testing.mlp import RAFMlp
+
+
+def get_model(name, batch):
+    """Return an inference model and its input."""
+    if name == "mlp":
+        model = RAFMlp(num_inputs=784, num_outputs=10, num_hiddens1=256, num_hiddens2=256)
+        m_x, _ = randn([batch, 784], device="cpu")
+    elif name == "resnet50":
+        from raf.testing import resnet  # pylint: disable=import-outside-toplevel
+
+        model = resnet.RAFResNet50([3, 4, 6, 3])
+        m_x, _ = randn([batch, 3, 224, 224], device="cpu")
+    else:
+        raise ValueError("Unknown model: %s" % name)
+    model.infer_mode()
+    return model, m_x
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--model", type=str, default="mlp", choices=["mlp", "resnet50"])
+    parser.add_argument("--batch", type=int, default=1)
+    parser.add_argument("--threads", type=int, nargs="+", default=[1, 2, 4, 8, 16])
+    parser.add_argument("--number", type=int, default=100)
+    args = parser.parse_args()
+
+    model, m_x = get_model(args.model, args.batch)
+    mod = model._internal(m_x).mod
+    executor = VMExecutor(mod, "cpu")
+
+    print("%-10s %14s %10s" % ("Threads", "Requests/sec", "Scaling"))
+    base = None
+    for num_threads in args.threads:
+        throughput = executor.vm.profile_throughput(
+            m_x, num_threads=num_threads, number=args.number
+        )
+        base = base or throughput
+        print("%-10d %14.2f %9.2fx" % (num_threads, throughput, throughput / base))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,70 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+"""Micro-benchmark of the VM InvokeJit dispatch overhead.
+
+The model is a chain of small element-wise ops that are not fused, and the VM runs in dryrun
+mode, so the measured latency is dominated by the per-instruction dispatch, i.e., resolving the
+OpEnv of each InvokeJit. The benchmark reports the overhead with and without the per-instruction
+OpEnv inline cache.
+
+Usage: python3 scripts/benchmark/vm_dispatch_overhead.py [--num-ops 256] [--device cpu]
+"""
+# pylint: disable=attribute-defined-outside-init,protected-access,no-self-use
+import argparse
+
+import raf
+from raf._core.executor import VMExecutor
+from raf.testing import randn
+
+
+class Chain(raf.Model):
+    def build(self, num_ops):
+        self.num_ops = num_ops
+
+    @raf.model.trace
+    def forward(self, x, y):
+        for i in range(self.num_ops):
+            x = raf.add(x, y) if i % 2 == 0 else raf.multiply(x, y)
+        return x
+
+
+def measure(mod, device, args, enable_inline_cache, number, repeat):
+    """Return the best per-run latency in milliseconds and the number of InvokeJit."""
+    with raf.ir.PassContext(disabled_pass=["FuseTVM", "FuseDialect"]):
+        executor = VMExecutor(mod, device, dryrun=True, enable_inline_cache=enable_inline_cache)
+    num_invoke_jit = executor.executable.bytecode.count("invoke_jit")
+    latency = executor.vm.profile(*args, warmup=5, number=number, repeat=repeat)
+    return min(latency), num_invoke_jit
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--num-ops", type=int, default=256)
+    parser.add_argument("--shape", type=int, nargs="+", default=[4, 4])
+    parser.add_argument("--device", type=str, default="cpu")
+    parser.add_argument("--number", type=int, default=100)
+    parser.add_argument("--repeat", type=int, default=10)
+    args = parser.parse_args()
+
+    model = Chain(args.num_ops)
+    model.infer_mode()
+    m_x, _ = randn(args.shape, device=args.device)
+    m_y, _ = randn(args.shape, device=args.device)
+    mod = model._internal(m_x, m_y).mod
+
+    print("%-20s %12s %14s" % ("Mode", "Run (ms)", "Per-op (us)"))
+    results = {}
+    for enable_inline_cache in [False, True]:
+        name = "inline cache" if enable_inline_cache else "OpEnvCache only"
+        latency, num_invoke_jit = measure(
+            mod, args.device, [m_x, m_y], enable_inline_cache, args.number, args.repeat
+        )
+        per_op = latency * 1000.0 / num_invoke_jit
+        results[name] = per_op
+        print("%-20s %12.4f %14.3f" % (name, latency, per_op))
+    print("Speedup: %.2fx" % (results["OpEnvCache only"] / results["inline cache"]))
+
+
+if __name__ == "__main__":
+    main()
@@ -203,6 +203,8 @@ OPS = [
     # Using underscore before the op name is because these ops won't be directly used in the
     # frontend and the wrapper ops are defined in python/raf/distributed/op.py
     Op(name="_allreduce", schema_name="allreduce"),
+    Op(name="_allreduce_async", schema_name="allreduce"),
+    Op(name="_wait_async", schema_name="wait_async"),
     Op(name="_allgather", schema_name="allgather"),
     Op(name="_group_allgather", schema_name="group_allgather"),
     Op(name="_reduce", schema_name="comm_reduce"),
@@ -212,6 +214,17 @@ OPS = [
     Op(name="_all_to_all", schema_name="all_to_all"),
     Op(name="_send", schema_name="send"),
     Op(name="_recv", schema_name="recv"),
+    Op(name="_topk_compress", schema_name="topk_compress"),
+    Op(name="_topk_decompress", schema_name="topk_decompress"),
+    Op(name="_onebit_compress", schema_name="onebit_compress"),
+    Op(name="_onebit_decompress", schema_name="onebit_decompress"),
+    Op(name="_powersgd_p", schema_name="powersgd_p"),
+    Op(name="_powersgd_q", schema_name="powersgd_q"),
+    Op(name="_powersgd_decompress", schema_name="powersgd_decompress"),
+    # Mixture-of-experts ops
+    Op(name="_moe_gate", schema_name="moe_gate"),
+    Op(name="_moe_dispatch", schema_name="moe_dispatch"),
+    Op(name="_moe_combine", schema_name="moe_combine"),
     # VM ops
     Op(name="vm.alloc_storage", schema_name="alloc_storage"),
     Op(name="vm.alloc_tensor", schema_name="alloc_tensor"),
@@ -701,6 +701,10 @@ SCHEMAS = {
         Arg(name="computation", cxx_type="std::string", cxx_default='"sum"', py_default='"sum"'),
         Arg(name="rank_list", cxx_type="value::Value", cxx_default="nullptr"),
     ],
+    "communication.h::wait_async": [
+        Arg(name="handle", cxx_type="value::BaseTensorValue"),
+        Arg(name="x", cxx_type="std::vector<value::BaseTensorValue>", cxx_normalizer="TensorTuple"),
+    ],
     "communication.h::comm_reduce": [
         Arg(name="x", cxx_type="std::vector<value::BaseTensorValue>", cxx_normalizer="TensorTuple"),
         Arg(name="root", cxx_type="int"),
@@ -754,6 +758,61 @@ SCHEMAS = {
         Arg(name="dtype", cxx_type="std::string", cxx_default='"float32"', py_default='"float32"'),
         Arg(name="token", cxx_type=OptionalTensor, cxx_default="nullptr", py_default="None"),
     ],
+    "communication.h::topk_compress": [
+        Arg(name="x", cxx_type="value::BaseTensorValue"),
+        Arg(name="ratio", cxx_type="double"),
+        Arg(name="key", cxx_type="std::string"),
+    ],
+    "communication.h::topk_decompress": [
+        Arg(name="values", cxx_type="value::BaseTensorValue"),
+        Arg(name="indices", cxx_type="value::BaseTensorValue"),
+        Arg(name="shape", cxx_type="std::vector<int64_t>", cxx_normalizer="IntTuple"),
+        Arg(name="scale", cxx_type="double", cxx_default=1.0),
+    ],
+    "communication.h::onebit_compress": [
+        Arg(name="x", cxx_type="value::BaseTensorValue"),
+        Arg(name="key", cxx_type="std::string"),
+    ],
+    "communication.h::onebit_decompress": [
+        Arg(name="bits", cxx_type="value::BaseTensorValue"),
+        Arg(name="scales", cxx_type="value::BaseTensorValue"),
+        Arg(name="shape", cxx_type="std::vector<int64_t>", cxx_normalizer="IntTuple"),
+        Arg(name="scale", cxx_type="double", cxx_default=1.0),
+    ],
+    "communication.h::powersgd_p": [
+        Arg(name="x", cxx_type="value::BaseTensorValue"),
+        Arg(name="rank", cxx_type="int"),
+        Arg(name="key", cxx_type="std::string"),
+    ],
+    "communication.h::powersgd_q": [
+        Arg(name="p", cxx_type="value::BaseTensorValue"),
+        Arg(name="shape", cxx_type="std::vector<int64_t>", cxx_normalizer="IntTuple"),
+        Arg(name="key", cxx_type="std::string"),
+    ],
+    "communication.h::powersgd_decompress": [
+        Arg(name="p", cxx_type="value::BaseTensorValue"),
+        Arg(name="q", cxx_type="value::BaseTensorValue"),
+        Arg(name="shape", cxx_type="std::vector<int64_t>", cxx_normalizer="IntTuple"),
+        Arg(name="key", cxx_type="std::string"),
+        Arg(name="scale", cxx_type="double", cxx_default=1.0),
+    ],
+    "moe.h::moe_gate": [
+        Arg(name="probs", cxx_type="value::BaseTensorValue"),
+        Arg(name="capacity", cxx_type="int"),
+        Arg(name="k", cxx_type="int", cxx_default=1),
+    ],
+    "moe.h::moe_dispatch": [
+        Arg(name="x", cxx_type="value::BaseTensorValue"),
+        Arg(name="indices", cxx_type="value::BaseTensorValue"),
+        Arg(name="locations", cxx_type="value::BaseTensorValue"),
+        Arg(name="num_experts", cxx_type="int"),
+        Arg(name="capacity", cxx_type="int"),
+    ],
+    "moe.h::moe_combine": [
+        Arg(name="y", cxx_type="value::BaseTensorValue"),
+        Arg(name="indices", cxx_type="value::BaseTensorValue"),
+        Arg(name="locations", cxx_type="value::BaseTensorValue"),
+    ],
     "transform.h::gather": [
         Arg(name="data", cxx_type="value::BaseTensorValue"),
         Arg(name="axis", cxx_type="int"),
@@ -885,6 +944,7 @@ SCHEMAS = {
             py_default="None",
         ),
         Arg(name="own", cxx_type="bool", cxx_default=True),
+        Arg(name="offset", cxx_type="int64_t", cxx_default=0),
     ],
     "vm.h::free": [
         Arg(name="memory", cxx_type="value::BaseTensorValue"),
@@ -32,11 +32,13 @@ def gen_file(filename):
  */
 #include <algorithm>
 #include <array>
+#include <sstream>
 #include "./regs_utils.h"
 #include "./ffi2expr.h"
 #include "./ffi2schema.h"
 #include "./value2schema.h"
 #include "./schema2value.h"
+#include "./schema2key.h"
 #include "../schema/list_args.h"
 {INCLUDES}
 
@@ -285,7 +287,10 @@ namespace imperative {
   } catch (const dmlc::Error &e) {                                                             \\
     FillError(e, "{op}", names::op);                                                           \\
   }                                                                                            \\
-  Value value = InvokePrimitive(CallValues::make(opack->opv, _schema));                        \\
+  const auto *schema = _schema.as<obj>();
+
+#define RAF_INVOKE(key, make_values)                                                           \\
+  Value value = InvokePrimitive(CallValues::make(opack->opv, _schema), key, make_values);      \\
   int n_tapes = grads.size();                                                                  \\
   bool full_grads = RemoveNoGrad(prev_tapes.data(), grads.data(), &n_tapes);                   \\
   /* case 1: no grad required */                                                               \\
@@ -302,7 +307,7 @@ namespace imperative {
     /* case 3: partial grad required, have to collect vars */                                  \\
     CollectVars(body, &used_vars);                                                             \\
   }                                                                                            \\
-  const auto *schema = _schema.as<obj>();                                                      \\
+  Array<Value> _values = make_values();                                                        \\
   Map<Var, Value> env;
 
 #define RAF_SET_ENV(var, value)                                                        \\
@@ -323,6 +328,7 @@ namespace imperative {
 IMPERATIVE_API_EPILOG = """
 #undef RAF_RET
 #undef RAF_SET_ENV
+#undef RAF_INVOKE
 #undef RAF_PRELUDE
 
 }  // namespace imperative
@@ -337,6 +343,14 @@ def gen_imperative_api(op):
 RAF_REGISTER_GLOBAL("raf.op.imp.{OP_NAME}")
 .set_body([](TVMArgs args, TVMRetValue* ret) {{
   RAF_PRELUDE({OP_VAR}, {N_ARGS}, ffi2schema::{SCHEMA_NAME}, schema::{SCHEMA_NAME}Args);  // NOLINT(whitespace/line_length)
+  std::ostringstream _key;
+{KEYS}
+  auto _make_values = [&]() -> Array<Value> {{
+    return {{
+{VALUES}
+    }};
+  }};
+  RAF_INVOKE(_key.str(), _make_values);
 {ARGS}
   RAF_SET_ENV(vpack->y, value);
   *ret = RAF_RET();
@@ -345,22 +359,42 @@ RAF_REGISTER_GLOBAL("raf.op.imp.{OP_NAME}")
     ARG = (
         " " * 2
         + """
-  RAF_SET_ENV(vpack->x[{I}], schema2value::{NORM}(schema->{ARG_NAME}));
+  RAF_SET_ENV(vpack->x[{I}], _values[{I}]);
+""".strip()
+    )
+    KEY = (
+        " " * 2
+        + """
+schema2key::{NORM}(&_key, schema->{ARG_NAME});
+""".strip()
+    )
+    VALUE = (
+        " " * 6
+        + """
+schema2value::{NORM}(schema->{ARG_NAME}),
 """.strip()
     )
     n_args = len(op.schema)
     schema_name = snake_to_pascal(op.schema_name)
     args = []
+    keys = []
+    values = []
     for i, entry in enumerate(op.schema):
         norm = NORM_CONVERTER[NORM_MAP[entry.cxx_normalizer or entry.cxx_type]]
         arg_name = entry.name
-        args.append(ARG.format(I=i, NORM=norm, ARG_NAME=arg_name))
+        args.append(ARG.format(I=i))
+        keys.append(KEY.format(NORM=norm, ARG_NAME=arg_name))
+        values.append(VALUE.format(NORM=norm, ARG_NAME=arg_name))
     args = "\n".join(map(add_no_lint, args))
+    keys = "\n".join(map(add_no_lint, keys))
+    values = "\n".join(map(add_no_lint, values))
     return IMPERATIVE_API.format(
         OP_NAME=op.name,
         OP_VAR=op.name.replace(".", "_"),
         SCHEMA_NAME=schema_name,
         N_ARGS=n_args,
+        KEYS=keys,
+        VALUES=values,
         ARGS=args,
     )
 
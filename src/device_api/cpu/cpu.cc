@@ -7,9 +7,14 @@
  * \file src/device_api/cpu/cpu.cc
  * \brief CPU device API
  */
+#include <chrono>
+#include <mutex>
 #include <thread>
+#include <unordered_set>
+#include <vector>
 #include "raf/device_api.h"
 #include "raf/registry.h"
+#include "./cpu_stream.h"
 
 namespace raf {
 namespace device_api {
@@ -72,15 +77,22 @@ class CPUDeviceAPI final : public DeviceAPI {
   }
 
   void* CreateStream(const Device&) override {
-    throw;
+    auto stream = new CPUStream();
+    std::lock_guard<std::mutex> lock(mutex_);
+    streams_.insert(stream);
+    return stream;
   }
 
   void FreeStream(const Device&, void* stream) override {
-    throw;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      streams_.erase(static_cast<CPUStream*>(stream));
+    }
+    delete static_cast<CPUStream*>(stream);
   }
 
   void SetStream(const Device&, void* stream) override {
-    throw;
+    // Kernels on CPU are launched to a stream explicitly by CPUStream::Launch.
   }
 
   void* GetStream() override {
@@ -88,35 +100,74 @@ class CPUDeviceAPI final : public DeviceAPI {
   }
 
   void* CreateEvent(const Device& dev, uint32_t flags) override {
-    throw;
+    return new CPUEvent();
   }
 
   void FreeEvent(const Device& dev, void* event) {
-    throw;
+    delete static_cast<CPUEvent*>(event);
   }
 
   float EventElapsedTimeInMilliSeconds(void* start_event, void* end_event) override {
-    throw;
+    WaitEvent(start_event);
+    WaitEvent(end_event);
+    int64_t start = static_cast<CPUEvent*>(start_event)->timestamp;
+    int64_t end = static_cast<CPUEvent*>(end_event)->timestamp;
+    return static_cast<float>(end - start) / 1000.0f;
   }
 
   void EventRecordOnStream(void* event, void* stream) override {
-    throw;
+    auto cpu_event = static_cast<CPUEvent*>(event);
+    auto cpu_stream = static_cast<CPUStream*>(stream);
+    cpu_event->stream = cpu_stream;
+    if (cpu_stream == nullptr) {
+      // The default stream is the host thread, so all its workloads have finished.
+      cpu_event->count = 0;
+      cpu_event->timestamp = NowInMicrosec();
+    } else {
+      cpu_event->count =
+          cpu_stream->Launch([cpu_event]() { cpu_event->timestamp = NowInMicrosec(); });
+    }
   }
 
   void StreamWaitEvent(void* stream, void* event) override {
-    throw;
+    auto cpu_event = static_cast<CPUEvent*>(event);
+    auto cpu_stream = static_cast<CPUStream*>(stream);
+    if (cpu_event->stream == nullptr || cpu_event->stream == cpu_stream) {
+      // The tasks on the same stream are executed in order.
+      return;
+    }
+    if (cpu_stream == nullptr) {
+      cpu_event->stream->WaitUntil(cpu_event->count);
+    } else {
+      // Take a snapshot of the event, as it may be recorded again before the task is executed.
+      CPUStream* event_stream = cpu_event->stream;
+      int64_t count = cpu_event->count;
+      cpu_stream->Launch([event_stream, count]() { event_stream->WaitUntil(count); });
+    }
   }
 
   void WaitDevice(const Device&) override {
-    // Do nothing
+    std::vector<CPUStream*> streams;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      streams.assign(streams_.begin(), streams_.end());
+    }
+    for (auto stream : streams) {
+      stream->Wait();
+    }
   }
 
   void WaitStream(void* stream) override {
-    throw;
+    if (stream != nullptr) {
+      static_cast<CPUStream*>(stream)->Wait();
+    }
   }
 
   void WaitEvent(void* event) {
-    throw;
+    auto cpu_event = static_cast<CPUEvent*>(event);
+    if (cpu_event->stream != nullptr) {
+      cpu_event->stream->WaitUntil(cpu_event->count);
+    }
   }
 
   void SetDevice(const int device_id) override {
@@ -126,6 +177,18 @@ class CPUDeviceAPI final : public DeviceAPI {
   static void* make() {
     return new CPUDeviceAPI();
   }
+
+ private:
+  static int64_t NowInMicrosec() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  /*! \brief The live streams, which are synchronized by WaitDevice. */
+  std::unordered_set<CPUStream*> streams_;
+  /*! \brief Mutex that guards streams_. */
+  std::mutex mutex_;
 };
 
 RAF_REGISTER_GLOBAL("raf.device_api._make.cpu").set_body_typed(CPUDeviceAPI::make);
@@ -0,0 +1,94 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/device_api/cpu/cpu_stream.cc
+ * \brief Stream and event emulation for CPU
+ */
+#include <utility>
+#include "./cpu_stream.h"
+
+namespace raf {
+namespace device_api {
+namespace cpu {
+
+CPUStream::CPUStream() : worker_([this]() { WorkerLoop(); }) {
+}
+
+CPUStream::~CPUStream() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stop_ = true;
+  }
+  launch_cv_.notify_one();
+  worker_.join();
+}
+
+int64_t CPUStream::Launch(std::function<void()> task) {
+  int64_t count;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    tasks_.push_back(std::move(task));
+    count = ++num_launched_;
+  }
+  launch_cv_.notify_one();
+  return count;
+}
+
+void CPUStream::WaitUntil(int64_t count) {
+  std::unique_lock<std::mutex> lock(mu_);
+  finish_cv_.wait(lock, [this, count]() { return num_finished_ >= count; });
+  if (error_) {
+    std::exception_ptr error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void CPUStream::Wait() {
+  int64_t count;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    count = num_launched_;
+  }
+  WaitUntil(count);
+}
+
+void CPUStream::WorkerLoop() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      launch_cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+      // Drain the pending tasks before exiting.
+      if (tasks_.empty()) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    std::exception_ptr error;
+    try {
+      task();
+    } catch (...) {
+      error = std::current_exception();
+    }
+    // Release the captures of the task before it is marked finished, so that they never
+    // outlive a wait for it.
+    task = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      if (error && !error_) {
+        error_ = error;
+      }
+      ++num_finished_;
+    }
+    finish_cv_.notify_all();
+  }
+}
+
+}  // namespace cpu
+}  // namespace device_api
+}  // namespace raf
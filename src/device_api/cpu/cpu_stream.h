@@ -0,0 +1,94 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/device_api/cpu/cpu_stream.h
+ * \brief Stream and event emulation for CPU
+ */
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace raf {
+namespace device_api {
+namespace cpu {
+
+/*!
+ * \brief A CPU stream is a worker thread that executes the launched tasks one by one in the
+ * launching order. Tasks on different streams run concurrently, which gives the inter-op
+ * parallelism on CPU as the multiple CUDA streams do on GPU.
+ *
+ * The tasks are numbered from 1 in the launching order, so the progress of a stream is described
+ * by the number of completed tasks, and an event is simply a (stream, task number) pair.
+ */
+class CPUStream {
+ public:
+  CPUStream();
+
+  ~CPUStream();
+
+  /*!
+   * \brief Launch a task to the stream. The call is asynchronous.
+   * \param task The task to be executed by the worker thread.
+   * \return The number of the launched task.
+   */
+  int64_t Launch(std::function<void()> task);
+
+  /*!
+   * \brief Block the calling thread until the first count tasks finished. If a task failed,
+   * the exception is rethrown here.
+   * \param count The number of tasks to wait for.
+   */
+  void WaitUntil(int64_t count);
+
+  /*! \brief Block the calling thread until all launched tasks finished. */
+  void Wait();
+
+ private:
+  /*! \brief The loop of the worker thread. */
+  void WorkerLoop();
+
+  /*! \brief The pending tasks. */
+  std::deque<std::function<void()>> tasks_;
+  /*! \brief The number of launched tasks. */
+  int64_t num_launched_{0};
+  /*! \brief The number of finished tasks. */
+  int64_t num_finished_{0};
+  /*! \brief The first exception thrown by a task that has not been reported yet. */
+  std::exception_ptr error_;
+  /*! \brief Whether the worker thread should exit. */
+  bool stop_{false};
+  /*! \brief Mutex that guards all members above. */
+  std::mutex mu_;
+  /*! \brief Notified when a task is launched or the stream is stopped. */
+  std::condition_variable launch_cv_;
+  /*! \brief Notified when a task is finished. */
+  std::condition_variable finish_cv_;
+  /*! \brief The worker thread. */
+  std::thread worker_;
+};
+
+/*!
+ * \brief A CPU event records the number of tasks launched to a stream at the time of recording.
+ * The event is reached once the stream finished that many tasks. An event recorded on the default
+ * stream (nullptr), i.e., the host thread, is reached immediately.
+ */
+struct CPUEvent {
+  /*! \brief The stream the event was recorded on, or nullptr. */
+  CPUStream* stream{nullptr};
+  /*! \brief The number of the last task launched before the event was recorded. */
+  int64_t count{0};
+  /*! \brief The time in microseconds at which the event was reached. */
+  int64_t timestamp{0};
+};
+
+}  // namespace cpu
+}  // namespace device_api
+}  // namespace raf
@@ -7,6 +7,8 @@
  * \file src/distributed/dist_config.cc
  * \brief Config of Distributed Settings.
  */
+#include <set>
+#include <string>
 #include "raf/registry.h"
 #include "raf/communicator.h"
 #include "raf/dist_config.h"
@@ -32,6 +34,8 @@ void EnableDataParallel(bool enable) {
 }
 
 void ZeroOpt(int opt_level) {
+  CHECK(opt_level >= 0 && opt_level <= 3) << "ZeRO optimization level must be 0-3, but got "
+                                          << opt_level;
   DistConfig::Global()->zero_opt_level = opt_level;
 }
 
@@ -47,6 +51,28 @@ void AutoDPProfilingEndIter(int auto_dp_profiling_end_iter) {
   DistConfig::Global()->auto_dp_profiling_end_iter = auto_dp_profiling_end_iter;
 }
 
+void GroupBucketSize(int64_t size) {
+  CHECK_GT(size, 0) << "The bucket size must be positive";
+  DistConfig::Global()->group_bucket_size = size;
+}
+
+void GradCompression(std::string method) {
+  static const std::set<std::string> methods = {"none", "fp16", "bf16", "topk", "onebit",
+                                                "powersgd"};
+  CHECK(methods.count(method)) << "Unknown gradient compression " << method;
+  DistConfig::Global()->grad_compression = method;
+}
+
+void GradCompressionTopKRatio(double ratio) {
+  CHECK(ratio > 0 && ratio <= 1) << "The ratio of top-k must be in (0, 1], but got " << ratio;
+  DistConfig::Global()->grad_compression_topk_ratio = ratio;
+}
+
+void GradCompressionPowerSGDRank(int rank) {
+  CHECK_GT(rank, 0) << "The rank of PowerSGD must be positive";
+  DistConfig::Global()->grad_compression_powersgd_rank = rank;
+}
+
 RAF_REGISTER_GLOBAL("raf.distributed.GlobalDistConfig").set_body_typed(DistConfig::Global);
 RAF_REGISTER_GLOBAL("raf.distributed.EnableDataParallel").set_body_typed(EnableDataParallel);
 RAF_REGISTER_GLOBAL("raf.distributed.ZeroOpt").set_body_typed(ZeroOpt);
@@ -55,6 +81,12 @@ RAF_REGISTER_GLOBAL("raf.distributed.AutoDPProfilingStartIter")
     .set_body_typed(AutoDPProfilingStartIter);
 RAF_REGISTER_GLOBAL("raf.distributed.AutoDPProfilingEndIter")
     .set_body_typed(AutoDPProfilingEndIter);
+RAF_REGISTER_GLOBAL("raf.distributed.GroupBucketSize").set_body_typed(GroupBucketSize);
+RAF_REGISTER_GLOBAL("raf.distributed.GradCompression").set_body_typed(GradCompression);
+RAF_REGISTER_GLOBAL("raf.distributed.GradCompressionTopKRatio")
+    .set_body_typed(GradCompressionTopKRatio);
+RAF_REGISTER_GLOBAL("raf.distributed.GradCompressionPowerSGDRank")
+    .set_body_typed(GradCompressionPowerSGDRank);
 
 RAF_REGISTER_OBJECT_REFLECT(DistConfigObj);
 
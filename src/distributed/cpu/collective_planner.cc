@@ -0,0 +1,201 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/distributed/cpu/collective_planner.cc
+ * \brief Select the algorithm of a CPU collective from the message size and the topology.
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include "dmlc/logging.h"
+#include "./collective_planner.h"
+
+namespace raf {
+namespace distributed {
+namespace communicator {
+
+/*! \brief The alpha-beta model of the network, i.e., the seconds per message and per byte. */
+constexpr double kInterHostAlpha = 50e-6;
+constexpr double kInterHostBeta = 1.0 / 1.25e9;
+constexpr double kIntraHostAlpha = 10e-6;
+constexpr double kIntraHostBeta = 1.0 / 5e9;
+
+const char* CollectiveAlgoName(CollectiveAlgo algo) {
+  switch (algo) {
+    case CollectiveAlgo::kRing:
+      return "ring";
+    case CollectiveAlgo::kTree:
+      return "tree";
+    case CollectiveAlgo::kHalving:
+      return "halving";
+    case CollectiveAlgo::kHierarchical:
+      return "hierarchical";
+  }
+  return "unknown";
+}
+
+std::string TableKey(const std::string& collective, CollectiveAlgo algo,
+                     const CollectiveTopology& topo) {
+  return collective + "/" + CollectiveAlgoName(algo) + "/" + std::to_string(topo.size) + "x" +
+         std::to_string(topo.num_hosts);
+}
+
+double Log2Ceil(int n) {
+  return n > 1 ? std::ceil(std::log2(n)) : 0;
+}
+
+CollectivePlanner* CollectivePlanner::Get() {
+  static CollectivePlanner* planner = []() {
+    auto planner = new CollectivePlanner();
+    if (const char* path = getenv("RAF_CPU_COLLECTIVE_TABLE")) {
+      planner->Load(path);
+    }
+    return planner;
+  }();
+  return planner;
+}
+
+CollectiveAlgo CollectivePlanner::Select(const std::string& collective,
+                                         const CollectiveTopology& topo, int64_t bytes,
+                                         const std::vector<CollectiveAlgo>& candidates) {
+  CHECK(!candidates.empty());
+  if (collective == "allreduce") {
+    if (const char* forced = getenv("RAF_CPU_ALLREDUCE_ALGO")) {
+      for (auto algo : candidates) {
+        if (forced == std::string(CollectiveAlgoName(algo))) {
+          return algo;
+        }
+      }
+    }
+  }
+  if (candidates.size() == 1) {
+    return candidates[0];
+  }
+  std::lock_guard<std::mutex> lock(mu_);
+  // Compare the measurements only if they cover all the candidates, since the model is not
+  // calibrated against them.
+  std::vector<double> latency;
+  for (auto algo : candidates) {
+    latency.push_back(Lookup(TableKey(collective, algo, topo), bytes));
+  }
+  if (std::any_of(latency.begin(), latency.end(), [](double t) { return t < 0; })) {
+    latency.clear();
+    for (auto algo : candidates) {
+      latency.push_back(Model(collective, algo, topo, bytes));
+    }
+  }
+  return candidates[std::min_element(latency.begin(), latency.end()) - latency.begin()];
+}
+
+void CollectivePlanner::Record(const std::string& collective, CollectiveAlgo algo,
+                               const CollectiveTopology& topo, int64_t bytes, double seconds) {
+  std::lock_guard<std::mutex> lock(mu_);
+  auto& samples = table_[TableKey(collective, algo, topo)];
+  auto it = std::lower_bound(samples.begin(), samples.end(), std::make_pair(bytes, 0.0));
+  if (it != samples.end() && it->first == bytes) {
+    it->second = seconds;
+  } else {
+    samples.insert(it, {bytes, seconds});
+  }
+}
+
+void CollectivePlanner::Load(const std::string& path) {
+  std::ifstream file(path);
+  if (!file) {
+    LOG(WARNING) << "Cannot open the collective table " << path << ", using the network model";
+    return;
+  }
+  // Each line is "<collective>/<algo>/<size>x<num_hosts> <bytes> <seconds>".
+  std::lock_guard<std::mutex> lock(mu_);
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream is(line);
+    std::string key;
+    int64_t bytes;
+    double seconds;
+    if (line.empty() || line[0] == '#' || !(is >> key >> bytes >> seconds)) {
+      continue;
+    }
+    table_[key].emplace_back(bytes, seconds);
+  }
+  for (auto& kv : table_) {
+    std::sort(kv.second.begin(), kv.second.end());
+  }
+}
+
+void CollectivePlanner::Save(const std::string& path) {
+  std::lock_guard<std::mutex> lock(mu_);
+  // Publish the table atomically, since the other jobs may be loading it.
+  std::string tmp = path + ".tmp";
+  {
+    std::ofstream file(tmp, std::ios::trunc);
+    file << "# <collective>/<algo>/<size>x<num_hosts> <bytes> <seconds>\n";
+    file.precision(9);
+    for (const auto& kv : table_) {
+      for (const auto& sample : kv.second) {
+        file << kv.first << " " << sample.first << " " << sample.second << "\n";
+      }
+    }
+    CHECK(file.good()) << "Failed to write the collective table " << tmp;
+  }
+  CHECK_EQ(std::rename(tmp.c_str(), path.c_str()), 0) << "Failed to write " << path;
+}
+
+double CollectivePlanner::Lookup(const std::string& key, int64_t bytes) const {
+  auto it = table_.find(key);
+  if (it == table_.end() || it->second.empty()) {
+    return -1;
+  }
+  const auto& samples = it->second;
+  if (bytes <= samples.front().first) {
+    // Below the smallest sample, the latency term dominates.
+    return samples.front().second;
+  }
+  if (bytes >= samples.back().first) {
+    // Above the largest sample, the bandwidth term dominates.
+    return samples.back().second * bytes / samples.back().first;
+  }
+  auto hi = std::lower_bound(samples.begin(), samples.end(), std::make_pair(bytes, 0.0));
+  auto lo = hi - 1;
+  double ratio = static_cast<double>(bytes - lo->first) / (hi->first - lo->first);
+  return lo->second + ratio * (hi->second - lo->second);
+}
+
+double CollectivePlanner::Model(const std::string& collective, CollectiveAlgo algo,
+                                const CollectiveTopology& topo, int64_t bytes) const {
+  int p = topo.size;
+  int hosts = std::max(topo.num_hosts, 1);
+  double alpha = hosts > 1 ? kInterHostAlpha : kIntraHostAlpha;
+  double beta = hosts > 1 ? kInterHostBeta : kIntraHostBeta;
+  double n = static_cast<double>(bytes);
+  if (collective == "reduce_scatter") {
+    // bytes is the block of a rank, and every algorithm moves (p - 1) blocks.
+    double steps = algo == CollectiveAlgo::kHalving ? Log2Ceil(p) : p - 1;
+    return steps * alpha + (p - 1) * n * beta;
+  }
+  switch (algo) {
+    case CollectiveAlgo::kRing:
+      return 2 * (p - 1) * alpha + 2.0 * (p - 1) / p * n * beta;
+    case CollectiveAlgo::kTree:
+      return 2 * Log2Ceil(p) * (alpha + n * beta);
+    case CollectiveAlgo::kHierarchical: {
+      int local = p / hosts;
+      double intra = 2 * Log2Ceil(local) * (kIntraHostAlpha + n * kIntraHostBeta);
+      double inter = 2 * (hosts - 1) * kInterHostAlpha + 2.0 * (hosts - 1) / hosts * n * beta;
+      return intra + inter;
+    }
+    default:
+      return std::numeric_limits<double>::max();
+  }
+}
+
+}  // namespace communicator
+}  // namespace distributed
+}  // namespace raf
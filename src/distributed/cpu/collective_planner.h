@@ -0,0 +1,65 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/distributed/cpu/collective_planner.h
+ * \brief Select the algorithm of a CPU collective from the message size and the topology.
+ */
+#pragma once
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "raf/cpu_communicator.h"
+
+namespace raf {
+namespace distributed {
+namespace communicator {
+
+const char* CollectiveAlgoName(CollectiveAlgo algo);
+
+/*! \brief The shape of a group that a collective runs on. */
+struct CollectiveTopology {
+  int size;
+  int num_hosts;
+};
+
+/*!
+ * \brief Pick the fastest algorithm of a collective per call. The planner interpolates the latency
+ * of each candidate from the measured table at RAF_CPU_COLLECTIVE_TABLE, which
+ * TuneCPUCollectives generates, or falls back to an alpha-beta model of the network if the table
+ * does not cover all the candidates on this topology. RAF_CPU_ALLREDUCE_ALGO forces the algorithm
+ * of allreduce.
+ *
+ * All the ranks of a group must see the same table, so that they run the same algorithm.
+ */
+class CollectivePlanner {
+ public:
+  static CollectivePlanner* Get();
+
+  CollectiveAlgo Select(const std::string& collective, const CollectiveTopology& topo,
+                        int64_t bytes, const std::vector<CollectiveAlgo>& candidates);
+
+  /*! \brief Add a measured latency in seconds of a collective on bytes per rank. */
+  void Record(const std::string& collective, CollectiveAlgo algo, const CollectiveTopology& topo,
+              int64_t bytes, double seconds);
+  void Load(const std::string& path);
+  void Save(const std::string& path);
+
+ private:
+  /*! \brief The latency in seconds of the algorithm, or a negative value if it is not measured. */
+  double Lookup(const std::string& key, int64_t bytes) const;
+  double Model(const std::string& collective, CollectiveAlgo algo, const CollectiveTopology& topo,
+               int64_t bytes) const;
+
+  std::mutex mu_;
+  /*! \brief The (bytes, seconds) samples of each collective/algorithm/topology, sorted by bytes. */
+  std::map<std::string, std::vector<std::pair<int64_t, double>>> table_;
+};
+
+}  // namespace communicator
+}  // namespace distributed
+}  // namespace raf
@@ -0,0 +1,174 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/distributed/cpu/cpu_communicator.cc
+ * \brief The common utilities of the CPU Communicators.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include "raf/cpu_communicator.h"
+#include "./reduce.h"
+
+namespace raf {
+namespace distributed {
+namespace communicator {
+
+CPUReduceOp CPUReduceOpFromString(const std::string& computation) {
+  if (computation == "sum") {
+    return CPUReduceOp::kSum;
+  } else if (computation == "prod") {
+    return CPUReduceOp::kProd;
+  } else if (computation == "min") {
+    return CPUReduceOp::kMin;
+  } else if (computation == "max") {
+    return CPUReduceOp::kMax;
+  } else if (computation == "avg") {
+    return CPUReduceOp::kAvg;
+  }
+  LOG(FATAL) << "Invalid computation " << computation;
+  throw;
+}
+
+bool CPUCanReduce(DType dtype) {
+  return DispatchReduceType(dtype, [](auto) {});
+}
+
+std::string GetCPUCommunicatorName() {
+  if (const char* name = getenv("RAF_CPU_COMMUNICATOR")) {
+    return name;
+  }
+  if (getenv("RAF_TCP_ADDR") != nullptr || getenv("RAF_TCP_RENDEZVOUS_DIR") != nullptr) {
+    return "tcp";
+  }
+  return "shm";
+}
+
+/*!
+ * \brief Measure a collective of the given CPU communicator on float32 buffers.
+ * \param name The name of the communicator.
+ * \param collective One of allreduce, allgather, reduce_scatter, broadcast and all_to_all.
+ * \param bytes The bytes each rank contributes.
+ * \param warmup The untimed runs.
+ * \param number The timed runs.
+ * \return The average latency in seconds of the slowest rank.
+ */
+double BenchmarkCPUCollective(std::string name, std::string collective, int64_t bytes,
+                              int warmup, int number) {
+  auto comm = Downcast<CPUCommunicator>(Communicator::Get(name));
+  int64_t count = std::max<int64_t>(bytes / sizeof(float), 1);
+  int64_t factor = collective == "allreduce" || collective == "broadcast" ? 1 : comm->size;
+  std::vector<float> send(count * (collective == "allgather" ? 1 : factor), 1.0f);
+  std::vector<float> recv(count * (collective == "reduce_scatter" ? 1 : factor));
+  DType dtype(DTypeCode::kFloat(), 32);
+  auto run = [&]() {
+    if (collective == "allreduce") {
+      comm->AllReduce(send.data(), recv.data(), count, dtype, CPUReduceOp::kSum);
+    } else if (collective == "allgather") {
+      comm->AllGather(send.data(), recv.data(), count * sizeof(float));
+    } else if (collective == "reduce_scatter") {
+      comm->ReduceScatter(send.data(), recv.data(), count, dtype, CPUReduceOp::kSum);
+    } else if (collective == "broadcast") {
+      comm->Broadcast(send.data(), recv.data(), count * sizeof(float), 0);
+    } else if (collective == "all_to_all") {
+      comm->AllToAll(send.data(), recv.data(), count * sizeof(float));
+    } else {
+      LOG(FATAL) << "Unknown collective " << collective;
+    }
+  };
+  for (int i = 0; i < warmup; ++i) {
+    run();
+  }
+  comm->Barrier();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < number; ++i) {
+    run();
+  }
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  // Report the slowest rank, which bounds the collective.
+  double latency = elapsed / number;
+  comm->AllReduce(&latency, &latency, 1, DType(DTypeCode::kFloat(), 64), CPUReduceOp::kMax);
+  return latency;
+}
+
+RAF_REGISTER_GLOBAL("raf.distributed.BenchmarkCPUCollective")
+    .set_body_typed(BenchmarkCPUCollective);
+
+CPUCommWorker::~CPUCommWorker() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+CPUCommWorker* CPUCommWorker::Get() {
+  static CPUCommWorker inst;
+  return &inst;
+}
+
+int64_t CPUCommWorker::Submit(std::function<void()> task, std::shared_ptr<void> result) {
+  std::packaged_task<void()> packaged(std::move(task));
+  std::lock_guard<std::mutex> lock(mu_);
+  int64_t ticket = num_submitted_++;
+  pending_[ticket] = Pending{packaged.get_future().share(), std::move(result)};
+  queue_.push_back(std::move(packaged));
+  if (!thread_.joinable()) {
+    thread_ = std::thread([this]() { Run(); });
+  }
+  cv_.notify_all();
+  return ticket;
+}
+
+std::shared_ptr<void> CPUCommWorker::Wait(int64_t ticket) {
+  Pending pending;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = pending_.find(ticket);
+    CHECK(it != pending_.end()) << "Ticket " << ticket << " is not submitted or already waited";
+    pending = std::move(it->second);
+    pending_.erase(it);
+  }
+  pending.future.get();
+  return pending.result;
+}
+
+void CPUCommWorker::Flush() {
+  if (std::this_thread::get_id() == thread_.get_id()) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(mu_);
+  cv_.wait(lock, [this]() { return num_finished_ == num_submitted_; });
+}
+
+void CPUCommWorker::Run() {
+  while (true) {
+    std::packaged_task<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      task = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    // The error of the task is stored in its future and rethrown by Wait.
+    task();
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      ++num_finished_;
+    }
+    cv_.notify_all();
+  }
+}
+
+}  // namespace communicator
+}  // namespace distributed
+}  // namespace raf
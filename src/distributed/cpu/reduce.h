@@ -0,0 +1,139 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/distributed/cpu/reduce.h
+ * \brief The element-wise reductions of the CPU collectives.
+ */
+#pragma once
+#include <builtin_fp16.h>
+#include <algorithm>
+#include <cstring>
+#include "raf/cpu_communicator.h"
+
+namespace raf {
+namespace distributed {
+namespace communicator {
+
+/*!
+ * \brief A 16-bit float of the collectives, which is reduced in float32 and rounded back per
+ * element. Traits converts it with float32.
+ */
+template <typename Traits>
+struct Float16Storage {
+  uint16_t bits;
+
+  Float16Storage() = default;
+  explicit Float16Storage(float value) : bits(Traits::FromFloat(value)) {
+  }
+  explicit Float16Storage(int value) : Float16Storage(static_cast<float>(value)) {
+  }
+  float ToFloat() const {
+    return Traits::ToFloat(bits);
+  }
+  Float16Storage& operator+=(Float16Storage other) {
+    return *this = Float16Storage(ToFloat() + other.ToFloat());
+  }
+  Float16Storage& operator*=(Float16Storage other) {
+    return *this = Float16Storage(ToFloat() * other.ToFloat());
+  }
+  Float16Storage& operator/=(Float16Storage other) {
+    return *this = Float16Storage(ToFloat() / other.ToFloat());
+  }
+  bool operator<(Float16Storage other) const {
+    return ToFloat() < other.ToFloat();
+  }
+};
+
+struct HalfTraits {
+  static float ToFloat(uint16_t bits) {
+    return __extendXfYf2__<uint16_t, uint16_t, 10, float, uint32_t, 23>(bits);
+  }
+  static uint16_t FromFloat(float value) {
+    return __truncXfYf2__<float, uint32_t, 23, uint16_t, uint16_t, 10>(value);
+  }
+};
+
+struct BFloat16Traits {
+  static float ToFloat(uint16_t bits) {
+    uint32_t word = static_cast<uint32_t>(bits) << 16;
+    float value;
+    std::memcpy(&value, &word, sizeof(value));
+    return value;
+  }
+  static uint16_t FromFloat(float value) {
+    uint32_t word;
+    std::memcpy(&word, &value, sizeof(word));
+    if ((word & 0x7fffffffu) > 0x7f800000u) {
+      // Keep NaN a quiet NaN instead of rounding it to infinity.
+      return static_cast<uint16_t>((word >> 16) | 0x40);
+    }
+    // Round to the nearest even.
+    word += 0x7fffu + ((word >> 16) & 1u);
+    return static_cast<uint16_t>(word >> 16);
+  }
+};
+
+using Half = Float16Storage<HalfTraits>;
+using BFloat16 = Float16Storage<BFloat16Traits>;
+
+/*! \brief Call f with a value of the C++ type of dtype, or return false if there is none. */
+template <typename F>
+bool DispatchReduceType(DLDataType dtype, F f) {
+  if (dtype.lanes != 1) {
+    return false;
+  }
+  if (dtype.code == kDLFloat && dtype.bits == 32) {
+    f(float());
+  } else if (dtype.code == kDLFloat && dtype.bits == 64) {
+    f(double());
+  } else if (dtype.code == kDLFloat && dtype.bits == 16) {
+    f(Half());
+  } else if (dtype.code == kDLBfloat && dtype.bits == 16) {
+    f(BFloat16());
+  } else if (dtype.code == kDLInt && dtype.bits == 32) {
+    f(int32_t());
+  } else if (dtype.code == kDLInt && dtype.bits == 64) {
+    f(int64_t());
+  } else if (dtype.code == kDLInt && dtype.bits == 8) {
+    f(int8_t());
+  } else if (dtype.code == kDLUInt && dtype.bits == 8) {
+    f(uint8_t());
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/*! \brief dst[i] = op(dst[i], src[i]), where avg sums up and is divided by Finalize. */
+template <typename T>
+void ReduceInto(T* dst, const T* src, int64_t n, CPUReduceOp op) {
+  switch (op) {
+    case CPUReduceOp::kSum:
+    case CPUReduceOp::kAvg:
+      for (int64_t i = 0; i < n; ++i) dst[i] += src[i];
+      return;
+    case CPUReduceOp::kProd:
+      for (int64_t i = 0; i < n; ++i) dst[i] *= src[i];
+      return;
+    case CPUReduceOp::kMin:
+      for (int64_t i = 0; i < n; ++i) dst[i] = std::min(dst[i], src[i]);
+      return;
+    case CPUReduceOp::kMax:
+      for (int64_t i = 0; i < n; ++i) dst[i] = std::max(dst[i], src[i]);
+      return;
+  }
+}
+
+template <typename T>
+void Finalize(T* dst, int64_t n, CPUReduceOp op, int size) {
+  if (op == CPUReduceOp::kAvg) {
+    for (int64_t i = 0; i < n; ++i) dst[i] /= static_cast<T>(size);
+  }
+}
+
+}  // namespace communicator
+}  // namespace distributed
+}  // namespace raf
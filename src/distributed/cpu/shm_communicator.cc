@@ -0,0 +1,480 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/distributed/cpu/shm_communicator.cc
+ * \brief Shared-memory Communicator.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+#include "raf/shm_communicator.h"
+#include "./reduce.h"
+
+namespace raf {
+namespace distributed {
+namespace communicator {
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+              "Atomics in shared memory must be lock-free");
+
+/*! \brief The default bytes of the slot of a rank, overridden by RAF_SHM_CHUNK_BYTES. */
+constexpr int64_t kDefaultChunkBytes = 1 << 20;
+/*! \brief The bytes of the mailbox of a pair of ranks, relative to the slot. */
+constexpr int64_t kMailboxDivisor = 4;
+/*! \brief How long a rank waits for the others to attach the segment. */
+constexpr std::chrono::seconds kRendezvousTimeout(300);
+/*! \brief The spins on a flag before yielding, so that oversubscribed ranks make progress. */
+constexpr int kSpinsBeforeYield = 256;
+constexpr int64_t kCacheLine = 64;
+constexpr int64_t kPageBytes = 4096;
+
+/*! \brief A flag on its own cache line, so that polling ranks do not contend with the writer. */
+struct alignas(kCacheLine) ShmFlag {
+  std::atomic<uint64_t> value;
+};
+
+struct alignas(kCacheLine) ShmHeader {
+  /*! \brief The generation of the segment, published once it is initialized. */
+  std::atomic<uint64_t> ready;
+  /*! \brief The number of non-root ranks that have attached the segment. */
+  std::atomic<int32_t> attached;
+  int32_t size;
+  int64_t chunk_bytes;
+  int64_t mailbox_bytes;
+  int64_t total_bytes;
+};
+
+inline int64_t AlignUp(int64_t value, int64_t align) {
+  return (value + align - 1) / align * align;
+}
+
+inline void SpinWait(int* spins) {
+  if (++*spins < kSpinsBeforeYield) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+  } else {
+    std::this_thread::yield();
+  }
+}
+
+/*!
+ * \brief The mapping of the segment in this process. It holds, in order, the header, the barrier
+ * flag of each rank, the send and acknowledge flags of the mailbox of each pair of ranks, two sets
+ * of slots of chunk_bytes per rank, and the mailboxes of mailbox_bytes per pair of ranks.
+ */
+struct ShmSegment {
+  std::string name;
+  uint8_t* base = nullptr;
+  int64_t total_bytes = 0;
+  int size = 0;
+  int rank = 0;
+  int64_t chunk_bytes = 0;
+  int64_t mailbox_bytes = 0;
+  ShmHeader* header = nullptr;
+  ShmFlag* arrive = nullptr;
+  ShmFlag* sent = nullptr;
+  ShmFlag* acked = nullptr;
+  uint8_t* slots = nullptr;
+  uint8_t* mailboxes = nullptr;
+  /*! \brief The barriers passed, which every rank counts alike. */
+  uint64_t barrier_seq = 0;
+  /*! \brief The chunks moved, which alternate between the two sets of slots. */
+  uint64_t step = 0;
+
+  static int64_t LayoutBytes(int size, int64_t chunk_bytes, int64_t mailbox_bytes) {
+    int64_t pairs = static_cast<int64_t>(size) * size;
+    int64_t flags = AlignUp(sizeof(ShmHeader), kCacheLine) + (size + 2 * pairs) * kCacheLine;
+    return AlignUp(flags, kPageBytes) + 2 * size * chunk_bytes + pairs * mailbox_bytes;
+  }
+
+  void Map(uint8_t* base, int64_t total_bytes) {
+    this->base = base;
+    this->total_bytes = total_bytes;
+    header = reinterpret_cast<ShmHeader*>(base);
+    size = header->size;
+    chunk_bytes = header->chunk_bytes;
+    mailbox_bytes = header->mailbox_bytes;
+    int64_t pairs = static_cast<int64_t>(size) * size;
+    uint8_t* ptr = base + AlignUp(sizeof(ShmHeader), kCacheLine);
+    arrive = reinterpret_cast<ShmFlag*>(ptr);
+    sent = arrive + size;
+    acked = sent + pairs;
+    slots = base + AlignUp(reinterpret_cast<uint8_t*>(acked + pairs) - base, kPageBytes);
+    mailboxes = slots + 2 * size * chunk_bytes;
+  }
+
+  /*! \brief The set of slots of the next chunk. */
+  uint8_t* NextSlots() {
+    return slots + (step++ % 2) * size * chunk_bytes;
+  }
+
+  uint8_t* Slot(uint8_t* set, int r) const {
+    return set + r * chunk_bytes;
+  }
+
+  void Barrier() {
+    uint64_t seq = ++barrier_seq;
+    arrive[rank].value.store(seq, std::memory_order_release);
+    for (int r = 0; r < size; ++r) {
+      int spins = 0;
+      while (arrive[r].value.load(std::memory_order_acquire) < seq) {
+        SpinWait(&spins);
+      }
+    }
+  }
+};
+
+/*! \brief The name of the segment shared by the given ranks. */
+std::string SegmentName(const std::vector<int64_t>& members) {
+  const char* session = getenv("RAF_SHM_SESSION");
+  // Processes started by one launcher share the parent, which tells concurrent jobs apart.
+  std::string prefix = session != nullptr ? std::string(session) : std::to_string(getppid());
+  std::string key;
+  for (auto r : members) {
+    key += std::to_string(r) + ",";
+  }
+  return "/raf_shm_" + prefix + "_" + std::to_string(std::hash<std::string>{}(key));
+}
+
+int64_t ChunkBytes(int size) {
+  const char* env = getenv("RAF_SHM_CHUNK_BYTES");
+  int64_t chunk_bytes = env != nullptr ? std::atoll(env) : kDefaultChunkBytes;
+  // Every rank gets at least a cache line of a chunk in ReduceScatter and AllToAll.
+  chunk_bytes = AlignUp(std::max(chunk_bytes, size * kCacheLine), kCacheLine * kMailboxDivisor);
+  return chunk_bytes;
+}
+
+/*!
+ * \brief Create (on rank 0) or attach (on the other ranks) the segment of the group. The name is
+ * unlinked once every rank has attached, so the segment is released when the processes exit. A
+ * generation tells the segments apart when a group creates its communicator again.
+ */
+ShmSegment* AttachSegment(const std::string& name, int size, int rank) {
+  static std::unordered_map<std::string, uint64_t> generations;
+  uint64_t generation = ++generations[name];
+  auto deadline = std::chrono::steady_clock::now() + kRendezvousTimeout;
+  auto segment = std::make_unique<ShmSegment>();
+  segment->name = name;
+  segment->rank = rank;
+
+  if (rank == 0) {
+    int64_t chunk_bytes = ChunkBytes(size);
+    int64_t mailbox_bytes = chunk_bytes / kMailboxDivisor;
+    int64_t total_bytes = ShmSegment::LayoutBytes(size, chunk_bytes, mailbox_bytes);
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    CHECK_GE(fd, 0) << "shm_open(" << name << "): " << strerror(errno);
+    CHECK_EQ(ftruncate(fd, total_bytes), 0) << "ftruncate(" << name << "): " << strerror(errno);
+    void* base = mmap(nullptr, total_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    CHECK(base != MAP_FAILED) << "mmap(" << name << "): " << strerror(errno);
+    // The new pages are zero-filled, which is the initial value of every flag.
+    auto header = static_cast<ShmHeader*>(base);
+    header->size = size;
+    header->chunk_bytes = chunk_bytes;
+    header->mailbox_bytes = mailbox_bytes;
+    header->total_bytes = total_bytes;
+    segment->Map(static_cast<uint8_t*>(base), total_bytes);
+    header->ready.store(generation, std::memory_order_release);
+    int spins = 0;
+    while (header->attached.load(std::memory_order_acquire) < size - 1) {
+      CHECK(std::chrono::steady_clock::now() < deadline)
+          << "Timed out waiting for the ranks to attach " << name;
+      SpinWait(&spins);
+    }
+    shm_unlink(name.c_str());
+    return segment.release();
+  }
+
+  while (true) {
+    CHECK(std::chrono::steady_clock::now() < deadline)
+        << "Timed out waiting for rank 0 to create " << name;
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+      CHECK_EQ(errno, ENOENT) << "shm_open(" << name << "): " << strerror(errno);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      continue;
+    }
+    struct stat st;
+    void* base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(ShmHeader))) {
+      base = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (base != MAP_FAILED) {
+      auto header = static_cast<ShmHeader*>(base);
+      // A segment of an earlier generation may not be unlinked yet.
+      if (header->ready.load(std::memory_order_acquire) == generation &&
+          header->total_bytes == st.st_size) {
+        CHECK_EQ(header->size, size) << "Ranks disagree on the size of " << name;
+        segment->Map(static_cast<uint8_t*>(base), st.st_size);
+        header->attached.fetch_add(1, std::memory_order_acq_rel);
+        return segment.release();
+      }
+      munmap(base, st.st_size);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+/*! \brief dst = op(dst, the slot of every rank but self at offset) on n elements. */
+template <typename T>
+void ReduceSlots(const ShmSegment* seg, uint8_t* set, int64_t offset, T* dst, int64_t n,
+                 CPUReduceOp op, int self) {
+  for (int r = 0; r < seg->size; ++r) {
+    if (r != self) {
+      ReduceInto(dst, reinterpret_cast<const T*>(seg->Slot(set, r) + offset), n, op);
+    }
+  }
+  Finalize(dst, n, op, seg->size);
+}
+
+ShmCommunicatorObj::~ShmCommunicatorObj() {
+  if (segment != nullptr) {
+    munmap(segment->base, segment->total_bytes);
+    delete segment;
+  }
+}
+
+void ShmCommunicatorObj::AllReduce(const void* send, void* recv, int64_t count, DType dtype,
+                                   CPUReduceOp op) {
+  int64_t elem_bytes = (dtype.bits + 7) / 8;
+  if (segment == nullptr) {
+    if (send != recv) memcpy(recv, send, count * elem_bytes);
+    return;
+  }
+  ShmSegment* seg = segment;
+  auto in = static_cast<const uint8_t*>(send);
+  auto out = static_cast<uint8_t*>(recv);
+  int64_t step_count = seg->chunk_bytes / elem_bytes;
+  bool supported = DispatchReduceType(dtype, [&](auto type) {
+    using T = decltype(type);
+    for (int64_t offset = 0; offset < count; offset += step_count) {
+      int64_t n = std::min(step_count, count - offset);
+      uint8_t* set = seg->NextSlots();
+      uint8_t* mine = seg->Slot(set, rank);
+      memcpy(mine, in + offset * elem_bytes, n * elem_bytes);
+      seg->Barrier();
+      // Every rank reduces its share of the chunk into its own slot.
+      int64_t begin = n * rank / size;
+      int64_t end = n * (rank + 1) / size;
+      auto dst = reinterpret_cast<T*>(mine + begin * elem_bytes);
+      ReduceSlots<T>(seg, set, begin * elem_bytes, dst, end - begin, op, rank);
+      seg->Barrier();
+      for (int r = 0; r < size; ++r) {
+        int64_t r_begin = n * r / size;
+        int64_t r_end = n * (r + 1) / size;
+        memcpy(out + (offset + r_begin) * elem_bytes, seg->Slot(set, r) + r_begin * elem_bytes,
+               (r_end - r_begin) * elem_bytes);
+      }
+    }
+  });
+  CHECK(supported) << "NotImplementedError: AllReduce of " << dtype.c_str();
+}
+
+void ShmCommunicatorObj::AllGather(const void* send, void* recv, int64_t bytes) {
+  if (segment == nullptr) {
+    if (send != recv) memcpy(recv, send, bytes);
+    return;
+  }
+  ShmSegment* seg = segment;
+  auto in = static_cast<const uint8_t*>(send);
+  auto out = static_cast<uint8_t*>(recv);
+  for (int64_t offset = 0; offset < bytes; offset += seg->chunk_bytes) {
+    int64_t n = std::min(seg->chunk_bytes, bytes - offset);
+    uint8_t* set = seg->NextSlots();
+    memcpy(seg->Slot(set, rank), in + offset, n);
+    seg->Barrier();
+    for (int r = 0; r < size; ++r) {
+      memcpy(out + r * bytes + offset, seg->Slot(set, r), n);
+    }
+  }
+}
+
+void ShmCommunicatorObj::ReduceScatter(const void* send, void* recv, int64_t count, DType dtype,
+                                       CPUReduceOp op) {
+  int64_t elem_bytes = (dtype.bits + 7) / 8;
+  if (segment == nullptr) {
+    if (send != recv) memcpy(recv, send, count * elem_bytes);
+    return;
+  }
+  ShmSegment* seg = segment;
+  auto in = static_cast<const uint8_t*>(send);
+  auto out = static_cast<uint8_t*>(recv);
+  // A chunk holds a piece of every block, so that each rank reduces its own piece.
+  int64_t piece_count = seg->chunk_bytes / size / elem_bytes;
+  int64_t piece_bytes = piece_count * elem_bytes;
+  bool supported = DispatchReduceType(dtype, [&](auto type) {
+    using T = decltype(type);
+    for (int64_t offset = 0; offset < count; offset += piece_count) {
+      int64_t n = std::min(piece_count, count - offset);
+      uint8_t* set = seg->NextSlots();
+      uint8_t* mine = seg->Slot(set, rank);
+      for (int r = 0; r < size; ++r) {
+        memcpy(mine + r * piece_bytes, in + (r * count + offset) * elem_bytes, n * elem_bytes);
+      }
+      seg->Barrier();
+      uint8_t* dst = out + offset * elem_bytes;
+      memcpy(dst, mine + rank * piece_bytes, n * elem_bytes);
+      ReduceSlots<T>(seg, set, rank * piece_bytes, reinterpret_cast<T*>(dst), n, op, rank);
+    }
+  });
+  CHECK(supported) << "NotImplementedError: ReduceScatter of " << dtype.c_str();
+}
+
+void ShmCommunicatorObj::Broadcast(const void* send, void* recv, int64_t bytes, int root) {
+  if (rank == root && send != recv) {
+    memcpy(recv, send, bytes);
+  }
+  if (segment == nullptr) {
+    return;
+  }
+  ShmSegment* seg = segment;
+  auto in = static_cast<const uint8_t*>(send);
+  auto out = static_cast<uint8_t*>(recv);
+  for (int64_t offset = 0; offset < bytes; offset += seg->chunk_bytes) {
+    int64_t n = std::min(seg->chunk_bytes, bytes - offset);
+    uint8_t* set = seg->NextSlots();
+    if (rank == root) {
+      memcpy(seg->Slot(set, root), in + offset, n);
+    }
+    seg->Barrier();
+    if (rank != root) {
+      memcpy(out + offset, seg->Slot(set, root), n);
+    }
+  }
+}
+
+void ShmCommunicatorObj::AllToAll(const void* send, void* recv, int64_t bytes) {
+  if (segment == nullptr) {
+    if (send != recv) memcpy(recv, send, bytes);
+    return;
+  }
+  ShmSegment* seg = segment;
+  auto in = static_cast<const uint8_t*>(send);
+  auto out = static_cast<uint8_t*>(recv);
+  int64_t piece_bytes = seg->chunk_bytes / size;
+  for (int64_t offset = 0; offset < bytes; offset += piece_bytes) {
+    int64_t n = std::min(piece_bytes, bytes - offset);
+    uint8_t* set = seg->NextSlots();
+    uint8_t* mine = seg->Slot(set, rank);
+    for (int r = 0; r < size; ++r) {
+      memcpy(mine + r * piece_bytes, in + r * bytes + offset, n);
+    }
+    seg->Barrier();
+    for (int r = 0; r < size; ++r) {
+      memcpy(out + r * bytes + offset, seg->Slot(set, r) + rank * piece_bytes, n);
+    }
+  }
+}
+
+void ShmCommunicatorObj::Send(const void* data, int64_t bytes, int peer) {
+  CHECK(segment != nullptr && peer != rank && peer >= 0 && peer < size)
+      << "Invalid peer " << peer << " of rank " << rank;
+  ShmSegment* seg = segment;
+  int64_t pair = static_cast<int64_t>(rank) * size + peer;
+  uint8_t* mailbox = seg->mailboxes + pair * seg->mailbox_bytes;
+  auto in = static_cast<const uint8_t*>(data);
+  for (int64_t offset = 0; offset < bytes; offset += seg->mailbox_bytes) {
+    int64_t n = std::min(seg->mailbox_bytes, bytes - offset);
+    // Only this rank writes the sent flag, so it holds the messages sent so far.
+    uint64_t sent = seg->sent[pair].value.load(std::memory_order_relaxed);
+    int spins = 0;
+    while (seg->acked[pair].value.load(std::memory_order_acquire) < sent) {
+      SpinWait(&spins);
+    }
+    memcpy(mailbox, in + offset, n);
+    seg->sent[pair].value.store(sent + 1, std::memory_order_release);
+  }
+}
+
+void ShmCommunicatorObj::Recv(void* data, int64_t bytes, int peer) {
+  CHECK(segment != nullptr && peer != rank && peer >= 0 && peer < size)
+      << "Invalid peer " << peer << " of rank " << rank;
+  ShmSegment* seg = segment;
+  int64_t pair = static_cast<int64_t>(peer) * size + rank;
+  const uint8_t* mailbox = seg->mailboxes + pair * seg->mailbox_bytes;
+  auto out = static_cast<uint8_t*>(data);
+  for (int64_t offset = 0; offset < bytes; offset += seg->mailbox_bytes) {
+    int64_t n = std::min(seg->mailbox_bytes, bytes - offset);
+    // Only this rank writes the acknowledge flag, so it holds the messages received so far.
+    uint64_t acked = seg->acked[pair].value.load(std::memory_order_relaxed);
+    int spins = 0;
+    while (seg->sent[pair].value.load(std::memory_order_acquire) <= acked) {
+      SpinWait(&spins);
+    }
+    memcpy(out + offset, mailbox, n);
+    seg->acked[pair].value.store(acked + 1, std::memory_order_release);
+  }
+}
+
+void ShmCommunicatorObj::Barrier() {
+  if (segment != nullptr) {
+    segment->Barrier();
+  }
+}
+
+ShmCommunicator ShmCommunicator::make(Value rank_list) {
+  auto global_comm = GetGlobalCommunicator();
+  auto obj = make_object<ShmCommunicatorObj>();
+  obj->parent_comm = global_comm;
+
+  std::vector<int64_t> members;
+  if (!rank_list.defined()) {
+    // Create Global Communicator
+    obj->local_size = global_comm->local_size;
+    obj->local_rank = global_comm->local_rank;
+    obj->size = global_comm->size;
+    obj->rank = global_comm->rank;
+    obj->world_size = global_comm->world_size;
+    obj->world_rank = global_comm->world_rank;
+    obj->root_rank = global_comm->root_rank;
+    obj->group_id = -1;
+    obj->group_size = 0;
+    obj->host_ids = global_comm->host_ids;
+    members.resize(obj->size);
+    std::iota(members.begin(), members.end(), 0);
+  } else {
+    // Create Sub-communicator
+    InitSubCommunicator(obj.get(), rank_list, global_comm);
+    if (obj->group_id != -1) {
+      auto group = Downcast<TupleValue>(Downcast<TupleValue>(rank_list)->fields[obj->group_id]);
+      for (auto rank : group->fields) {
+        members.push_back(Downcast<IntValue>(rank)->value);
+      }
+    }
+  }
+
+  for (auto host_id : obj->host_ids) {
+    CHECK_EQ(host_id, obj->host_ids[0]) << "ShmCommunicator requires all the ranks on one host.";
+  }
+  if (obj->size > 1) {
+    obj->segment = AttachSegment(SegmentName(members), obj->size, obj->rank);
+  }
+  return ShmCommunicator(obj);
+}
+
+RAF_REGISTER_GLOBAL("raf.distributed.communicator._make.shm").set_body_typed(ShmCommunicator::make);
+
+RAF_REGISTER_OBJECT_REFLECT(ShmCommunicatorObj);
+
+}  // namespace communicator
+}  // namespace distributed
+}  // namespace raf
@@ -0,0 +1,899 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/distributed/cpu/tcp_communicator.cc
+ * \brief TCP socket Communicator.
+ */
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <map>
+#include <numeric>
+#include <set>
+#include <thread>
+#include "raf/tcp_communicator.h"
+#include "./collective_planner.h"
+#include "./reduce.h"
+
+namespace raf {
+namespace distributed {
+namespace communicator {
+
+/*! \brief The default bytes of a pipelined chunk, overridden by RAF_TCP_CHUNK_BYTES. */
+constexpr int64_t kDefaultChunkBytes = 1 << 18;
+/*! \brief How long a rank waits for the others to join the rendezvous. */
+constexpr std::chrono::seconds kRendezvousTimeout(300);
+
+/*! \brief The address of a rank, which it publishes in the rendezvous. */
+struct TcpPeerInfo {
+  char host[64];
+  int32_t port;
+  uint64_t host_id;
+};
+
+int64_t TcpChunkBytes() {
+  const char* env = getenv("RAF_TCP_CHUNK_BYTES");
+  int64_t chunk_bytes = env != nullptr ? std::atoll(env) : kDefaultChunkBytes;
+  // A chunk holds whole elements of any dtype.
+  return std::max<int64_t>(chunk_bytes / 8 * 8, 8);
+}
+
+/*!
+ * \brief The host that this rank reports in the rendezvous, which decides the hierarchical
+ * collectives. RAF_TCP_HOST_ID overrides it, e.g., to emulate several hosts with local processes.
+ */
+uint64_t TcpHostID() {
+  if (const char* env = getenv("RAF_TCP_HOST_ID")) {
+    return std::strtoull(env, nullptr, 10);
+  }
+  return Communicator::GetHostID();
+}
+
+void SetNoDelay(int fd) {
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+void SetNonBlocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  CHECK_EQ(fcntl(fd, F_SETFL, flags | O_NONBLOCK), 0) << "fcntl: " << strerror(errno);
+}
+
+/*! \brief Write or read all the bytes on a blocking socket. */
+void WriteAll(int fd, const void* data, int64_t bytes) {
+  auto ptr = static_cast<const uint8_t*>(data);
+  while (bytes > 0) {
+    ssize_t n = ::send(fd, ptr, bytes, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    CHECK_GT(n, 0) << "send: " << strerror(errno);
+    ptr += n;
+    bytes -= n;
+  }
+}
+
+void ReadAll(int fd, void* data, int64_t bytes) {
+  auto ptr = static_cast<uint8_t*>(data);
+  while (bytes > 0) {
+    ssize_t n = ::recv(fd, ptr, bytes, 0);
+    if (n < 0 && errno == EINTR) continue;
+    CHECK_GT(n, 0) << "recv: " << (n == 0 ? "connection closed by peer" : strerror(errno));
+    ptr += n;
+    bytes -= n;
+  }
+}
+
+/*! \brief Listen on the port of all the interfaces, where port 0 picks a free one. */
+int Listen(int port, int* bound_port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  CHECK_GE(fd, 0) << "socket: " << strerror(errno);
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  CHECK_EQ(bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0)
+      << "bind(" << port << "): " << strerror(errno);
+  CHECK_EQ(listen(fd, SOMAXCONN), 0) << "listen: " << strerror(errno);
+  socklen_t len = sizeof(addr);
+  getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+  *bound_port = ntohs(addr.sin_port);
+  return fd;
+}
+
+int Accept(int listen_fd) {
+  while (true) {
+    int fd = accept(listen_fd, nullptr, nullptr);
+    if (fd >= 0) return fd;
+    CHECK_EQ(errno, EINTR) << "accept: " << strerror(errno);
+  }
+}
+
+/*! \brief Connect to host:port, retrying until the peer listens. */
+int Connect(const std::string& host, int port) {
+  auto deadline = std::chrono::steady_clock::now() + kRendezvousTimeout;
+  addrinfo hints{};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  while (true) {
+    addrinfo* res = nullptr;
+    int err = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res);
+    if (err == 0) {
+      int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+      CHECK_GE(fd, 0) << "socket: " << strerror(errno);
+      int ret = connect(fd, res->ai_addr, res->ai_addrlen);
+      freeaddrinfo(res);
+      if (ret == 0) {
+        return fd;
+      }
+      close(fd);
+    }
+    CHECK(std::chrono::steady_clock::now() < deadline)
+        << "Timed out connecting to " << host << ":" << port << ": "
+        << (err != 0 ? gai_strerror(err) : strerror(errno));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
+/*! \brief The address of this host that the other ranks can reach. */
+std::string LocalAddress(int connected_fd) {
+  if (const char* ifaddr = getenv("RAF_TCP_IFADDR")) {
+    return ifaddr;
+  }
+  sockaddr_in addr{};
+  socklen_t len = sizeof(addr);
+  char buf[INET_ADDRSTRLEN];
+  // The interface that reaches the rendezvous reaches the other ranks as well.
+  if (connected_fd >= 0 &&
+      getsockname(connected_fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0 &&
+      inet_ntop(AF_INET, &addr.sin_addr, buf, sizeof(buf)) != nullptr) {
+    return buf;
+  }
+  char hostname[256];
+  addrinfo hints{};
+  hints.ai_family = AF_INET;
+  addrinfo* res = nullptr;
+  if (gethostname(hostname, sizeof(hostname)) == 0 &&
+      getaddrinfo(hostname, nullptr, &hints, &res) == 0) {
+    auto sin = reinterpret_cast<sockaddr_in*>(res->ai_addr);
+    std::string host = inet_ntop(AF_INET, &sin->sin_addr, buf, sizeof(buf)) ? buf : "127.0.0.1";
+    freeaddrinfo(res);
+    return host;
+  }
+  return "127.0.0.1";
+}
+
+void SetHost(TcpPeerInfo* info, const std::string& host) {
+  CHECK_LT(host.size(), sizeof(info->host)) << "Host name too long: " << host;
+  snprintf(info->host, sizeof(info->host), "%s", host.c_str());
+}
+
+/*!
+ * \brief Exchange the addresses through the store of rank 0 at host:port. Every other rank sends
+ * its address to rank 0, which replies with the addresses of all the ranks.
+ */
+std::vector<TcpPeerInfo> StoreRendezvous(const std::string& addr, int rank, int size,
+                                         TcpPeerInfo self) {
+  auto colon = addr.rfind(':');
+  CHECK(colon != std::string::npos) << "RAF_TCP_ADDR must be host:port, but got " << addr;
+  std::string host = addr.substr(0, colon);
+  int port = std::atoi(addr.substr(colon + 1).c_str());
+  std::vector<TcpPeerInfo> table(size);
+  if (rank == 0) {
+    int bound_port;
+    int listen_fd = Listen(port, &bound_port);
+    if (getenv("RAF_TCP_IFADDR") == nullptr) {
+      SetHost(&self, host);
+    }
+    table[0] = self;
+    std::vector<int> fds(size, -1);
+    for (int i = 1; i < size; ++i) {
+      int fd = Accept(listen_fd);
+      int32_t peer;
+      ReadAll(fd, &peer, sizeof(peer));
+      CHECK(peer > 0 && peer < size && fds[peer] < 0) << "Invalid rank " << peer << " joined";
+      ReadAll(fd, &table[peer], sizeof(TcpPeerInfo));
+      fds[peer] = fd;
+    }
+    close(listen_fd);
+    for (int i = 1; i < size; ++i) {
+      WriteAll(fds[i], table.data(), size * sizeof(TcpPeerInfo));
+      close(fds[i]);
+    }
+    return table;
+  }
+  int fd = Connect(host, port);
+  SetHost(&self, LocalAddress(fd));
+  int32_t me = rank;
+  WriteAll(fd, &me, sizeof(me));
+  WriteAll(fd, &self, sizeof(TcpPeerInfo));
+  ReadAll(fd, table.data(), size * sizeof(TcpPeerInfo));
+  close(fd);
+  return table;
+}
+
+/*!
+ * \brief Exchange the addresses through the files in dir, which every rank writes atomically and
+ * polls for the others. RAF_TCP_SESSION tells concurrent jobs sharing dir apart.
+ */
+std::vector<TcpPeerInfo> FileRendezvous(const std::string& dir, int rank, int size,
+                                        TcpPeerInfo self) {
+  const char* session = getenv("RAF_TCP_SESSION");
+  std::string prefix = dir + "/raf_tcp_" + (session ? session : "default") + ".";
+  SetHost(&self, LocalAddress(-1));
+  std::string path = prefix + std::to_string(rank);
+  {
+    std::ofstream file(path + ".tmp", std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&self), sizeof(self));
+    CHECK(file.good()) << "Failed to write " << path;
+  }
+  CHECK_EQ(std::rename((path + ".tmp").c_str(), path.c_str()), 0)
+      << "rename(" << path << "): " << strerror(errno);
+  auto deadline = std::chrono::steady_clock::now() + kRendezvousTimeout;
+  std::vector<TcpPeerInfo> table(size);
+  for (int i = 0; i < size; ++i) {
+    std::string peer = prefix + std::to_string(i);
+    while (true) {
+      std::ifstream file(peer, std::ios::binary);
+      if (file.read(reinterpret_cast<char*>(&table[i]), sizeof(TcpPeerInfo))) {
+        break;
+      }
+      CHECK(std::chrono::steady_clock::now() < deadline) << "Timed out waiting for " << peer;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  return table;
+}
+
+/*!
+ * \brief The connections of this process to every global rank, which the rendezvous establishes
+ * once per process. Rank i connects to every rank above it and accepts the ranks below it.
+ */
+struct TcpMesh {
+  int rank = 0;
+  int size = 1;
+  std::vector<int> sockets;
+  std::vector<uint64_t> host_ids;
+
+  ~TcpMesh() {
+    for (int fd : sockets) {
+      if (fd >= 0) close(fd);
+    }
+  }
+
+  static std::shared_ptr<TcpMesh> Get(int rank, int size) {
+    static std::mutex mu;
+    static std::shared_ptr<TcpMesh> mesh;
+    std::lock_guard<std::mutex> lock(mu);
+    if (mesh == nullptr) {
+      mesh = std::make_shared<TcpMesh>();
+      mesh->Connect(rank, size);
+    }
+    CHECK(mesh->rank == rank && mesh->size == size)
+        << "The TCP connections were set up for rank " << mesh->rank << " of " << mesh->size;
+    return mesh;
+  }
+
+  void Connect(int rank, int size) {
+    this->rank = rank;
+    this->size = size;
+    sockets.assign(size, -1);
+    host_ids.assign(size, TcpHostID());
+    if (size == 1) {
+      return;
+    }
+    int port;
+    int listen_fd = Listen(0, &port);
+    TcpPeerInfo self{};
+    self.port = port;
+    self.host_id = TcpHostID();
+    std::vector<TcpPeerInfo> table;
+    if (const char* addr = getenv("RAF_TCP_ADDR")) {
+      table = StoreRendezvous(addr, rank, size, self);
+    } else if (const char* dir = getenv("RAF_TCP_RENDEZVOUS_DIR")) {
+      table = FileRendezvous(dir, rank, size, self);
+    } else {
+      LOG(FATAL) << "TcpCommunicator requires RAF_TCP_ADDR or RAF_TCP_RENDEZVOUS_DIR";
+    }
+    // The backlog completes the connections to the ranks that are not accepting yet.
+    for (int peer = rank + 1; peer < size; ++peer) {
+      int fd = ::raf::distributed::communicator::Connect(table[peer].host, table[peer].port);
+      int32_t me = rank;
+      WriteAll(fd, &me, sizeof(me));
+      sockets[peer] = fd;
+    }
+    for (int i = 0; i < rank; ++i) {
+      int fd = Accept(listen_fd);
+      int32_t peer;
+      ReadAll(fd, &peer, sizeof(peer));
+      CHECK(peer >= 0 && peer < rank && sockets[peer] < 0) << "Invalid rank " << peer;
+      sockets[peer] = fd;
+    }
+    close(listen_fd);
+    for (int peer = 0; peer < size; ++peer) {
+      host_ids[peer] = table[peer].host_id;
+      if (sockets[peer] >= 0) {
+        SetNoDelay(sockets[peer]);
+        SetNonBlocking(sockets[peer]);
+      }
+    }
+    if (getenv("RAF_TCP_RENDEZVOUS_DIR") != nullptr && getenv("RAF_TCP_ADDR") == nullptr) {
+      // Every rank has read the files once it is connected to all the others.
+      const char* session = getenv("RAF_TCP_SESSION");
+      std::remove((std::string(getenv("RAF_TCP_RENDEZVOUS_DIR")) + "/raf_tcp_" +
+                   (session ? session : "default") + "." + std::to_string(rank))
+                      .c_str());
+    }
+  }
+};
+
+/*!
+ * \brief A pending send or receive on a non-blocking socket. on_recv is called with the bytes
+ * received so far whenever more data lands, so that the caller can consume the finished chunks.
+ */
+struct Transfer {
+  int fd;
+  bool is_send;
+  uint8_t* data;
+  int64_t bytes;
+  std::function<void(int64_t)> on_recv = nullptr;
+  int64_t done = 0;
+
+  static Transfer Send(int fd, const void* data, int64_t bytes) {
+    return {fd, true, static_cast<uint8_t*>(const_cast<void*>(data)), bytes};
+  }
+
+  static Transfer Recv(int fd, void* data, int64_t bytes,
+                       std::function<void(int64_t)> on_recv = nullptr) {
+    return {fd, false, static_cast<uint8_t*>(data), bytes, on_recv};
+  }
+
+  /*! \brief Move as many bytes as the socket takes without blocking. */
+  bool Advance() {
+    bool progressed = false;
+    while (done < bytes) {
+      ssize_t n = is_send ? ::send(fd, data + done, bytes - done, MSG_NOSIGNAL)
+                          : ::recv(fd, data + done, bytes - done, 0);
+      if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        break;
+      }
+      CHECK_GT(n, 0) << (is_send ? "send: " : "recv: ")
+                     << (n == 0 ? "connection closed by peer" : strerror(errno));
+      done += n;
+      progressed = true;
+    }
+    if (progressed && on_recv) {
+      on_recv(done);
+    }
+    return progressed;
+  }
+};
+
+/*! \brief Run the transfers concurrently until all of them finish. */
+void Progress(std::vector<Transfer>* transfers) {
+  std::vector<pollfd> fds;
+  while (true) {
+    bool finished = true;
+    for (auto& t : *transfers) {
+      t.Advance();
+      finished &= t.done == t.bytes;
+    }
+    if (finished) {
+      return;
+    }
+    fds.clear();
+    for (auto& t : *transfers) {
+      if (t.done < t.bytes) {
+        fds.push_back({t.fd, static_cast<int16_t>(t.is_send ? POLLOUT : POLLIN), 0});
+      }
+    }
+    int ret = poll(fds.data(), fds.size(), -1);
+    CHECK(ret > 0 || errno == EINTR) << "poll: " << strerror(errno);
+  }
+}
+
+/*!
+ * \brief Receive bytes from fd into the workspace and reduce each finished chunk into dst, so that
+ * the reduction of a chunk overlaps with the transfer of the next.
+ */
+Transfer ReduceRecv(int fd, uint8_t* scratch, uint8_t* dst, int64_t bytes, DType dtype,
+                    CPUReduceOp op, int64_t chunk_bytes, int64_t* reduced) {
+  *reduced = 0;
+  return Transfer::Recv(fd, scratch, bytes, [=](int64_t done) {
+    int64_t ready = done == bytes ? done : done / chunk_bytes * chunk_bytes;
+    if (ready <= *reduced) {
+      return;
+    }
+    DispatchReduceType(dtype, [&](auto type) {
+      using T = decltype(type);
+      ReduceInto(reinterpret_cast<T*>(dst + *reduced),
+                 reinterpret_cast<const T*>(scratch + *reduced),
+                 (ready - *reduced) / static_cast<int64_t>(sizeof(T)), op);
+    });
+    *reduced = ready;
+  });
+}
+
+void FinalizeBytes(uint8_t* data, int64_t count, DType dtype, CPUReduceOp op, int size) {
+  DispatchReduceType(dtype, [&](auto type) {
+    using T = decltype(type);
+    Finalize(reinterpret_cast<T*>(data), count, op, size);
+  });
+}
+
+uint8_t* TcpCommunicatorObj::Workspace(int64_t bytes) {
+  if (static_cast<int64_t>(workspace.size()) < bytes) {
+    workspace.resize(bytes);
+  }
+  return workspace.data();
+}
+
+void TcpCommunicatorObj::RingReduceScatter(uint8_t* data, const std::vector<int64_t>& offsets,
+                                           DType dtype, CPUReduceOp op, int shift,
+                                           uint8_t* scratch) {
+  int64_t elem_bytes = (dtype.bits + 7) / 8;
+  int64_t chunk_bytes = TcpChunkBytes();
+  int next = sockets[(rank + 1) % size];
+  int prev = sockets[(rank + size - 1) % size];
+  for (int s = 0; s < size - 1; ++s) {
+    int send_block = ((rank - s + shift) % size + size) % size;
+    int recv_block = ((rank - s - 1 + shift) % size + size) % size;
+    int64_t reduced;
+    std::vector<Transfer> transfers{
+        Transfer::Send(next, data + offsets[send_block] * elem_bytes,
+                       (offsets[send_block + 1] - offsets[send_block]) * elem_bytes),
+        ReduceRecv(prev, scratch, data + offsets[recv_block] * elem_bytes,
+                   (offsets[recv_block + 1] - offsets[recv_block]) * elem_bytes, dtype, op,
+                   chunk_bytes, &reduced)};
+    Progress(&transfers);
+  }
+}
+
+int TcpCommunicatorObj::NumHosts() const {
+  return std::set<uint64_t>(host_ids.begin(), host_ids.end()).size();
+}
+
+TcpCommunicatorObj* TcpCommunicatorObj::Subgroup(Communicator* cache,
+                                                 const std::function<bool(int)>& pred) {
+  if (!cache->defined()) {
+    auto obj = make_object<TcpCommunicatorObj>();
+    obj->parent_comm = parent_comm;
+    obj->mesh = mesh;
+    obj->world_size = world_size;
+    obj->world_rank = world_rank;
+    obj->root_rank = root_rank;
+    obj->group_id = group_id;
+    obj->group_size = group_size;
+    obj->size = 0;
+    for (int r = 0; r < size; ++r) {
+      if (!pred(r)) continue;
+      if (r == rank) obj->rank = obj->size;
+      obj->size++;
+      obj->sockets.push_back(sockets[r]);
+      obj->host_ids.push_back(host_ids[r]);
+    }
+    obj->local_size = 0;
+    obj->local_rank = 0;
+    for (int r = 0; r < obj->size; ++r) {
+      if (obj->host_ids[r] != obj->host_ids[obj->rank]) continue;
+      obj->local_rank += r < obj->rank;
+      obj->local_size++;
+    }
+    *cache = TcpCommunicator(obj);
+  }
+  return const_cast<TcpCommunicatorObj*>(cache->as<TcpCommunicatorObj>());
+}
+
+std::vector<CollectiveAlgo> TcpCommunicatorObj::AllReduceAlgos() const {
+  std::vector<CollectiveAlgo> algos{CollectiveAlgo::kRing, CollectiveAlgo::kTree};
+  // Hierarchy pays off when every host runs the same number of ranks, more than one.
+  std::map<uint64_t, int> ranks_per_host;
+  for (auto host_id : host_ids) {
+    ranks_per_host[host_id]++;
+  }
+  bool regular = std::all_of(ranks_per_host.begin(), ranks_per_host.end(),
+                             [&](const auto& kv) { return kv.second == local_size; });
+  if (ranks_per_host.size() > 1 && local_size > 1 && regular) {
+    algos.push_back(CollectiveAlgo::kHierarchical);
+  }
+  return algos;
+}
+
+std::vector<CollectiveAlgo> TcpCommunicatorObj::ReduceScatterAlgos() const {
+  if ((size & (size - 1)) == 0) {
+    return {CollectiveAlgo::kRing, CollectiveAlgo::kHalving};
+  }
+  return {CollectiveAlgo::kRing};
+}
+
+void TcpCommunicatorObj::AllReduce(const void* send, void* recv, int64_t count, DType dtype,
+                                   CPUReduceOp op) {
+  CHECK(CPUCanReduce(dtype)) << "NotImplementedError: AllReduce of " << dtype.c_str();
+  int64_t elem_bytes = (dtype.bits + 7) / 8;
+  auto data = static_cast<uint8_t*>(recv);
+  if (send != recv) {
+    memcpy(data, send, count * elem_bytes);
+  }
+  if (size == 1) {
+    return;
+  }
+  auto algo = CollectivePlanner::Get()->Select("allreduce", {size, NumHosts()},
+                                               count * elem_bytes, AllReduceAlgos());
+  AllReduce(data, count, dtype, op, algo);
+}
+
+void TcpCommunicatorObj::AllReduce(uint8_t* data, int64_t count, DType dtype, CPUReduceOp op,
+                                   CollectiveAlgo algo) {
+  switch (algo) {
+    case CollectiveAlgo::kRing:
+      RingAllReduce(data, count, dtype, op);
+      return;
+    case CollectiveAlgo::kTree:
+      TreeReduce(data, count, dtype, op, 0);
+      if (rank == 0) {
+        FinalizeBytes(data, count, dtype, op, size);
+      }
+      Broadcast(data, data, count * ((dtype.bits + 7) / 8), 0);
+      return;
+    case CollectiveAlgo::kHierarchical:
+      HierarchicalAllReduce(data, count, dtype, op);
+      return;
+    default:
+      LOG(FATAL) << "Invalid allreduce algorithm " << CollectiveAlgoName(algo);
+  }
+}
+
+void TcpCommunicatorObj::RingAllReduce(uint8_t* data, int64_t count, DType dtype,
+                                       CPUReduceOp op) {
+  int64_t elem_bytes = (dtype.bits + 7) / 8;
+  std::vector<int64_t> offsets(size + 1);
+  for (int r = 0; r <= size; ++r) {
+    offsets[r] = count * r / size;
+  }
+  int64_t max_block = (count + size - 1) / size;
+  RingReduceScatter(data, offsets, dtype, op, 0, Workspace(max_block * elem_bytes));
+  int owned = (rank + 1) % size;
+  FinalizeBytes(data + offsets[owned] * elem_bytes, offsets[owned + 1] - offsets[owned], dtype, op,
+                size);
+  // Ring allgather of the reduced blocks, starting from the owned one.
+  int next = sockets[(rank + 1) % size];
+  int prev = sockets[(rank + size - 1) % size];
+  for (int s = 0; s < size - 1; ++s) {
+    int send_block = (rank + 1 - s + size) % size;
+    int recv_block = (rank - s + size) % size;
+    std::vector<Transfer> transfers{
+        Transfer::Send(next, data + offsets[send_block] * elem_bytes,
+                       (offsets[send_block + 1] - offsets[send_block]) * elem_bytes),
+        Transfer::Recv(prev, data + offsets[recv_block] * elem_bytes,
+                       (offsets[recv_block + 1] - offsets[recv_block]) * elem_bytes)};
+    Progress(&transfers);
+  }
+}
+
+void TcpCommunicatorObj::TreeReduce(uint8_t* data, int64_t count, DType dtype, CPUReduceOp op,
+                                    int root) {
+  int64_t bytes = count * ((dtype.bits + 7) / 8);
+  uint8_t* scratch = Workspace(bytes);
+  int64_t chunk_bytes = TcpChunkBytes();
+  // Binomial tree over the ranks relative to the root, the mirror of Broadcast: reduce the
+  // children above the lowest set bit, then send to the parent.
+  int vrank = (rank - root + size) % size;
+  for (int mask = 1; mask < size; mask <<= 1) {
+    if (vrank & mask) {
+      std::vector<Transfer> transfers{
+          Transfer::Send(sockets[(vrank - mask + root) % size], data, bytes)};
+      Progress(&transfers);
+      return;
+    }
+    if (vrank + mask < size) {
+      int64_t reduced;
+      std::vector<Transfer> transfers{ReduceRecv(sockets[(vrank + mask + root) % size], scratch,
+                                                 data, bytes, dtype, op, chunk_bytes, &reduced)};
+      Progress(&transfers);
+    }
+  }
+}
+
+void TcpCommunicatorObj::HierarchicalAllReduce(uint8_t* data, int64_t count, DType dtype,
+                                               CPUReduceOp op) {
+  uint64_t host = host_ids[rank];
+  auto intra = Subgroup(&intra_host, [&](int r) { return host_ids[r] == host; });
+  auto inter = Subgroup(&inter_host, [&](int r) {
+    int local = 0;
+    for (int p = 0; p < r; ++p) local += host_ids[p] == host_ids[r];
+    return local == local_rank;
+  });
+  // The partial results are summed up for avg, which is divided once by the leaders.
+  CPUReduceOp partial = op == CPUReduceOp::kAvg ? CPUReduceOp::kSum : op;
+  intra->TreeReduce(data, count, dtype, partial, 0);
+  if (local_rank == 0) {
+    inter->AllReduce(data, data, count, dtype, partial);
+    FinalizeBytes(data, count, dtype, op, size);
+  }
+  intra->Broadcast(data, data, count * ((dtype.bits + 7) / 8), 0);
+}
+
+void TcpCommunicatorObj::AllGather(const void* send, void* recv, int64_t bytes) {
+  auto out = static_cast<uint8_t*>(recv);
+  if (out + rank * bytes != send) {
+    memcpy(out + rank * bytes, send, bytes);
+  }
+  int next = size > 1 ? sockets[(rank + 1) % size] : -1;
+  int prev = size > 1 ? sockets[(rank + size - 1) % size] : -1;
+  for (int s = 0; s < size - 1; ++s) {
+    int send_block = (rank - s + size) % size;
+    int recv_block = (rank - s - 1 + size) % size;
+    std::vector<Transfer> transfers{Transfer::Send(next, out + send_block * bytes, bytes),
+                                    Transfer::Recv(prev, out + recv_block * bytes, bytes)};
+    Progress(&transfers);
+  }
+}
+
+void TcpCommunicatorObj::ReduceScatter(const void* send, void* recv, int64_t count, DType dtype,
+                                       CPUReduceOp op) {
+  CHECK(CPUCanReduce(dtype)) << "NotImplementedError: ReduceScatter of " << dtype.c_str();
+  int64_t elem_bytes = (dtype.bits + 7) / 8;
+  int64_t block_bytes = count * elem_bytes;
+  if (size == 1) {
+    if (send != recv) memcpy(recv, send, block_bytes);
+    return;
+  }
+  auto algo = CollectivePlanner::Get()->Select("reduce_scatter", {size, NumHosts()}, block_bytes,
+                                               ReduceScatterAlgos());
+  ReduceScatter(send, recv, count, dtype, op, algo);
+}
+
+void TcpCommunicatorObj::ReduceScatter(const void* send, void* recv, int64_t count, DType dtype,
+                                       CPUReduceOp op, CollectiveAlgo algo) {
+  int64_t elem_bytes = (dtype.bits + 7) / 8;
+  int64_t block_bytes = count * elem_bytes;
+  // Reduce a copy of the input, whose spare tail receives the chunks of the peers.
+  int64_t scratch_blocks = algo == CollectiveAlgo::kHalving ? size / 2 : 1;
+  uint8_t* work = Workspace((size + scratch_blocks) * block_bytes);
+  uint8_t* scratch = work + size * block_bytes;
+  memcpy(work, send, size * block_bytes);
+  if (algo == CollectiveAlgo::kHalving) {
+    CHECK_EQ(size & (size - 1), 0) << "Recursive halving requires a power-of-two group";
+    // Recursive halving: exchange half of the remaining blocks with the peer at distance d, and
+    // keep reducing the half that holds the block of this rank.
+    int64_t chunk_bytes = TcpChunkBytes();
+    int lo = 0;
+    for (int d = size / 2; d >= 1; d /= 2) {
+      int peer = rank ^ d;
+      int mid = lo + d;
+      int keep = (rank & d) ? mid : lo;
+      int give = (rank & d) ? lo : mid;
+      int64_t reduced;
+      std::vector<Transfer> transfers{
+          Transfer::Send(sockets[peer], work + give * block_bytes, d * block_bytes),
+          ReduceRecv(sockets[peer], scratch, work + keep * block_bytes, d * block_bytes, dtype,
+                     op, chunk_bytes, &reduced)};
+      Progress(&transfers);
+      lo = keep;
+    }
+  } else {
+    std::vector<int64_t> offsets(size + 1);
+    for (int r = 0; r <= size; ++r) {
+      offsets[r] = count * r;
+    }
+    // The ring ends with the block (rank + 1 + shift), i.e., the block of this rank.
+    RingReduceScatter(work, offsets, dtype, op, -1, scratch);
+  }
+  memcpy(recv, work + rank * block_bytes, block_bytes);
+  FinalizeBytes(static_cast<uint8_t*>(recv), count, dtype, op, size);
+}
+
+void TcpCommunicatorObj::Broadcast(const void* send, void* recv, int64_t bytes, int root) {
+  auto out = static_cast<uint8_t*>(recv);
+  if (rank == root && send != recv) {
+    memcpy(out, send, bytes);
+  }
+  if (size == 1) {
+    return;
+  }
+  // Binomial tree over the ranks relative to the root: receive from the parent, which clears the
+  // lowest set bit, and forward to the children below it.
+  int vrank = (rank - root + size) % size;
+  int parent = -1;
+  int mask = 1;
+  while (mask < size) {
+    if (vrank & mask) {
+      parent = sockets[(vrank - mask + root) % size];
+      break;
+    }
+    mask <<= 1;
+  }
+  std::vector<int> children;
+  for (mask >>= 1; mask > 0; mask >>= 1) {
+    if (vrank + mask < size) {
+      children.push_back(sockets[(vrank + mask + root) % size]);
+    }
+  }
+  // Forward a chunk to the children while the next one arrives from the parent.
+  int64_t chunk_bytes = TcpChunkBytes();
+  int64_t num_chunks = (bytes + chunk_bytes - 1) / chunk_bytes;
+  for (int64_t k = 0; k <= num_chunks; ++k) {
+    std::vector<Transfer> transfers;
+    if (k < num_chunks && parent >= 0) {
+      int64_t offset = k * chunk_bytes;
+      transfers.push_back(
+          Transfer::Recv(parent, out + offset, std::min(chunk_bytes, bytes - offset)));
+    }
+    if (k > 0) {
+      int64_t offset = (k - 1) * chunk_bytes;
+      for (int child : children) {
+        transfers.push_back(
+            Transfer::Send(child, out + offset, std::min(chunk_bytes, bytes - offset)));
+      }
+    }
+    Progress(&transfers);
+  }
+}
+
+void TcpCommunicatorObj::AllToAll(const void* send, void* recv, int64_t bytes) {
+  auto in = static_cast<const uint8_t*>(send);
+  auto out = static_cast<uint8_t*>(recv);
+  CHECK(in == out || in + size * bytes <= out || out + size * bytes <= in)
+      << "AllToAll cannot run in place";
+  memcpy(out + rank * bytes, in + rank * bytes, bytes);
+  // Pairwise exchange: at step k, send to the rank k after and receive from the rank k before.
+  for (int k = 1; k < size; ++k) {
+    int to = (rank + k) % size;
+    int from = (rank - k + size) % size;
+    std::vector<Transfer> transfers{Transfer::Send(sockets[to], in + to * bytes, bytes),
+                                    Transfer::Recv(sockets[from], out + from * bytes, bytes)};
+    Progress(&transfers);
+  }
+}
+
+void TcpCommunicatorObj::Send(const void* data, int64_t bytes, int peer) {
+  CHECK(peer != rank && peer >= 0 && peer < size) << "Invalid peer " << peer << " of rank " << rank;
+  std::vector<Transfer> transfers{Transfer::Send(sockets[peer], data, bytes)};
+  Progress(&transfers);
+}
+
+void TcpCommunicatorObj::Recv(void* data, int64_t bytes, int peer) {
+  CHECK(peer != rank && peer >= 0 && peer < size) << "Invalid peer " << peer << " of rank " << rank;
+  std::vector<Transfer> transfers{Transfer::Recv(sockets[peer], data, bytes)};
+  Progress(&transfers);
+}
+
+void TcpCommunicatorObj::Barrier() {
+  // Dissemination barrier: a rank passes round k after hearing from the rank 2^k before.
+  uint8_t token = 0, ack = 0;
+  for (int k = 1; k < size; k <<= 1) {
+    std::vector<Transfer> transfers{
+        Transfer::Send(sockets[(rank + k) % size], &token, 1),
+        Transfer::Recv(sockets[(rank - k + size) % size], &ack, 1)};
+    Progress(&transfers);
+  }
+}
+
+/*!
+ * \brief Measure every algorithm of the planned collectives of the global TCP communicator across
+ * message sizes, from 8 bytes to max_bytes by a factor of 4. Every rank records the latency of the
+ * slowest rank, so that all of them plan alike right away, and rank 0 saves the table to path,
+ * which later jobs load with RAF_CPU_COLLECTIVE_TABLE.
+ */
+void TuneCPUCollectives(std::string path, int64_t max_bytes, int number) {
+  auto comm = Downcast<TcpCommunicator>(Communicator::Get("tcp"));
+  auto planner = CollectivePlanner::Get();
+  CollectiveTopology topo{comm->size, comm->NumHosts()};
+  DType dtype(DTypeCode::kFloat(), 32);
+  std::vector<float> send(std::max<int64_t>(max_bytes / sizeof(float), 1) * comm->size, 1.0f);
+  std::vector<float> recv(send.size());
+  auto measure = [&](const std::function<void()>& run) {
+    run();
+    comm->Barrier();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < number; ++i) {
+      run();
+    }
+    double latency =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / number;
+    comm->RingAllReduce(reinterpret_cast<uint8_t*>(&latency), 1, DType(DTypeCode::kFloat(), 64),
+                        CPUReduceOp::kMax);
+    return latency;
+  };
+  for (int64_t bytes = 8; bytes <= max_bytes; bytes *= 4) {
+    int64_t count = bytes / sizeof(float);
+    for (auto algo : comm->AllReduceAlgos()) {
+      double latency = measure([&]() {
+        comm->AllReduce(reinterpret_cast<uint8_t*>(recv.data()), count, dtype, CPUReduceOp::kSum,
+                        algo);
+      });
+      planner->Record("allreduce", algo, topo, bytes, latency);
+    }
+    for (auto algo : comm->ReduceScatterAlgos()) {
+      double latency = measure([&]() {
+        comm->ReduceScatter(send.data(), recv.data(), count, dtype, CPUReduceOp::kSum, algo);
+      });
+      planner->Record("reduce_scatter", algo, topo, bytes, latency);
+    }
+  }
+  if (comm->rank == 0) {
+    planner->Save(path);
+  }
+}
+
+RAF_REGISTER_GLOBAL("raf.distributed.TuneCPUCollectives").set_body_typed(TuneCPUCollectives);
+
+/*! \brief The algorithm that the global TCP communicator picks for bytes per rank. */
+std::string PlanCPUCollective(std::string collective, int64_t bytes) {
+  auto comm = Downcast<TcpCommunicator>(Communicator::Get("tcp"));
+  CHECK(collective == "allreduce" || collective == "reduce_scatter")
+      << "Unsupported collective " << collective;
+  auto algos = collective == "allreduce" ? comm->AllReduceAlgos() : comm->ReduceScatterAlgos();
+  auto algo =
+      CollectivePlanner::Get()->Select(collective, {comm->size, comm->NumHosts()}, bytes, algos);
+  return CollectiveAlgoName(algo);
+}
+
+RAF_REGISTER_GLOBAL("raf.distributed.PlanCPUCollective").set_body_typed(PlanCPUCollective);
+
+TcpCommunicator TcpCommunicator::make(Value rank_list) {
+  auto global_comm = GetGlobalCommunicator();
+  auto obj = make_object<TcpCommunicatorObj>();
+  obj->parent_comm = global_comm;
+  obj->mesh = TcpMesh::Get(global_comm->rank, global_comm->size);
+
+  std::vector<int64_t> members;
+  if (!rank_list.defined()) {
+    // Create Global Communicator, whose hosts come from the rendezvous.
+    obj->size = global_comm->size;
+    obj->rank = global_comm->rank;
+    obj->world_size = global_comm->world_size;
+    obj->world_rank = global_comm->world_rank;
+    obj->root_rank = global_comm->root_rank;
+    obj->group_id = -1;
+    obj->group_size = 0;
+    obj->host_ids = obj->mesh->host_ids;
+    obj->local_size = 0;
+    obj->local_rank = 0;
+    for (int p = 0; p < obj->size; ++p) {
+      if (obj->host_ids[p] != obj->host_ids[obj->rank]) continue;
+      obj->local_rank += p < obj->rank;
+      obj->local_size++;
+    }
+    members.resize(obj->size);
+    std::iota(members.begin(), members.end(), 0);
+  } else {
+    // Create Sub-communicator
+    InitSubCommunicator(obj.get(), rank_list, Communicator::Get("tcp"));
+    if (obj->group_id != -1) {
+      auto group = Downcast<TupleValue>(Downcast<TupleValue>(rank_list)->fields[obj->group_id]);
+      for (auto rank : group->fields) {
+        members.push_back(Downcast<IntValue>(rank)->value);
+      }
+    }
+  }
+  for (auto member : members) {
+    obj->sockets.push_back(obj->mesh->sockets.at(member));
+  }
+  return TcpCommunicator(obj);
+}
+
+RAF_REGISTER_GLOBAL("raf.distributed.communicator._make.tcp").set_body_typed(TcpCommunicator::make);
+
+RAF_REGISTER_OBJECT_REFLECT(TcpCommunicatorObj);
+
+}  // namespace communicator
+}  // namespace distributed
+}  // namespace raf
@@ -18,12 +18,15 @@
 #include "raf/binding.h"
 #include "raf/profiler.h"
 #include "raf/communicator.h"
+#include "raf/dialect.h"
 #include "dmlc/thread_local.h"
 #include "../common/shape_utils.h"
 #include "../requests.h"
 #include "../op/schema/reduce.h"
 
 #include <list>
+#include <sstream>
+#include <unordered_map>
 
 namespace raf {
 namespace executor {
@@ -45,6 +48,89 @@ using requests::Requests;
 using stream_pool::Stream;
 using tensor::Tensor;
 
+void AppendOpEnvCacheKey(std::ostream* os, const Value& value) {
+  if (!value.defined()) {
+    *os << "N";
+  } else if (const auto* tensor = value.as<TensorValueObj>()) {
+    const DLTensor* t = tensor->tensor.operator->();
+    *os << "T<";
+    for (int i = 0; i < t->ndim; ++i) {
+      *os << t->shape[i] << "x";
+    }
+    if (t->strides != nullptr) {
+      *os << "s";
+      for (int i = 0; i < t->ndim; ++i) {
+        *os << t->strides[i] << "x";
+      }
+    }
+    *os << "+" << t->byte_offset << tvm::runtime::DLDataType2String(t->dtype) << "@"
+        << t->device.device_type << ":" << t->device.device_id << ">";
+  } else if (const auto* tuple = value.as<TupleValueObj>()) {
+    *os << "(";
+    for (const auto& field : tuple->fields) {
+      AppendOpEnvCacheKey(os, field);
+      *os << ",";
+    }
+    *os << ")";
+  } else {
+    *os << value;
+  }
+}
+
+/*!
+ * \brief Build the string key of a primitive call to query the OpEnv cache of the interpreter. The
+ * dialects that the op may be dispatched to are part of the key, because they depend on the
+ * dialect preference and the enabled dialects.
+ */
+std::string OpEnvCacheKey(const CallValues& call, const std::string& args_key) {
+  const Op& op = Downcast<OpValue>(call->callee)->op;
+  Op base_op = IsDialectOp(op) ? GetBaseOp(op) : op;
+  std::ostringstream os;
+  os << op->name << "@" << call->device.c_str() << "|";
+  for (const auto& entry : OpDialect::GetDispatchList(base_op, call->device.device_type())) {
+    os << entry.dialect << ",";
+  }
+  os << (DispatchByProfilingEnabled() ? "P" : "") << "|" << args_key << "|";
+  AppendOpEnvCacheKey(&os, call->out);
+  return os.str();
+}
+
+/*! \brief A least recently used cache of the OpEnvs of primitive calls. */
+class OpEnvLRUCache {
+ public:
+  explicit OpEnvLRUCache(size_t capacity) : capacity_(capacity) {
+  }
+
+  /*! \brief Get the OpEnv of a key and mark it as the most recently used, or nullptr. */
+  std::shared_ptr<OpEnv> Get(const std::string& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->second;
+  }
+
+  /*! \brief Add the OpEnv of a missing key, and evict the least recently used one if full. */
+  void Set(const std::string& key, std::shared_ptr<OpEnv> op_env) {
+    entries_.emplace_front(key, std::move(op_env));
+    index_[key] = entries_.begin();
+    if (entries_.size() > capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+  }
+
+ private:
+  using Entry = std::pair<std::string, std::shared_ptr<OpEnv>>;
+  /*! \brief The maximum number of OpEnvs. */
+  size_t capacity_;
+  /*! \brief The OpEnvs from the most to the least recently used. */
+  std::list<Entry> entries_;
+  /*! \brief The entries indexed by their keys. */
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+};
+
 class SymbolTable {
  public:
   std::unordered_map<const VarNode*, std::vector<Value>> tab;
@@ -176,7 +262,7 @@ class Interpreter final : public ExprFunctor<Value(const Expr& n)>, public Execu
       call_values->args = fschema[opv->op](args);
       Value output_value;
       WITH_BASE_PROFILER(call_values->device, opv->op->name, "SchedulingCommunication", {},
-                         { output_value = InvokePrimitive(call_values); });
+                         { output_value = InvokePrimitive(call_values, &args); });
       return output_value;
     }
     LOG(FATAL) << "ValueError: type " << call_values->callee->GetTypeKey() << " is not callable";
@@ -244,7 +330,12 @@ class Interpreter final : public ExprFunctor<Value(const Expr& n)>, public Execu
   }
 
  public:
-  Value InvokePrimitive(const CallValues& call) {
+  /*!
+   * \brief Invoke a primitive op. When the key of the arguments is given, the OpEnv is looked up in
+   * the cache by the op, attributes and tensor shapes, and is created only on a cache miss.
+   */
+  Value InvokePrimitive(const CallValues& call, const std::string* args_key = nullptr,
+                        const std::function<Array<Value>()>* make_args = nullptr) {
     const Op& op = Downcast<OpValue>(call->callee)->op;
     bool use_upper_bound = false;
     static auto upper_bound_map = Op::GetAttrMap<Op>("TRAFUpperBoundOp");
@@ -259,7 +350,19 @@ class Interpreter final : public ExprFunctor<Value(const Expr& n)>, public Execu
     ICHECK(call->out.defined()) << "ValueError: Tensor compute of " << op->name
                                 << " is not implemented.";
     AllocOutputBuffer(call->out);
-    std::shared_ptr<OpEnv> op_env = Dispatch(call);
+    std::shared_ptr<OpEnv> op_env;
+    if (args_key != nullptr) {
+      std::string key = OpEnvCacheKey(call, *args_key);
+      op_env = op_env_cache_.Get(key);
+      if (op_env == nullptr) {
+        op_env = Dispatch(call, (*make_args)());
+        if (op_env != nullptr) {
+          op_env_cache_.Set(key, op_env);
+        }
+      }
+    } else {
+      op_env = Dispatch(call);
+    }
     if (op_env != nullptr) {
       InvokePrimitiveOpEnv(std::move(op_env), call, use_upper_bound);
     } else {
@@ -315,17 +418,23 @@ class Interpreter final : public ExprFunctor<Value(const Expr& n)>, public Execu
 
     {
       // note: Force op to run synchronously.
-      for (int i = 0, n = req->stream.size(); i < n; ++i) {
-        req->stream[i].stream->Wait();
+      if (sync_after_each_op) {
+        for (int i = 0, n = req->stream.size(); i < n; ++i) {
+          req->stream[i].stream->Wait();
+        }
       }
-      // note: Free the workspace of this op.
+      // note: Free the workspace of this op. The requests are kept, because the OpEnv may be
+      // cached and requests its resources again in the next call.
       WITH_BASE_PROFILER(call->device, op->name, "WorkspaceClear", {}, {
-        req->workspace.clear();
-        req->workspace.shrink_to_fit();
+        for (auto& entry : req->workspace) {
+          *entry.dest = nullptr;
+          entry.memory.reset();
+        }
       });
 
-      req->stream.clear();
-      req->stream.shrink_to_fit();
+      for (auto& entry : req->stream) {
+        entry.stream.reset();
+      }
     }
 
     // note: The next op holds a reference to this op. It will make sure that the memories requested
@@ -333,16 +442,21 @@ class Interpreter final : public ExprFunctor<Value(const Expr& n)>, public Execu
     call->out->op_env = std::move(op_env);
 
     if (use_upper_bound) {
-      auto tup = Downcast<TupleValue>(call->out);
-      auto data = Downcast<TensorValue>(tup->fields[0]);
-      auto shape_data = Downcast<TensorValue>(tup->fields[1]);
-      shape_data = Downcast<TensorValue>(CopyTo(shape_data, Device(DevType::kCPU(), 0)));
-      auto shape = common::shape_utils::GetShapeVecFromData(shape_data);
-      auto new_out = data.CreateView(shape);
-      call->out = new_out;
+      ShrinkUpperBoundOutput(call);
     }
   }
 
+  /*! \brief Replace the upper bound output with a view in the actual shape. */
+  void ShrinkUpperBoundOutput(const CallValues& call) {
+    auto tup = Downcast<TupleValue>(call->out);
+    auto data = Downcast<TensorValue>(tup->fields[0]);
+    auto shape_data = Downcast<TensorValue>(tup->fields[1]);
+    shape_data = Downcast<TensorValue>(CopyTo(shape_data, Device(DevType::kCPU(), 0)));
+    auto shape = common::shape_utils::GetShapeVecFromData(shape_data);
+    auto new_out = data.CreateView(shape);
+    call->out = new_out;
+  }
+
  public:
   Value InvokeClosure(const CallValues& call) {
     const auto* node = call->callee.as<ClosureValueObj>();
@@ -393,7 +507,19 @@ class Interpreter final : public ExprFunctor<Value(const Expr& n)>, public Execu
     *entry.dest = (void*)(Communicator::Get(entry.name, entry.rank_list).as<CommunicatorObj>());
   }
 
+ public:
+  /*!
+   * \brief Whether the interpreter waits for the streams of an op after launching it. Skipping the
+   * synchronization lets the host run ahead of the device, as the VM does.
+   */
+  bool sync_after_each_op{true};
+
  private:
+  /*! \brief The maximum number of OpEnvs cached by an interpreter. */
+  static constexpr size_t kOpEnvCacheCapacity = 1024;
+  /*! \brief The OpEnvs of primitive calls, keyed by the op, attributes and tensor shapes. */
+  OpEnvLRUCache op_env_cache_{kOpEnvCacheCapacity};
+
   void AllocOutputBuffer(Value& out) {
     std::vector<DLTensor*> out_tensors;
     std::vector<TensorValue> out_tvs;
@@ -454,6 +580,15 @@ Value InvokePrimitive(const CallValues& call) {
   return ret;
 }
 
+Value InvokePrimitive(const CallValues& call, const std::string& args_key,
+                      const std::function<Array<Value>()>& make_args) {
+  Interpreter* intrp = IntrpThreadEntry::ThreadLocal();
+  auto ret = intrp->InvokePrimitive(call, &args_key, &make_args);
+  intrp->mod = {};
+  intrp->st.tab = {};
+  return ret;
+}
+
 Value InvokeClosure(const CallValues& call) {
   Interpreter* intrp = IntrpThreadEntry::ThreadLocal();
   auto ret = intrp->InvokeClosure(call);
@@ -466,7 +601,12 @@ ObjectRef _Interpret(Expr expr, Optional<IRModule> mod) {
   return DeTuple(Interpret(expr, mod));
 }
 
+void SetInterpreterSync(bool sync) {
+  IntrpThreadEntry::ThreadLocal()->sync_after_each_op = sync;
+}
+
 RAF_REGISTER_GLOBAL("raf.executor.Interpret").set_body_typed(_Interpret);
+RAF_REGISTER_GLOBAL("raf.executor.SetInterpreterSync").set_body_typed(SetInterpreterSync);
 }  // namespace interpreter
 }  // namespace executor
 }  // namespace raf
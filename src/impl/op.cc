@@ -8,7 +8,12 @@
  * \brief RAF operator interface underlying implementation
  */
 #include <tvm/runtime/device_api.h>
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <mutex>
 #include "dmlc/registry.h"
+#include "raf/cache.h"
 #include "raf/executor.h"
 #include "raf/ir_ext.h"
 #include "raf/op.h"
@@ -17,8 +22,10 @@
 #include "raf/pass.h"
 #include "raf/value.h"
 #include "raf/device_api.h"
+#include "raf/op_profiler.h"
 #include "../requests.h"
 #include "../op/schema/list_args.h"
+#include "../op/ty/utils.h"
 
 namespace dmlc {
 DMLC_REGISTRY_ENABLE(::raf::op::OpEnvMaker);
@@ -179,6 +186,170 @@ OpEnvPtr DispatchSingleOp(const CallValues& call) {
   return nullptr;
 }
 
+/*! \brief The persist cache entry of the dialect op selected by profiling. */
+class DispatchDialectCacheEntry {
+ public:
+  explicit DispatchDialectCacheEntry() {
+  }
+
+  DispatchDialectCacheEntry(const std::string& dialect_op) : dialect_op_(dialect_op) {
+  }
+
+  const std::string& GetDialectOp() const {
+    return dialect_op_;
+  }
+
+  static DispatchDialectCacheEntry Load(const std::string path) {
+    std::ifstream ifs(path + "/" + DIALECT_OP_FILE);
+    std::string dialect_op;
+    ifs >> dialect_op;
+    CHECK(!dialect_op.empty()) << "Cannot read the dialect op from " << path;
+    return DispatchDialectCacheEntry(dialect_op);
+  }
+
+  bool Save(const std::string& path) {
+    std::ofstream ofs(path + "/" + DIALECT_OP_FILE);
+    ofs << dialect_op_;
+    return ofs.good();
+  }
+
+ private:
+  /*! \brief The persist dialect op name file. */
+  static constexpr const char* DIALECT_OP_FILE = "dialect_op.txt";
+  /*! \brief The name of the selected dialect op. */
+  std::string dialect_op_;
+};
+
+MetaPersistCache<DispatchDialectCacheEntry> CacheDispatchDialect("dispatch_dialect");
+
+bool DispatchByProfilingEnabled() {
+  const char* enable = getenv("RAF_DISPATCH_BY_PROFILING");
+  return enable != nullptr && strcmp(enable, "1") == 0;
+}
+
+void HashDispatchValue(HashKey* key, const Value& value) {
+  if (!value.defined()) {
+    *key << "null";
+  } else if (const auto* tensor = value.as<TensorValueObj>()) {
+    *key << GetRef<TensorValue>(tensor);
+  } else if (const auto* tuple = value.as<TupleValueObj>()) {
+    *key << static_cast<int64_t>(tuple->fields.size());
+    for (const auto& field : tuple->fields) {
+      HashDispatchValue(key, field);
+    }
+  } else if (const auto* int_value = value.as<IntValueObj>()) {
+    *key << int_value->value;
+  } else if (const auto* float_value = value.as<FloatValueObj>()) {
+    *key << float_value->value;
+  } else if (const auto* bool_value = value.as<BoolValueObj>()) {
+    *key << bool_value->value;
+  } else if (const auto* str_value = value.as<StringValueObj>()) {
+    *key << str_value->value;
+  } else {
+    *key << value->GetTypeKey();
+  }
+}
+
+/*! \brief Create a value with dummy data in the same shape and data type as the given value. */
+Value CreateDummyValueLike(const Value& value, const Device& device) {
+  if (const auto* tuple = value.as<TupleValueObj>()) {
+    Array<Value> fields;
+    for (const auto& field : tuple->fields) {
+      fields.push_back(CreateDummyValueLike(field, device));
+    }
+    return TupleValue::make(fields);
+  } else if (value.as<TensorValueObj>()) {
+    return CreateDummyValueFromType(GetType(value), device);
+  }
+  return value;
+}
+
+OpEnvPtr DispatchSingleOpByProfiling(const CallValues& call, const Array<Value>& args) {
+  // Profiling ops from multiple threads at the same time results in inaccurate latencies.
+  static std::mutex mu;
+
+  Op op = Downcast<OpValue>(call->callee)->op;
+  Op base_op = IsDialectOp(op) ? GetBaseOp(op) : op;
+  // The dialect ops get the type of their base op when they are registered, so no global op is
+  // written here and concurrent dispatches do not race.
+  auto make_env = [&](const std::string& dialect_op_name) -> OpEnvPtr {
+    auto maker = OpEnvMaker::Get(dialect_op_name);
+    if (maker == nullptr) {
+      return nullptr;
+    }
+    auto env = OpEnvPtr((*maker)(call));
+    return (env && !env->HasError()) ? env : nullptr;
+  };
+
+  HashKey key;
+  key << base_op->name << static_cast<int32_t>(call->device.device_type());
+  for (const auto& arg : args) {
+    HashDispatchValue(&key, arg);
+  }
+  HashDispatchValue(&key, call->out);
+
+  // Reuse the decision made by this or a previous process.
+  if (const auto* entry = CacheDispatchDialect.Get(key)) {
+    if (auto env = make_env(entry->GetDialectOp())) {
+      DLOG(INFO) << "Dispatch to " << entry->GetDialectOp() << " (cached)";
+      return env;
+    }
+  }
+
+  // Build all eligible dialect ops.
+  std::vector<std::pair<std::string, OpEnvPtr>> candidates;
+  if (IsDialectOp(op)) {
+    if (auto env = make_env(op->name)) {
+      candidates.emplace_back(op->name, env);
+    }
+  }
+  for (const auto& entry : OpDialect::GetDispatchList(base_op, call->device.device_type())) {
+    if (entry.dialect_op == op->name) {
+      continue;
+    }
+    if (auto env = make_env(entry.dialect_op)) {
+      candidates.emplace_back(entry.dialect_op, env);
+    }
+  }
+  if (candidates.empty()) {
+    // Report the dispatch errors.
+    return DispatchSingleOp(call);
+  }
+
+  // The candidates are profiled on uninitialized tensors of the same shapes and data types
+  // instead of the real arguments, because a candidate may write its inputs in place. As a
+  // result, kernels whose latency depends on the data (e.g., sparse or sorting kernels) are
+  // profiled on arbitrary data.
+  size_t best = 0;
+  if (candidates.size() > 1) {
+    std::lock_guard<std::mutex> lock(mu);
+    std::vector<Value> dummy_args;
+    for (const auto& arg : args) {
+      dummy_args.push_back(CreateDummyValueLike(arg, call->device));
+    }
+    Value dummy_out = CreateDummyValueLike(call->out, call->device);
+    auto profiler = op_profiler::OpProfiler::Get(call->device);
+    float best_latency = std::numeric_limits<float>::max();
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      const auto& env = candidates[i].second;
+      std::vector<Value> inputs;
+      for (int k : env->arg_indices) {
+        inputs.push_back(dummy_args[k]);
+      }
+      auto latencies = profiler->ProfileOpEnv(env, inputs, dummy_out);
+      float latency = *std::min_element(latencies.begin(), latencies.end());
+      DLOG(INFO) << "Profiled " << candidates[i].first << ": " << latency << " us";
+      if (latency < best_latency) {
+        best_latency = latency;
+        best = i;
+      }
+    }
+  }
+  DLOG(INFO) << "Dispatch to " << candidates[best].first << " (profiled)";
+  CacheDispatchDialect.Set(key, DispatchDialectCacheEntry(candidates[best].first));
+  return candidates[best].second;
+}
+
 OpEnvPtr DispatchFusedOp(const CallValues& call) {
   auto clo = Downcast<ClosureValue>(call->callee);
   auto func = clo->func;
@@ -214,6 +385,21 @@ OpEnvPtr Dispatch(const CallValues& call) {
   return nullptr;
 }
 
+OpEnvPtr Dispatch(const CallValues& call, const Array<Value>& args) {
+  if (call->callee.as<value::OpValueObj>() && DispatchByProfilingEnabled()) {
+    return DispatchSingleOpByProfiling(call, args);
+  }
+  return Dispatch(call);
+}
+
+PackedMetricMap DumpDispatchCacheMetric() {
+  PackedMetricMap ret;
+  for (const auto& it : CacheDispatchDialect.GetMetric()) {
+    ret.Set(it.first, it.second);
+  }
+  return ret;
+}
+
 CallValues CreateDummyCallValues(Call call, Device device) {
   auto call_node = call.as<CallNode>();
   CHECK(call_node != nullptr);
@@ -262,6 +448,9 @@ Array<Value> GetListArgs(const Attrs& attrs) {
 
 std::string GetUniqueName(std::string name) {
   static std::unordered_map<std::string, int> name_map;
+  // OpEnvs may be built by concurrent VM contexts.
+  static std::mutex mu;
+  std::lock_guard<std::mutex> lock(mu);
   for (size_t i = 0; i < name.length(); ++i) {
     if (name[i] == '.') name[i] = '_';
   }
@@ -296,6 +485,7 @@ Op GetOp(const std::string& op_name) {
 }
 
 RAF_REGISTER_GLOBAL("raf.op.GetOp").set_body_typed(GetOp);
+RAF_REGISTER_GLOBAL("raf.cache.DumpDispatchCacheMetric").set_body_typed(DumpDispatchCacheMetric);
 
 RAF_REGISTER_OBJECT_REFLECT(CallValuesNode);
 
@@ -114,5 +114,9 @@ std::shared_ptr<Stream> Stream::Get(const Device& dev, int tag_index, int index)
   return StreamPool::Get(dev)->GetStream(tag_index, index);
 }
 
+std::shared_ptr<Stream> Stream::Create(const Device& dev) {
+  return std::make_shared<Stream>(new Stream::Impl(dev));
+}
+
 }  // namespace stream_pool
 }  // namespace raf
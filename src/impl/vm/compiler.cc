@@ -79,6 +79,28 @@ inline Function BindParamsByName(Function func,
   return ret;
 }
 
+/*!
+ * \brief Run the memory passes unless the module waits for asynchronous allreduces, which
+ * AsyncDataParallelSchedule only inserts when it schedules some. The passes may reorder the
+ * waits, while the modules that have nothing to schedule still get them.
+ */
+pass::Pass MemoryPassesUnlessAsync(const Array<pass::Pass>& passes) {
+  auto pass_func = [=](IRModule mod, const pass::PassContext& pass_ctx) {
+    static const Op& wait_op = Op::Get("raf.op._wait_async");
+    bool has_wait = false;
+    for (const auto& kv : mod->functions) {
+      if (kv.second->IsInstance<FunctionNode>()) {
+        tvm::relay::PostOrderVisit(Downcast<Function>(kv.second), [&has_wait](const Expr& expr) {
+          const auto* call = expr.as<CallNode>();
+          has_wait |= call != nullptr && call->op.same_as(wait_op);
+        });
+      }
+    }
+    return has_wait ? mod : pass::RAFSequential(passes, "MemoryPasses")(mod);
+  };
+  return pass::CreateModulePass(pass_func, 0, "MemoryPassesUnlessAsync", {});
+}
+
 /*! \brief A helper class for matching and rewriting operators. */
 template <typename R>
 class OpMatch {
@@ -410,16 +432,24 @@ class VMFunctionCompiler : ExprFunctor<void(const Expr& expr)> {
           .Match("raf.op.vm.alloc_tensor",
                  [this](const Array<Expr>& args, const Attrs& attrs, const Array<Type>& type_arg) {
                    bool own = true;
-                   if (args.size() == 5) {
-                     // The last "own" argument is usually specified by the MemoryPlan pass
+                   Index offset = 0;
+                   CHECK(args.size() >= 4 && args.size() <= 6);
+                   if (args.size() >= 5) {
+                     // The "own" argument is usually specified by the MemoryPlan pass
                      // to indicate that this tensor is not the final output so it should not
                      // own the memory pointer.
                      CHECK(args[4].as<ConstantNode>());
                      auto own_val = args[4].as<ConstantNode>()->value;
                      CHECK(own_val->IsInstance<BoolValueObj>());
                      own = own_val.as<BoolValueObj>()->value;
-                   } else {
-                     CHECK_EQ(args.size(), 4);
+                   }
+                   if (args.size() == 6) {
+                     // The "offset" argument is specified by the arena policy of the
+                     // MemoryPlan pass to place this tensor inside a shared storage.
+                     CHECK(args[5].as<ConstantNode>());
+                     auto offset_val = args[5].as<ConstantNode>()->value;
+                     CHECK(offset_val->IsInstance<IntValueObj>());
+                     offset = offset_val.as<IntValueObj>()->value;
                    }
 
                    // The storage will be passed dynamically.
@@ -446,12 +476,12 @@ class VMFunctionCompiler : ExprFunctor<void(const Expr& expr)> {
                        raw_shape.push_back(imm->value);
                      }
                      // Add context field.
-                     Emit(Instruction::AllocTensor(storage_register, 0, raw_shape, dtype,
+                     Emit(Instruction::AllocTensor(storage_register, offset, raw_shape, dtype,
                                                    NewRegister(), own));
                    } else {
                      this->VisitExpr(args[1]);
-                     Emit(Instruction::AllocTensorReg(storage_register, 0, last_register_, dtype,
-                                                      NewRegister(), own));
+                     Emit(Instruction::AllocTensorReg(storage_register, offset, last_register_,
+                                                      dtype, NewRegister(), own));
                    }
                  })
           .Match("raf.op.vm.alloc_storage",
@@ -856,6 +886,7 @@ IRModule VMCompiler::OptimizeModule(const IRModule& mod, const DeviceMap& device
   }
 
   bool enable_stream_schedule = true;
+  bool async_data_parallel = false;
   if (!pass_ctx->GetConfig("raf.vm.optimize.anf_only", Bool(false)).value()) {
     // optimization passes that work on BBNF
     pass_seqs.push_back(pass::ToGraphNormalForm());
@@ -870,8 +901,9 @@ IRModule VMCompiler::OptimizeModule(const IRModule& mod, const DeviceMap& device
     pass_seqs.push_back(pass::EraseType());
 
     // optimization passes that transform BBNF into ANF
-    if (device_t == DevType::kCUDA()) {
-      if (DistConfig::Global()->enable_data_parallel) {
+    // Multi-stream schedules run on CUDA streams on GPU and on emulated streams on CPU.
+    if (device_t == DevType::kCUDA() || device_t == DevType::kCPU()) {
+      if (device_t == DevType::kCUDA() && DistConfig::Global()->enable_data_parallel) {
         // The current design of EnforceSync assumes ops are executed on multiple CUDA streams:
         // all computation ops are executed on a computation stream, and all communication
         // collectives are executed on another communication stream. Memory copy ops added in
@@ -884,6 +916,13 @@ IRModule VMCompiler::OptimizeModule(const IRModule& mod, const DeviceMap& device
         pass_seqs.push_back(pass::DataParallelSchedule());
         pass_seqs.push_back(pass::AnnotateCollectiveOps());
         pass_seqs.push_back(pass::EnforceSync());
+      } else if (device_t == DevType::kCPU() && DistConfig::Global()->enable_data_parallel) {
+        // The CPU collectives run on the communication worker thread instead of streams, so the
+        // ops stay in ANF order and only the gradient allreduces are made asynchronous. The
+        // memory passes below are skipped if any allreduce is, so that they keep the waits.
+        async_data_parallel = true;
+        pass_seqs.push_back(pass::ToANormalForm());
+        pass_seqs.push_back(pass::AsyncDataParallelSchedule());
       } else {
         auto policy_name =
             pass_ctx->GetConfig<tvm::String>("raf.stream_schedule.policy", "sequential");
@@ -921,12 +960,15 @@ IRModule VMCompiler::OptimizeModule(const IRModule& mod, const DeviceMap& device
     pass_seqs.push_back(pass::FullInline());
   }
 
-  if (!enable_stream_schedule) {
+  Array<pass::Pass> memory_passes = {pass::InferType(), pass::MemorySchedule(), pass::InferType(),
+                                     pass::Rematerialization()};
+  if (async_data_parallel) {
+    pass_seqs.push_back(MemoryPassesUnlessAsync(memory_passes));
+  } else if (!enable_stream_schedule) {
     // TODO(@comaniac): Support rematerialization with multi-streaming.
-    pass_seqs.push_back(pass::InferType());
-    pass_seqs.push_back(pass::MemorySchedule());
-    pass_seqs.push_back(pass::InferType());
-    pass_seqs.push_back(pass::Rematerialization());
+    for (const auto& memory_pass : memory_passes) {
+      pass_seqs.push_back(memory_pass);
+    }
   }
   // TODO(@hzfan): Currently disable the ValidateInplaceUpdate pass because it removes the may_share
   // attr in some cases without any error messages.
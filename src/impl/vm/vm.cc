@@ -15,10 +15,13 @@
 
 #include <algorithm>
 #include <chrono>
+#include <condition_variable>
 #include <iostream>
 #include <memory>
 #include <mutex>
 #include <stdexcept>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "raf/communicator.h"
@@ -38,6 +41,7 @@
 #include "../../requests.h"
 #include "../../op/ty/utils.h"
 #include "../../common/shape_utils.h"
+#include "../../device_api/cpu/cpu_stream.h"
 
 #include "raf/device_api.h"
 #include "raf/registry.h"
@@ -63,7 +67,9 @@ using namespace raf::stream_pool;
 using namespace raf::distributed::communicator;
 
 namespace utils {
-inline std::shared_ptr<Event> GetEventById(const VMContext& ctx, Index device_id, Index event_id) {
+inline std::shared_ptr<Event> GetEventById(const VMContext& ctx, const Device& device,
+                                           Index event_id) {
+  Index device_id = device.device_id();
   if (device_id >= ctx->events.size()) {
     ctx->events.resize(device_id + 1);
   }
@@ -71,15 +77,15 @@ inline std::shared_ptr<Event> GetEventById(const VMContext& ctx, Index device_id
     ctx->events[device_id].resize(event_id + 1);
   }
   if (ctx->events[device_id][event_id] == nullptr) {
-    Device device(DevType::kCUDA(), static_cast<int>(device_id));
     ctx->events[device_id][event_id] =
         EventPool::Get(device)->GetEvent(0x02 /*cudaEventDisableTiming*/);
   }
   return ctx->events[device_id][event_id];
 }
 
-inline std::shared_ptr<Stream> GetStreamById(const VMContext& ctx, Index device_id,
+inline std::shared_ptr<Stream> GetStreamById(const VMContext& ctx, const Device& device,
                                              Index stream_id) {
+  Index device_id = device.device_id();
   if (device_id >= ctx->streams.size()) {
     ctx->streams.resize(device_id + 1);
   }
@@ -87,10 +93,14 @@ inline std::shared_ptr<Stream> GetStreamById(const VMContext& ctx, Index device_
     ctx->streams[device_id].resize(stream_id + 1);
   }
   if (ctx->streams[device_id][stream_id] == nullptr) {
-    if (stream_id == 0) {
+    if (device.device_type() == DevType::kCPU()) {
+      // There is no default stream on CPU, so every stream id maps to a CPU stream. The CPU
+      // streams are owned by the context, so that concurrent contexts do not share the worker
+      // threads of the streams.
+      ctx->streams[device_id][stream_id] = Stream::Create(device);
+    } else if (stream_id == 0) {
       ctx->streams[device_id][stream_id] = std::make_shared<Stream>(nullptr);
     } else {
-      Device device(DevType::kCUDA(), static_cast<int>(device_id));
       ctx->streams[device_id][stream_id] =
           Stream::Get(device, kCudaCompute, static_cast<int>(stream_id));
     }
@@ -98,6 +108,22 @@ inline std::shared_ptr<Stream> GetStreamById(const VMContext& ctx, Index device_
   return ctx->streams[device_id][stream_id];
 }
 
+/*!
+ * \brief Collect the memory of the tensors in a value, so that it can be held until an
+ * asynchronous task that uses the tensors finished.
+ */
+void CollectMemory(const Value& value, std::vector<std::shared_ptr<memory_pool::Memory>>* mems) {
+  if (const auto* tensor = value.as<TensorValueObj>()) {
+    if (tensor->mem != nullptr) {
+      mems->push_back(tensor->mem);
+    }
+  } else if (const auto* tuple = value.as<TupleValueObj>()) {
+    for (const auto& field : tuple->fields) {
+      CollectMemory(field, mems);
+    }
+  }
+}
+
 const char* GetStreamName(Index stream_id) {
   static std::vector<std::string> names = {"Default Stream"};
   while (stream_id >= names.size()) {
@@ -139,6 +165,161 @@ void TensorRepr(std::ostringstream& os, const TensorValueObj* tensor) {
   }
   os << ">";
 }
+
+/*!
+ * \brief Append the dtype and shape of a tensor to the signature.
+ * \return False if the signature overflows.
+ */
+inline bool AppendTensorSignature(OpEnvSignature* sig, const TensorValueObj* tensor) {
+  const DLTensor* t = tensor->tensor.operator->();
+  // Pack dtype and ndim into one word. The word is never 0 because bits is at least 1.
+  int64_t header = (static_cast<int64_t>(t->dtype.code) << 56) |
+                   (static_cast<int64_t>(t->dtype.bits) << 48) |
+                   (static_cast<int64_t>(t->dtype.lanes) << 32) | static_cast<int64_t>(t->ndim);
+  if (!sig->Append(header)) {
+    return false;
+  }
+  for (int i = 0; i < t->ndim; ++i) {
+    if (!sig->Append(t->shape[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+ * \brief Build the signature of an InvokeJit instruction. It encodes the same information as
+ * the string key used by the OpEnvCache.
+ * \return False if the signature cannot be built, in which case the inline cache is bypassed.
+ */
+bool MakeOpEnvSignature(const VMContext& ctx, const Instruction& instr, OpEnvSignature* sig) {
+  Index num_inputs = instr.invoke_jit.arity - instr.invoke_jit.output_size;
+  for (Index i = 0; i < num_inputs; i++) {
+    if (ctx.IsConst(instr.invoke_jit.args[i])) {
+      continue;
+    }
+    const Value& reg = ctx.ReadRegister(instr.invoke_jit.args[i]);
+    if (auto tensor = reg.as<TensorValueObj>()) {
+      if (!AppendTensorSignature(sig, tensor)) {
+        return false;
+      }
+    } else if (auto tup = reg.as<TupleValueObj>()) {
+      // Tuples are marked with a negative word, which cannot be a tensor header.
+      if (!sig->Append(-1 - static_cast<int64_t>(tup->fields.size()))) {
+        return false;
+      }
+      for (auto field : tup->fields) {
+        auto t = field.as<TensorValueObj>();
+        if (t == nullptr) {
+          if (!sig->Append(0)) {
+            return false;
+          }
+        } else if (!AppendTensorSignature(sig, t)) {
+          return false;
+        }
+      }
+    } else {
+      // Let the slow path report the unsupported register type.
+      return false;
+    }
+  }
+  // The output registers are encoded like a tuple.
+  if (!sig->Append(-1 - static_cast<int64_t>(instr.invoke_jit.output_size))) {
+    return false;
+  }
+  for (Index i = num_inputs; i < instr.invoke_jit.arity; i++) {
+    auto tensor = ctx.ReadRegister(instr.invoke_jit.args[i]).as<TensorValueObj>();
+    if (tensor == nullptr || !AppendTensorSignature(sig, tensor)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+ * \brief Build the string key of an InvokeJit instruction to query the OpEnvCache.
+ * \param is_const Whether a register holds a constant, which is skipped in the key.
+ */
+template <typename IsConstFn>
+std::string OpEnvCacheKey(const Instruction& instr, const Array<Value>& args, const Value& output,
+                          IsConstFn is_const) {
+  Index num_inputs = instr.invoke_jit.arity - instr.invoke_jit.output_size;
+  std::ostringstream os;
+  for (Index i = 0; i < num_inputs; i++) {
+    if (is_const(instr.invoke_jit.args[i])) {
+      // Skip constatnts in the hash key
+      continue;
+    }
+    const Value& reg = args[i];
+    if (auto tensor = reg.as<TensorValueObj>()) {
+      TensorRepr(os, tensor);
+    } else if (auto tup = reg.as<TupleValueObj>()) {
+      os << "(";
+      for (auto field : tup->fields) {
+        auto t = field.as<TensorValueObj>();
+        if (t != nullptr) {
+          TensorRepr(os, t);
+        }
+        os << ",";
+      }
+      os << ")";
+    } else {
+      LOG(FATAL) << "Unsupported non-const register type: " << reg->GetTypeKey();
+    }
+    os << ",";
+  }
+
+  os << "|";
+  if (instr.invoke_jit.output_size == 1) {
+    TensorRepr(os, output.as<TensorValueObj>());
+  } else {
+    os << "(";
+    for (auto field : Downcast<TupleValue>(output)->fields) {
+      TensorRepr(os, field.as<TensorValueObj>());
+      os << ",";
+    }
+    os << ")";
+  }
+  return os.str();
+}
+
+/*! \brief Read the input arguments of an InvokeJit instruction. */
+Array<Value> ReadInvokeJitArgs(const VMContext& ctx, const Instruction& instr) {
+  Index num_inputs = instr.invoke_jit.arity - instr.invoke_jit.output_size;
+  Array<Value> args;
+  for (Index i = 0; i < num_inputs; i++) {
+    args.push_back(ctx.ReadRegister(instr.invoke_jit.args[i]));
+  }
+  return args;
+}
+
+/*! \brief Get the operands of the current InvokeJit instruction of a context. */
+InvokeJitOperands& GetInvokeJitOperands(VMContext& ctx) {
+  auto& funcs = ctx->invoke_jit_operands;
+  if (funcs.empty()) {
+    funcs.resize(ctx->exec->functions.size());
+  }
+  auto& instrs = funcs[ctx->func_index];
+  if (instrs.empty()) {
+    instrs.resize(ctx->exec->functions[ctx->func_index].instructions.size());
+  }
+  return instrs[ctx->pc];
+}
+
+/*! \brief Build the call values of an InvokeJit instruction to dispatch its OpEnv. */
+CallValues MakeInvokeJitCallValues(const Value& callee, const Array<Value>& args,
+                                   const Value& output, const Device& device) {
+  auto call_values = CallValues::make();
+  call_values->callee = callee;
+  if (const auto* op = callee.as<OpValueObj>()) {
+    call_values->args = GetOpAttr<FRAFSchema>(op->op, "FRAFSchema")(args);
+  } else {
+    call_values->args = MakeListArgs(args);
+  }
+  call_values->device = device;
+  call_values->out = output;
+  return call_values;
+}
 }  // namespace utils
 
 RAF_REGISTER_OBJECT_REFLECT(VMContextObj);
@@ -230,6 +411,15 @@ inline Index VMContext::PopFrame() {
   return fr.caller_return_register;
 }
 
+VMFuncOpEnvCache::VMFuncOpEnvCache(size_t num_instructions)
+    : num_instructions_(num_instructions),
+      inline_cache_(new std::atomic<const InlineCacheEntry*>[num_instructions]),
+      inline_cache_updates_(num_instructions, 0) {
+  for (size_t i = 0; i < num_instructions; ++i) {
+    inline_cache_[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
 std::shared_ptr<OpEnvCache> VMFuncOpEnvCache::Get(Index pc) {
   std::lock_guard<std::mutex> lock(mu_);
   auto it = cache_map_.find(pc);
@@ -241,9 +431,34 @@ std::shared_ptr<OpEnvCache> VMFuncOpEnvCache::Get(Index pc) {
   return cache;
 }
 
+void VMFuncOpEnvCache::UpdateInlineCache(Index pc, const OpEnvSignature& signature,
+                                         const OpEnvPtr& op_env,
+                                         const std::shared_ptr<const std::string>& key) {
+  if (static_cast<size_t>(pc) >= num_instructions_) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mu_);
+  if (inline_cache_updates_[pc] >= kMaxInlineCacheUpdates) {
+    // The instruction is polymorphic. Stop updating the slot to bound the number of entries.
+    return;
+  }
+  inline_cache_updates_[pc]++;
+  auto entry = std::make_unique<InlineCacheEntry>();
+  entry->signature = signature;
+  entry->op_env = op_env;
+  entry->key = key;
+  inline_cache_[pc].store(entry.get(), std::memory_order_release);
+  inline_cache_entries_.push_back(std::move(entry));
+}
+
 void VMFuncOpEnvCache::Clear() {
   std::lock_guard<std::mutex> lock(mu_);
   cache_map_.clear();
+  for (size_t i = 0; i < num_instructions_; ++i) {
+    inline_cache_[i].store(nullptr, std::memory_order_relaxed);
+    inline_cache_updates_[i] = 0;
+  }
+  inline_cache_entries_.clear();
 }
 
 #ifdef RAF_USE_CUDA
@@ -321,6 +536,23 @@ PackedFunc VirtualMachine::GetFunction(const std::string& name,
       }
       this->SetDevices(devices);
     });
+  } else if (name == "profile_throughput") {
+    return PackedFunc([sptr_to_self, this](registry::TVMArgs args, registry::TVMRetValue* rv) {
+      CHECK(exec_) << "The executable is not loaded yet.";
+      std::string func_name = args[0];
+      int num_threads = args[1];
+      int number = args[2];
+      std::vector<Value> inputs(args.size() - 3);
+      for (size_t i = 3; i < args.size(); ++i) {
+        inputs[i - 3] = args[i];
+      }
+      *rv = ProfileThroughput(func_name, inputs, num_threads, number);
+    });
+  } else if (name == "precompile") {
+    return PackedFunc([sptr_to_self, this](registry::TVMArgs args, registry::TVMRetValue* rv) {
+      int num_threads = args[0];
+      Precompile(num_threads);
+    });
   } else if (name == "prepare_context") {
     return PackedFunc([sptr_to_self, this](registry::TVMArgs args, registry::TVMRetValue* rv) {
       CHECK(exec_) << "The executable is not loaded yet.";
@@ -341,7 +573,8 @@ void VirtualMachine::LoadExecutable(const Executable* exec) {
   CHECK(exec) << "The executable is not created yet.";
   exec_ = exec;
   for (int i = 0; i < exec_->functions.size(); ++i) {
-    op_env_cache_.push_back(std::make_shared<VMFuncOpEnvCache>());
+    op_env_cache_.push_back(
+        std::make_shared<VMFuncOpEnvCache>(exec_->functions[i].instructions.size()));
   }
 
   tvm::runtime::Module lib = exec_->lib;
@@ -412,6 +645,44 @@ VMContext VirtualMachine::PrepareVMContext(const std::string& func_name,
   return ctx;
 }
 
+VMContext VirtualMachine::AcquireVMContext(const std::string& func_name,
+                                           const std::vector<Value>& inputs) {
+  CHECK(!enable_cuda_graph_) << "The context pool is not supported in CUDA graph mode";
+  auto gvit = exec_->global_map.find(func_name);
+  CHECK(gvit != exec_->global_map.end()) << "Cannot find function " << func_name;
+  auto func_index = gvit->second;
+  VMContext ctx;
+  {
+    std::lock_guard<std::mutex> lock(context_pool_mu_);
+    auto& contexts = context_pool_[func_index];
+    if (!contexts.empty()) {
+      ctx = contexts.back();
+      contexts.pop_back();
+    }
+  }
+  if (!ctx.defined()) {
+    return PrepareVMContext(func_name, inputs);
+  }
+  CHECK_EQ(inputs.size(), ctx->inputs.size())
+      << "The number of inputs doesn't match the number of parameters for function " << func_name;
+  Device dev = devices_[0];
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    ctx->inputs[i] = CopyTo(inputs[i], dev);
+  }
+  return ctx;
+}
+
+void VirtualMachine::ReleaseVMContext(VMContext ctx) {
+  CHECK(ctx->frames.empty()) << "Cannot release a context that is still running";
+  // Drop the references to the values of the previous run, so that their memory can be reused.
+  ctx->return_register = Value();
+  for (auto& input : ctx->inputs) {
+    input = Value();
+  }
+  std::lock_guard<std::mutex> lock(context_pool_mu_);
+  context_pool_[ctx->entry_func_index].push_back(ctx);
+}
+
 Value VirtualMachine::Run(VMContext ctx) {
   auto frun = [&]() {
     // ctx->pc will be reset to 0 in the PushFrame
@@ -438,7 +709,16 @@ Value VirtualMachine::Run(VMContext ctx) {
   }
 #endif
   frun();
-  if (ctx->current_stream_id != 0) {
+  if (ctx->use_cpu_streams) {
+    // The results are visible to the caller only after the CPU streams finished.
+    for (const auto& device_streams : ctx->streams) {
+      for (const auto& stream : device_streams) {
+        if (stream != nullptr) {
+          stream->Wait();
+        }
+      }
+    }
+  } else if (ctx->current_stream_id != 0) {
     // reset the working stream to default stream.
     OpEnv::SetStreamForAllBackends(devices_[0], nullptr);
   }
@@ -468,6 +748,54 @@ Array<FloatValue> VirtualMachine::Profile(VMContext ctx, int warmup, int number,
   return results;
 }
 
+double VirtualMachine::ProfileThroughput(const std::string& func_name,
+                                         const std::vector<Value>& inputs, int num_threads,
+                                         int number) {
+  CHECK_GT(num_threads, 0);
+  CHECK_GT(number, 0);
+  Device device = devices_[0];
+  auto api = DeviceAPI::Get(device.device_type());
+
+  // Warmup to build all OpEnvs, and fill the context pool with one context per thread.
+  std::vector<VMContext> warmup_ctxs;
+  for (int i = 0; i < num_threads; ++i) {
+    warmup_ctxs.push_back(AcquireVMContext(func_name, inputs));
+  }
+  for (auto& ctx : warmup_ctxs) {
+    Run(ctx);
+    ReleaseVMContext(ctx);
+  }
+  api->WaitDevice(device);
+
+  std::vector<std::thread> workers;
+  std::vector<std::exception_ptr> errors(num_threads);
+  auto beg = raf::profiler::ProfileStat::NowInMicrosec();
+  for (int t = 0; t < num_threads; ++t) {
+    workers.emplace_back([&, t]() {
+      try {
+        for (int i = 0; i < number; ++i) {
+          auto ctx = AcquireVMContext(func_name, inputs);
+          Run(ctx);
+          ReleaseVMContext(ctx);
+        }
+      } catch (...) {
+        errors[t] = std::current_exception();
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  api->WaitDevice(device);
+  auto end = raf::profiler::ProfileStat::NowInMicrosec();
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  return static_cast<double>(num_threads) * number * 1e6 / static_cast<double>(end - beg);
+}
+
 Device VirtualMachine::GetParamsDevice() const {
   CHECK(!devices_.empty()) << "Devices have not been initialized yet.";
 
@@ -482,6 +810,247 @@ Device VirtualMachine::GetParamsDevice() const {
   return (cit == devices_.end() ? devices_[0] : *cit);
 }
 
+/*!
+ * \brief The InvokeJit instruction whose inputs and outputs have static shapes. The tensors other
+ * than the constants only carry the shapes, data types and devices; dummy data is allocated when
+ * the task runs.
+ */
+struct CompileTask {
+  Index func_index;
+  Index pc;
+  Value callee;
+  Array<Value> args;
+  /*! \brief Whether each argument is a constant, which is passed as is. */
+  std::vector<bool> const_args;
+  Value output;
+  /*! \brief The key of the OpEnv in the OpEnv cache of the instruction. */
+  std::string op_env_cache_key;
+};
+
+class CompileService {
+ public:
+  CompileService(std::vector<CompileTask> tasks, int num_threads, const Device& device,
+                 std::vector<std::shared_ptr<VMFuncOpEnvCache>> op_env_cache)
+      : tasks_(std::move(tasks)),
+        status_(tasks_.size(), kPending),
+        device_(device),
+        op_env_cache_(std::move(op_env_cache)),
+        pass_ctx_(pass::PassContext::Current()) {
+    for (size_t i = 0; i < tasks_.size(); ++i) {
+      task_index_[Key(tasks_[i].func_index, tasks_[i].pc)] = i;
+    }
+    for (int i = 0; i < num_threads; ++i) {
+      workers_.emplace_back([this]() { WorkerLoop(); });
+    }
+  }
+
+  ~CompileService() {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      stop_ = true;
+    }
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  /*!
+   * \brief Wait for the task of an instruction if it is being compiled. A task that has not
+   * started is taken over by the caller, which builds the OpEnv itself. A finished task has
+   * added its OpEnv to the OpEnv cache unless the OpEnv needs the resources of a VM context.
+   */
+  void Wait(Index func_index, Index pc) {
+    auto it = task_index_.find(Key(func_index, pc));
+    if (it == task_index_.end()) {
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mu_);
+    if (status_[it->second] == kPending) {
+      status_[it->second] = kDone;
+      return;
+    }
+    done_cv_.wait(lock, [this, &it]() { return status_[it->second] == kDone; });
+  }
+
+ private:
+  enum Status { kPending, kRunning, kDone };
+
+  static int64_t Key(Index func_index, Index pc) {
+    return (static_cast<int64_t>(func_index) << 32) | pc;
+  }
+
+  /*! \brief Create a value with dummy data in the same shapes as the given value. */
+  static Value MakeDummy(const Value& value) {
+    if (const auto* tensor = value.as<TensorValueObj>()) {
+      const DLTensor* t = tensor->tensor.operator->();
+      Array<PrimExpr> shape;
+      for (int i = 0; i < t->ndim; ++i) {
+        shape.push_back(Integer(t->shape[i]));
+      }
+      return CreateDummyValueFromType(TensorType(shape, DataType(t->dtype)), Device(t->device));
+    } else if (const auto* tuple = value.as<TupleValueObj>()) {
+      Array<Value> fields;
+      for (const auto& field : tuple->fields) {
+        fields.push_back(MakeDummy(field));
+      }
+      return TupleValue::make(fields);
+    }
+    return value;
+  }
+
+  void WorkerLoop() {
+    tvm::With<pass::PassContext> ctx_scope(pass_ctx_);
+    for (size_t next = 0;; ++next) {
+      {
+        std::lock_guard<std::mutex> lock(mu_);
+        while (next < tasks_.size() && status_[next] != kPending) {
+          ++next;
+        }
+        if (stop_ || next >= tasks_.size()) {
+          return;
+        }
+        status_[next] = kRunning;
+      }
+      const CompileTask& task = tasks_[next];
+      try {
+        Array<Value> args;
+        for (size_t i = 0; i < task.args.size(); ++i) {
+          args.push_back(task.const_args[i] ? task.args[i] : MakeDummy(task.args[i]));
+        }
+        auto call = utils::MakeInvokeJitCallValues(task.callee, args, MakeDummy(task.output),
+                                                   device_);
+        OpEnvPtr op_env = Dispatch(call, args);
+        // The streams and communicators are bound when a VM context creates the OpEnv, so such
+        // OpEnvs are rebuilt from the compiled kernel at runtime.
+        if (op_env != nullptr && op_env->GetRequests()->stream.empty() &&
+            op_env->GetRequests()->distributed.empty()) {
+          op_env_cache_[task.func_index]->Get(task.pc)->SetIfAbsent(task.op_env_cache_key,
+                                                                     op_env);
+        }
+      } catch (const dmlc::Error& e) {
+        DLOG(WARNING) << "Failed to precompile instruction " << task.pc << " of function "
+                      << task.func_index << ": " << e.what();
+      }
+      {
+        std::lock_guard<std::mutex> lock(mu_);
+        status_[next] = kDone;
+      }
+      done_cv_.notify_all();
+    }
+  }
+
+  std::vector<CompileTask> tasks_;
+  std::vector<Status> status_;
+  std::unordered_map<int64_t, size_t> task_index_;
+  Device device_;
+  std::vector<std::shared_ptr<VMFuncOpEnvCache>> op_env_cache_;
+  pass::PassContext pass_ctx_;
+  std::vector<std::thread> workers_;
+  std::mutex mu_;
+  std::condition_variable done_cv_;
+  bool stop_ = false;
+};
+
+void VirtualMachine::Precompile(int num_threads) {
+  CHECK(exec_ != nullptr && !devices_.empty()) << "The executable and devices must be set first.";
+  std::vector<CompileTask> tasks;
+  for (Index func_index = 0; func_index < exec_->functions.size(); ++func_index) {
+    const auto& func = exec_->functions[func_index];
+    // Track the registers that have static shapes, assuming the code is straight-line. A wrong
+    // guess across branches only builds an unused kernel.
+    std::vector<Value> regs(func.register_file_size);
+    std::vector<bool> is_const(func.register_file_size, false);
+    std::unordered_map<RegName, Device> storage_devices;
+    for (Index pc = 0; pc < func.instructions.size(); ++pc) {
+      const Instruction& instr = func.instructions[pc];
+      switch (instr.op) {
+        case Opcode::LoadConst:
+          regs[instr.dst] = GetConstant(instr.const_index);
+          is_const[instr.dst] = true;
+          break;
+        case Opcode::LoadConsti:
+          regs[instr.dst] = ScalarValue::make(instr.load_consti.val);
+          is_const[instr.dst] = false;
+          break;
+        case Opcode::Move:
+          regs[instr.dst] = regs[instr.from];
+          is_const[instr.dst] = is_const[instr.from];
+          break;
+        case Opcode::AllocStorage:
+          storage_devices[instr.dst] =
+              Device(instr.alloc_storage.device_type, instr.alloc_storage.device_id);
+          break;
+        case Opcode::AllocTensor: {
+          auto it = storage_devices.find(instr.alloc_tensor.storage);
+          regs[instr.dst] = Value();
+          if (it != storage_devices.end()) {
+            std::vector<int64_t> shape(instr.alloc_tensor.shape,
+                                       instr.alloc_tensor.shape + instr.alloc_tensor.ndim);
+            regs[instr.dst] = TensorValue::Assemble(it->second, instr.alloc_tensor.dtype, shape);
+          }
+          is_const[instr.dst] = false;
+          break;
+        }
+        case Opcode::AllocTuple: {
+          Array<Value> fields;
+          for (Index i = 0; i < instr.alloc_tuple.num_fields; ++i) {
+            fields.push_back(regs[instr.alloc_tuple.fields[i]]);
+          }
+          bool known = std::all_of(fields.begin(), fields.end(),
+                                   [](const Value& field) { return field.defined(); });
+          regs[instr.dst] = known ? TupleValue::make(fields) : Value();
+          is_const[instr.dst] = false;
+          break;
+        }
+        case Opcode::GetField: {
+          const auto* tuple = regs[instr.get_field.object].as<TupleValueObj>();
+          regs[instr.dst] = tuple ? tuple->fields[instr.get_field.field_index] : Value();
+          is_const[instr.dst] = false;
+          break;
+        }
+        case Opcode::InvokeJit: {
+          Index num_inputs = instr.invoke_jit.arity - instr.invoke_jit.output_size;
+          CompileTask task{func_index, pc, regs[instr.invoke_jit.op_reg], {}, {}, {}, {}};
+          bool known = is_const[instr.invoke_jit.op_reg];
+          for (Index i = 0; i < num_inputs && known; ++i) {
+            task.args.push_back(regs[instr.invoke_jit.args[i]]);
+            task.const_args.push_back(is_const[instr.invoke_jit.args[i]]);
+            known = task.args.back().defined();
+          }
+          Array<Value> outs;
+          for (Index i = num_inputs; i < instr.invoke_jit.arity && known; ++i) {
+            outs.push_back(regs[instr.invoke_jit.args[i]]);
+            known = outs.back().defined();
+          }
+          if (known) {
+            task.output = instr.invoke_jit.output_size == 1 ? outs[0] : TupleValue::make(outs);
+            task.op_env_cache_key = utils::OpEnvCacheKey(
+                instr, task.args, task.output, [&is_const](RegName reg) { return is_const[reg]; });
+            tasks.push_back(std::move(task));
+          }
+          break;
+        }
+        case Opcode::AllocTensorReg:
+        case Opcode::AllocClosure:
+        case Opcode::SetShape:
+        case Opcode::InvokeFunc:
+        case Opcode::InvokeClosure:
+        case Opcode::InvokePacked:
+        case Opcode::InferType:
+          // The results are only known at runtime.
+          regs[instr.dst] = Value();
+          is_const[instr.dst] = false;
+          break;
+        default:
+          break;
+      }
+    }
+  }
+  DLOG(INFO) << "Precompiling " << tasks.size() << " kernels with " << num_threads << " threads";
+  compile_service_ =
+      std::make_shared<CompileService>(std::move(tasks), num_threads, devices_[0], op_env_cache_);
+}
+
 void VirtualMachine::SetDevices(const std::vector<Device>& devices) {
   devices_ = devices;
   host_device_ = Device(DevType::kCPU(), 0);
@@ -494,6 +1063,23 @@ void VirtualMachine::SetDevices(const std::vector<Device>& devices) {
   if (!use_cuda_) {
     enable_cuda_graph_ = false;
   }
+  // The constants are copied to the device when they are first loaded.
+  if (exec_ != nullptr) {
+    const_pool_.clear();
+    const_pool_.resize(exec_->constants.size());
+    const_pool_once_.reset(new std::once_flag[exec_->constants.size()]);
+  }
+}
+
+const Value& VirtualMachine::GetConstant(Index const_index) {
+  CHECK_LT(static_cast<size_t>(const_index), const_pool_.size())
+      << "The constant pool is not initialized. Please set devices first.";
+  // Kernels only run on the first device, so the constants are copied there. The copy is done
+  // once even if concurrent contexts load the constant at the same time.
+  std::call_once(const_pool_once_[const_index], [this, const_index]() {
+    const_pool_[const_index] = CopyTo(exec_->constants[const_index], devices_[0]);
+  });
+  return const_pool_[const_index];
 }
 
 inline std::shared_ptr<Memory> VirtualMachine::Alloc(const VMContext& ctx, Device dev,
@@ -505,7 +1091,8 @@ inline std::shared_ptr<Memory> VirtualMachine::Alloc(const VMContext& ctx, Devic
       // We can not use async memory allocation in cuda graph tracing mode
       return memory_pool::Memory::Alloc(dev, nbytes, alignment);
     } else {
-      auto stream = utils::GetStreamById(ctx, ctx->current_device_id, ctx->current_stream_id);
+      auto stream = utils::GetStreamById(ctx, Device(DevType::kCUDA(), ctx->current_device_id),
+                                         ctx->current_stream_id);
       return memory_pool::Memory::AllocAsync(dev, nbytes, stream->data(), alignment);
     }
 #else
@@ -529,6 +1116,7 @@ void VirtualMachine::RunLoop(VMContext& ctx) {
   ctx->current_device_id = 0;
   ctx->current_stream_id = 0;
   ctx->current_barrier_event_index = 0;
+  ctx->use_cpu_streams = false;
   while (true) {
   main_loop:
     auto const& instr = ctx->code[ctx->pc];
@@ -663,19 +1251,9 @@ void VirtualMachine::HandleMove(VMContext& ctx, const Instruction& instr) {
 }
 
 void VirtualMachine::HandleLoadConst(VMContext& ctx, const Instruction& instr) {
-  auto constant_obj = exec_->constants[instr.const_index];
-  // We cache the allocated object in the constant pool. To measure, the
-  // first iteration will set the pool up. The other iterations will
-  // directly reuse the allocated objects.
-  if (const_pool_.size() <= static_cast<size_t>(instr.const_index)) {
-    const_pool_.resize(instr.const_index + 1);
-  }
-
-  if (!const_pool_[instr.const_index].defined()) {
-    // TODO(@zhiics): device could be obtained from the device list.
-    const_pool_[instr.const_index] = CopyTo(constant_obj, devices_[0]);
-  }
-  ctx.WriteRegister(instr.dst, const_pool_[instr.const_index]);
+  // The constant pool caches the device dependent constants. The first load copies a constant
+  // to the device, and the other loads directly reuse the allocated object.
+  ctx.WriteRegister(instr.dst, GetConstant(instr.const_index));
   ctx->frames.back().is_const[instr.dst] = true;
   ctx->pc++;
 }
@@ -734,8 +1312,10 @@ void VirtualMachine::HandleAllocTensor(VMContext& ctx, const Instruction& instr)
   if (instr.alloc_tensor.own) {
     mem = storage->buffer;
   }
+  // A non-zero offset places the tensor inside a storage shared with other tensors (an arena).
+  void* data = static_cast<char*>(storage->buffer->data) + instr.alloc_tensor.offset;
   auto tensor = TensorValue::Assemble(storage->buffer->device, instr.alloc_tensor.dtype, shape, {},
-                                      storage->buffer->data, mem);
+                                      data, mem);
   ctx.WriteRegister(instr.dst, tensor);
   ctx->pc++;
 }
@@ -754,8 +1334,9 @@ void VirtualMachine::HandleAllocTensorReg(VMContext& ctx, const Instruction& ins
   if (instr.alloc_tensor_reg.own) {
     mem = storage->buffer;
   }
+  void* data = static_cast<char*>(storage->buffer->data) + instr.alloc_tensor_reg.offset;
   auto tensor = TensorValue::Assemble(storage->buffer->device, instr.alloc_tensor_reg.dtype, shape,
-                                      {}, storage->buffer->data, mem);
+                                      {}, data, mem);
   ctx.WriteRegister(instr.dst, tensor);
   ctx->pc++;
 }
@@ -815,24 +1396,34 @@ void VirtualMachine::HandleInvokeClosure(VMContext& ctx, const Instruction& inst
 }
 
 void VirtualMachine::HandleInvokeJit(VMContext& ctx, const Instruction& instr) {
-  OpEnvPtr op_env;
-  std::vector<Value> inputs;
-  Value output;
-  std::string op_env_cache_key;
+  InvokeJitOperands& operands = PrepareOpEnv(ctx, instr);
+  const OpEnvPtr& op_env = *operands.op_env;
+  const std::vector<Value>& inputs = operands.inputs;
+  const Value& output = operands.output;
+  const std::shared_ptr<const std::string>& op_env_cache_key = *operands.op_env_cache_key;
+
+  if (ctx->use_cpu_streams) {
+    LaunchOnCPUStream(ctx, op_env, inputs, output, op_env_cache_key);
+    ReleaseOperands(&operands);
+    ctx->pc++;
+    return;
+  }
 
-  std::tie(op_env, inputs, output, op_env_cache_key) = PrepareOpEnv(ctx, instr);
+  AllocWorkspace(ctx, op_env);
   if (!dryrun_) {  // Skip the execution in dryrun mode
 #ifdef RAF_USE_CUDA
     if (use_cuda_) {
       WITH_CUDA_PROFILER(
           devices_[0],
-          utils::GetStreamById(ctx, ctx->current_device_id, ctx->current_stream_id)->data(),
-          op_env->name(), utils::GetStreamName(ctx->current_stream_id), {op_env_cache_key},
+          utils::GetStreamById(ctx, Device(DevType::kCUDA(), ctx->current_device_id),
+                               ctx->current_stream_id)
+              ->data(),
+          op_env->name(), utils::GetStreamName(ctx->current_stream_id), {*op_env_cache_key},
           { op_env->Execute(inputs, output); });
     } else
 #endif
     {  // cpu
-      WITH_BASE_PROFILER(devices_[0], op_env->name(), "ComputationOperator", {op_env_cache_key},
+      WITH_BASE_PROFILER(devices_[0], op_env->name(), "ComputationOperator", {*op_env_cache_key},
                          { op_env->Execute(inputs, output); });
     }
   }
@@ -842,14 +1433,8 @@ void VirtualMachine::HandleInvokeJit(VMContext& ctx, const Instruction& instr) {
   // TODO(yaoyaoding): It seems that we can not release the workspace once we launched the
   //   kernel. Because the kernel may be in the executing status at this point due to
   //   asynchronous execution. This would cause problem for multi-stream execution.
-  std::shared_ptr<Requests> requests = op_env->GetRequests();
-  for (size_t i = 0; i < requests->workspace.size(); ++i) {
-    Requests::WorkspaceRequest& entry = requests->workspace[i];
-    if (entry.nbytes > 0 && entry.memory != nullptr) {
-      *entry.dest = nullptr;
-      entry.memory.reset();
-    }
-  }
+  ReleaseWorkspace(op_env);
+  ReleaseOperands(&operands);
   ctx->pc++;
 }
 
@@ -936,9 +1521,14 @@ void VirtualMachine::HandleInferType(VMContext& ctx, const Instruction& instr) {
 void VirtualMachine::HandleCudaSetStream(VMContext& ctx, const Instruction& instr) {
   Index device_id = instr.cuda_set_stream.device_id;
   Index stream_id = instr.cuda_set_stream.stream_id;
-  Device device(DevType::kCUDA(), static_cast<int>(device_id));
-  auto stream = utils::GetStreamById(ctx, device_id, stream_id);
-  OpEnv::SetStreamForAllBackends(device, stream->data());
+  Device device(devices_[0].device_type(), static_cast<int>(device_id));
+  auto stream = utils::GetStreamById(ctx, device, stream_id);
+  if (device.device_type() == DevType::kCPU()) {
+    // Kernels on CPU run on the host thread unless they are launched to a CPU stream.
+    ctx->use_cpu_streams = true;
+  } else {
+    OpEnv::SetStreamForAllBackends(device, stream->data());
+  }
   ctx->current_device_id = device_id;
   ctx->current_stream_id = stream_id;
   ctx->pc++;
@@ -951,10 +1541,10 @@ void VirtualMachine::HandleCudaAddEvent(VMContext& ctx, const Instruction& instr
     stream_id = ctx->current_stream_id;
   }
   Index event_id = instr.cuda_event.event_id;
-  auto event = utils::GetEventById(ctx, device_id, event_id);
-  auto stream = utils::GetStreamById(ctx, device_id, stream_id);
-  auto api = DeviceAPI::Get(DevType::kCUDA());
-  Device device(DevType::kCUDA(), static_cast<int>(device_id));
+  Device device(devices_[0].device_type(), static_cast<int>(device_id));
+  auto event = utils::GetEventById(ctx, device, event_id);
+  auto stream = utils::GetStreamById(ctx, device, stream_id);
+  auto api = DeviceAPI::Get(device.device_type());
   api->EventRecordOnStream(event->data(), stream->data());
   ctx->pc++;
 }
@@ -966,21 +1556,37 @@ void VirtualMachine::HandleCudaWaitEvent(VMContext& ctx, const Instruction& inst
     stream_id = ctx->current_stream_id;
   }
   Index event_id = instr.cuda_event.event_id;
-  auto event = utils::GetEventById(ctx, device_id, event_id);
-  auto stream = utils::GetStreamById(ctx, device_id, stream_id);
-  auto api = DeviceAPI::Get(DevType::kCUDA());
+  Device device(devices_[0].device_type(), static_cast<int>(device_id));
+  auto event = utils::GetEventById(ctx, device, event_id);
+  auto stream = utils::GetStreamById(ctx, device, stream_id);
+  auto api = DeviceAPI::Get(device.device_type());
   api->StreamWaitEvent(stream->data(), event->data());
   ctx->pc++;
 }
 
 void VirtualMachine::HandleCudaStreamBarrier(VMContext& ctx, const Instruction& instr) {
+  Device device(devices_[0].device_type(), static_cast<int>(ctx->current_device_id));
+  auto api = DeviceAPI::Get(device.device_type());
+  if (device.device_type() == DevType::kCPU()) {
+    // There is no default stream on CPU that implicitly synchronizes with other streams, so the
+    // host thread waits for the streams of this context on the device. The streams of the other
+    // contexts running concurrently are not waited.
+    Index device_id = ctx->current_device_id;
+    if (device_id < ctx->streams.size()) {
+      for (const auto& stream : ctx->streams[device_id]) {
+        if (stream != nullptr) {
+          api->WaitStream(stream->data());
+        }
+      }
+    }
+    ctx->pc++;
+    return;
+  }
   if (ctx->current_barrier_event_index >= ctx->barrier_events.size()) {
-    Device device(DevType::kCUDA(), static_cast<int>(ctx->current_device_id));
     ctx->barrier_events.resize(ctx->current_barrier_event_index + 1);
     ctx->barrier_events[ctx->current_barrier_event_index] =
         EventPool::Get(device)->GetEvent(0x02 /*cudaEventDisableTiming*/);
   }
-  auto api = DeviceAPI::Get(DevType::kCUDA());
   /*
    * We implement the cuda stream barrier by recording an event on the default stream. See also
    * the cudaEventRecord API in
@@ -996,124 +1602,207 @@ void VirtualMachine::HandleCudaStreamBarrier(VMContext& ctx, const Instruction&
   ctx->pc++;
 }
 
-std::tuple<std::shared_ptr<OpEnv>, std::vector<Value>, Value, std::string>
-VirtualMachine::PrepareOpEnv(const VMContext& ctx, const Instruction& instr) {
-  Index num_inputs = instr.invoke_jit.arity - instr.invoke_jit.output_size;
-  Array<Value> args;
-  Value output;
+void VirtualMachine::AllocWorkspace(const VMContext& ctx, const OpEnvPtr& op_env) const {
+  std::shared_ptr<Requests> requests = op_env->GetRequests();
+  for (size_t i = 0; i < requests->workspace.size(); i++) {
+    Requests::WorkspaceRequest& entry = requests->workspace[i];
+    auto buf = Alloc(ctx, entry.device, entry.nbytes);
+    entry.memory = buf;
+    *entry.dest = buf->data;
+  }
+}
 
-  // extract the input args and prepare the hash key to query op env
-  std::ostringstream os;
-  for (Index i = 0; i < num_inputs; i++) {
-    Index reg_idx = instr.invoke_jit.args[i];
-    auto reg = ctx.ReadRegister(reg_idx);
-    args.push_back(reg);
-    if (ctx.IsConst(reg_idx)) {
-      // Skip constatnts in the hash key
-      continue;
-    }
-    if (auto tensor = reg.as<TensorValueObj>()) {
-      utils::TensorRepr(os, tensor);
-    } else if (auto tup = reg.as<TupleValueObj>()) {
-      os << "(";
-      for (auto field : tup->fields) {
-        auto t = field.as<TensorValueObj>();
-        if (t != nullptr) {
-          utils::TensorRepr(os, t);
-        }
-        os << ",";
-      }
-      os << ")";
-    } else {
-      LOG(FATAL) << "Unsupported non-const register type: " << reg->GetTypeKey();
+void VirtualMachine::ReleaseWorkspace(const OpEnvPtr& op_env) const {
+  std::shared_ptr<Requests> requests = op_env->GetRequests();
+  for (size_t i = 0; i < requests->workspace.size(); ++i) {
+    Requests::WorkspaceRequest& entry = requests->workspace[i];
+    if (entry.nbytes > 0 && entry.memory != nullptr) {
+      *entry.dest = nullptr;
+      entry.memory.reset();
     }
-    os << ",";
   }
+}
 
-  // extract the output
-  os << "|";
+void VirtualMachine::LaunchOnCPUStream(const VMContext& ctx, const OpEnvPtr& op_env,
+                                       const std::vector<Value>& inputs, const Value& output,
+                                       const std::shared_ptr<const std::string>& op_env_cache_key) {
+  Device device(DevType::kCPU(), static_cast<int>(ctx->current_device_id));
+  auto stream = utils::GetStreamById(ctx, device, ctx->current_stream_id);
+  // The Free instruction may release the memory of a tensor before the task is executed, so the
+  // task holds the memory of its inputs and output.
+  std::vector<std::shared_ptr<memory_pool::Memory>> mems;
+  for (const auto& input : inputs) {
+    utils::CollectMemory(input, &mems);
+  }
+  utils::CollectMemory(output, &mems);
+  static_cast<device_api::cpu::CPUStream*>(stream->data())
+      ->Launch([this, ctx, op_env, inputs, output, mems, op_env_cache_key]() {
+        // The OpEnv is owned by the context, but the tasks of an instruction in a loop may run
+        // on different streams of the context at the same time.
+        std::shared_ptr<Requests> requests = op_env->GetRequests();
+        std::unique_lock<std::mutex> workspace_lock(requests->mu, std::defer_lock);
+        if (!requests->workspace.empty()) {
+          workspace_lock.lock();
+        }
+        AllocWorkspace(ctx, op_env);
+        if (!dryrun_) {
+          // WITH_BASE_PROFILER is not used here: its helper pool is only accessed by the host
+          // thread, and its helper waits for the device, i.e., all CPU streams including this
+          // one. The stat is added to the profiler directly, which is thread-safe.
+          auto base_profiler = raf::profiler::Profiler::Get();
+          if (base_profiler->IsProfiling(1)) {
+            uint64_t start = raf::profiler::ProfileStat::NowInMicrosec();
+            op_env->Execute(inputs, output);
+            uint64_t end = raf::profiler::ProfileStat::NowInMicrosec();
+            base_profiler->AddNewProfileStat("ComputationOperator", op_env->name(), start, end,
+                                             {*op_env_cache_key});
+          } else {
+            op_env->Execute(inputs, output);
+          }
+        }
+        ReleaseWorkspace(op_env);
+      });
+}
+
+InvokeJitOperands& VirtualMachine::PrepareOpEnv(VMContext& ctx, const Instruction& instr) {
+  Index num_inputs = instr.invoke_jit.arity - instr.invoke_jit.output_size;
+  InvokeJitOperands& operands = utils::GetInvokeJitOperands(ctx);
+
+  // extract the output. The tuple of multiple outputs is updated in place unless it is still
+  // referenced, e.g., by a task launched to a CPU stream.
   if (instr.invoke_jit.output_size == 1) {
-    output = ctx.ReadRegister(instr.invoke_jit.args[num_inputs]);
-    utils::TensorRepr(os, output.as<TensorValueObj>());
+    operands.output = ctx.ReadRegister(instr.invoke_jit.args[num_inputs]);
   } else {
-    os << "(";
-    Array<Value> outs;
+    if (!operands.output.defined() || !operands.output.unique()) {
+      Array<Value> outs(instr.invoke_jit.output_size, Value());
+      operands.output = TupleValue::make(std::move(outs));
+    }
+    auto tup = const_cast<TupleValueObj*>(operands.output.as<TupleValueObj>());
     for (Index i = num_inputs; i < instr.invoke_jit.arity; i++) {
-      Value val = ctx.ReadRegister(instr.invoke_jit.args[i]);
-      outs.push_back(val);
-      utils::TensorRepr(os, val.as<TensorValueObj>());
-      os << ",";
+      tup->fields.Set(i - num_inputs, ctx.ReadRegister(instr.invoke_jit.args[i]));
+    }
+  }
+
+  // check the inline cache first, which only compares the compact signature built from the
+  // registers. The input args are only collected on a miss.
+  const auto& func_op_env_cache = op_env_cache_[ctx->func_index];
+  OpEnvSignature signature;
+  bool has_signature = enable_inline_cache_ && utils::MakeOpEnvSignature(ctx, instr, &signature);
+  const InlineCacheEntry* cached =
+      has_signature ? func_op_env_cache->LookupInlineCache(ctx->pc, signature) : nullptr;
+  if (cached != nullptr) {
+    operands.op_env = &cached->op_env;
+    operands.op_env_cache_key = &cached->key;
+  } else {
+    Array<Value> args = utils::ReadInvokeJitArgs(ctx, instr);
+    std::string key;
+    operands.miss_op_env = PrepareOpEnvSlow(ctx, instr, args, operands.output, &key);
+    operands.miss_op_env_cache_key = std::make_shared<const std::string>(std::move(key));
+    operands.op_env = &operands.miss_op_env;
+    operands.op_env_cache_key = &operands.miss_op_env_cache_key;
+    if (has_signature) {
+      func_op_env_cache->UpdateInlineCache(ctx->pc, signature, operands.miss_op_env,
+                                           operands.miss_op_env_cache_key);
     }
-    os << ")";
-    output = TupleValue::make(outs);
   }
-  std::string op_env_cache_key = os.str();
+
+  // An OpEnv binds its workspace to itself, so each context executes its own instance of an
+  // OpEnv that requests workspace instead of the shared one.
+  if (operands.shared_op_env != operands.op_env->get()) {
+    operands.shared_op_env = operands.op_env->get();
+    operands.context_op_env = nullptr;
+    if (!(*operands.op_env)->GetRequests()->workspace.empty()) {
+      operands.context_op_env =
+          CreateOpEnv(ctx, instr, utils::ReadInvokeJitArgs(ctx, instr), operands.output);
+    }
+  }
+  if (operands.context_op_env != nullptr) {
+    operands.op_env = &operands.context_op_env;
+  }
+
+  // the inputs are cleared after the last execution, which keeps the capacity
+  const OpEnvPtr& op_env = *operands.op_env;
+  for (int i : op_env->arg_indices) {
+    CHECK(i >= 0 && i < num_inputs) << "Invalid input index: " << i;
+    operands.inputs.push_back(ctx.ReadRegister(instr.invoke_jit.args[i]));
+  }
+  return operands;
+}
+
+void VirtualMachine::ReleaseOperands(InvokeJitOperands* operands) const {
+  operands->inputs.clear();
+  const auto* tup = operands->output.as<TupleValueObj>();
+  if (tup != nullptr && operands->output.unique()) {
+    auto fields = &const_cast<TupleValueObj*>(tup)->fields;
+    for (size_t i = 0; i < fields->size(); ++i) {
+      fields->Set(i, Value());
+    }
+  } else {
+    operands->output = Value();
+  }
+}
+
+OpEnvPtr VirtualMachine::PrepareOpEnvSlow(const VMContext& ctx, const Instruction& instr,
+                                          const Array<Value>& args, const Value& output,
+                                          std::string* op_env_cache_key) {
+  *op_env_cache_key = utils::OpEnvCacheKey(instr, args, output,
+                                           [&ctx](RegName reg) { return ctx.IsConst(reg); });
 
   // check the OpEnv cache
   std::shared_ptr<OpEnv> op_env;
   auto op_env_cache = op_env_cache_[ctx->func_index]->Get(ctx->pc);
-  if (auto p = op_env_cache->Get(op_env_cache_key)) {
+  if (auto p = op_env_cache->Get(*op_env_cache_key)) {
     // Cache hit. Reuse the OpEnv from the cache.
     op_env = *p;
   } else {
-    // Create a new OpEnv.
-    auto call_values = CallValues::make();
-    Value callee = ctx.ReadRegister(instr.invoke_jit.op_reg);
-    const auto* op = callee.as<OpValueObj>();
-    const auto* closure = callee.as<ClosureValueObj>();
-    call_values->callee = callee;
-    if (op) {
-      call_values->args = GetOpAttr<FRAFSchema>(op->op, "FRAFSchema")(args);
-    } else {
-      call_values->args = MakeListArgs(args);
-    }
-    call_values->device = devices_[0];
-    call_values->out = output;
-    op_env = Dispatch(call_values);
-    CHECK(op_env != nullptr) << "ValueError: Cannot dispatch "
-                             << (op ? op->op->name : PrettyPrint(closure->func)) << " @"
-                             << call_values->device.c_str();
-    std::shared_ptr<Requests> requests = op_env->GetRequests();
-    // prepare distributed requests
-    for (size_t i = 0; i < requests->distributed.size(); i++) {
-      Requests::DistributedRequest& entry = requests->distributed[i];
-      *entry.dest = (void*)(Communicator::Get(entry.name, entry.rank_list).as<CommunicatorObj>());
-    }
-#ifdef RAF_USE_CUDA
-    // prepare cuda stream requests
-    for (size_t i = 0; i < requests->stream.size(); i++) {
-      Requests::StreamRequest& entry = requests->stream[i];
-      // currently ignores the stream_idx field in requests, all requests with the same tag_idx will
-      // get the same cuda stream in vm
-      std::shared_ptr<Stream> stream =
-          utils::GetStreamById(ctx, entry.device.device_id(), entry.tag_idx);
-      *entry.dest = stream->data();
-      entry.stream = stream;
+    // The OpEnv may be being built by the compile service, which caches it when done.
+    if (compile_service_ != nullptr) {
+      compile_service_->Wait(ctx->func_index, ctx->pc);
+      if (auto p = op_env_cache->Get(*op_env_cache_key)) {
+        return *p;
+      }
     }
-#endif
-    // add to cache
-    op_env_cache->Set(op_env_cache_key, op_env);
+    // Create a new OpEnv and add it to cache. Another context may have created the OpEnv for the
+    // same key concurrently, in which case the cached one is used.
+    op_env = CreateOpEnv(ctx, instr, args, output);
+    op_env = *op_env_cache->SetIfAbsent(*op_env_cache_key, op_env);
   }
+  return op_env;
+}
 
+OpEnvPtr VirtualMachine::CreateOpEnv(const VMContext& ctx, const Instruction& instr,
+                                     const Array<Value>& args, const Value& output) {
+  Value callee = ctx.ReadRegister(instr.invoke_jit.op_reg);
+  const auto* op = callee.as<OpValueObj>();
+  const auto* closure = callee.as<ClosureValueObj>();
+  auto call_values = utils::MakeInvokeJitCallValues(callee, args, output, devices_[0]);
+  OpEnvPtr op_env = Dispatch(call_values, args);
+  CHECK(op_env != nullptr) << "ValueError: Cannot dispatch "
+                           << (op ? op->op->name : PrettyPrint(closure->func)) << " @"
+                           << call_values->device.c_str();
   std::shared_ptr<Requests> requests = op_env->GetRequests();
-  for (size_t i = 0; i < requests->workspace.size(); i++) {
-    Requests::WorkspaceRequest& entry = requests->workspace[i];
-    auto buf = Alloc(ctx, entry.device, entry.nbytes);
-    entry.memory = buf;
-    *entry.dest = buf->data;
+  // prepare distributed requests
+  for (size_t i = 0; i < requests->distributed.size(); i++) {
+    Requests::DistributedRequest& entry = requests->distributed[i];
+    *entry.dest = (void*)(Communicator::Get(entry.name, entry.rank_list).as<CommunicatorObj>());
   }
-
-  std::vector<Value> inputs;
-  for (int i : op_env->arg_indices) {
-    CHECK_GE(i, 0) << "Invalid input index: " << i;
-    inputs.push_back(args[i]);
+#ifdef RAF_USE_CUDA
+  // prepare cuda stream requests
+  for (size_t i = 0; i < requests->stream.size(); i++) {
+    Requests::StreamRequest& entry = requests->stream[i];
+    // currently ignores the stream_idx field in requests, all requests with the same tag_idx
+    // will get the same cuda stream in vm
+    std::shared_ptr<Stream> stream = utils::GetStreamById(ctx, entry.device, entry.tag_idx);
+    *entry.dest = stream->data();
+    entry.stream = stream;
   }
-  return std::make_tuple(op_env, std::move(inputs), std::move(output), op_env_cache_key);
+#endif
+  return op_env;
 }
 
 tvm::runtime::Module CreateVirtualMachine(const Executable* exec, bool enable_cuda_graph,
-                                          bool dryrun) {
-  auto vm = make_object<VirtualMachine>(enable_cuda_graph, dryrun);
+                                          bool dryrun, bool enable_inline_cache) {
+  auto vm = make_object<VirtualMachine>(enable_cuda_graph, dryrun, enable_inline_cache);
   vm->LoadExecutable(exec);
   return tvm::runtime::Module(vm);
 }
@@ -1122,9 +1811,10 @@ RAF_REGISTER_GLOBAL("raf.vm.VirtualMachine").set_body([](tvm::TVMArgs args, tvm:
   tvm::runtime::Module mod = args[0];
   bool enable_cuda_graph = args[1];
   bool dryrun = args[2];
+  bool enable_inline_cache = args.size() > 3 ? static_cast<bool>(args[3]) : true;
   const auto* exec = dynamic_cast<Executable*>(mod.operator->());
   CHECK(exec) << "The virtual machine executable has not been defined yet.";
-  *rv = CreateVirtualMachine(exec, enable_cuda_graph, dryrun);
+  *rv = CreateVirtualMachine(exec, enable_cuda_graph, dryrun, enable_inline_cache);
 });
 
 }  // namespace vm
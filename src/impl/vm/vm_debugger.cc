@@ -82,13 +82,14 @@ PackedFunc VMDebugger::GetFunction(const std::string& name, const ObjectPtr<Obje
 }
 
 void VMDebugger::HandleInvokeJit(VMContext& ctx, const Instruction& instr) {
-  OpEnvPtr op_env;
-  std::vector<Value> inputs;
-  Value output;
-  std::string op_env_cache_key;
-
-  std::tie(op_env, inputs, output, op_env_cache_key) = PrepareOpEnv(ctx, instr);
+  InvokeJitOperands& operands = PrepareOpEnv(ctx, instr);
+  OpEnvPtr op_env = *operands.op_env;
+  std::vector<Value> inputs = operands.inputs;
+  Value output = operands.output;
+  ReleaseOperands(&operands);
+  AllocWorkspace(ctx, op_env);
   op_env->Execute(inputs, output);
+  ReleaseWorkspace(op_env);
   ctx->pc++;
 
   if (op_invokes_.find(op_env.get()) == op_invokes_.end()) {
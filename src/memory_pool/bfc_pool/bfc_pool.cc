@@ -0,0 +1,418 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/memory_pool/bfc_pool/bfc_pool.cc
+ * \brief A best-fit memory pool that splits and coalesces memory chunks
+ */
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "raf/device_api.h"
+#include "raf/memory_pool.h"
+#include "raf/registry.h"
+
+namespace raf {
+namespace memory_pool {
+namespace bfc_pool {
+
+using device_api::DeviceAPI;
+
+/*! \brief The granularity of chunk sizes and offsets in bytes. */
+static constexpr int64_t kMinAllocationSize = 256;
+/*! \brief The size of the first region requested from the device. */
+static constexpr int64_t kInitialRegionSize = 2LL << 20;
+/*! \brief The region size doubles on each extension until it reaches this size. */
+static constexpr int64_t kMaxRegionSize = 1LL << 30;
+/*! \brief The number of bins. Bin i holds the free chunks of [256 * 2^i, 256 * 2^(i+1)) bytes. */
+static constexpr int kNumBins = 21;
+
+/*!
+ * \brief A contiguous piece of a region. A chunk is either used by a Memory or free. The chunks
+ * of a region are chained by address so that the neighbours of a freed chunk can be coalesced.
+ */
+struct Chunk {
+  /*! \brief The start address of the chunk. */
+  char* ptr{nullptr};
+  /*! \brief The size of the chunk in bytes. */
+  int64_t size{0};
+  /*! \brief Whether the chunk is used by a Memory. */
+  bool in_use{false};
+  /*! \brief The previous chunk in the same region, or nullptr. */
+  Chunk* prev{nullptr};
+  /*! \brief The next chunk in the same region, or nullptr. */
+  Chunk* next{nullptr};
+};
+
+/*! \brief Orders the free chunks in a bin by size, then by address. */
+struct ChunkCompare {
+  bool operator()(const Chunk* lhs, const Chunk* rhs) const {
+    return lhs->size != rhs->size ? lhs->size < rhs->size : lhs->ptr < rhs->ptr;
+  }
+};
+
+/*!
+ * \brief The allocator behind BFCPool. It is shared by the pool and all the memory it handed out,
+ * so the regions stay alive until the last Memory is released, even if the pool has been removed.
+ */
+class BFCAllocator {
+ public:
+  BFCAllocator(Device dev, std::shared_ptr<DeviceAPI> api, int64_t pool_limit)
+      : device_(dev), api_(std::move(api)), max_pool_size_(pool_limit) {
+  }
+
+  ~BFCAllocator() {
+    for (auto& region : regions_) {
+      Chunk* chunk = region.first;
+      while (chunk != nullptr) {
+        Chunk* next = chunk->next;
+        delete chunk;
+        chunk = next;
+      }
+      api_->FreeMemory(region.ptr);
+    }
+  }
+
+  /*!
+   * \brief Find the smallest free chunk that fits the request, and split off the remainder.
+   * Extend the pool with a new region if no free chunk fits.
+   * \param nbytes The requested size, which must be a multiple of kMinAllocationSize.
+   * \return The allocated chunk, or nullptr if out of memory.
+   */
+  Chunk* Alloc(int64_t nbytes) {
+    std::lock_guard<std::mutex> lock(mu_);
+    Chunk* chunk = FindChunk(nbytes);
+    if (chunk == nullptr && !Extend(nbytes)) {
+      // Return the fully free regions to the device and try again.
+      int64_t free_nbytes = FreeUnusedRegions();
+      DLOG(WARNING) << "Failed to extend the pool for " << nbytes << " bytes. Freed "
+                    << free_nbytes << " bytes of unused regions";
+      if (!Extend(nbytes)) {
+        return nullptr;
+      }
+    }
+    if (chunk == nullptr) {
+      chunk = FindChunk(nbytes);
+      CHECK(chunk != nullptr);
+    }
+    chunk->in_use = true;
+    used_size_ += chunk->size;
+    return chunk;
+  }
+
+  /*!
+   * \brief Return a chunk to the pool and coalesce it with its free neighbours.
+   * \param chunk The chunk to be freed.
+   */
+  void Free(Chunk* chunk) {
+    std::lock_guard<std::mutex> lock(mu_);
+    CHECK(chunk->in_use);
+    chunk->in_use = false;
+    used_size_ -= chunk->size;
+    if (chunk->next != nullptr && !chunk->next->in_use) {
+      Chunk* next = chunk->next;
+      RemoveFreeChunk(next);
+      Merge(chunk, next);
+    }
+    if (chunk->prev != nullptr && !chunk->prev->in_use) {
+      Chunk* prev = chunk->prev;
+      RemoveFreeChunk(prev);
+      Merge(prev, chunk);
+      chunk = prev;
+    }
+    InsertFreeChunk(chunk);
+  }
+
+  /*! \brief Return the used and reserved size in bytes. */
+  std::pair<int64_t, int64_t> GetPoolSize() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return std::make_pair(used_size_, pool_size_);
+  }
+
+ private:
+  /*! \brief A chunk of memory allocated from the device. */
+  struct Region {
+    /*! \brief The memory allocated from the device. */
+    void* ptr;
+    /*! \brief The size of the region in bytes. */
+    int64_t size;
+    /*! \brief The chunk at the start of the region. */
+    Chunk* first;
+  };
+
+  /*!
+   * \brief Free the regions that have no used chunk.
+   * \return The freed memory in bytes.
+   */
+  int64_t FreeUnusedRegions() {
+    int64_t total_free = 0;
+    for (auto it = regions_.begin(); it != regions_.end();) {
+      Chunk* chunk = it->first;
+      if (chunk->in_use || chunk->next != nullptr) {
+        ++it;
+        continue;
+      }
+      RemoveFreeChunk(chunk);
+      delete chunk;
+      api_->FreeMemory(it->ptr);
+      total_free += it->size;
+      pool_size_ -= it->size;
+      it = regions_.erase(it);
+    }
+    return total_free;
+  }
+
+  static int BinIndex(int64_t nbytes) {
+    int index = 0;
+    for (int64_t size = nbytes / kMinAllocationSize; size > 1; size >>= 1) {
+      ++index;
+    }
+    return std::min(index, kNumBins - 1);
+  }
+
+  void InsertFreeChunk(Chunk* chunk) {
+    bins_[BinIndex(chunk->size)].insert(chunk);
+  }
+
+  void RemoveFreeChunk(Chunk* chunk) {
+    bins_[BinIndex(chunk->size)].erase(chunk);
+  }
+
+  /*! \brief Merge the chunk rhs into its previous neighbour lhs. */
+  void Merge(Chunk* lhs, Chunk* rhs) {
+    lhs->size += rhs->size;
+    lhs->next = rhs->next;
+    if (rhs->next != nullptr) {
+      rhs->next->prev = lhs;
+    }
+    delete rhs;
+  }
+
+  Chunk* FindChunk(int64_t nbytes) {
+    Chunk key;
+    key.size = nbytes;
+    for (int bin = BinIndex(nbytes); bin < kNumBins; ++bin) {
+      auto it = bins_[bin].lower_bound(&key);
+      if (it == bins_[bin].end()) {
+        continue;
+      }
+      Chunk* chunk = *it;
+      bins_[bin].erase(it);
+      if (chunk->size - nbytes >= kMinAllocationSize) {
+        // Split off the remainder as a new free chunk.
+        Chunk* rest = new Chunk();
+        rest->ptr = chunk->ptr + nbytes;
+        rest->size = chunk->size - nbytes;
+        rest->prev = chunk;
+        rest->next = chunk->next;
+        if (chunk->next != nullptr) {
+          chunk->next->prev = rest;
+        }
+        chunk->next = rest;
+        chunk->size = nbytes;
+        InsertFreeChunk(rest);
+      }
+      return chunk;
+    }
+    return nullptr;
+  }
+
+  /*!
+   * \brief Allocate a new region from the device that fits at least nbytes. The region size
+   * grows geometrically so that the number of regions stays small.
+   * \return Whether the region is allocated.
+   */
+  bool Extend(int64_t nbytes) {
+    int64_t region_size = std::max(next_region_size_, nbytes);
+    if (max_pool_size_ > 0 && pool_size_ + region_size > max_pool_size_) {
+      region_size = nbytes;
+      if (pool_size_ + region_size > max_pool_size_) {
+        return false;
+      }
+    }
+    void* ptr = AllocDeviceMemory(region_size);
+    if (ptr == nullptr && region_size > nbytes) {
+      region_size = nbytes;
+      ptr = AllocDeviceMemory(region_size);
+    }
+    if (ptr == nullptr) {
+      return false;
+    }
+    next_region_size_ = std::min(next_region_size_ * 2, kMaxRegionSize);
+    Chunk* chunk = new Chunk();
+    chunk->ptr = static_cast<char*>(ptr);
+    chunk->size = region_size;
+    regions_.push_back(Region{ptr, region_size, chunk});
+    pool_size_ += region_size;
+    InsertFreeChunk(chunk);
+    return true;
+  }
+
+  void* AllocDeviceMemory(int64_t nbytes) {
+    try {
+      return api_->AllocMemory(nbytes, kMinAllocationSize);
+    } catch (const dmlc::Error& e) {
+      return nullptr;
+    } catch (const std::bad_alloc& e) {
+      return nullptr;
+    }
+  }
+
+  /*! \brief The device of the pool. */
+  Device device_;
+  /*! \brief The pointer to the DeviceAPI which determines the context of memory. */
+  std::shared_ptr<DeviceAPI> api_;
+  /*! \brief The maximum allowed size (bytes) in the pool. 0 means no limit. */
+  int64_t max_pool_size_;
+  /*! \brief The size of the next region to be allocated. */
+  int64_t next_region_size_ = kInitialRegionSize;
+  /*! \brief The total size of the chunks in use in bytes. */
+  int64_t used_size_ = 0;
+  /*! \brief The total size of the regions in bytes. */
+  int64_t pool_size_ = 0;
+  /*! \brief The regions allocated from the device. */
+  std::list<Region> regions_;
+  /*! \brief The free chunks, binned by size. */
+  std::set<Chunk*, ChunkCompare> bins_[kNumBins];
+  /*! \brief The lock of the allocator. */
+  std::mutex mu_;
+};
+
+/*!
+ * \brief A wrapper which holds a chunk of a BFCPool region, and returns the chunk to the pool
+ * when it is released.
+ */
+class BFCMemory final : public Memory {
+ public:
+  explicit BFCMemory(void* data, const Device& dev, Chunk* chunk,
+                     std::shared_ptr<BFCAllocator> allocator)
+      : chunk(chunk), allocator(std::move(allocator)) {
+    this->data = data;
+    this->device = dev;
+  }
+
+  ~BFCMemory() {
+    if (chunk != nullptr) {
+      allocator->Free(chunk);
+    }
+  }
+
+ public:
+  /*! \brief The chunk that holds the memory. */
+  Chunk* chunk;
+  /*! \brief The allocator that owns the chunk. */
+  std::shared_ptr<BFCAllocator> allocator;
+};
+
+/*!
+ * \brief A best-fit with coalescing (BFC) memory pool. The pool requests large regions from the
+ * device and carves them into chunks. Free chunks are kept in bins by size.
+ *
+ * When user requests a chunk of memory with size N (rounded to 256 bytes), the pool picks the
+ * smallest free chunk that is not smaller than N, and splits off the remainder as a new free
+ * chunk. When a chunk is released, it is merged with its free neighbours in the same region.
+ * Unlike PageUnitPool, a freed chunk can therefore serve requests of any smaller size, which
+ * keeps the pool compact for workloads with variable shapes.
+ *
+ * If no free chunk fits, a new region is allocated. The region size starts at 2MB and doubles
+ * on each extension up to 1GB. When the device is out of memory or the pool limit is reached,
+ * the regions that are entirely free are returned to the device before giving up.
+ *
+ * \sa PageUnitPool
+ */
+class BFCPool final : public MemoryPool {
+ public:
+  explicit BFCPool(Device dev, int64_t pool_limit = 0) {
+    this->device = dev;
+    this->api = DeviceAPI::Get(dev.device_type());
+    this->allocator = std::make_shared<BFCAllocator>(dev, this->api, pool_limit);
+
+    if (dev.device_type() == DevType::kCUDA()) {
+      this->api->SetDevice(dev.device_id());
+    }
+  }
+
+  std::string GetName() {
+    return "bfc_pool";
+  }
+
+  int64_t GetAllocBytes(int64_t nbytes) override {
+    return (nbytes + kMinAllocationSize - 1) / kMinAllocationSize * kMinAllocationSize;
+  }
+
+  std::shared_ptr<Memory> Alloc(int64_t nbytes, int64_t alignment) override {
+    CHECK_GE(nbytes, 0);
+    if (nbytes == 0) {
+      return std::make_shared<BFCMemory>(nullptr, device, nullptr, allocator);
+    }
+    // Chunks are aligned to kMinAllocationSize. Pad the request for larger alignments.
+    int64_t padding = alignment > kMinAllocationSize ? alignment - kMinAllocationSize : 0;
+    int64_t alloc_nbytes = GetAllocBytes(nbytes + padding);
+    Chunk* chunk = allocator->Alloc(alloc_nbytes);
+    if (chunk == nullptr) {
+      float used, allocated;
+      std::tie(used, allocated) = GetPoolSize();
+      LOG(FATAL) << "Out-Of-Memory. Tried to allocate " << BytesToMegaBytes(alloc_nbytes)
+                 << " MBs; Already allocated " << allocated << " MBs and used " << used << " MBs";
+      throw;
+    }
+    int64_t address = reinterpret_cast<int64_t>(chunk->ptr);
+    void* data = reinterpret_cast<void*>((address + alignment - 1) / alignment * alignment);
+    return std::make_shared<BFCMemory>(data, device, chunk, allocator);
+  }
+
+  std::shared_ptr<Memory> AllocAsync(int64_t nbytes, void* stream,
+                                     int64_t alignment = kDefaultMemoryAlignment) override {
+    LOG(FATAL) << "Please use NoPool to use AllocAsync.";
+    throw;
+  }
+
+  std::vector<std::shared_ptr<Memory>> AllocBatch(const std::vector<int64_t>& nbytes,
+                                                  int64_t alignment) override {
+    std::vector<std::shared_ptr<Memory>> ret;
+    ret.reserve(nbytes.size());
+    for (int64_t bytes : nbytes) {
+      ret.emplace_back(Alloc(bytes, alignment));
+    }
+    return ret;
+  }
+
+  std::pair<float, float> GetPoolSize() override {
+    // First query the device API and use its numbers if available.
+    auto ret = api->GetPoolSize();
+    if (ret.first == 0 && ret.second == 0) {
+      ret = allocator->GetPoolSize();
+    }
+    return std::make_pair(BytesToMegaBytes(ret.first), BytesToMegaBytes(ret.second));
+  }
+
+ public:
+  static void* make(const Device& dev) {
+    int64_t max_pool_limit = 0;
+    if (const char* val = getenv("RAF_MEMORY_POOL_SIZE_LIMIT")) {
+      max_pool_limit = atol(val);
+    }
+    return new BFCPool(dev, max_pool_limit);
+  }
+
+ protected:
+  Device device;
+  /*! \brief The pointer to the DeviceAPI which determines the context of memory. */
+  std::shared_ptr<DeviceAPI> api;
+  /*! \brief The allocator that manages the regions and chunks. */
+  std::shared_ptr<BFCAllocator> allocator;
+};
+
+RAF_REGISTER_GLOBAL("raf.memory_pool._make.bfc_pool").set_body_typed([](const Device& dev) {
+  return BFCPool::make(dev);
+});
+
+}  // namespace bfc_pool
+}  // namespace memory_pool
+}  // namespace raf
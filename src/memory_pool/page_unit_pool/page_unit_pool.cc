@@ -7,7 +7,10 @@
  * \file src/memory_pool/page_unit_pool/page_unit_pool.cc
  * \brief A memory pool that use page as memory unit
  */
+#include <algorithm>
 #include <atomic>
+#include <mutex>
+#include <unordered_map>
 #include <tvm/relay/transform.h>
 #include "raf/device_api.h"
 #include "raf/memory_pool.h"
@@ -29,10 +32,12 @@ using device_api::DeviceAPI;
  */
 class NonOwnedMemory final : public Memory {
  public:
-  explicit NonOwnedMemory(void* data, const Device& dev, std::shared_ptr<DeviceAPI> api) {
+  explicit NonOwnedMemory(void* data, const Device& dev, std::shared_ptr<DeviceAPI> api,
+                          int64_t nbytes = 0) {
     this->data = data;
     this->device = dev;
     this->api = std::move(api);
+    this->nbytes = nbytes;
   }
 
   ~NonOwnedMemory() {
@@ -44,6 +49,94 @@ class NonOwnedMemory final : public Memory {
  public:
   /*! \brief The pointer to the DeviceAPI which determines the context of memory. */
   std::shared_ptr<DeviceAPI> api;
+  /*! \brief The size of the chunck in bytes. */
+  int64_t nbytes;
+  /*! \brief The next chunck in the free list of the same size. */
+  NonOwnedMemory* next_free = nullptr;
+};
+
+/*!
+ * \brief The chuncks of a PageUnitPool. The free chuncks of the same size are chained into an
+ * intrusive free list, so that both taking and returning a chunck are constant time. The pool
+ * statistics are maintained incrementally.
+ *
+ * The store is shared by the pool and the deleters of the chuncks in use, so a chunck released
+ * after the pool has been removed still goes back to the store, and is freed with it.
+ */
+class ChunkStore {
+ public:
+  ~ChunkStore() {
+    FreeUnusedChunks();
+  }
+
+  /*!
+   * \brief Take a free chunck of the given size.
+   * \param nbytes The size of the chunck.
+   * \param alignment The alignment of the chunck.
+   * \return The chunck, or nullptr if no free chunck is available.
+   */
+  NonOwnedMemory* Take(int64_t nbytes, int64_t alignment) {
+    auto it = free_lists.find(nbytes);
+    if (it == free_lists.end()) {
+      return nullptr;
+    }
+    // All chuncks are allocated with at least the page alignment, so the head fits in most
+    // cases. Otherwise, look for an aligned chunck in the rest of the list.
+    NonOwnedMemory** link = &it->second;
+    while (*link != nullptr && reinterpret_cast<int64_t>((*link)->data) % alignment != 0) {
+      link = &(*link)->next_free;
+    }
+    NonOwnedMemory* chunk = *link;
+    if (chunk != nullptr) {
+      *link = chunk->next_free;
+      chunk->next_free = nullptr;
+      used_size += nbytes;
+    }
+    return chunk;
+  }
+
+  /*!
+   * \brief Return a chunck to the free list of its size. This is called by the deleter of the
+   * chunck, i.e., when its last user releases it.
+   * \param chunk The chunck to be returned.
+   */
+  void Return(NonOwnedMemory* chunk) {
+    std::lock_guard<std::mutex> lock(mu);
+    NonOwnedMemory*& head = free_lists[chunk->nbytes];
+    chunk->next_free = head;
+    head = chunk;
+    used_size -= chunk->nbytes;
+  }
+
+  /*!
+   * \brief Free all chuncks in the free lists.
+   * \return The freed memory in bytes.
+   */
+  int64_t FreeUnusedChunks() {
+    int64_t total_free = 0;
+    for (auto& kv : free_lists) {
+      NonOwnedMemory* chunk = kv.second;
+      while (chunk != nullptr) {
+        NonOwnedMemory* next = chunk->next_free;
+        total_free += chunk->nbytes;
+        delete chunk;
+        chunk = next;
+      }
+      kv.second = nullptr;
+    }
+    pool_size -= total_free;
+    return total_free;
+  }
+
+ public:
+  /*! \brief The heads of the free lists, indexed by the chunck size. */
+  std::unordered_map<int64_t, NonOwnedMemory*> free_lists;
+  /*! \brief The total size of the chuncks in use in bytes. */
+  int64_t used_size = 0;
+  /*! \brief The total size of the chuncks in bytes. */
+  int64_t pool_size = 0;
+  /*! \brief The lock of the store. */
+  std::mutex mu;
 };
 
 /*!
@@ -55,8 +148,9 @@ class NonOwnedMemory final : public Memory {
  * available memory chunck with the same size in this pool. If so, return this available chunck. If
  * not, allocate a new memory chunck with size N, and return it.
  *
- * As the pool hold a reference to each memory chunck allocate, thus the memory chunck won't be
- * freed once it is allocated, until user's application finishes or fails.
+ * The chuncks are handed out with a deleter that returns them to the free list of the pool once
+ * the last user releases them, thus the memory chunck won't be freed once it is allocated, until
+ * user's application finishes or fails, or the pool runs GC.
  *
  * \example Assume the Page Size is 4KB. When user requests a chunck of memory with size 2KB, the
  * user will actually get a memory chunck with size 4KB, wrapped in NonOwnedMemory.
@@ -69,6 +163,7 @@ class PageUnitPool : public MemoryPool {
     this->device = dev;
     this->api = DeviceAPI::Get(dev.device_type());
     this->max_pool_size = pool_limit;
+    this->store = std::make_shared<ChunkStore>();
 
     if (dev.device_type() == DevType::kCUDA()) {
       this->api->SetDevice(dev.device_id());
@@ -93,74 +188,59 @@ class PageUnitPool : public MemoryPool {
   }
 
   int64_t FreeUnusedChunks() {
-    // Remove the memory from the pool and return the freed memory in bytes.
-    // Since this is the last share_ptr, the removed memory will be deconstructed and freed.
-    int64_t total_free = 0;
-    curr_pool_size = 0;
-
-    std::vector<int64_t> page_nbytes;
-    for (auto kv : _pool) {
-      page_nbytes.push_back(kv.first);
-    }
-
-    for (auto nbytes : page_nbytes) {
-      auto nchunk = _pool[nbytes].size();
-      _pool[nbytes].remove_if([](std::shared_ptr<Memory>& mem) { return mem.use_count() == 1; });
-      total_free += nbytes * (nchunk - _pool[nbytes].size());
-      curr_pool_size += nbytes * _pool[nbytes].size();
-    }
-    return total_free;
+    // Free the chuncks in the free lists and return the freed memory in bytes.
+    std::lock_guard<std::mutex> lock(store->mu);
+    return store->FreeUnusedChunks();
   }
 
   std::shared_ptr<Memory> Alloc(int64_t nbytes, int64_t alignment) override {
     nbytes = GetAllocBytes(nbytes);
     CHECK_GE(nbytes, 0);
+    if (nbytes == 0) {
+      return std::make_shared<NonOwnedMemory>(nullptr, device, api);
+    }
 
     // Find whether there are available memory chuncks in the pool.
     // If so, return the available memory chunck.
-    if (_pool.find(nbytes) == _pool.end()) {
-      _pool.insert({nbytes, std::list<std::shared_ptr<Memory>>()});
-    }
-    for (const auto& it : _pool[nbytes]) {
-      if (it.use_count() == 1) {
-        int64_t address = (int64_t)it->data;
-        if (address % alignment == 0) return it;
-      }
-    }
+    std::unique_lock<std::mutex> lock(store->mu);
+    NonOwnedMemory* chunk = store->Take(nbytes, alignment);
 
     // If not, allocate a new memory chunck from device.
-    void* data = nullptr;
-    if (nbytes > 0) {
-      data = AllocDeviceMemory(nbytes, alignment);
+    if (chunk == nullptr) {
+      int64_t chunk_alignment = std::max(alignment, static_cast<int64_t>(1) << page_size_exp);
+      void* data = AllocDeviceMemory(nbytes, chunk_alignment);
 
       // Out of memory or exceed the user-specified limitation, free unused chunks on other pages.
       size_t free_nbytes = SIZE_MAX;
-      if ((max_pool_size > 0 && curr_pool_size >= max_pool_size) ||
+      if ((max_pool_size > 0 && store->pool_size >= max_pool_size) ||
           (data == nullptr && free_nbytes > 0)) {
-        free_nbytes = FreeUnusedChunks();
+        free_nbytes = store->FreeUnusedChunks();
         DLOG(WARNING) << "Failed to allocate " << BytesToMegaBytes(nbytes)
                       << " MBs). Ran GC and got " << BytesToMegaBytes(free_nbytes) << " more MBs";
       }
 
       // Re-allocate the desired chunk if needed.
       if (data == nullptr && free_nbytes > 0) {
-        data = AllocDeviceMemory(nbytes, alignment);
+        data = AllocDeviceMemory(nbytes, chunk_alignment);
       }
       if (data == nullptr) {
         // If the freed memory is insufficient, then we can do nothing in memory pool.
-        size_t used, allocated;
-        std::tie(used, allocated) = GetPoolSize();
+        float used = BytesToMegaBytes(store->used_size);
+        float allocated = BytesToMegaBytes(store->pool_size);
         LOG(FATAL) << "Out-Of-Memory. Tried to allocate " << BytesToMegaBytes(nbytes)
                    << " MBs; Already allocated " << allocated << " MBs and used " << used << " MBs";
         throw;
       }
-      curr_pool_size += nbytes;
-      std::shared_ptr<Memory> new_mem = std::make_shared<NonOwnedMemory>(data, device, api);
-      _pool[nbytes].push_back(new_mem);
-      return new_mem;
-    } else {
-      return std::make_shared<NonOwnedMemory>(data, device, api);
+      chunk = new NonOwnedMemory(data, device, api, nbytes);
+      store->pool_size += nbytes;
+      store->used_size += nbytes;
     }
+    lock.unlock();
+
+    std::shared_ptr<ChunkStore> chunk_store = store;
+    return std::shared_ptr<Memory>(chunk, [chunk_store](Memory* mem) {
+      chunk_store->Return(static_cast<NonOwnedMemory*>(mem));
+    });
   }
 
   std::shared_ptr<Memory> AllocAsync(int64_t nbytes, void* stream,
@@ -186,22 +266,9 @@ class PageUnitPool : public MemoryPool {
     float pool_total = BytesToMegaBytes(ret.second);
 
     if (used_total == 0 && pool_total == 0) {
-      // First get all chunk sizes. Note that we do not count the number of used chunks
-      // with use_count > 1 here becuase the kv itself also holds a share_ptr.
-      std::vector<int64_t> page_nbytes;
-      for (auto kv : _pool) {
-        page_nbytes.push_back(kv.first);
-      }
-
-      // Then directly access each page to get the precise use_count.
-      for (auto nbytes : page_nbytes) {
-        size_t used_chunks = 0;
-        for (const auto& it : _pool[nbytes]) {
-          used_chunks += (it.use_count() > 1) ? 1 : 0;
-        }
-        used_total += BytesToMegaBytes(nbytes * used_chunks);
-        pool_total += BytesToMegaBytes(nbytes * _pool[nbytes].size());
-      }
+      std::lock_guard<std::mutex> lock(store->mu);
+      used_total = BytesToMegaBytes(store->used_size);
+      pool_total = BytesToMegaBytes(store->pool_size);
     }
     return std::make_pair(used_total, pool_total);
   }
@@ -219,14 +286,12 @@ class PageUnitPool : public MemoryPool {
   Device device;
   /*! \brief The size of each memory page (exponent). */
   static const int64_t page_size_exp = 12;
-  /*! \brief The current pool size in bytes. */
-  int64_t curr_pool_size = 0;
   /*! \brief The maximum allowed size (bytes) in the pool. 0 means no limit. */
   int64_t max_pool_size = 0;
   /*! \brief The pointer to the DeviceAPI which determines the context of memory. */
   std::shared_ptr<DeviceAPI> api;
-  /*! \brief The pool that hold the references to NonOwnedMemory. */
-  std::unordered_map<int64_t, std::list<std::shared_ptr<Memory>>> _pool;
+  /*! \brief The chuncks of the pool. */
+  std::shared_ptr<ChunkStore> store;
 };
 
 RAF_REGISTER_GLOBAL("raf.memory_pool._make.page_unit_pool").set_body_typed([](const Device& dev) {
@@ -50,6 +50,47 @@ RAF_OP_DECLARE("raf.op._allreduce", AllReduce)
     .set_attr<TRAFCollective>("TRAFCollective", true)
     .set_attr<TRAFInplaceUpdate>("TRAFInplaceUpdate", {{0, 0}});
 
+void AllReduceAsync(const CallValues& call) {
+  const auto* args = call->args.as<AllreduceArgs>();
+  CHECK(args != nullptr);
+  CHECK(!args->x.empty());
+  const DLTensor* x = args->x[0];
+  call->device = x->device;
+  // The ticket of the collective, which _wait_async waits for.
+  call->out = TensorValue::Assemble(/*dev=*/x->device,
+                                    /*dtype=*/DType(DTypeCode::kInt(), 64),
+                                    /*shape=*/{});
+}
+
+RAF_OP_DECLARE("raf.op._allreduce_async", AllReduceAsync)
+    .set_attr<TOpPattern>("TOpPattern", kOpaque)
+    .set_attr<TRAFCollective>("TRAFCollective", true);
+
+void WaitAsync(const CallValues& call) {
+  const auto* args = call->args.as<WaitAsyncArgs>();
+  CHECK(args != nullptr);
+  ir::Array<Value> ret;
+  const DLTensor* handle = args->handle;
+  call->device = handle->device;
+  for (const auto& tv : args->x) {
+    const DLTensor* x = tv;
+    std::vector<int64_t> shape(x->shape, x->shape + x->ndim);
+    ret.push_back(TensorValue::Assemble(/*dev=*/x->device,
+                                        /*dtype=*/x->dtype,
+                                        /*shape=*/shape));
+  }
+  if (ret.size() == 1) {
+    call->out = ret[0];
+  } else {
+    call->out = TupleValue::make(ret);
+  }
+}
+
+// Like _allreduce, the result may be written to the buffers of x.
+RAF_OP_DECLARE("raf.op._wait_async", WaitAsync)
+    .set_attr<TOpPattern>("TOpPattern", kOpaque)
+    .set_attr<TRAFInplaceUpdate>("TRAFInplaceUpdate", {{1, 0}});
+
 void Reduce(const CallValues& call) {
   const auto* args = call->args.as<CommReduceArgs>();
   CHECK(args != nullptr);
@@ -235,7 +276,11 @@ RAF_OP_DECLARE("raf.op._send", Send)
 void Recv(const CallValues& call) {
   const auto* args = call->args.as<RecvArgs>();
   CHECK(args != nullptr);
-  Device dev(DevType::kCUDA(), GetGlobalCommunicator()->rank);
+  // Receive into the host memory when running on CPU, where the ranks share the host.
+  Device dev = Device::Current(/*allow_default=*/true);
+  if (dev.device_type() != DevType::kCPU()) {
+    dev = Device(DevType::kCUDA(), GetGlobalCommunicator()->rank);
+  }
   call->device = dev;
   call->out = TensorValue::Assemble(/*ctx=*/dev,
                                     /*dtype=*/ir::String2DLDataType(args->dtype),
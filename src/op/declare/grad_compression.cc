@@ -0,0 +1,157 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/declare/grad_compression.cc
+ * \brief Declaration of the gradient compression operators of data parallelism
+ */
+#include <limits>
+#include "raf/op.h"
+#include "raf/tensor.h"
+#include "raf/grad_compression.h"
+#include "../schema/communication.h"
+#include "../../common/shape_utils.h"
+#include "./declare_utils.h"
+
+namespace raf {
+namespace op {
+namespace declare {
+
+using namespace raf::op::schema;
+using namespace raf::value;
+using common::shape_utils::GetNumel;
+using raf::distributed::OneBitBytes;
+using raf::distributed::PowerSGDMatrixShape;
+using raf::distributed::TopKCount;
+
+void TopKCompress(const CallValues& call) {
+  const auto* args = call->args.as<TopkCompressArgs>();
+  CHECK(args != nullptr);
+  const DLTensor* x = args->x;
+  int64_t n = GetNumel(*x);
+  CHECK(args->ratio > 0 && args->ratio <= 1) << "The ratio of top-k must be in (0, 1]";
+  CHECK_LE(n, std::numeric_limits<int32_t>::max()) << "The indices of top-k are int32";
+  int64_t k = TopKCount(n, args->ratio);
+  call->device = x->device;
+  call->out = TupleValue::make(ir::Array<Value>{
+      TensorValue::Assemble(/*dev=*/x->device, /*dtype=*/x->dtype, /*shape=*/{k}),
+      TensorValue::Assemble(/*dev=*/x->device, /*dtype=*/DType(DTypeCode::kInt(), 32),
+                            /*shape=*/{k}),
+  });
+}
+
+RAF_OP_DECLARE("raf.op._topk_compress", TopKCompress)
+    .set_attr<TOpPattern>("TOpPattern", kOpaque)
+    .set_attr<TRAFSideEffect>("TRAFSideEffect", true);
+
+void TopKDecompress(const CallValues& call) {
+  const auto* args = call->args.as<TopkDecompressArgs>();
+  CHECK(args != nullptr);
+  const DLTensor* values = args->values;
+  const DLTensor* indices = args->indices;
+  CHECK_EQ(GetNumel(*values), GetNumel(*indices));
+  call->device = values->device;
+  call->out = TensorValue::Assemble(/*dev=*/values->device,
+                                    /*dtype=*/values->dtype,
+                                    /*shape=*/args->shape);
+}
+
+RAF_OP_DECLARE("raf.op._topk_decompress", TopKDecompress)
+    .set_attr<TOpPattern>("TOpPattern", kOpaque);
+
+void OneBitCompress(const CallValues& call) {
+  const auto* args = call->args.as<OnebitCompressArgs>();
+  CHECK(args != nullptr);
+  const DLTensor* x = args->x;
+  call->device = x->device;
+  call->out = TupleValue::make(ir::Array<Value>{
+      TensorValue::Assemble(/*dev=*/x->device, /*dtype=*/DType(DTypeCode::kUInt(), 8),
+                            /*shape=*/{OneBitBytes(GetNumel(*x))}),
+      TensorValue::Assemble(/*dev=*/x->device, /*dtype=*/x->dtype, /*shape=*/{2}),
+  });
+}
+
+RAF_OP_DECLARE("raf.op._onebit_compress", OneBitCompress)
+    .set_attr<TOpPattern>("TOpPattern", kOpaque)
+    .set_attr<TRAFSideEffect>("TRAFSideEffect", true);
+
+void OneBitDecompress(const CallValues& call) {
+  const auto* args = call->args.as<OnebitDecompressArgs>();
+  CHECK(args != nullptr);
+  const DLTensor* bits = args->bits;
+  const DLTensor* scales = args->scales;
+  int64_t n = 1;
+  for (int64_t dim : args->shape) {
+    n *= dim;
+  }
+  CHECK_EQ(GetNumel(*bits) * 2, OneBitBytes(n) * GetNumel(*scales))
+      << "The signs and the scales must come from the same ranks";
+  call->device = scales->device;
+  call->out = TensorValue::Assemble(/*dev=*/scales->device,
+                                    /*dtype=*/scales->dtype,
+                                    /*shape=*/args->shape);
+}
+
+RAF_OP_DECLARE("raf.op._onebit_decompress", OneBitDecompress)
+    .set_attr<TOpPattern>("TOpPattern", kOpaque);
+
+void PowerSGDP(const CallValues& call) {
+  const auto* args = call->args.as<PowersgdPArgs>();
+  CHECK(args != nullptr);
+  const DLTensor* x = args->x;
+  auto matrix = PowerSGDMatrixShape(std::vector<int64_t>(x->shape, x->shape + x->ndim));
+  CHECK_GT(args->rank, 0);
+  call->device = x->device;
+  call->out = TensorValue::Assemble(/*dev=*/x->device,
+                                    /*dtype=*/x->dtype,
+                                    /*shape=*/{matrix.first, args->rank});
+}
+
+RAF_OP_DECLARE("raf.op._powersgd_p", PowerSGDP)
+    .set_attr<TOpPattern>("TOpPattern", kOpaque)
+    .set_attr<TRAFSideEffect>("TRAFSideEffect", true);
+
+void PowerSGDQ(const CallValues& call) {
+  const auto* args = call->args.as<PowersgdQArgs>();
+  CHECK(args != nullptr);
+  const DLTensor* p = args->p;
+  auto matrix = PowerSGDMatrixShape(args->shape);
+  CHECK_EQ(p->ndim, 2);
+  CHECK_EQ(p->shape[0], matrix.first);
+  call->device = p->device;
+  call->out = TupleValue::make(ir::Array<Value>{
+      TensorValue::Assemble(/*dev=*/p->device, /*dtype=*/p->dtype,
+                            /*shape=*/{p->shape[0], p->shape[1]}),
+      TensorValue::Assemble(/*dev=*/p->device, /*dtype=*/p->dtype,
+                            /*shape=*/{matrix.second, p->shape[1]}),
+  });
+}
+
+RAF_OP_DECLARE("raf.op._powersgd_q", PowerSGDQ)
+    .set_attr<TOpPattern>("TOpPattern", kOpaque)
+    .set_attr<TRAFSideEffect>("TRAFSideEffect", true);
+
+void PowerSGDDecompress(const CallValues& call) {
+  const auto* args = call->args.as<PowersgdDecompressArgs>();
+  CHECK(args != nullptr);
+  const DLTensor* p = args->p;
+  const DLTensor* q = args->q;
+  auto matrix = PowerSGDMatrixShape(args->shape);
+  CHECK_EQ(p->shape[0], matrix.first);
+  CHECK_EQ(q->shape[0], matrix.second);
+  CHECK_EQ(p->shape[1], q->shape[1]);
+  call->device = p->device;
+  call->out = TensorValue::Assemble(/*dev=*/p->device,
+                                    /*dtype=*/p->dtype,
+                                    /*shape=*/args->shape);
+}
+
+RAF_OP_DECLARE("raf.op._powersgd_decompress", PowerSGDDecompress)
+    .set_attr<TOpPattern>("TOpPattern", kOpaque)
+    .set_attr<TRAFSideEffect>("TRAFSideEffect", true);
+
+}  // namespace declare
+}  // namespace op
+}  // namespace raf
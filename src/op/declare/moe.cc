@@ -0,0 +1,75 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/declare/moe.cc
+ * \brief Declaration of the mixture-of-experts operators, which route the tokens to the experts
+ */
+#include "raf/op.h"
+#include "raf/tensor.h"
+#include "../schema/moe.h"
+#include "./declare_utils.h"
+
+namespace raf {
+namespace op {
+namespace declare {
+
+using namespace raf::op::schema;
+using namespace raf::value;
+
+void MoEGate(const CallValues& call) {
+  const auto* args = call->args.as<MoeGateArgs>();
+  CHECK(args != nullptr);
+  const DLTensor* probs = args->probs;
+  CHECK_EQ(probs->ndim, 2) << "_moe_gate expects the probabilities of (tokens, experts)";
+  CHECK(args->k > 0 && args->k <= probs->shape[1])
+      << "k must be in [1, " << probs->shape[1] << "], but got " << args->k;
+  CHECK_GT(args->capacity, 0) << "The capacity of an expert must be positive";
+  std::vector<int64_t> shape = {probs->shape[0], args->k};
+  call->device = probs->device;
+  call->out = TupleValue::make(ir::Array<Value>{
+      TensorValue::Assemble(/*dev=*/probs->device, /*dtype=*/DType(DTypeCode::kInt(), 32),
+                            /*shape=*/shape),
+      TensorValue::Assemble(/*dev=*/probs->device, /*dtype=*/DType(DTypeCode::kInt(), 32),
+                            /*shape=*/shape),
+  });
+}
+
+RAF_OP_DECLARE("raf.op._moe_gate", MoEGate).set_attr<TOpPattern>("TOpPattern", kOpaque);
+
+void MoEDispatch(const CallValues& call) {
+  const auto* args = call->args.as<MoeDispatchArgs>();
+  CHECK(args != nullptr);
+  const DLTensor* x = args->x;
+  const DLTensor* indices = args->indices;
+  CHECK(x->ndim == 2 || x->ndim == 3)
+      << "_moe_dispatch expects the tokens of (tokens, hidden) or (tokens, k, hidden)";
+  CHECK_EQ(x->shape[0], indices->shape[0]);
+  if (x->ndim == 3) {
+    CHECK_EQ(x->shape[1], indices->shape[1]);
+  }
+  std::vector<int64_t> shape = {args->num_experts, args->capacity, x->shape[x->ndim - 1]};
+  call->device = x->device;
+  call->out = TensorValue::Assemble(/*dev=*/x->device, /*dtype=*/x->dtype, /*shape=*/shape);
+}
+
+RAF_OP_DECLARE("raf.op._moe_dispatch", MoEDispatch).set_attr<TOpPattern>("TOpPattern", kOpaque);
+
+void MoECombine(const CallValues& call) {
+  const auto* args = call->args.as<MoeCombineArgs>();
+  CHECK(args != nullptr);
+  const DLTensor* y = args->y;
+  const DLTensor* indices = args->indices;
+  CHECK_EQ(y->ndim, 3) << "_moe_combine expects the experts of (experts, capacity, hidden)";
+  std::vector<int64_t> shape = {indices->shape[0], indices->shape[1], y->shape[2]};
+  call->device = y->device;
+  call->out = TensorValue::Assemble(/*dev=*/y->device, /*dtype=*/y->dtype, /*shape=*/shape);
+}
+
+RAF_OP_DECLARE("raf.op._moe_combine", MoECombine).set_attr<TOpPattern>("TOpPattern", kOpaque);
+
+}  // namespace declare
+}  // namespace op
+}  // namespace raf
@@ -0,0 +1,176 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/dialect/cpu/binary.cc
+ * \brief Broadcasting binary operators implemented by native CPU kernels.
+ */
+#include <cmath>
+#include <memory>
+#include "raf/op_utils.h"
+#include "../../schema/ufunc.h"
+#include "./cpu_utils.h"
+
+namespace raf {
+namespace op {
+namespace cpu {
+
+using namespace raf::value;
+using namespace raf::ir;
+using raf::op::schema::BinaryArgs;
+using raf::op::schema::BinaryUfuncArgs;
+
+static auto fschema_index = ir::Op::GetAttrMap<op::FRAFSchemaFieldIndex>("FRAFSchemaFieldIndex");
+
+/*!
+ * \brief A binary functor has the vectorized float32 kernel kKernel (-1 if there is none), supports
+ * integers if kIntegral, and computes the other cases element by element with Apply.
+ */
+#define RAF_CPU_BINARY_FUNCTOR(NAME, KERNEL, INTEGRAL, EXPR) \
+  struct NAME {                                              \
+    static constexpr int kKernel = KERNEL;                   \
+    static constexpr bool kIntegral = INTEGRAL;              \
+    template <typename T>                                    \
+    static T Apply(T a, T b) {                               \
+      return EXPR;                                           \
+    }                                                        \
+  }
+
+RAF_CPU_BINARY_FUNCTOR(AddFunctor, kAdd, true, a + b);
+RAF_CPU_BINARY_FUNCTOR(SubtractFunctor, kSubtract, true, a - b);
+RAF_CPU_BINARY_FUNCTOR(MultiplyFunctor, kMultiply, true, a * b);
+RAF_CPU_BINARY_FUNCTOR(DivideFunctor, kDivide, false, a / b);
+RAF_CPU_BINARY_FUNCTOR(MaximumFunctor, kMaximum, true, a > b ? a : b);
+RAF_CPU_BINARY_FUNCTOR(MinimumFunctor, kMinimum, true, a < b ? a : b);
+RAF_CPU_BINARY_FUNCTOR(PowerFunctor, -1, false, std::pow(a, b));
+
+#undef RAF_CPU_BINARY_FUNCTOR
+
+/*! \brief Whether the call has an argument the CPU kernels do not handle. */
+inline bool HasUnsupportedArgs(const BinaryArgs* args) {
+  return false;
+}
+
+inline bool HasUnsupportedArgs(const BinaryUfuncArgs* args) {
+  return args->where.defined();
+}
+
+template <typename F, typename SchemaT>
+class BinaryOpEnv : public raf::op::OpEnv {
+ public:
+  BinaryOpEnv(const CallValues& cv, const std::string& op_name)
+      : env_name_(TruncateName(GetUniqueName("raf.op.cpu." + op_name))) {
+    auto op = Op::Get("raf.op." + op_name);
+    this->arg_indices = {
+        fschema_index[op]("x1"),
+        fschema_index[op]("x2"),
+    };
+    auto args = cv->args.as<SchemaT>();
+    if (HasUnsupportedArgs(args) || !args->x1->template IsInstance<TensorValueObj>() ||
+        !args->x2->template IsInstance<TensorValueObj>() ||
+        !cv->out->IsInstance<TensorValueObj>()) {
+      error_msgs.push_back("[CPU] " + op_name + ": only tensor inputs are supported");
+      return;
+    }
+    DLTensor* x1 = args->x1;
+    DLTensor* x2 = args->x2;
+    DLTensor* out = cv->out;
+    elem_type_ = GetElemType(out->dtype);
+    bool is_float = elem_type_ == ElemType::kFloat32 || elem_type_ == ElemType::kFloat64;
+    if (elem_type_ == ElemType::kUnsupported || (!is_float && !F::kIntegral) ||
+        GetElemType(x1->dtype) != elem_type_ || GetElemType(x2->dtype) != elem_type_) {
+      error_msgs.push_back("[CPU] " + op_name + ": unsupported dtype " + DType(out->dtype).c_str());
+      return;
+    }
+    if (!IsContiguous(x1) || !IsContiguous(x2) || !IsContiguous(out)) {
+      error_msgs.push_back("[CPU] " + op_name + ": tensors must be contiguous");
+      return;
+    }
+    plan_ = std::make_unique<BroadcastPlan>(x1, x2, out);
+  }
+
+  std::string name() const override {
+    return env_name_;
+  }
+
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<SchemaT>();
+    Execute(std::vector<Value>{args->x1, args->x2}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    CHECK_EQ(inputs.size(), 2);
+    DLTensor* x1 = Downcast<TensorValue>(inputs[0]);
+    DLTensor* x2 = Downcast<TensorValue>(inputs[1]);
+    DLTensor* out = Downcast<TensorValue>(output);
+    switch (elem_type_) {
+      case ElemType::kFloat32:
+        // The kernel table is looked up at every launch so that the ISA can be switched.
+        if (F::kKernel >= 0) {
+          BinaryKernel kernel = GetKernelTable()->binary[F::kKernel];
+          const float* a = static_cast<const float*>(x1->data);
+          const float* b = static_cast<const float*>(x2->data);
+          float* y = static_cast<float*>(out->data);
+          int64_t sa = plan_->stride1;
+          int64_t sb = plan_->stride2;
+          plan_->Run([&](int64_t off1, int64_t off2, int64_t off, int64_t len) {
+            kernel(a + off1, sa, b + off2, sb, y + off, len);
+          });
+          return;
+        }
+        return Compute<float>(x1, x2, out);
+      case ElemType::kFloat64:
+        return Compute<double>(x1, x2, out);
+      case ElemType::kInt32:
+        return Compute<int32_t>(x1, x2, out);
+      case ElemType::kInt64:
+        return Compute<int64_t>(x1, x2, out);
+      default:
+        LOG(FATAL) << "Unsupported dtype for " << env_name_;
+    }
+  }
+
+  static OpEnv* make(const CallValues& cv, const std::string& op_name) {
+    return new BinaryOpEnv<F, SchemaT>(cv, op_name);
+  }
+
+ private:
+  template <typename T>
+  void Compute(const DLTensor* x1, const DLTensor* x2, DLTensor* out) {
+    const T* a = static_cast<const T*>(x1->data);
+    const T* b = static_cast<const T*>(x2->data);
+    T* y = static_cast<T*>(out->data);
+    int64_t sa = plan_->stride1;
+    int64_t sb = plan_->stride2;
+    plan_->Run([&](int64_t off1, int64_t off2, int64_t off, int64_t len) {
+      for (int64_t i = 0; i < len; ++i) {
+        y[off + i] = F::template Apply<T>(a[off1 + i * sa], b[off2 + i * sb]);
+      }
+    });
+  }
+
+  std::string env_name_;
+  ElemType elem_type_ = ElemType::kUnsupported;
+  /*! \brief The broadcasting of the inputs, which only depends on the shapes. */
+  std::unique_ptr<BroadcastPlan> plan_;
+};
+
+#define RAF_CPU_BINARY(OP, FUNCTOR, SCHEMA)                      \
+  RAF_REGISTER_DIALECT_OP(cpu, OP, 20);                          \
+  RAF_OP_ENV_MAKER("raf.op.cpu." #OP, [](const CallValues& cv) { \
+    return BinaryOpEnv<FUNCTOR, SCHEMA>::make(cv, #OP);          \
+  })
+
+RAF_CPU_BINARY(add, AddFunctor, BinaryUfuncArgs);
+RAF_CPU_BINARY(subtract, SubtractFunctor, BinaryUfuncArgs);
+RAF_CPU_BINARY(multiply, MultiplyFunctor, BinaryArgs);
+RAF_CPU_BINARY(divide, DivideFunctor, BinaryArgs);
+RAF_CPU_BINARY(maximum, MaximumFunctor, BinaryArgs);
+RAF_CPU_BINARY(minimum, MinimumFunctor, BinaryArgs);
+RAF_CPU_BINARY(power, PowerFunctor, BinaryArgs);
+
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
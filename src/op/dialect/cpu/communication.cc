@@ -0,0 +1,575 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/dialect/cpu/communication.cc
+ * \brief Communication operators implemented by the CPU communicators.
+ */
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "raf/op_utils.h"
+#include "raf/cpu_communicator.h"
+#include "../../schema/communication.h"
+#include "../../../common/shape_utils.h"
+
+namespace raf {
+namespace op {
+namespace cpu {
+
+using namespace raf::value;
+using namespace raf::distributed::communicator;
+using common::shape_utils::BytesCompactTensor;
+
+static auto fschema_index = ir::Op::GetAttrMap<op::FRAFSchemaFieldIndex>("FRAFSchemaFieldIndex");
+
+class CPUCommOpEnv : public raf::op::OpEnv {
+ protected:
+  void* communicator;
+
+  /*! \brief The communicator for a synchronous collective, which first waits for the pending
+   * asynchronous ones, so that every rank runs the collectives in the same order. */
+  CPUCommunicatorObj* comm() const {
+    CPUCommWorker::Get()->Flush();
+    return reinterpret_cast<CPUCommunicatorObj*>(communicator);
+  }
+
+  /*! \brief Decline the dtypes the communicator cannot reduce, so another dialect may take them. */
+  bool CheckReducible(const std::vector<BaseTensorValue>& tensors, const std::string& op_name) {
+    DType first = static_cast<const DLTensor*>(tensors[0])->dtype;
+    for (const auto& tv : tensors) {
+      DType dtype = static_cast<const DLTensor*>(tv)->dtype;
+      if (!CPUCanReduce(dtype) || dtype != first) {
+        error_msgs.push_back("[CPU] " + op_name + ": unsupported dtype " + dtype.c_str());
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+class CPUAllReduce : public CPUCommOpEnv {
+  void* fused_data;
+  int64_t total_size = 0;
+  std::vector<int64_t> tuple_sizes;
+  DType dtype;
+  CPUReduceOp compute;
+
+  explicit CPUAllReduce(const CallValues& cv) {
+    auto op = ir::Op::Get("raf.op._allreduce");
+    auto args = cv->args.as<raf::op::schema::AllreduceArgs>();
+    this->arg_indices = {fschema_index[op]("x")};
+    compute = CPUReduceOpFromString(args->computation);
+    if (!CheckReducible(args->x, "_allreduce")) {
+      return;
+    }
+    RequestDistributed(&communicator, GetCPUCommunicatorName(), args->rank_list);
+    for (const auto& tv : args->x) {
+      const DLTensor* x = tv;
+      int64_t size = BytesCompactTensor(*x);
+      tuple_sizes.push_back(size);
+      total_size += size;
+      dtype = x->dtype;
+    }
+    if (args->x.size() > 1) {
+      RequestWorkspace(&fused_data, cv->device, total_size);
+    }
+  }
+
+ public:
+  std::string name() const override {
+    return TruncateName(GetUniqueName("raf.op.cpu._allreduce"));
+  }
+
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::AllreduceArgs>();
+    Execute({TupleValue::make(ir::Array<Value>(args->x.begin(), args->x.end()))}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    auto tv = Downcast<TupleValue>(inputs[0]);
+    int64_t count = total_size / ((dtype.bits + 7) / 8);
+    if (tv->fields.size() == 1) {
+      DLTensor* x = tv->fields[0];
+      DLTensor* out = output;
+      comm()->AllReduce(x->data, out->data, count, dtype, compute);
+      return;
+    }
+    // Fuse the tensors, so that they are reduced in one pass.
+    auto fused = static_cast<uint8_t*>(fused_data);
+    int64_t offset = 0;
+    for (int i = 0; i < tv->fields.size(); ++i) {
+      DLTensor* x = tv->fields[i];
+      std::memcpy(fused + offset, x->data, tuple_sizes[i]);
+      offset += tuple_sizes[i];
+    }
+    comm()->AllReduce(fused, fused, count, dtype, compute);
+    auto out = Downcast<TupleValue>(output);
+    offset = 0;
+    for (int i = 0; i < out->fields.size(); ++i) {
+      DLTensor* ot = out->fields[i];
+      std::memcpy(ot->data, fused + offset, tuple_sizes[i]);
+      offset += tuple_sizes[i];
+    }
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUAllReduce(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _allreduce, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._allreduce", CPUAllReduce::make);
+
+class CPUAllReduceAsync : public CPUCommOpEnv {
+  std::vector<int64_t> tuple_sizes;
+  int64_t total_size = 0;
+  DType dtype;
+  CPUReduceOp compute;
+
+  explicit CPUAllReduceAsync(const CallValues& cv) {
+    auto op = ir::Op::Get("raf.op._allreduce_async");
+    auto args = cv->args.as<raf::op::schema::AllreduceArgs>();
+    this->arg_indices = {fschema_index[op]("x")};
+    compute = CPUReduceOpFromString(args->computation);
+    if (!CheckReducible(args->x, "_allreduce_async")) {
+      return;
+    }
+    RequestDistributed(&communicator, GetCPUCommunicatorName(), args->rank_list);
+    for (const auto& tv : args->x) {
+      const DLTensor* x = tv;
+      int64_t size = BytesCompactTensor(*x);
+      tuple_sizes.push_back(size);
+      total_size += size;
+      dtype = x->dtype;
+    }
+  }
+
+ public:
+  std::string name() const override {
+    return TruncateName(GetUniqueName("raf.op.cpu._allreduce_async"));
+  }
+
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::AllreduceArgs>();
+    Execute({TupleValue::make(ir::Array<Value>(args->x.begin(), args->x.end()))}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    // The tensors are fused and reduced in a buffer of the worker, from which _wait_async copies
+    // the result. The inputs are kept alive until then, since _wait_async takes them as well.
+    auto tv = Downcast<TupleValue>(inputs[0]);
+    auto fused = std::make_shared<std::vector<uint8_t>>(total_size);
+    auto comm = reinterpret_cast<CPUCommunicatorObj*>(communicator);
+    auto sizes = tuple_sizes;
+    auto dtype = this->dtype;
+    auto compute = this->compute;
+    int64_t count = total_size / ((dtype.bits + 7) / 8);
+    auto task = [tv, fused, comm, sizes, dtype, compute, count]() {
+      uint8_t* data = fused->data();
+      if (tv->fields.size() == 1) {
+        DLTensor* x = tv->fields[0];
+        comm->AllReduce(x->data, data, count, dtype, compute);
+        return;
+      }
+      int64_t offset = 0;
+      for (int i = 0; i < tv->fields.size(); ++i) {
+        DLTensor* x = tv->fields[i];
+        std::memcpy(data + offset, x->data, sizes[i]);
+        offset += sizes[i];
+      }
+      comm->AllReduce(data, data, count, dtype, compute);
+    };
+    DLTensor* out = output;
+    *static_cast<int64_t*>(out->data) = CPUCommWorker::Get()->Submit(task, fused);
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUAllReduceAsync(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _allreduce_async, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._allreduce_async", CPUAllReduceAsync::make);
+
+class CPUWaitAsync : public raf::op::OpEnv {
+  std::vector<int64_t> tuple_sizes;
+
+  explicit CPUWaitAsync(const CallValues& cv) {
+    auto op = ir::Op::Get("raf.op._wait_async");
+    auto args = cv->args.as<raf::op::schema::WaitAsyncArgs>();
+    this->arg_indices = {fschema_index[op]("handle"), fschema_index[op]("x")};
+    for (const auto& tv : args->x) {
+      tuple_sizes.push_back(BytesCompactTensor(*static_cast<const DLTensor*>(tv)));
+    }
+  }
+
+ public:
+  std::string name() const override {
+    return TruncateName(GetUniqueName("raf.op.cpu._wait_async"));
+  }
+
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::WaitAsyncArgs>();
+    Execute({args->handle, TupleValue::make(ir::Array<Value>(args->x.begin(), args->x.end()))},
+            cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    const DLTensor* handle = inputs[0];
+    auto result = CPUCommWorker::Get()->Wait(*static_cast<const int64_t*>(handle->data));
+    auto fused = std::static_pointer_cast<std::vector<uint8_t>>(result)->data();
+    int64_t offset = 0;
+    for (int i = 0; i < tuple_sizes.size(); ++i) {
+      DLTensor* out = tuple_sizes.size() == 1 ? output : Downcast<TupleValue>(output)->fields[i];
+      std::memcpy(out->data, fused + offset, tuple_sizes[i]);
+      offset += tuple_sizes[i];
+    }
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUWaitAsync(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _wait_async, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._wait_async", CPUWaitAsync::make);
+
+class CPUReduce : public CPUCommOpEnv {
+  CPUReduceOp compute;
+
+  explicit CPUReduce(const CallValues& cv) {
+    auto op = ir::Op::Get("raf.op._reduce");
+    auto args = cv->args.as<raf::op::schema::CommReduceArgs>();
+    this->arg_indices = {fschema_index[op]("x")};
+    compute = CPUReduceOpFromString(args->computation);
+    if (!CheckReducible(args->x, "_reduce")) {
+      return;
+    }
+    RequestDistributed(&communicator, GetCPUCommunicatorName(), NullValue<Value>());
+  }
+
+ public:
+  std::string name() const override {
+    return TruncateName(GetUniqueName("raf.op.cpu._reduce"));
+  }
+
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::CommReduceArgs>();
+    Execute({TupleValue::make(ir::Array<Value>(args->x.begin(), args->x.end()))}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    // The result is only defined on the root, so reducing to every rank is as good.
+    auto tv = Downcast<TupleValue>(inputs[0]);
+    for (int i = 0; i < tv->fields.size(); ++i) {
+      DLTensor* x = tv->fields[i];
+      DLTensor* out = tv->fields.size() == 1 ? output : Downcast<TupleValue>(output)->fields[i];
+      int64_t count = BytesCompactTensor(*x) / ((x->dtype.bits + 7) / 8);
+      comm()->AllReduce(x->data, out->data, count, x->dtype, compute);
+    }
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUReduce(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _reduce, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._reduce", CPUReduce::make);
+
+class CPUAllGather : public CPUCommOpEnv {
+  explicit CPUAllGather(const CallValues& cv) {
+    auto op = ir::Op::Get("raf.op._allgather");
+    auto args = cv->args.as<raf::op::schema::AllgatherArgs>();
+    this->arg_indices = {fschema_index[op]("x")};
+    RequestDistributed(&communicator, GetCPUCommunicatorName(), args->rank_list);
+  }
+
+ public:
+  std::string name() const override {
+    return TruncateName(GetUniqueName("raf.op.cpu._allgather"));
+  }
+
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::AllgatherArgs>();
+    Execute({args->x}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    DLTensor* x = inputs[0];
+    DLTensor* out = output;
+    comm()->AllGather(x->data, out->data, BytesCompactTensor(*x));
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUAllGather(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _allgather, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._allgather", CPUAllGather::make);
+
+class CPUGroupAllGather : public CPUCommOpEnv {
+  explicit CPUGroupAllGather(const CallValues& cv) {
+    auto op = ir::Op::Get("raf.op._group_allgather");
+    this->arg_indices = {fschema_index[op]("tensor_list")};
+    RequestDistributed(&communicator, GetCPUCommunicatorName(), NullValue<Value>());
+  }
+
+ public:
+  std::string name() const override {
+    return TruncateName(GetUniqueName("raf.op.cpu._group_allgather"));
+  }
+
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::GroupAllgatherArgs>();
+    Execute(
+        {TupleValue::make(ir::Array<Value>(args->tensor_list.begin(), args->tensor_list.end()))},
+        cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    auto tv = Downcast<TupleValue>(inputs[0]);
+    auto out = Downcast<TupleValue>(output);
+    for (int i = 0; i < tv->fields.size(); ++i) {
+      DLTensor* x = tv->fields[i];
+      DLTensor* ot = out->fields[i];
+      comm()->AllGather(x->data, ot->data, BytesCompactTensor(*x));
+    }
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUGroupAllGather(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _group_allgather, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._group_allgather", CPUGroupAllGather::make);
+
+class CPUReduceScatter : public CPUCommOpEnv {
+  CPUReduceOp compute;
+
+  explicit CPUReduceScatter(const CallValues& cv) {
+    auto op = ir::Op::Get("raf.op._reduce_scatter");
+    auto args = cv->args.as<raf::op::schema::ReduceScatterArgs>();
+    this->arg_indices = {fschema_index[op]("x")};
+    compute = CPUReduceOpFromString(args->computation);
+    if (!CheckReducible({args->x}, "_reduce_scatter")) {
+      return;
+    }
+    RequestDistributed(&communicator, GetCPUCommunicatorName(), args->rank_list);
+  }
+
+ public:
+  std::string name() const override {
+    return TruncateName(GetUniqueName("raf.op.cpu._reduce_scatter"));
+  }
+
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::ReduceScatterArgs>();
+    Execute({args->x}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    DLTensor* x = inputs[0];
+    DLTensor* out = output;
+    int64_t count = BytesCompactTensor(*out) / ((out->dtype.bits + 7) / 8);
+    comm()->ReduceScatter(x->data, out->data, count, x->dtype, compute);
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUReduceScatter(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _reduce_scatter, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._reduce_scatter", CPUReduceScatter::make);
+
+class CPUGroupReduceScatter : public CPUCommOpEnv {
+  CPUReduceOp compute;
+
+  explicit CPUGroupReduceScatter(const CallValues& cv) {
+    auto op = ir::Op::Get("raf.op._group_reduce_scatter");
+    auto args = cv->args.as<raf::op::schema::GroupReduceScatterArgs>();
+    this->arg_indices = {fschema_index[op]("tensor_list")};
+    compute = CPUReduceOpFromString(args->computation);
+    if (!CheckReducible(args->tensor_list, "_group_reduce_scatter")) {
+      return;
+    }
+    RequestDistributed(&communicator, GetCPUCommunicatorName(), NullValue<Value>());
+  }
+
+ public:
+  std::string name() const override {
+    return TruncateName(GetUniqueName("raf.op.cpu._group_reduce_scatter"));
+  }
+
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::GroupReduceScatterArgs>();
+    Execute(
+        {TupleValue::make(ir::Array<Value>(args->tensor_list.begin(), args->tensor_list.end()))},
+        cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    auto tv = Downcast<TupleValue>(inputs[0]);
+    auto out = Downcast<TupleValue>(output);
+    for (int i = 0; i < tv->fields.size(); ++i) {
+      DLTensor* x = tv->fields[i];
+      DLTensor* ot = out->fields[i];
+      int64_t count = BytesCompactTensor(*ot) / ((ot->dtype.bits + 7) / 8);
+      comm()->ReduceScatter(x->data, ot->data, count, x->dtype, compute);
+    }
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUGroupReduceScatter(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _group_reduce_scatter, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._group_reduce_scatter", CPUGroupReduceScatter::make);
+
+class CPUBroadcast : public CPUCommOpEnv {
+  int root;
+
+  explicit CPUBroadcast(const CallValues& cv) {
+    auto op = ir::Op::Get("raf.op._broadcast");
+    auto args = cv->args.as<raf::op::schema::BroadcastArgs>();
+    this->arg_indices = {fschema_index[op]("x")};
+    RequestDistributed(&communicator, GetCPUCommunicatorName(), NullValue<Value>());
+    root = args->root;
+  }
+
+ public:
+  std::string name() const override {
+    return TruncateName(GetUniqueName("raf.op.cpu._broadcast"));
+  }
+
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::BroadcastArgs>();
+    Execute({TupleValue::make(ir::Array<Value>(args->x.begin(), args->x.end()))}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    auto tv = Downcast<TupleValue>(inputs[0]);
+    for (int i = 0; i < tv->fields.size(); ++i) {
+      DLTensor* x = tv->fields[i];
+      DLTensor* out = tv->fields.size() == 1 ? output : Downcast<TupleValue>(output)->fields[i];
+      comm()->Broadcast(x->data, out->data, BytesCompactTensor(*x), root);
+    }
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUBroadcast(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _broadcast, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._broadcast", CPUBroadcast::make);
+
+class CPUAllToAll : public CPUCommOpEnv {
+  explicit CPUAllToAll(const CallValues& cv) {
+    auto op = ir::Op::Get("raf.op._all_to_all");
+    auto args = cv->args.as<raf::op::schema::AllToAllArgs>();
+    this->arg_indices = {fschema_index[op]("x")};
+    RequestDistributed(&communicator, GetCPUCommunicatorName(), args->rank_list);
+  }
+
+ public:
+  std::string name() const override {
+    return TruncateName(GetUniqueName("raf.op.cpu._all_to_all"));
+  }
+
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::AllToAllArgs>();
+    Execute({args->x}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    DLTensor* x = inputs[0];
+    DLTensor* out = output;
+    int64_t bytes = BytesCompactTensor(*x);
+    CHECK(bytes % comm()->size == 0) << "Cannot evenly distribute input tensor to all ranks.";
+    comm()->AllToAll(x->data, out->data, bytes / comm()->size);
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUAllToAll(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _all_to_all, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._all_to_all", CPUAllToAll::make);
+
+class CPUSend : public CPUCommOpEnv {
+  int peer;
+
+  explicit CPUSend(const CallValues& cv) {
+    auto op = ir::Op::Get("raf.op._send");
+    auto args = cv->args.as<raf::op::schema::SendArgs>();
+    this->arg_indices = {fschema_index[op]("x")};
+    RequestDistributed(&communicator, GetCPUCommunicatorName(), NullValue<Value>());
+    peer = args->peer;
+  }
+
+ public:
+  std::string name() const override {
+    return TruncateName(GetUniqueName("raf.op.cpu._send"));
+  }
+
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::SendArgs>();
+    Execute({args->x}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    const DLTensor* x = inputs[0];
+    comm()->Send(x->data, BytesCompactTensor(*x), peer);
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUSend(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _send, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._send", CPUSend::make);
+
+class CPURecv : public CPUCommOpEnv {
+  int peer;
+
+  explicit CPURecv(const CallValues& cv) {
+    auto args = cv->args.as<raf::op::schema::RecvArgs>();
+    RequestDistributed(&communicator, GetCPUCommunicatorName(), NullValue<Value>());
+    peer = args->peer;
+  }
+
+ public:
+  std::string name() const override {
+    return TruncateName(GetUniqueName("raf.op.cpu._recv"));
+  }
+
+  void Execute(const CallValues& cv) override {
+    Execute({}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    DLTensor* out = output;
+    comm()->Recv(out->data, BytesCompactTensor(*out), peer);
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPURecv(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _recv, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._recv", CPURecv::make);
+
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
@@ -0,0 +1,252 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/dialect/cpu/cpu_utils.cc
+ * \brief Helper functions for the native CPU dialect
+ */
+#include <tvm/runtime/c_backend_api.h>
+#include <atomic>
+#include <cstdlib>
+#include "raf/registry.h"
+#include "./cpu_utils.h"
+
+namespace raf {
+namespace op {
+namespace cpu {
+
+namespace {
+
+const char* CPUISAToString(CPUISA isa) {
+  switch (isa) {
+    case CPUISA::kScalar:
+      return "scalar";
+    case CPUISA::kSSE41:
+      return "sse4.1";
+    case CPUISA::kAVX2:
+      return "avx2";
+    case CPUISA::kAVX512:
+      return "avx512";
+  }
+  return "unknown";
+}
+
+CPUISA CPUISAFromString(const std::string& name) {
+  for (int i = static_cast<int>(CPUISA::kScalar); i <= static_cast<int>(CPUISA::kAVX512); ++i) {
+    if (name == CPUISAToString(static_cast<CPUISA>(i))) {
+      return static_cast<CPUISA>(i);
+    }
+  }
+  LOG(FATAL) << "Unknown CPU ISA: " << name
+             << ". Expected one of scalar, sse4.1, avx2 and avx512";
+  throw;
+}
+
+/*! \brief The best ISA the host supports and the kernels are built for. */
+CPUISA DetectCPUISA() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (GetAVX512Kernels() && __builtin_cpu_supports("avx512f")) {
+    return CPUISA::kAVX512;
+  }
+  if (GetAVX2Kernels() && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return CPUISA::kAVX2;
+  }
+  if (GetSSE41Kernels() && __builtin_cpu_supports("sse4.1")) {
+    return CPUISA::kSSE41;
+  }
+#endif
+  return CPUISA::kScalar;
+}
+
+CPUISA HostCPUISA() {
+  static const CPUISA isa = DetectCPUISA();
+  return isa;
+}
+
+std::atomic<int>& CurrentCPUISA() {
+  static std::atomic<int> isa([]() {
+    CPUISA host = HostCPUISA();
+    if (const char* val = getenv("RAF_CPU_ISA")) {
+      CPUISA requested = CPUISAFromString(val);
+      return static_cast<int>(requested < host ? requested : host);
+    }
+    return static_cast<int>(host);
+  }());
+  return isa;
+}
+
+struct ParallelForClosure {
+  int64_t n;
+  int64_t grain;
+  const std::function<void(int64_t, int64_t)>* f;
+};
+
+int ParallelForTask(int task_id, TVMParallelGroupEnv* penv, void* cdata) {
+  const auto* closure = static_cast<const ParallelForClosure*>(cdata);
+  // Hand out chunks of at least grain elements, so a task is never too small to pay off.
+  int64_t num_chunks = (closure->n + closure->grain - 1) / closure->grain;
+  int64_t num_tasks = std::min<int64_t>(penv->num_task, num_chunks);
+  // Round the chunks to whole cache lines of float32 when the grain allows it, to avoid false
+  // sharing on the output.
+  int64_t align = std::min<int64_t>(closure->grain, 16);
+  int64_t chunk = ((closure->n + num_tasks - 1) / num_tasks + align - 1) / align * align;
+  int64_t begin = std::min(closure->n, task_id * chunk);
+  int64_t end = std::min(closure->n, begin + chunk);
+  if (begin < end) {
+    (*closure->f)(begin, end);
+  }
+  return 0;
+}
+
+}  // namespace
+
+CPUISA GetCPUISA() {
+  return static_cast<CPUISA>(CurrentCPUISA().load(std::memory_order_relaxed));
+}
+
+void SetCPUISA(CPUISA isa) {
+  CPUISA host = HostCPUISA();
+  CurrentCPUISA().store(static_cast<int>(isa < host ? isa : host), std::memory_order_relaxed);
+}
+
+const KernelTable* GetKernelTable() {
+  switch (GetCPUISA()) {
+    case CPUISA::kAVX512:
+      return GetAVX512Kernels();
+    case CPUISA::kAVX2:
+      return GetAVX2Kernels();
+    case CPUISA::kSSE41:
+      return GetSSE41Kernels();
+    default:
+      return GetScalarKernels();
+  }
+}
+
+void ParallelFor(int64_t n, int64_t grain, const std::function<void(int64_t, int64_t)>& f) {
+  if (n <= 0) {
+    return;
+  }
+  if (n < 2 * grain) {
+    f(0, n);
+    return;
+  }
+  ParallelForClosure closure{n, grain, &f};
+  // num_task = 0 uses all the threads of the pool. Nested launches run on the calling worker.
+  TVMBackendParallelLaunch(ParallelForTask, &closure, 0);
+}
+
+ElemType GetElemType(const DLDataType& dtype) {
+  if (dtype.lanes != 1) {
+    return ElemType::kUnsupported;
+  }
+  if (dtype.code == kDLFloat && dtype.bits == 32) {
+    return ElemType::kFloat32;
+  }
+  if (dtype.code == kDLFloat && dtype.bits == 64) {
+    return ElemType::kFloat64;
+  }
+  if (dtype.code == kDLInt && dtype.bits == 32) {
+    return ElemType::kInt32;
+  }
+  if (dtype.code == kDLInt && dtype.bits == 64) {
+    return ElemType::kInt64;
+  }
+  return ElemType::kUnsupported;
+}
+
+bool IsContiguous(const DLTensor* tensor) {
+  if (tensor->strides == nullptr) {
+    return true;
+  }
+  int64_t expected = 1;
+  for (int i = tensor->ndim - 1; i >= 0; --i) {
+    if (tensor->shape[i] != 1 && tensor->strides[i] != expected) {
+      return false;
+    }
+    expected *= tensor->shape[i];
+  }
+  return true;
+}
+
+int64_t NumElements(const DLTensor* tensor) {
+  int64_t numel = 1;
+  for (int i = 0; i < tensor->ndim; ++i) {
+    numel *= tensor->shape[i];
+  }
+  return numel;
+}
+
+BroadcastPlan::BroadcastPlan(const DLTensor* x1, const DLTensor* x2, const DLTensor* out) {
+  // Align the inputs to the output from the right, and give broadcast dimensions a zero stride.
+  int ndim = out->ndim;
+  std::vector<int64_t> shape, strides1, strides2;
+  int64_t s1 = 1, s2 = 1;
+  for (int i = ndim - 1; i >= 0; --i) {
+    int i1 = i - (ndim - x1->ndim);
+    int i2 = i - (ndim - x2->ndim);
+    int64_t d1 = i1 >= 0 ? x1->shape[i1] : 1;
+    int64_t d2 = i2 >= 0 ? x2->shape[i2] : 1;
+    int64_t dim = out->shape[i];
+    if (dim != 1) {
+      shape.push_back(dim);
+      strides1.push_back(d1 == 1 ? 0 : s1);
+      strides2.push_back(d2 == 1 ? 0 : s2);
+    }
+    s1 *= d1;
+    s2 *= d2;
+  }
+  // Collapse adjacent dimensions (innermost first) that are laid out the same way in all tensors.
+  std::vector<int64_t> cshape, cstrides1, cstrides2;
+  for (size_t i = 0; i < shape.size(); ++i) {
+    if (!cshape.empty() && strides1[i] == cstrides1.back() * cshape.back() &&
+        strides2[i] == cstrides2.back() * cshape.back()) {
+      cshape.back() *= shape[i];
+    } else {
+      cshape.push_back(shape[i]);
+      cstrides1.push_back(strides1[i]);
+      cstrides2.push_back(strides2[i]);
+    }
+  }
+  numel = NumElements(out);
+  if (cshape.empty()) {
+    inner = 1;
+    stride1 = stride2 = 1;
+    return;
+  }
+  inner = cshape[0];
+  stride1 = cstrides1[0];
+  stride2 = cstrides2[0];
+  // Store the outer dimensions from the outermost one.
+  outer_shape.assign(cshape.rbegin(), cshape.rend() - 1);
+  outer_strides1.assign(cstrides1.rbegin(), cstrides1.rend() - 1);
+  outer_strides2.assign(cstrides2.rbegin(), cstrides2.rend() - 1);
+}
+
+void BroadcastPlan::RowOffsets(int64_t row, int64_t* off1, int64_t* off2) const {
+  *off1 = *off2 = 0;
+  for (int i = static_cast<int>(outer_shape.size()) - 1; i >= 0; --i) {
+    int64_t idx = row % outer_shape[i];
+    row /= outer_shape[i];
+    *off1 += idx * outer_strides1[i];
+    *off2 += idx * outer_strides2[i];
+  }
+}
+
+std::string GetISA() {
+  return CPUISAToString(GetCPUISA());
+}
+
+void SetISA(const std::string& isa) {
+  SetCPUISA(CPUISAFromString(isa));
+}
+
+RAF_REGISTER_DIALECT("cpu").set_enable(DevType::kCPU());
+RAF_REGISTER_GLOBAL("raf.backend.cpu.GetISA").set_body_typed(GetISA);
+RAF_REGISTER_GLOBAL("raf.backend.cpu.SetISA").set_body_typed(SetISA);
+
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
@@ -0,0 +1,106 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/dialect/cpu/cpu_utils.h
+ * \brief Helper functions for the native CPU dialect
+ */
+#pragma once
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+#include "raf/op.h"
+#include "raf/value.h"
+#include "./kernels/kernels.h"
+
+namespace raf {
+namespace op {
+namespace cpu {
+
+/*! \brief The number of elements below which a kernel runs on the calling thread. */
+constexpr int64_t kParallelGrainSize = 1 << 15;
+
+/*!
+ * \brief The ISA used by the CPU kernels. It is the best one supported by the host, capped by the
+ * environment variable RAF_CPU_ISA (scalar, sse4.1, avx2 or avx512) if set.
+ */
+CPUISA GetCPUISA();
+
+/*! \brief Override the ISA used by the CPU kernels. It is capped by what the host supports. */
+void SetCPUISA(CPUISA isa);
+
+/*! \brief The float32 kernels of the current ISA. */
+const KernelTable* GetKernelTable();
+
+/*!
+ * \brief Run f(begin, end) over the chunks of [0, n) on the TVM runtime thread pool. The range is
+ * processed on the calling thread if it has fewer than grain elements.
+ */
+void ParallelFor(int64_t n, int64_t grain, const std::function<void(int64_t, int64_t)>& f);
+
+/*! \brief The element types the CPU kernels are instantiated for. */
+enum class ElemType : int {
+  kUnsupported = 0,
+  kFloat32,
+  kFloat64,
+  kInt32,
+  kInt64,
+};
+
+/*! \brief The element type of the given dtype, or kUnsupported. */
+ElemType GetElemType(const DLDataType& dtype);
+
+/*! \brief Whether the tensor is a dense row-major tensor. */
+bool IsContiguous(const DLTensor* tensor);
+
+/*! \brief The number of elements of the tensor. */
+int64_t NumElements(const DLTensor* tensor);
+
+/*!
+ * \brief Broadcasting two inputs to the output shape, with the dimensions that have the same
+ * layout in all tensors collapsed into one. The innermost dimension is a run of inner elements,
+ * in which an input is either contiguous (stride 1) or broadcast (stride 0).
+ */
+struct BroadcastPlan {
+  BroadcastPlan(const DLTensor* x1, const DLTensor* x2, const DLTensor* out);
+
+  /*! \brief The offsets of the row-th run in x1, x2 and out. */
+  void RowOffsets(int64_t row, int64_t* off1, int64_t* off2) const;
+
+  /*!
+   * \brief Call f(off1, off2, off_out, len) on every run of the output, split at the run
+   * boundaries, on the TVM runtime thread pool.
+   */
+  template <typename FRun>
+  void Run(FRun f) const {
+    ParallelFor(numel, kParallelGrainSize, [this, &f](int64_t begin, int64_t end) {
+      int64_t row = begin / inner;
+      int64_t col = begin % inner;
+      while (begin < end) {
+        int64_t off1, off2;
+        RowOffsets(row, &off1, &off2);
+        int64_t len = std::min(inner - col, end - begin);
+        f(off1 + col * stride1, off2 + col * stride2, begin, len);
+        begin += len;
+        col = 0;
+        ++row;
+      }
+    });
+  }
+
+  /*! \brief The number of output elements. */
+  int64_t numel;
+  /*! \brief The length of the innermost run. */
+  int64_t inner;
+  /*! \brief The strides of x1 and x2 in the innermost run, either 0 or 1. */
+  int64_t stride1, stride2;
+  /*! \brief The shape of the outer dimensions and their strides in x1 and x2. */
+  std::vector<int64_t> outer_shape, outer_strides1, outer_strides2;
+};
+
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
@@ -0,0 +1,317 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/dialect/cpu/gemm.cc
+ * \brief Matmul, dense and batch_matmul implemented by a blocked, multithreaded CPU GEMM.
+ */
+#include <tvm/runtime/threading_backend.h>
+#include <algorithm>
+#include <vector>
+#include "raf/op_utils.h"
+#include "../../schema/ufunc.h"
+#include "./cpu_utils.h"
+
+namespace raf {
+namespace op {
+namespace cpu {
+
+using namespace raf::value;
+using namespace raf::ir;
+
+static auto fschema_index = ir::Op::GetAttrMap<op::FRAFSchemaFieldIndex>("FRAFSchemaFieldIndex");
+
+// The depth of the packed panels, chosen to keep a panel of b in L1.
+constexpr int64_t kGemmKC = 256;
+// The rows of a packed block of a, chosen to keep it in L2. Rounded down to the micro-tile.
+constexpr int64_t kGemmMC = 144;
+// The columns of a packed block of b, chosen to keep it in L3.
+constexpr int64_t kGemmNC = 2048;
+// Problems with fewer multiply-adds than this run on the calling thread.
+constexpr int64_t kGemmParallelFlops = 1 << 18;
+
+namespace {
+
+/*! \brief A row-major matrix, or its transpose with the strides swapped. */
+struct MatrixView {
+  const float* data;
+  int64_t row_stride;
+  int64_t col_stride;
+
+  const float* At(int64_t i, int64_t j) const {
+    return data + i * row_stride + j * col_stride;
+  }
+};
+
+/*!
+ * \brief Pack the mc x kc block of a at (i0, p0) into panels of mr rows, stored column by column
+ * and padded with zeros. A transposed a only changes the strides read here.
+ */
+void PackA(const MatrixView& a, int64_t i0, int64_t p0, int64_t mc, int64_t kc, int64_t mr,
+           float* dst) {
+  for (int64_t ir = 0; ir < mc; ir += mr) {
+    int64_t rows = std::min(mr, mc - ir);
+    for (int64_t p = 0; p < kc; ++p) {
+      const float* src = a.At(i0 + ir, p0 + p);
+      int64_t i = 0;
+      for (; i < rows; ++i) {
+        dst[i] = src[i * a.row_stride];
+      }
+      for (; i < mr; ++i) {
+        dst[i] = 0.0f;
+      }
+      dst += mr;
+    }
+  }
+}
+
+/*!
+ * \brief Pack the kc x nc block of b at (p0, j0) into panels of nr columns, stored row by row and
+ * padded with zeros. A transposed b only changes the strides read here.
+ */
+void PackB(const MatrixView& b, int64_t p0, int64_t j0, int64_t kc, int64_t nc, int64_t nr,
+           float* dst) {
+  for (int64_t jr = 0; jr < nc; jr += nr) {
+    int64_t cols = std::min(nr, nc - jr);
+    for (int64_t p = 0; p < kc; ++p) {
+      const float* src = b.At(p0 + p, j0 + jr);
+      int64_t j = 0;
+      if (b.col_stride == 1) {
+        for (; j < cols; ++j) {
+          dst[j] = src[j];
+        }
+      } else {
+        for (; j < cols; ++j) {
+          dst[j] = src[j * b.col_stride];
+        }
+      }
+      for (; j < nr; ++j) {
+        dst[j] = 0.0f;
+      }
+      dst += nr;
+    }
+  }
+}
+
+/*! \brief The packing buffers of the calling thread, which are reused across calls. */
+float* GetPackBuffer(int which, int64_t size) {
+  thread_local std::vector<float> buffers[2];
+  std::vector<float>& buffer = buffers[which];
+  if (static_cast<int64_t>(buffer.size()) < size) {
+    buffer.resize(size);
+  }
+  return buffer.data();
+}
+
+/*! \brief c[m, n] = a[m, k] * b[k, n] on the calling thread, where c has the row stride ldc. */
+void GemmBlocked(const KernelTable* kernels, int64_t m, int64_t n, int64_t k, const MatrixView& a,
+                 const MatrixView& b, float* c, int64_t ldc) {
+  const int64_t mr = kernels->gemm_mr;
+  const int64_t nr = kernels->gemm_nr;
+  const int64_t mc_max = std::max(mr, kGemmMC / mr * mr);
+  const int64_t nc_max = std::max(nr, kGemmNC / nr * nr);
+  float* packed_a = GetPackBuffer(0, mc_max * kGemmKC);
+  float* packed_b = GetPackBuffer(1, nc_max * kGemmKC);
+  float edge[64 * 64];
+  CHECK_LE(mr * nr, 64 * 64);
+
+  for (int64_t jc = 0; jc < n; jc += nc_max) {
+    int64_t nc = std::min(nc_max, n - jc);
+    for (int64_t pc = 0; pc < k; pc += kGemmKC) {
+      int64_t kc = std::min(kGemmKC, k - pc);
+      bool accumulate = pc > 0;
+      PackB(b, pc, jc, kc, nc, nr, packed_b);
+      for (int64_t ic = 0; ic < m; ic += mc_max) {
+        int64_t mc = std::min(mc_max, m - ic);
+        PackA(a, ic, pc, mc, kc, mr, packed_a);
+        for (int64_t jr = 0; jr < nc; jr += nr) {
+          int64_t cols = std::min(nr, nc - jr);
+          const float* panel_b = packed_b + jr * kc;
+          for (int64_t ir = 0; ir < mc; ir += mr) {
+            int64_t rows = std::min(mr, mc - ir);
+            const float* panel_a = packed_a + ir * kc;
+            float* tile = c + (ic + ir) * ldc + jc + jr;
+            if (rows == mr && cols == nr) {
+              kernels->gemm(kc, panel_a, panel_b, tile, ldc, accumulate);
+              continue;
+            }
+            // A partial tile is computed in full into a scratch tile and then copied.
+            kernels->gemm(kc, panel_a, panel_b, edge, nr, false);
+            for (int64_t i = 0; i < rows; ++i) {
+              for (int64_t j = 0; j < cols; ++j) {
+                float v = edge[i * nr + j];
+                tile[i * ldc + j] = accumulate ? tile[i * ldc + j] + v : v;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+/*!
+ * \brief Split the output of each batch into a grid of parts, so that there are about as many
+ * tasks as threads. The larger of the two dimensions is split first, in whole micro-tiles.
+ */
+void SplitGemm(int64_t batch, int64_t m, int64_t n, int64_t k, const KernelTable* kernels,
+               int64_t* m_parts, int64_t* n_parts) {
+  *m_parts = *n_parts = 1;
+  if (batch * m * n * k < kGemmParallelFlops) {
+    return;
+  }
+  int64_t num_threads = tvm::runtime::threading::MaxConcurrency();
+  int64_t target = (num_threads + batch - 1) / batch;
+  while (*m_parts * *n_parts < target) {
+    int64_t m_chunk = m / *m_parts;
+    int64_t n_chunk = n / *n_parts;
+    bool can_split_m = m_chunk >= 2 * kernels->gemm_mr;
+    bool can_split_n = n_chunk >= 2 * kernels->gemm_nr;
+    if (can_split_n && (n_chunk >= m_chunk || !can_split_m)) {
+      ++*n_parts;
+    } else if (can_split_m) {
+      ++*m_parts;
+    } else {
+      break;
+    }
+  }
+}
+
+/*! \brief The range [begin, end) of the part-th of num_parts parts of [0, size), in units. */
+void PartRange(int64_t size, int64_t num_parts, int64_t part, int64_t unit, int64_t* begin,
+               int64_t* end) {
+  int64_t num_units = (size + unit - 1) / unit;
+  int64_t units_per_part = (num_units + num_parts - 1) / num_parts;
+  *begin = std::min(size, part * units_per_part * unit);
+  *end = std::min(size, *begin + units_per_part * unit);
+}
+
+/*!
+ * \brief out[i] = op(x1[i]) * op(x2[i]) for each batch i, where op transposes its input if
+ * requested. A batch of size 1 is broadcast. Matrices are given by 2-D or 3-D tensors.
+ */
+void BatchGemm(const DLTensor* x1, bool transpose_a, const DLTensor* x2, bool transpose_b,
+               DLTensor* out) {
+  const KernelTable* kernels = GetKernelTable();
+  int nd = out->ndim;
+  int64_t batch = nd == 3 ? out->shape[0] : 1;
+  int64_t m = out->shape[nd - 2];
+  int64_t n = out->shape[nd - 1];
+  int64_t a_rows = x1->shape[x1->ndim - 2];
+  int64_t a_cols = x1->shape[x1->ndim - 1];
+  int64_t b_rows = x2->shape[x2->ndim - 2];
+  int64_t b_cols = x2->shape[x2->ndim - 1];
+  int64_t k = transpose_a ? a_rows : a_cols;
+  int64_t a_batch_stride = (x1->ndim == 3 && x1->shape[0] != 1) ? a_rows * a_cols : 0;
+  int64_t b_batch_stride = (x2->ndim == 3 && x2->shape[0] != 1) ? b_rows * b_cols : 0;
+  const float* a_data = static_cast<const float*>(x1->data);
+  const float* b_data = static_cast<const float*>(x2->data);
+  float* c_data = static_cast<float*>(out->data);
+  if (k == 0) {
+    // The blocked loop over k never runs, but an empty sum is zero.
+    std::fill(c_data, c_data + batch * m * n, 0.0f);
+    return;
+  }
+
+  int64_t m_parts, n_parts;
+  SplitGemm(batch, m, n, k, kernels, &m_parts, &n_parts);
+  int64_t parts = m_parts * n_parts;
+  ParallelFor(batch * parts, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t task = begin; task < end; ++task) {
+      int64_t bi = task / parts;
+      int64_t part = task % parts;
+      int64_t m0, m1, n0, n1;
+      PartRange(m, m_parts, part / n_parts, kernels->gemm_mr, &m0, &m1);
+      PartRange(n, n_parts, part % n_parts, kernels->gemm_nr, &n0, &n1);
+      if (m0 >= m1 || n0 >= n1) {
+        continue;
+      }
+      const float* a_base = a_data + bi * a_batch_stride;
+      const float* b_base = b_data + bi * b_batch_stride;
+      MatrixView a = transpose_a ? MatrixView{a_base, 1, a_cols} : MatrixView{a_base, a_cols, 1};
+      MatrixView b = transpose_b ? MatrixView{b_base, 1, b_cols} : MatrixView{b_base, b_cols, 1};
+      a.data = a.At(m0, 0);
+      b.data = b.At(0, n0);
+      GemmBlocked(kernels, m1 - m0, n1 - n0, k, a, b, c_data + bi * m * n + m0 * n + n0, n);
+    }
+  });
+}
+
+}  // namespace
+
+template <bool transpose_a, bool transpose_b>
+class GemmOpEnv : public raf::op::OpEnv {
+ public:
+  GemmOpEnv(const CallValues& cv, const std::string& op_name)
+      : env_name_(TruncateName(GetUniqueName("raf.op.cpu." + op_name))) {
+    auto op = Op::Get("raf.op." + op_name);
+    this->arg_indices = {
+        fschema_index[op]("x1"),
+        fschema_index[op]("x2"),
+    };
+    auto args = cv->args.as<raf::op::schema::BinaryArgs>();
+    if (!args->x1->IsInstance<TensorValueObj>() || !args->x2->IsInstance<TensorValueObj>() ||
+        !cv->out->IsInstance<TensorValueObj>()) {
+      error_msgs.push_back("[CPU] " + op_name + ": only tensor inputs are supported");
+      return;
+    }
+    DLTensor* x1 = args->x1;
+    DLTensor* x2 = args->x2;
+    DLTensor* out = cv->out;
+    if (GetElemType(x1->dtype) != ElemType::kFloat32 ||
+        GetElemType(x2->dtype) != ElemType::kFloat32 ||
+        GetElemType(out->dtype) != ElemType::kFloat32) {
+      error_msgs.push_back("[CPU] " + op_name + ": only float32 is supported");
+      return;
+    }
+    if (!IsContiguous(x1) || !IsContiguous(x2) || !IsContiguous(out)) {
+      error_msgs.push_back("[CPU] " + op_name + ": tensors must be contiguous");
+    }
+  }
+
+  std::string name() const override {
+    return env_name_;
+  }
+
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::BinaryArgs>();
+    BatchGemm(args->x1, transpose_a, args->x2, transpose_b, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    CHECK_EQ(inputs.size(), 2);
+    DLTensor* x1 = Downcast<TensorValue>(inputs[0]);
+    DLTensor* x2 = Downcast<TensorValue>(inputs[1]);
+    DLTensor* out = Downcast<TensorValue>(output);
+    BatchGemm(x1, transpose_a, x2, transpose_b, out);
+  }
+
+  static OpEnv* make(const CallValues& cv, const std::string& op_name) {
+    return new GemmOpEnv<transpose_a, transpose_b>(cv, op_name);
+  }
+
+ private:
+  std::string env_name_;
+};
+
+#define RAF_CPU_GEMM(OP, TRANSPOSE_A, TRANSPOSE_B)                \
+  RAF_REGISTER_DIALECT_OP(cpu, OP, 20);                           \
+  RAF_OP_ENV_MAKER("raf.op.cpu." #OP, [](const CallValues& cv) {  \
+    return GemmOpEnv<TRANSPOSE_A, TRANSPOSE_B>::make(cv, #OP);    \
+  })
+
+RAF_CPU_GEMM(matmul, false, false);
+RAF_CPU_GEMM(matmul_nt, false, true);
+RAF_CPU_GEMM(matmul_tn, true, false);
+RAF_CPU_GEMM(matmul_tt, true, true);
+RAF_CPU_GEMM(dense, false, true);
+RAF_CPU_GEMM(batch_matmul, false, false);
+RAF_CPU_GEMM(batch_matmul_nt, false, true);
+RAF_CPU_GEMM(batch_matmul_tn, true, false);
+RAF_CPU_GEMM(batch_matmul_tt, true, true);
+
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
@@ -0,0 +1,528 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/dialect/cpu/grad_compression.cc
+ * \brief Gradient compression operators of data parallelism implemented by native CPU kernels.
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include "raf/op_utils.h"
+#include "raf/registry.h"
+#include "raf/grad_compression.h"
+#include "../../schema/communication.h"
+#include "./cpu_utils.h"
+
+namespace raf {
+namespace op {
+namespace cpu {
+
+using namespace raf::value;
+using namespace raf::ir;
+using raf::distributed::OneBitBytes;
+using raf::distributed::PowerSGDMatrixShape;
+using raf::distributed::TopKCount;
+
+static auto fschema_index = ir::Op::GetAttrMap<op::FRAFSchemaFieldIndex>("FRAFSchemaFieldIndex");
+
+namespace {
+
+/*!
+ * \brief The state of a compressed gradient across iterations. The residual is the error that
+ * the compression dropped, which is added back to the gradient of the next iteration, so that
+ * the updates are unbiased over time.
+ */
+struct CompressionState {
+  std::vector<float> residual;
+  /*! \brief PowerSGD: the gradient plus the residual of this iteration. */
+  std::vector<float> m;
+  /*! \brief PowerSGD: the right factor of the last iteration, which warm-starts this one. */
+  std::vector<float> q;
+};
+
+/*!
+ * \brief The states of the compressed gradients of the process. The data parallel pass keys each
+ * gradient by its run, so the functions that it compiles do not share their states.
+ */
+struct CompressionStates {
+  std::mutex mu;
+  std::unordered_map<std::string, std::unique_ptr<CompressionState>> states;
+
+  static CompressionStates* Global() {
+    static CompressionStates* states = new CompressionStates();
+    return states;
+  }
+};
+
+/*! \brief The state of the gradient of the key, which is reset if the gradient changes size. */
+CompressionState* GetCompressionState(const std::string& key, int64_t n) {
+  auto global = CompressionStates::Global();
+  std::lock_guard<std::mutex> lock(global->mu);
+  auto& state = global->states[key];
+  if (state == nullptr || static_cast<int64_t>(state->residual.size()) != n) {
+    state = std::make_unique<CompressionState>();
+    state->residual.assign(n, 0.0f);
+  }
+  return state.get();
+}
+
+/*! \brief The grain of ParallelFor over rows, each of which takes the given work. */
+int64_t RowGrain(int64_t work_per_row) {
+  return std::max<int64_t>(1, kParallelGrainSize / std::max<int64_t>(work_per_row, 1));
+}
+
+}  // namespace
+
+/*!
+ * \brief Free the states of all the compressed gradients, so the next iteration starts without
+ * residuals. It must not run concurrently with the compression operators.
+ */
+void ResetGradCompression() {
+  auto global = CompressionStates::Global();
+  std::lock_guard<std::mutex> lock(global->mu);
+  global->states.clear();
+}
+
+RAF_REGISTER_GLOBAL("raf.distributed.ResetGradCompression").set_body_typed(ResetGradCompression);
+
+/*! \brief The base of the compression operators, which only take float32 tensors. */
+class GradCompressionOpEnv : public raf::op::OpEnv {
+ protected:
+  GradCompressionOpEnv(const std::string& op_name, const std::vector<std::string>& fields)
+      : env_name_(TruncateName(GetUniqueName("raf.op.cpu." + op_name))) {
+    auto op = Op::Get("raf.op." + op_name);
+    for (const auto& field : fields) {
+      this->arg_indices.push_back(fschema_index[op](field));
+    }
+  }
+
+  bool CheckFloat32(const DLTensor* tensor, const std::string& op_name) {
+    if (GetElemType(tensor->dtype) != ElemType::kFloat32 || !IsContiguous(tensor)) {
+      error_msgs.push_back("[CPU] " + op_name + ": requires a contiguous float32 tensor");
+      return false;
+    }
+    return true;
+  }
+
+ public:
+  std::string name() const override {
+    return env_name_;
+  }
+
+ private:
+  std::string env_name_;
+};
+
+class CPUTopKCompress : public GradCompressionOpEnv {
+  std::string key;
+
+  explicit CPUTopKCompress(const CallValues& cv)
+      : GradCompressionOpEnv("_topk_compress", {"x"}) {
+    auto args = cv->args.as<raf::op::schema::TopkCompressArgs>();
+    key = args->key;
+    CheckFloat32(args->x, "_topk_compress");
+  }
+
+ public:
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::TopkCompressArgs>();
+    Execute({args->x}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    DLTensor* x = inputs[0];
+    auto out = Downcast<TupleValue>(output);
+    DLTensor* values = out->fields[0];
+    DLTensor* indices = out->fields[1];
+    int64_t n = NumElements(x);
+    int64_t k = NumElements(values);
+    auto state = GetCompressionState(key, n);
+    float* acc = state->residual.data();
+    const float* x_data = static_cast<const float*>(x->data);
+    for (int64_t i = 0; i < n; ++i) {
+      acc[i] += x_data[i];
+    }
+    // Select the k largest magnitudes in O(n), and keep the indices sorted for locality.
+    std::vector<int32_t> order(n);
+    for (int64_t i = 0; i < n; ++i) {
+      order[i] = static_cast<int32_t>(i);
+    }
+    std::nth_element(order.begin(), order.begin() + (k - 1), order.end(),
+                     [acc](int32_t a, int32_t b) { return std::abs(acc[a]) > std::abs(acc[b]); });
+    std::sort(order.begin(), order.begin() + k);
+    auto values_data = static_cast<float*>(values->data);
+    auto indices_data = static_cast<int32_t*>(indices->data);
+    for (int64_t i = 0; i < k; ++i) {
+      indices_data[i] = order[i];
+      values_data[i] = acc[order[i]];
+      acc[order[i]] = 0.0f;
+    }
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUTopKCompress(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _topk_compress, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._topk_compress", CPUTopKCompress::make);
+
+class CPUTopKDecompress : public GradCompressionOpEnv {
+  float scale;
+
+  explicit CPUTopKDecompress(const CallValues& cv)
+      : GradCompressionOpEnv("_topk_decompress", {"values", "indices"}) {
+    auto args = cv->args.as<raf::op::schema::TopkDecompressArgs>();
+    scale = args->scale;
+    CheckFloat32(args->values, "_topk_decompress");
+  }
+
+ public:
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::TopkDecompressArgs>();
+    Execute({args->values, args->indices}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    DLTensor* values = inputs[0];
+    DLTensor* indices = inputs[1];
+    DLTensor* out = output;
+    auto out_data = static_cast<float*>(out->data);
+    auto values_data = static_cast<const float*>(values->data);
+    auto indices_data = static_cast<const int32_t*>(indices->data);
+    int64_t n = NumElements(out);
+    std::fill(out_data, out_data + n, 0.0f);
+    // The ranks may select the same index, so their values are summed up.
+    int64_t k = NumElements(values);
+    for (int64_t i = 0; i < k; ++i) {
+      int64_t idx = indices_data[i];
+      CHECK(0 <= idx && idx < n) << "_topk_decompress: index " << idx << " is out of " << n;
+      out_data[idx] += values_data[i] * scale;
+    }
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUTopKDecompress(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _topk_decompress, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._topk_decompress", CPUTopKDecompress::make);
+
+class CPUOneBitCompress : public GradCompressionOpEnv {
+  std::string key;
+
+  explicit CPUOneBitCompress(const CallValues& cv)
+      : GradCompressionOpEnv("_onebit_compress", {"x"}) {
+    auto args = cv->args.as<raf::op::schema::OnebitCompressArgs>();
+    key = args->key;
+    CheckFloat32(args->x, "_onebit_compress");
+  }
+
+ public:
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::OnebitCompressArgs>();
+    Execute({args->x}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    DLTensor* x = inputs[0];
+    auto out = Downcast<TupleValue>(output);
+    DLTensor* bits = out->fields[0];
+    DLTensor* scales = out->fields[1];
+    int64_t n = NumElements(x);
+    auto state = GetCompressionState(key, n);
+    float* acc = state->residual.data();
+    const float* x_data = static_cast<const float*>(x->data);
+    // The positive and the negative elements are restored to their mean magnitudes.
+    double pos_sum = 0, neg_sum = 0;
+    int64_t pos_count = 0;
+    for (int64_t i = 0; i < n; ++i) {
+      acc[i] += x_data[i];
+      if (acc[i] >= 0) {
+        pos_sum += acc[i];
+        ++pos_count;
+      } else {
+        neg_sum -= acc[i];
+      }
+    }
+    float pos = pos_count > 0 ? pos_sum / pos_count : 0.0f;
+    float neg = pos_count < n ? neg_sum / (n - pos_count) : 0.0f;
+    auto bits_data = static_cast<uint8_t*>(bits->data);
+    std::memset(bits_data, 0, OneBitBytes(n));
+    for (int64_t i = 0; i < n; ++i) {
+      if (acc[i] >= 0) {
+        bits_data[i / 8] |= 1 << (i % 8);
+        acc[i] -= pos;
+      } else {
+        acc[i] += neg;
+      }
+    }
+    auto scales_data = static_cast<float*>(scales->data);
+    scales_data[0] = pos;
+    scales_data[1] = neg;
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUOneBitCompress(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _onebit_compress, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._onebit_compress", CPUOneBitCompress::make);
+
+class CPUOneBitDecompress : public GradCompressionOpEnv {
+  float scale;
+
+  explicit CPUOneBitDecompress(const CallValues& cv)
+      : GradCompressionOpEnv("_onebit_decompress", {"bits", "scales"}) {
+    auto args = cv->args.as<raf::op::schema::OnebitDecompressArgs>();
+    scale = args->scale;
+    CheckFloat32(args->scales, "_onebit_decompress");
+  }
+
+ public:
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::OnebitDecompressArgs>();
+    Execute({args->bits, args->scales}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    DLTensor* bits = inputs[0];
+    DLTensor* scales = inputs[1];
+    DLTensor* out = output;
+    int64_t n = NumElements(out);
+    int64_t num_ranks = NumElements(scales) / 2;
+    int64_t bytes = OneBitBytes(n);
+    auto out_data = static_cast<float*>(out->data);
+    auto bits_data = static_cast<const uint8_t*>(bits->data);
+    auto scales_data = static_cast<const float*>(scales->data);
+    std::fill(out_data, out_data + n, 0.0f);
+    for (int64_t r = 0; r < num_ranks; ++r) {
+      const uint8_t* signs = bits_data + r * bytes;
+      float pos = scales_data[2 * r] * scale;
+      float neg = -scales_data[2 * r + 1] * scale;
+      ParallelFor(n, kParallelGrainSize, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          out_data[i] += (signs[i / 8] >> (i % 8)) & 1 ? pos : neg;
+        }
+      });
+    }
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUOneBitDecompress(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _onebit_decompress, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._onebit_decompress", CPUOneBitDecompress::make);
+
+/*!
+ * \brief PowerSGD approximates the gradient M (rows x cols) by P Q^T of the given rank, with one
+ * step of subspace iteration per training iteration: P = M Q, orthogonalize the allreduced P, then
+ * Q = M^T P, whose allreduce gives the approximation. Q is warm-started from the last iteration.
+ */
+class CPUPowerSGDP : public GradCompressionOpEnv {
+  std::string key;
+
+  explicit CPUPowerSGDP(const CallValues& cv) : GradCompressionOpEnv("_powersgd_p", {"x"}) {
+    auto args = cv->args.as<raf::op::schema::PowersgdPArgs>();
+    key = args->key;
+    CheckFloat32(args->x, "_powersgd_p");
+  }
+
+ public:
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::PowersgdPArgs>();
+    Execute({args->x}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    DLTensor* x = inputs[0];
+    DLTensor* p = output;
+    int64_t rows = p->shape[0];
+    int64_t rank = p->shape[1];
+    int64_t cols = NumElements(x) / rows;
+    auto state = GetCompressionState(key, rows * cols);
+    if (static_cast<int64_t>(state->q.size()) != cols * rank) {
+      // All the ranks must start from the same Q, so the seed is fixed.
+      std::mt19937 gen(0);
+      std::normal_distribution<float> dist;
+      state->q.resize(cols * rank);
+      for (auto& v : state->q) {
+        v = dist(gen);
+      }
+    }
+    const float* x_data = static_cast<const float*>(x->data);
+    state->m.resize(rows * cols);
+    float* m = state->m.data();
+    for (int64_t i = 0; i < rows * cols; ++i) {
+      m[i] = x_data[i] + state->residual[i];
+    }
+    const float* q = state->q.data();
+    auto p_data = static_cast<float*>(p->data);
+    ParallelFor(rows, RowGrain(cols * rank), [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        for (int64_t r = 0; r < rank; ++r) {
+          float sum = 0;
+          for (int64_t j = 0; j < cols; ++j) {
+            sum += m[i * cols + j] * q[j * rank + r];
+          }
+          p_data[i * rank + r] = sum;
+        }
+      }
+    });
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUPowerSGDP(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _powersgd_p, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._powersgd_p", CPUPowerSGDP::make);
+
+class CPUPowerSGDQ : public GradCompressionOpEnv {
+  std::string key;
+
+  explicit CPUPowerSGDQ(const CallValues& cv) : GradCompressionOpEnv("_powersgd_q", {"p"}) {
+    auto args = cv->args.as<raf::op::schema::PowersgdQArgs>();
+    key = args->key;
+    CheckFloat32(args->p, "_powersgd_q");
+  }
+
+ public:
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::PowersgdQArgs>();
+    Execute({args->p}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    DLTensor* p_in = inputs[0];
+    auto out = Downcast<TupleValue>(output);
+    DLTensor* p = out->fields[0];
+    DLTensor* q = out->fields[1];
+    int64_t rows = p->shape[0];
+    int64_t rank = p->shape[1];
+    int64_t cols = q->shape[0];
+    auto state = GetCompressionState(key, rows * cols);
+    CHECK_EQ(static_cast<int64_t>(state->m.size()), rows * cols)
+        << "_powersgd_q of " << key << " without _powersgd_p";
+    // Orthonormalize the columns of P with Gram-Schmidt, which is cheap for a small rank.
+    auto p_data = static_cast<float*>(p->data);
+    if (p_data != p_in->data) {
+      std::memcpy(p_data, p_in->data, rows * rank * sizeof(float));
+    }
+    for (int64_t r = 0; r < rank; ++r) {
+      for (int64_t prev = 0; prev < r; ++prev) {
+        double dot = 0;
+        for (int64_t i = 0; i < rows; ++i) {
+          dot += p_data[i * rank + r] * p_data[i * rank + prev];
+        }
+        for (int64_t i = 0; i < rows; ++i) {
+          p_data[i * rank + r] -= dot * p_data[i * rank + prev];
+        }
+      }
+      double norm = 0;
+      for (int64_t i = 0; i < rows; ++i) {
+        norm += p_data[i * rank + r] * p_data[i * rank + r];
+      }
+      // A degenerate column is dropped rather than amplifying the noise.
+      float inv = norm > 1e-16 ? 1.0 / std::sqrt(norm) : 0.0f;
+      for (int64_t i = 0; i < rows; ++i) {
+        p_data[i * rank + r] *= inv;
+      }
+    }
+    const float* m = state->m.data();
+    auto q_data = static_cast<float*>(q->data);
+    ParallelFor(cols, RowGrain(rows * rank), [&](int64_t begin, int64_t end) {
+      std::fill(q_data + begin * rank, q_data + end * rank, 0.0f);
+      for (int64_t i = 0; i < rows; ++i) {
+        for (int64_t j = begin; j < end; ++j) {
+          for (int64_t r = 0; r < rank; ++r) {
+            q_data[j * rank + r] += m[i * cols + j] * p_data[i * rank + r];
+          }
+        }
+      }
+    });
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUPowerSGDQ(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _powersgd_q, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._powersgd_q", CPUPowerSGDQ::make);
+
+class CPUPowerSGDDecompress : public GradCompressionOpEnv {
+  std::string key;
+  float scale;
+
+  explicit CPUPowerSGDDecompress(const CallValues& cv)
+      : GradCompressionOpEnv("_powersgd_decompress", {"p", "q"}) {
+    auto args = cv->args.as<raf::op::schema::PowersgdDecompressArgs>();
+    key = args->key;
+    scale = args->scale;
+    CheckFloat32(args->p, "_powersgd_decompress");
+  }
+
+ public:
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::PowersgdDecompressArgs>();
+    Execute({args->p, args->q}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    DLTensor* p = inputs[0];
+    DLTensor* q = inputs[1];
+    DLTensor* out = output;
+    int64_t rows = p->shape[0];
+    int64_t rank = p->shape[1];
+    int64_t cols = q->shape[0];
+    auto state = GetCompressionState(key, rows * cols);
+    CHECK_EQ(static_cast<int64_t>(state->m.size()), rows * cols)
+        << "_powersgd_decompress of " << key << " without _powersgd_p";
+    // Keep the averaged Q for the next iteration.
+    auto q_data = static_cast<const float*>(q->data);
+    for (int64_t i = 0; i < cols * rank; ++i) {
+      state->q[i] = q_data[i] * scale;
+    }
+    const float* p_data = static_cast<const float*>(p->data);
+    const float* q_avg = state->q.data();
+    const float* m = state->m.data();
+    float* residual = state->residual.data();
+    auto out_data = static_cast<float*>(out->data);
+    ParallelFor(rows, RowGrain(cols * rank), [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        for (int64_t j = 0; j < cols; ++j) {
+          float sum = 0;
+          for (int64_t r = 0; r < rank; ++r) {
+            sum += p_data[i * rank + r] * q_avg[j * rank + r];
+          }
+          out_data[i * cols + j] = sum;
+          residual[i * cols + j] = m[i * cols + j] - sum;
+        }
+      }
+    });
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUPowerSGDDecompress(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _powersgd_decompress, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._powersgd_decompress", CPUPowerSGDDecompress::make);
+
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
@@ -0,0 +1,285 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/dialect/cpu/kernels/kernel_impl.h
+ * \brief The ISA-independent part of the elementwise kernels. It is included by each kernels_*.cc
+ * after it defines a struct Vec of SIMD primitives in an anonymous namespace, and everything here
+ * is kept in that namespace as well: a definition shared between units compiled with different
+ * -m flags could otherwise be resolved by the linker to a copy using unsupported instructions.
+ */
+#pragma once
+#include "./kernels.h"
+
+namespace raf {
+namespace op {
+namespace cpu {
+namespace {
+
+using VecT = Vec::T;
+
+// Scalar ops are used for the tails and must round exactly like their vector counterparts.
+// max and min follow the SSE convention of returning the second operand if either is NaN.
+
+struct CopyOp {
+  static VecT ApplyVec(VecT x) {
+    return x;
+  }
+  static float Apply(float x) {
+    return x;
+  }
+};
+
+struct NegativeOp {
+  static VecT ApplyVec(VecT x) {
+    return Vec::Neg(x);
+  }
+  static float Apply(float x) {
+    return -x;
+  }
+};
+
+struct AbsOp {
+  static VecT ApplyVec(VecT x) {
+    return Vec::Abs(x);
+  }
+  static float Apply(float x) {
+    return __builtin_fabsf(x);
+  }
+};
+
+struct ReluOp {
+  static VecT ApplyVec(VecT x) {
+    return Vec::Max(x, Vec::Set1(0.0f));
+  }
+  static float Apply(float x) {
+    return x > 0.0f ? x : 0.0f;
+  }
+};
+
+struct SqrtOp {
+  static VecT ApplyVec(VecT x) {
+    return Vec::Sqrt(x);
+  }
+  static float Apply(float x) {
+    return __builtin_sqrtf(x);
+  }
+};
+
+struct RsqrtOp {
+  // The approximate rsqrt instructions are not accurate enough, so compute 1 / sqrt(x).
+  static VecT ApplyVec(VecT x) {
+    return Vec::Div(Vec::Set1(1.0f), Vec::Sqrt(x));
+  }
+  static float Apply(float x) {
+    return 1.0f / __builtin_sqrtf(x);
+  }
+};
+
+struct ReciprocalOp {
+  static VecT ApplyVec(VecT x) {
+    return Vec::Div(Vec::Set1(1.0f), x);
+  }
+  static float Apply(float x) {
+    return 1.0f / x;
+  }
+};
+
+struct CeilOp {
+  static VecT ApplyVec(VecT x) {
+    return Vec::Ceil(x);
+  }
+  static float Apply(float x) {
+    return __builtin_ceilf(x);
+  }
+};
+
+struct FloorOp {
+  static VecT ApplyVec(VecT x) {
+    return Vec::Floor(x);
+  }
+  static float Apply(float x) {
+    return __builtin_floorf(x);
+  }
+};
+
+struct TruncOp {
+  static VecT ApplyVec(VecT x) {
+    return Vec::Trunc(x);
+  }
+  static float Apply(float x) {
+    return __builtin_truncf(x);
+  }
+};
+
+struct AddOp {
+  static VecT ApplyVec(VecT a, VecT b) {
+    return Vec::Add(a, b);
+  }
+  static float Apply(float a, float b) {
+    return a + b;
+  }
+};
+
+struct SubtractOp {
+  static VecT ApplyVec(VecT a, VecT b) {
+    return Vec::Sub(a, b);
+  }
+  static float Apply(float a, float b) {
+    return a - b;
+  }
+};
+
+struct MultiplyOp {
+  static VecT ApplyVec(VecT a, VecT b) {
+    return Vec::Mul(a, b);
+  }
+  static float Apply(float a, float b) {
+    return a * b;
+  }
+};
+
+struct DivideOp {
+  static VecT ApplyVec(VecT a, VecT b) {
+    return Vec::Div(a, b);
+  }
+  static float Apply(float a, float b) {
+    return a / b;
+  }
+};
+
+struct MaximumOp {
+  static VecT ApplyVec(VecT a, VecT b) {
+    return Vec::Max(a, b);
+  }
+  static float Apply(float a, float b) {
+    return a > b ? a : b;
+  }
+};
+
+struct MinimumOp {
+  static VecT ApplyVec(VecT a, VecT b) {
+    return Vec::Min(a, b);
+  }
+  static float Apply(float a, float b) {
+    return a < b ? a : b;
+  }
+};
+
+template <typename Op>
+void UnaryKernelImpl(const float* x, float* y, int64_t n) {
+  int64_t i = 0;
+  for (; i + Vec::kWidth <= n; i += Vec::kWidth) {
+    Vec::Store(y + i, Op::ApplyVec(Vec::Load(x + i)));
+  }
+  for (; i < n; ++i) {
+    y[i] = Op::Apply(x[i]);
+  }
+}
+
+template <typename Op>
+void BinaryKernelImpl(const float* a, int64_t sa, const float* b, int64_t sb, float* out,
+                      int64_t n) {
+  int64_t i = 0;
+  if (sa != 0 && sb != 0) {
+    for (; i + Vec::kWidth <= n; i += Vec::kWidth) {
+      Vec::Store(out + i, Op::ApplyVec(Vec::Load(a + i), Vec::Load(b + i)));
+    }
+    for (; i < n; ++i) {
+      out[i] = Op::Apply(a[i], b[i]);
+    }
+  } else if (sb != 0) {
+    const VecT va = Vec::Set1(a[0]);
+    for (; i + Vec::kWidth <= n; i += Vec::kWidth) {
+      Vec::Store(out + i, Op::ApplyVec(va, Vec::Load(b + i)));
+    }
+    for (; i < n; ++i) {
+      out[i] = Op::Apply(a[0], b[i]);
+    }
+  } else if (sa != 0) {
+    const VecT vb = Vec::Set1(b[0]);
+    for (; i + Vec::kWidth <= n; i += Vec::kWidth) {
+      Vec::Store(out + i, Op::ApplyVec(Vec::Load(a + i), vb));
+    }
+    for (; i < n; ++i) {
+      out[i] = Op::Apply(a[i], b[0]);
+    }
+  } else {
+    const float value = Op::Apply(a[0], b[0]);
+    for (; i < n; ++i) {
+      out[i] = value;
+    }
+  }
+}
+
+// The micro-tile of the GEMM kernel is kGemmMR rows of kGemmNV vectors, which keeps the
+// accumulators and one row of b in registers on every ISA.
+constexpr int64_t kGemmMR = 6;
+constexpr int64_t kGemmNV = Vec::kWidth == 1 ? 4 : 2;
+constexpr int64_t kGemmNR = kGemmNV * Vec::kWidth;
+
+void GemmMicroKernelImpl(int64_t kc, const float* a, const float* b, float* c, int64_t ldc,
+                         bool accumulate) {
+  VecT acc[kGemmMR][kGemmNV];
+  for (int64_t i = 0; i < kGemmMR; ++i) {
+    for (int64_t j = 0; j < kGemmNV; ++j) {
+      acc[i][j] = Vec::Set1(0.0f);
+    }
+  }
+  for (int64_t p = 0; p < kc; ++p) {
+    VecT bv[kGemmNV];
+    for (int64_t j = 0; j < kGemmNV; ++j) {
+      bv[j] = Vec::Load(b + j * Vec::kWidth);
+    }
+    for (int64_t i = 0; i < kGemmMR; ++i) {
+      const VecT av = Vec::Set1(a[i]);
+      for (int64_t j = 0; j < kGemmNV; ++j) {
+        acc[i][j] = Vec::FMA(av, bv[j], acc[i][j]);
+      }
+    }
+    a += kGemmMR;
+    b += kGemmNR;
+  }
+  for (int64_t i = 0; i < kGemmMR; ++i) {
+    for (int64_t j = 0; j < kGemmNV; ++j) {
+      float* cp = c + i * ldc + j * Vec::kWidth;
+      Vec::Store(cp, accumulate ? Vec::Add(acc[i][j], Vec::Load(cp)) : acc[i][j]);
+    }
+  }
+}
+
+const KernelTable* MakeKernelTable() {
+  static const KernelTable table = {
+      {
+          UnaryKernelImpl<CopyOp>,
+          UnaryKernelImpl<NegativeOp>,
+          UnaryKernelImpl<AbsOp>,
+          UnaryKernelImpl<ReluOp>,
+          UnaryKernelImpl<SqrtOp>,
+          UnaryKernelImpl<RsqrtOp>,
+          UnaryKernelImpl<ReciprocalOp>,
+          UnaryKernelImpl<CeilOp>,
+          UnaryKernelImpl<FloorOp>,
+          UnaryKernelImpl<TruncOp>,
+      },
+      {
+          BinaryKernelImpl<AddOp>,
+          BinaryKernelImpl<SubtractOp>,
+          BinaryKernelImpl<MultiplyOp>,
+          BinaryKernelImpl<DivideOp>,
+          BinaryKernelImpl<MaximumOp>,
+          BinaryKernelImpl<MinimumOp>,
+      },
+      GemmMicroKernelImpl,
+      kGemmMR,
+      kGemmNR,
+  };
+  return &table;
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
@@ -0,0 +1,85 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/dialect/cpu/kernels/kernels.h
+ * \brief Hand-vectorized float32 elementwise and GEMM kernels of the CPU dialect. Each ISA is
+ * compiled in its own translation unit with the matching compiler flags, so this header must not
+ * expose any code that would be instantiated in those units.
+ */
+#pragma once
+#include <stdint.h>
+
+namespace raf {
+namespace op {
+namespace cpu {
+
+/*! \brief The instruction set extensions the kernels are specialized for, in increasing order. */
+enum class CPUISA : int {
+  kScalar = 0,
+  kSSE41 = 1,
+  kAVX2 = 2,
+  kAVX512 = 3,
+};
+
+enum UnaryKernelKind : int {
+  kCopy = 0,
+  kNegative,
+  kAbs,
+  kRelu,
+  kSqrt,
+  kRsqrt,
+  kReciprocal,
+  kCeil,
+  kFloor,
+  kTrunc,
+  kNumUnaryKernels,
+};
+
+enum BinaryKernelKind : int {
+  kAdd = 0,
+  kSubtract,
+  kMultiply,
+  kDivide,
+  kMaximum,
+  kMinimum,
+  kNumBinaryKernels,
+};
+
+/*! \brief y[i] = f(x[i]) for i in [0, n). */
+using UnaryKernel = void (*)(const float* x, float* y, int64_t n);
+
+/*!
+ * \brief out[i] = f(a[i * sa], b[i * sb]) for i in [0, n), where the strides sa and sb are either
+ * 0 (broadcast) or 1 (contiguous).
+ */
+using BinaryKernel = void (*)(const float* a, int64_t sa, const float* b, int64_t sb, float* out,
+                              int64_t n);
+
+/*!
+ * \brief The GEMM micro-kernel. It computes the gemm_mr x gemm_nr tile c = a * b, or c += a * b
+ * if accumulate, where a is a packed panel of kc columns of gemm_mr rows each and b is a packed
+ * panel of kc rows of gemm_nr columns each. ldc is the row stride of c.
+ */
+using GemmMicroKernel = void (*)(int64_t kc, const float* a, const float* b, float* c, int64_t ldc,
+                                 bool accumulate);
+
+struct KernelTable {
+  UnaryKernel unary[kNumUnaryKernels];
+  BinaryKernel binary[kNumBinaryKernels];
+  GemmMicroKernel gemm;
+  int64_t gemm_mr;
+  int64_t gemm_nr;
+};
+
+/*! \brief The kernels of each ISA, or nullptr if they are not built for the target. */
+const KernelTable* GetScalarKernels();
+const KernelTable* GetSSE41Kernels();
+const KernelTable* GetAVX2Kernels();
+const KernelTable* GetAVX512Kernels();
+
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
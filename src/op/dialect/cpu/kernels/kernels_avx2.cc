@@ -0,0 +1,106 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/dialect/cpu/kernels/kernels_avx2.cc
+ * \brief Elementwise and GEMM kernels with AVX2 and FMA. This file is compiled with -mavx2 -mfma.
+ */
+#include "./kernels.h"
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+
+namespace raf {
+namespace op {
+namespace cpu {
+namespace {
+
+struct Vec {
+  using T = __m256;
+  static constexpr int64_t kWidth = 8;
+  static T Load(const float* p) {
+    return _mm256_loadu_ps(p);
+  }
+  static void Store(float* p, T v) {
+    _mm256_storeu_ps(p, v);
+  }
+  static T Set1(float v) {
+    return _mm256_set1_ps(v);
+  }
+  static T Add(T a, T b) {
+    return _mm256_add_ps(a, b);
+  }
+  static T Sub(T a, T b) {
+    return _mm256_sub_ps(a, b);
+  }
+  static T Mul(T a, T b) {
+    return _mm256_mul_ps(a, b);
+  }
+  static T Div(T a, T b) {
+    return _mm256_div_ps(a, b);
+  }
+  static T Max(T a, T b) {
+    return _mm256_max_ps(a, b);
+  }
+  static T Min(T a, T b) {
+    return _mm256_min_ps(a, b);
+  }
+  static T FMA(T a, T b, T c) {
+    return _mm256_fmadd_ps(a, b, c);
+  }
+  static T Neg(T x) {
+    return _mm256_xor_ps(x, _mm256_set1_ps(-0.0f));
+  }
+  static T Abs(T x) {
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x);
+  }
+  static T Sqrt(T x) {
+    return _mm256_sqrt_ps(x);
+  }
+  static T Ceil(T x) {
+    return _mm256_round_ps(x, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+  }
+  static T Floor(T x) {
+    return _mm256_round_ps(x, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+  }
+  static T Trunc(T x) {
+    return _mm256_round_ps(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+  }
+};
+
+}  // namespace
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
+
+#include "./kernel_impl.h"
+
+namespace raf {
+namespace op {
+namespace cpu {
+
+const KernelTable* GetAVX2Kernels() {
+  return MakeKernelTable();
+}
+
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
+
+#else
+
+namespace raf {
+namespace op {
+namespace cpu {
+
+const KernelTable* GetAVX2Kernels() {
+  return nullptr;
+}
+
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
+
+#endif
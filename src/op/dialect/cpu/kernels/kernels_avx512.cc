@@ -0,0 +1,109 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/dialect/cpu/kernels/kernels_avx512.cc
+ * \brief Elementwise and GEMM kernels with AVX-512F. This file is compiled with -mavx512f.
+ */
+#include "./kernels.h"
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+namespace raf {
+namespace op {
+namespace cpu {
+namespace {
+
+struct Vec {
+  using T = __m512;
+  static constexpr int64_t kWidth = 16;
+  static T Load(const float* p) {
+    return _mm512_loadu_ps(p);
+  }
+  static void Store(float* p, T v) {
+    _mm512_storeu_ps(p, v);
+  }
+  static T Set1(float v) {
+    return _mm512_set1_ps(v);
+  }
+  static T Add(T a, T b) {
+    return _mm512_add_ps(a, b);
+  }
+  static T Sub(T a, T b) {
+    return _mm512_sub_ps(a, b);
+  }
+  static T Mul(T a, T b) {
+    return _mm512_mul_ps(a, b);
+  }
+  static T Div(T a, T b) {
+    return _mm512_div_ps(a, b);
+  }
+  static T Max(T a, T b) {
+    return _mm512_max_ps(a, b);
+  }
+  static T Min(T a, T b) {
+    return _mm512_min_ps(a, b);
+  }
+  static T FMA(T a, T b, T c) {
+    return _mm512_fmadd_ps(a, b, c);
+  }
+  // The floating-point bitwise instructions need AVX-512DQ, so the sign bit is set as integers.
+  static T Neg(T x) {
+    return _mm512_castsi512_ps(
+        _mm512_xor_si512(_mm512_castps_si512(x), _mm512_castps_si512(_mm512_set1_ps(-0.0f))));
+  }
+  static T Abs(T x) {
+    return _mm512_castsi512_ps(_mm512_andnot_si512(_mm512_castps_si512(_mm512_set1_ps(-0.0f)),
+                                                   _mm512_castps_si512(x)));
+  }
+  static T Sqrt(T x) {
+    return _mm512_sqrt_ps(x);
+  }
+  static T Ceil(T x) {
+    return _mm512_roundscale_ps(x, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+  }
+  static T Floor(T x) {
+    return _mm512_roundscale_ps(x, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+  }
+  static T Trunc(T x) {
+    return _mm512_roundscale_ps(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+  }
+};
+
+}  // namespace
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
+
+#include "./kernel_impl.h"
+
+namespace raf {
+namespace op {
+namespace cpu {
+
+const KernelTable* GetAVX512Kernels() {
+  return MakeKernelTable();
+}
+
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
+
+#else
+
+namespace raf {
+namespace op {
+namespace cpu {
+
+const KernelTable* GetAVX512Kernels() {
+  return nullptr;
+}
+
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
+
+#endif
@@ -0,0 +1,87 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/dialect/cpu/kernels/kernels_scalar.cc
+ * \brief Portable elementwise and GEMM kernels, used when no SIMD extension is available.
+ */
+#include "./kernels.h"
+
+namespace raf {
+namespace op {
+namespace cpu {
+namespace {
+
+struct Vec {
+  using T = float;
+  static constexpr int64_t kWidth = 1;
+  static T Load(const float* p) {
+    return *p;
+  }
+  static void Store(float* p, T v) {
+    *p = v;
+  }
+  static T Set1(float v) {
+    return v;
+  }
+  static T Add(T a, T b) {
+    return a + b;
+  }
+  static T Sub(T a, T b) {
+    return a - b;
+  }
+  static T Mul(T a, T b) {
+    return a * b;
+  }
+  static T Div(T a, T b) {
+    return a / b;
+  }
+  static T Max(T a, T b) {
+    return a > b ? a : b;
+  }
+  static T Min(T a, T b) {
+    return a < b ? a : b;
+  }
+  static T FMA(T a, T b, T c) {
+    return a * b + c;
+  }
+  static T Neg(T x) {
+    return -x;
+  }
+  static T Abs(T x) {
+    return __builtin_fabsf(x);
+  }
+  static T Sqrt(T x) {
+    return __builtin_sqrtf(x);
+  }
+  static T Ceil(T x) {
+    return __builtin_ceilf(x);
+  }
+  static T Floor(T x) {
+    return __builtin_floorf(x);
+  }
+  static T Trunc(T x) {
+    return __builtin_truncf(x);
+  }
+};
+
+}  // namespace
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
+
+#include "./kernel_impl.h"
+
+namespace raf {
+namespace op {
+namespace cpu {
+
+const KernelTable* GetScalarKernels() {
+  return MakeKernelTable();
+}
+
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
@@ -0,0 +1,106 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/dialect/cpu/kernels/kernels_sse41.cc
+ * \brief Elementwise and GEMM kernels with SSE4.1. This file is compiled with -msse4.1.
+ */
+#include "./kernels.h"
+
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+
+namespace raf {
+namespace op {
+namespace cpu {
+namespace {
+
+struct Vec {
+  using T = __m128;
+  static constexpr int64_t kWidth = 4;
+  static T Load(const float* p) {
+    return _mm_loadu_ps(p);
+  }
+  static void Store(float* p, T v) {
+    _mm_storeu_ps(p, v);
+  }
+  static T Set1(float v) {
+    return _mm_set1_ps(v);
+  }
+  static T Add(T a, T b) {
+    return _mm_add_ps(a, b);
+  }
+  static T Sub(T a, T b) {
+    return _mm_sub_ps(a, b);
+  }
+  static T Mul(T a, T b) {
+    return _mm_mul_ps(a, b);
+  }
+  static T Div(T a, T b) {
+    return _mm_div_ps(a, b);
+  }
+  static T Max(T a, T b) {
+    return _mm_max_ps(a, b);
+  }
+  static T Min(T a, T b) {
+    return _mm_min_ps(a, b);
+  }
+  static T FMA(T a, T b, T c) {
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+  }
+  static T Neg(T x) {
+    return _mm_xor_ps(x, _mm_set1_ps(-0.0f));
+  }
+  static T Abs(T x) {
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+  }
+  static T Sqrt(T x) {
+    return _mm_sqrt_ps(x);
+  }
+  static T Ceil(T x) {
+    return _mm_round_ps(x, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+  }
+  static T Floor(T x) {
+    return _mm_round_ps(x, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+  }
+  static T Trunc(T x) {
+    return _mm_round_ps(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+  }
+};
+
+}  // namespace
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
+
+#include "./kernel_impl.h"
+
+namespace raf {
+namespace op {
+namespace cpu {
+
+const KernelTable* GetSSE41Kernels() {
+  return MakeKernelTable();
+}
+
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
+
+#else
+
+namespace raf {
+namespace op {
+namespace cpu {
+
+const KernelTable* GetSSE41Kernels() {
+  return nullptr;
+}
+
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
+
+#endif
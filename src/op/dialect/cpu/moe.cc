@@ -0,0 +1,250 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/dialect/cpu/moe.cc
+ * \brief Mixture-of-experts operators implemented by native CPU kernels.
+ */
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <vector>
+#include "raf/op_utils.h"
+#include "raf/registry.h"
+#include "../../schema/moe.h"
+#include "./cpu_utils.h"
+
+namespace raf {
+namespace op {
+namespace cpu {
+
+using namespace raf::value;
+using namespace raf::ir;
+
+static auto fschema_index = ir::Op::GetAttrMap<op::FRAFSchemaFieldIndex>("FRAFSchemaFieldIndex");
+
+/*! \brief The base of the mixture-of-experts operators. */
+class MoEOpEnv : public raf::op::OpEnv {
+ protected:
+  MoEOpEnv(const std::string& op_name, const std::vector<std::string>& fields)
+      : env_name_(TruncateName(GetUniqueName("raf.op.cpu." + op_name))) {
+    auto op = Op::Get("raf.op." + op_name);
+    for (const auto& field : fields) {
+      this->arg_indices.push_back(fschema_index[op](field));
+    }
+  }
+
+  bool CheckContiguous(const std::vector<const DLTensor*>& tensors, const std::string& op_name) {
+    for (const auto* tensor : tensors) {
+      if (!IsContiguous(tensor)) {
+        error_msgs.push_back("[CPU] " + op_name + ": requires contiguous tensors");
+        return false;
+      }
+    }
+    return true;
+  }
+
+ public:
+  std::string name() const override {
+    return env_name_;
+  }
+
+ private:
+  std::string env_name_;
+};
+
+/*!
+ * \brief Route each token to the experts of its k largest probabilities. The choices are
+ * admitted in rounds, the first choices of all the tokens before their second choices and so on,
+ * and an expert admits at most capacity tokens in the order of the tokens. The location of a
+ * token is its slot in the buffer of the expert, or -1 if the expert is full and it is dropped.
+ */
+class CPUMoEGate : public MoEOpEnv {
+  int capacity;
+
+  explicit CPUMoEGate(const CallValues& cv) : MoEOpEnv("_moe_gate", {"probs"}) {
+    auto args = cv->args.as<raf::op::schema::MoeGateArgs>();
+    const DLTensor* probs = args->probs;
+    capacity = args->capacity;
+    if (!CheckContiguous({probs}, "_moe_gate")) {
+      return;
+    }
+    auto type = GetElemType(probs->dtype);
+    if (type != ElemType::kFloat32 && type != ElemType::kFloat64) {
+      error_msgs.push_back("[CPU] _moe_gate: requires float32 or float64 probabilities");
+    }
+  }
+
+  template <typename T>
+  void TopK(const DLTensor* probs, int64_t k, int32_t* indices) {
+    int64_t num_tokens = probs->shape[0];
+    int64_t num_experts = probs->shape[1];
+    const T* data = static_cast<const T*>(probs->data);
+    int64_t grain = std::max<int64_t>(1, kParallelGrainSize / num_experts);
+    ParallelFor(num_tokens, grain, [&](int64_t begin, int64_t end) {
+      std::vector<int32_t> order(num_experts);
+      for (int64_t t = begin; t < end; ++t) {
+        const T* row = data + t * num_experts;
+        std::iota(order.begin(), order.end(), 0);
+        // Break the ties by the lower expert, so that the routing is deterministic.
+        auto greater = [row](int32_t a, int32_t b) {
+          return row[a] > row[b] || (row[a] == row[b] && a < b);
+        };
+        std::partial_sort(order.begin(), order.begin() + k, order.end(), greater);
+        std::copy(order.begin(), order.begin() + k, indices + t * k);
+      }
+    });
+  }
+
+ public:
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::MoeGateArgs>();
+    Execute({args->probs}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    DLTensor* probs = inputs[0];
+    auto out = Downcast<TupleValue>(output);
+    DLTensor* indices = out->fields[0];
+    DLTensor* locations = out->fields[1];
+    int64_t num_tokens = indices->shape[0];
+    int64_t k = indices->shape[1];
+    auto indices_data = static_cast<int32_t*>(indices->data);
+    auto locations_data = static_cast<int32_t*>(locations->data);
+    if (GetElemType(probs->dtype) == ElemType::kFloat32) {
+      TopK<float>(probs, k, indices_data);
+    } else {
+      TopK<double>(probs, k, indices_data);
+    }
+    std::vector<int32_t> counts(probs->shape[1], 0);
+    for (int64_t j = 0; j < k; ++j) {
+      for (int64_t t = 0; t < num_tokens; ++t) {
+        int32_t& count = counts[indices_data[t * k + j]];
+        locations_data[t * k + j] = count < capacity ? count++ : -1;
+      }
+    }
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUMoEGate(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _moe_gate, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._moe_gate", CPUMoEGate::make);
+
+/*!
+ * \brief Pack the tokens into the contiguous buffer of each expert. A token of (tokens, hidden)
+ * goes to every expert it chooses, and a token of (tokens, k, hidden) sends its j-th row to its
+ * j-th choice. The empty slots are zeros.
+ */
+class CPUMoEDispatch : public MoEOpEnv {
+  explicit CPUMoEDispatch(const CallValues& cv)
+      : MoEOpEnv("_moe_dispatch", {"x", "indices", "locations"}) {
+    auto args = cv->args.as<raf::op::schema::MoeDispatchArgs>();
+    CheckContiguous({args->x, args->indices, args->locations}, "_moe_dispatch");
+  }
+
+ public:
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::MoeDispatchArgs>();
+    Execute({args->x, args->indices, args->locations}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    DLTensor* x = inputs[0];
+    DLTensor* indices = inputs[1];
+    DLTensor* locations = inputs[2];
+    DLTensor* out = output;
+    int64_t num_tokens = indices->shape[0];
+    int64_t k = indices->shape[1];
+    int64_t num_experts = out->shape[0];
+    int64_t capacity = out->shape[1];
+    int64_t row_bytes = out->shape[2] * ((out->dtype.bits + 7) / 8);
+    auto indices_data = static_cast<const int32_t*>(indices->data);
+    auto locations_data = static_cast<const int32_t*>(locations->data);
+    auto x_data = static_cast<const uint8_t*>(x->data);
+    auto out_data = static_cast<uint8_t*>(out->data);
+    std::memset(out_data, 0, NumElements(out) * ((out->dtype.bits + 7) / 8));
+    for (int64_t t = 0; t < num_tokens; ++t) {
+      for (int64_t j = 0; j < k; ++j) {
+        int32_t loc = locations_data[t * k + j];
+        if (loc < 0) {
+          continue;
+        }
+        CHECK(indices_data[t * k + j] < num_experts && loc < capacity)
+            << "Invalid route of a token";
+        int64_t src = x->ndim == 3 ? t * k + j : t;
+        int64_t dst = indices_data[t * k + j] * capacity + loc;
+        std::memcpy(out_data + dst * row_bytes, x_data + src * row_bytes, row_bytes);
+      }
+    }
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUMoEDispatch(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _moe_dispatch, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._moe_dispatch", CPUMoEDispatch::make);
+
+/*!
+ * \brief Unpack the outputs of the experts into (tokens, k, hidden), where the j-th row of a
+ * token is the output of its j-th choice, or zeros if it was dropped.
+ */
+class CPUMoECombine : public MoEOpEnv {
+  explicit CPUMoECombine(const CallValues& cv)
+      : MoEOpEnv("_moe_combine", {"y", "indices", "locations"}) {
+    auto args = cv->args.as<raf::op::schema::MoeCombineArgs>();
+    CheckContiguous({args->y, args->indices, args->locations}, "_moe_combine");
+  }
+
+ public:
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::MoeCombineArgs>();
+    Execute({args->y, args->indices, args->locations}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    DLTensor* y = inputs[0];
+    DLTensor* indices = inputs[1];
+    DLTensor* locations = inputs[2];
+    DLTensor* out = output;
+    int64_t num_rows = NumElements(indices);
+    int64_t num_experts = y->shape[0];
+    int64_t capacity = y->shape[1];
+    int64_t row_bytes = y->shape[2] * ((y->dtype.bits + 7) / 8);
+    auto indices_data = static_cast<const int32_t*>(indices->data);
+    auto locations_data = static_cast<const int32_t*>(locations->data);
+    auto y_data = static_cast<const uint8_t*>(y->data);
+    auto out_data = static_cast<uint8_t*>(out->data);
+    int64_t grain = std::max<int64_t>(1, kParallelGrainSize / std::max<int64_t>(row_bytes, 1));
+    ParallelFor(num_rows, grain, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        uint8_t* dst = out_data + i * row_bytes;
+        int32_t loc = locations_data[i];
+        if (loc < 0) {
+          std::memset(dst, 0, row_bytes);
+        } else {
+          CHECK(indices_data[i] < num_experts && loc < capacity) << "Invalid route of a token";
+          int64_t src = indices_data[i] * capacity + loc;
+          std::memcpy(dst, y_data + src * row_bytes, row_bytes);
+        }
+      }
+    });
+  }
+
+  static OpEnv* make(const CallValues& cv) {
+    return new CPUMoECombine(cv);
+  }
+};
+
+RAF_REGISTER_DIALECT_OP(cpu, _moe_combine, 10);
+RAF_OP_ENV_MAKER("raf.op.cpu._moe_combine", CPUMoECombine::make);
+
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
@@ -0,0 +1,186 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/dialect/cpu/unary.cc
+ * \brief Unary operators implemented by native CPU kernels.
+ */
+#include <cmath>
+#include "raf/op_utils.h"
+#include "../../schema/ufunc.h"
+#include "./cpu_utils.h"
+
+namespace raf {
+namespace op {
+namespace cpu {
+
+using namespace raf::value;
+using namespace raf::ir;
+
+static auto fschema_index = ir::Op::GetAttrMap<op::FRAFSchemaFieldIndex>("FRAFSchemaFieldIndex");
+
+/*!
+ * \brief A unary functor has the vectorized float32 kernel kKernel (-1 if there is none), supports
+ * integers if kIntegral, and computes the other cases element by element with Apply.
+ */
+#define RAF_CPU_UNARY_FUNCTOR(NAME, KERNEL, INTEGRAL, EXPR) \
+  struct NAME {                                             \
+    static constexpr int kKernel = KERNEL;                  \
+    static constexpr bool kIntegral = INTEGRAL;             \
+    template <typename T>                                   \
+    static T Apply(T x) {                                   \
+      return EXPR;                                          \
+    }                                                       \
+  }
+
+RAF_CPU_UNARY_FUNCTOR(CopyFunctor, kCopy, true, x);
+RAF_CPU_UNARY_FUNCTOR(NegativeFunctor, kNegative, true, -x);
+RAF_CPU_UNARY_FUNCTOR(AbsFunctor, kAbs, true, x < T(0) ? -x : x);
+RAF_CPU_UNARY_FUNCTOR(ReluFunctor, kRelu, true, x > T(0) ? x : T(0));
+RAF_CPU_UNARY_FUNCTOR(SignFunctor, -1, true, x > T(0) ? T(1) : (x < T(0) ? T(-1) : T(0)));
+RAF_CPU_UNARY_FUNCTOR(ZerosLikeFunctor, -1, true, T(0));
+RAF_CPU_UNARY_FUNCTOR(OnesLikeFunctor, -1, true, T(1));
+RAF_CPU_UNARY_FUNCTOR(SqrtFunctor, kSqrt, false, std::sqrt(x));
+RAF_CPU_UNARY_FUNCTOR(RsqrtFunctor, kRsqrt, false, T(1) / std::sqrt(x));
+RAF_CPU_UNARY_FUNCTOR(ReciprocalFunctor, kReciprocal, false, T(1) / x);
+RAF_CPU_UNARY_FUNCTOR(CeilFunctor, kCeil, false, std::ceil(x));
+RAF_CPU_UNARY_FUNCTOR(FloorFunctor, kFloor, false, std::floor(x));
+RAF_CPU_UNARY_FUNCTOR(TruncFunctor, kTrunc, false, std::trunc(x));
+RAF_CPU_UNARY_FUNCTOR(ExpFunctor, -1, false, std::exp(x));
+RAF_CPU_UNARY_FUNCTOR(LogFunctor, -1, false, std::log(x));
+RAF_CPU_UNARY_FUNCTOR(Log2Functor, -1, false, std::log2(x));
+RAF_CPU_UNARY_FUNCTOR(SinFunctor, -1, false, std::sin(x));
+RAF_CPU_UNARY_FUNCTOR(CosFunctor, -1, false, std::cos(x));
+RAF_CPU_UNARY_FUNCTOR(AtanFunctor, -1, false, std::atan(x));
+RAF_CPU_UNARY_FUNCTOR(TanhFunctor, -1, false, std::tanh(x));
+RAF_CPU_UNARY_FUNCTOR(ErfFunctor, -1, false, std::erf(x));
+RAF_CPU_UNARY_FUNCTOR(SigmoidFunctor, -1, false, T(1) / (T(1) + std::exp(-x)));
+RAF_CPU_UNARY_FUNCTOR(GeluFunctor, -1, false,
+                      x * (T(0.5) * (T(1) + std::erf(x / T(1.4142135623730951)))));
+
+#undef RAF_CPU_UNARY_FUNCTOR
+
+template <typename F>
+class UnaryOpEnv : public raf::op::OpEnv {
+ public:
+  UnaryOpEnv(const CallValues& cv, const std::string& op_name)
+      : env_name_(TruncateName(GetUniqueName("raf.op.cpu." + op_name))) {
+    auto op = Op::Get("raf.op." + op_name);
+    this->arg_indices = {
+        fschema_index[op]("x"),
+    };
+    auto args = cv->args.as<raf::op::schema::UnaryArgs>();
+    if (!args->x->IsInstance<TensorValueObj>() || !cv->out->IsInstance<TensorValueObj>()) {
+      error_msgs.push_back("[CPU] " + op_name + ": inputs and outputs must be tensors");
+      return;
+    }
+    DLTensor* x_t = args->x;
+    DLTensor* out_t = cv->out;
+    elem_type_ = GetElemType(out_t->dtype);
+    bool is_float = elem_type_ == ElemType::kFloat32 || elem_type_ == ElemType::kFloat64;
+    if (elem_type_ == ElemType::kUnsupported || (!is_float && !F::kIntegral) ||
+        GetElemType(x_t->dtype) != elem_type_) {
+      error_msgs.push_back("[CPU] " + op_name + ": unsupported dtype " +
+                           DType(out_t->dtype).c_str());
+      return;
+    }
+    if (!IsContiguous(x_t) || !IsContiguous(out_t) || NumElements(x_t) != NumElements(out_t)) {
+      error_msgs.push_back("[CPU] " + op_name + ": tensors must be contiguous and of equal size");
+    }
+  }
+
+  std::string name() const override {
+    return env_name_;
+  }
+
+  void Execute(const CallValues& cv) override {
+    auto args = cv->args.as<raf::op::schema::UnaryArgs>();
+    Execute(std::vector<Value>{args->x}, cv->out);
+  }
+
+  void Execute(const std::vector<Value>& inputs, Value output) override {
+    CHECK_EQ(inputs.size(), 1);
+    DLTensor* x = Downcast<TensorValue>(inputs[0]);
+    DLTensor* out = Downcast<TensorValue>(output);
+    int64_t n = NumElements(out);
+    switch (elem_type_) {
+      case ElemType::kFloat32:
+        // The kernel table is looked up at every launch so that the ISA can be switched.
+        if (F::kKernel >= 0) {
+          UnaryKernel kernel = GetKernelTable()->unary[F::kKernel];
+          const float* x_data = static_cast<const float*>(x->data);
+          float* out_data = static_cast<float*>(out->data);
+          ParallelFor(n, kParallelGrainSize, [&](int64_t begin, int64_t end) {
+            kernel(x_data + begin, out_data + begin, end - begin);
+          });
+          return;
+        }
+        return Compute<float>(x, out, n);
+      case ElemType::kFloat64:
+        return Compute<double>(x, out, n);
+      case ElemType::kInt32:
+        return Compute<int32_t>(x, out, n);
+      case ElemType::kInt64:
+        return Compute<int64_t>(x, out, n);
+      default:
+        LOG(FATAL) << "Unsupported dtype for " << env_name_;
+    }
+  }
+
+  static OpEnv* make(const CallValues& cv, const std::string& op_name) {
+    return new UnaryOpEnv<F>(cv, op_name);
+  }
+
+ private:
+  template <typename T>
+  void Compute(const DLTensor* x, DLTensor* out, int64_t n) {
+    const T* x_data = static_cast<const T*>(x->data);
+    T* out_data = static_cast<T*>(out->data);
+    // Transcendental functions cost much more than a memory access, so parallelize them earlier.
+    int64_t grain = F::kKernel >= 0 ? kParallelGrainSize : kParallelGrainSize / 8;
+    ParallelFor(n, grain, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        out_data[i] = F::template Apply<T>(x_data[i]);
+      }
+    });
+  }
+
+  std::string env_name_;
+  ElemType elem_type_ = ElemType::kUnsupported;
+};
+
+#define RAF_CPU_UNARY(OP, FUNCTOR)                               \
+  RAF_REGISTER_DIALECT_OP(cpu, OP, 20);                          \
+  RAF_OP_ENV_MAKER("raf.op.cpu." #OP, [](const CallValues& cv) { \
+    return UnaryOpEnv<FUNCTOR>::make(cv, #OP);                   \
+  })
+
+RAF_CPU_UNARY(copy, CopyFunctor);
+RAF_CPU_UNARY(negative, NegativeFunctor);
+RAF_CPU_UNARY(abs, AbsFunctor);
+RAF_CPU_UNARY(relu, ReluFunctor);
+RAF_CPU_UNARY(sign, SignFunctor);
+RAF_CPU_UNARY(zeros_like, ZerosLikeFunctor);
+RAF_CPU_UNARY(ones_like, OnesLikeFunctor);
+RAF_CPU_UNARY(sqrt, SqrtFunctor);
+RAF_CPU_UNARY(rsqrt, RsqrtFunctor);
+RAF_CPU_UNARY(reciprocal, ReciprocalFunctor);
+RAF_CPU_UNARY(ceil, CeilFunctor);
+RAF_CPU_UNARY(floor, FloorFunctor);
+RAF_CPU_UNARY(trunc, TruncFunctor);
+RAF_CPU_UNARY(exp, ExpFunctor);
+RAF_CPU_UNARY(log, LogFunctor);
+RAF_CPU_UNARY(log2, Log2Functor);
+RAF_CPU_UNARY(sin, SinFunctor);
+RAF_CPU_UNARY(cos, CosFunctor);
+RAF_CPU_UNARY(atan, AtanFunctor);
+RAF_CPU_UNARY(tanh, TanhFunctor);
+RAF_CPU_UNARY(erf, ErfFunctor);
+RAF_CPU_UNARY(sigmoid, SigmoidFunctor);
+RAF_CPU_UNARY(gelu, GeluFunctor);
+
+}  // namespace cpu
+}  // namespace op
+}  // namespace raf
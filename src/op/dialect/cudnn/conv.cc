@@ -104,7 +104,7 @@ MetaPersistCache<CuDNNConvAlgoCacheEntry<cudnnConvolutionFwdAlgoPerf_t>> CacheCu
     "cudnn_conv_fwd_algo_perf");
 
 cudnnConvolutionFwdAlgoPerf_t FindcudnnConvolutionFwdAlgoPerf_tExWrapper(
-    const std::vector<uint8_t>& key, const cudnnTensorDescriptor_t xDesc, const void* x,
+    const HashKey& key, const cudnnTensorDescriptor_t xDesc, const void* x,
     const cudnnFilterDescriptor_t wDesc, const void* w, const cudnnConvolutionDescriptor_t convDesc,
     const cudnnTensorDescriptor_t yDesc, void* y, const Device& device) {
   if (auto* val = CacheCudnnConvFwdAlgoPerf.Get(key)) {
@@ -163,7 +163,7 @@ MetaPersistCache<CuDNNConvAlgoCacheEntry<cudnnConvolutionBwdDataAlgoPerf_t>>
     CacheCudnnConvBwdDataAlgoPerf("cudnn_conv_bwd_data_algo_perf");
 
 cudnnConvolutionBwdDataAlgoPerf_t FindcudnnConvolutionBwdDataAlgoPerf_tExWrapper(
-    const std::vector<uint8_t>& key, const cudnnFilterDescriptor_t wDesc, const void* w,
+    const HashKey& key, const cudnnFilterDescriptor_t wDesc, const void* w,
     const cudnnTensorDescriptor_t dyDesc, const void* dy,
     const cudnnConvolutionDescriptor_t convDesc, const cudnnTensorDescriptor_t dxDesc, void* dx,
     const Device& device) {
@@ -219,7 +219,7 @@ MetaPersistCache<CuDNNConvAlgoCacheEntry<cudnnConvolutionBwdFilterAlgoPerf_t>>
     CacheCudnnConvBwdFilterAlgoPerf("cudnn_conv_bwd_filter_algo_perf");
 
 cudnnConvolutionBwdFilterAlgoPerf_t FindcudnnConvolutionBwdFilterAlgoPerf_tExWrapper(
-    const std::vector<uint8_t>& key, const cudnnTensorDescriptor_t xDesc, const void* x,
+    const HashKey& key, const cudnnTensorDescriptor_t xDesc, const void* x,
     const cudnnTensorDescriptor_t dyDesc, const void* dy,
     const cudnnConvolutionDescriptor_t convDesc, const cudnnFilterDescriptor_t dwDesc, void* dw,
     const Device& device) {
@@ -311,10 +311,9 @@ class Conv2DImplementedByCUDNNConvolutionForward : public raf::op::OpEnv {
       cudnnSetConvolutionMathType(convDesc, CUDNN_TENSOR_OP_MATH);
     }
 
-    HashKey algo_hasher;
-    algo_hasher << args->stride << args->padding << args->dilation << wDesc_tt << xDesc_tt
-                << yDesc_tt;
-    const auto& algo_key = algo_hasher.byte_vector;
+    HashKey algo_key;
+    algo_key << args->stride << args->padding << args->dilation << wDesc_tt << xDesc_tt
+             << yDesc_tt;
     algo = FindcudnnConvolutionFwdAlgoPerf_tExWrapper(algo_key, xDesc, x->data, wDesc, w->data,
                                                       convDesc, yDesc, out->data, cv->device);
     CUDNN_CALL(cudnnGetConvolutionForwardWorkspaceSize(CUDNNThreadEntry::ThreadLocal()->handle,
@@ -415,10 +414,9 @@ class Conv2DDwImplementedByCUDNNConvolutionBackwardFilter : public raf::op::OpEn
       cudnnSetConvolutionMathType(convDesc, CUDNN_TENSOR_OP_MATH);
     };
     cudnnSetConvolutionGroupCount(convDesc, args->groups);
-    HashKey algo_hasher;
-    algo_hasher << args->stride << args->padding << args->dilation << xDesc_tt << dyDesc_tt
-                << dwDesc_tt;
-    const auto& algo_key = algo_hasher.byte_vector;
+    HashKey algo_key;
+    algo_key << args->stride << args->padding << args->dilation << xDesc_tt << dyDesc_tt
+             << dwDesc_tt;
     algo = FindcudnnConvolutionBwdFilterAlgoPerf_tExWrapper(
         algo_key, xDesc, x_or_w->data, dyDesc, dy->data, convDesc, dwDesc, out->data, cv->device);
     CUDNN_CALL(cudnnGetConvolutionBackwardFilterWorkspaceSize(
@@ -510,10 +508,9 @@ class Conv2DDxImplementedByCUDNNConvolutionBackwardData : public raf::op::OpEnv
       cudnnSetConvolutionMathType(convDesc, CUDNN_TENSOR_OP_MATH);
     };
     cudnnSetConvolutionGroupCount(convDesc, args->groups);
-    HashKey algo_hasher;
-    algo_hasher << args->stride << args->padding << args->dilation << wDesc_tt << dyDesc_tt
-                << dxDesc_tt;
-    const auto& algo_key = algo_hasher.byte_vector;
+    HashKey algo_key;
+    algo_key << args->stride << args->padding << args->dilation << wDesc_tt << dyDesc_tt
+             << dxDesc_tt;
     algo = FindcudnnConvolutionBwdDataAlgoPerf_tExWrapper(
         algo_key, wDesc, x_or_w->data, dyDesc, dy->data, convDesc, dxDesc, out->data, cv->device);
     CUDNN_CALL(cudnnGetConvolutionBackwardDataWorkspaceSize(CUDNNThreadEntry::ThreadLocal()->handle,
@@ -72,7 +72,7 @@ OpEnv* Tune(const op::CallValues& call, OpEnv* op_env) {
   auto key = HashFusedFunc(Downcast<ClosureValue>(call->callee)->func);
   std::shared_ptr<TunableConfig> best;
 
-  if (const auto* compiled = CacheConfig.Get(key.byte_vector)) {
+  if (const auto* compiled = CacheConfig.Get(key)) {
     CUTLASSConfigCacheEntry entry = *compiled;
     best = entry.GetConfig();
   } else {
@@ -92,7 +92,7 @@ OpEnv* Tune(const op::CallValues& call, OpEnv* op_env) {
         best = config;
       }
     }
-    CacheConfig.Set(key.byte_vector, CUTLASSConfigCacheEntry(best));
+    CacheConfig.Set(key, CUTLASSConfigCacheEntry(best));
   }
 
   env->SetTunableConfig(best);
@@ -282,7 +282,7 @@ OpEnv* FusedFuncBuild(const op::CallValues& call) {
 
   auto key = HashFusedFunc(Downcast<ClosureValue>(call->callee)->func);
   TVMModuleCacheEntry entry;
-  if (const auto* compiled = cache->Get(key.byte_vector)) {
+  if (const auto* compiled = cache->Get(key)) {
     entry = *compiled;
   } else {
     te_compiler->Clear();
@@ -291,7 +291,7 @@ OpEnv* FusedFuncBuild(const op::CallValues& call) {
       auto cached_func = te_compiler->Lower(cached_key);
       auto mod = tvm::build(cached_func->funcs, cached_key->target, Target(nullptr));
       entry = TVMModuleCacheEntry(mod, cached_func->prim_fn_var->name_hint);
-      cache->Set(key.byte_vector, entry);
+      cache->Set(key, entry);
     } catch (const dmlc::Error& e) {
       if (!AllowJitFailure()) {
         LOG(FATAL) << "Failed to build a fused op " << env->env_name << ": " << e.what();
@@ -306,6 +306,7 @@ OpEnv* FusedFuncBuild(const op::CallValues& call) {
     GetDLTensor(args[i], &env->inputs);
   }
   GetDLTensor(call->out, &env->outputs);
+  env->PrepareLaunch();
   return env.release();
 }
 
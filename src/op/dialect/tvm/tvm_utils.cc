@@ -25,6 +25,7 @@ using common::shape_utils::GetShape;
 MetaPersistCache<TVMModuleCacheEntry> CacheBuildCpu("tvm_cpu");
 MetaPersistCache<TVMModuleCacheEntry> CacheBuildCuda("tvm_cuda");
 MetaPersistCache<RelayFuncCacheEntry> CacheLoweredFunc("tvm_lower");
+std::mutex BuildMutex;
 
 void GetDLTensor(const Value& v, std::vector<DLTensor>* tensors) {
   if (v->IsInstance<TensorValueObj>()) {
@@ -106,25 +107,51 @@ void TVMOpEnv::Execute(const op::CallValues& call) {
   }
 }
 
-void TVMOpEnv::Execute(const std::vector<Value>& inputs, Value output) {
-  this->inputs.clear();
-  this->outputs.clear();
-  for (auto val : inputs) {
-    GetDLTensor(val, &this->inputs);
+/*! \brief Copy the DLTensors of a value to the launch buffer starting at the given position. */
+inline void FillDLTensor(const Value& v, std::vector<DLTensor>* tensors, int* cnt) {
+  if (const auto* tv = v.as<TupleValueObj>()) {
+    for (const auto& field : tv->fields) {
+      FillDLTensor(field, tensors, cnt);
+    }
+    return;
   }
-  GetDLTensor(output, &this->outputs);
-  std::vector<TVMValue> values;
-  std::vector<int> codes;
-  SetArgs(&this->inputs, &this->outputs, &values, &codes);
-  TVMArgs targs(values.data(), codes.data(), values.size());
-  TVMRetValue rv;
+  CHECK_LT(*cnt, static_cast<int>(tensors->size()))
+      << "InternalError: Mismatched number of TVM arguments";
+  DLTensor* t = v;
+  (*tensors)[(*cnt)++] = *t;
+}
 
+void TVMOpEnv::PrepareLaunch() {
+  arg_codes.assign(inputs.size() + outputs.size(), kTVMDLTensorHandle);
+  allow_jit_failure = AllowJitFailure();
+}
+
+void TVMOpEnv::Execute(const std::vector<Value>& inputs, Value output) {
   // Skip the execution if we are in the task extraction mode since
   // we do not care about the correctness.
-  if (AllowJitFailure()) {
+  if (allow_jit_failure) {
     return;
   }
 
+  // The OpEnv may be executed by multiple VM contexts concurrently, so the arguments are
+  // prepared in per-thread buffers instead of the members inputs and outputs. The buffers
+  // only grow, so a launch does not allocate once the thread has seen the arity.
+  static thread_local std::vector<DLTensor> tensors;
+  static thread_local std::vector<TVMValue> values;
+  int arity = arg_codes.size();
+  tensors.resize(arity);
+  values.resize(arity);
+  int cnt = 0;
+  for (const auto& val : inputs) {
+    FillDLTensor(val, &tensors, &cnt);
+  }
+  FillDLTensor(output, &tensors, &cnt);
+  CHECK_EQ(cnt, arity) << "InternalError: Mismatched number of TVM arguments";
+  for (int i = 0; i < arity; ++i) {
+    values[i].v_handle = &tensors[i];
+  }
+  TVMArgs targs(values.data(), arg_codes.data(), arity);
+  TVMRetValue rv;
   f.CallPacked(targs, &rv);
 }
 
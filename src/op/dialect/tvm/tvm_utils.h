@@ -10,6 +10,7 @@
 #pragma once
 #include <vector>
 #include <memory>
+#include <mutex>
 #include <dmlc/filesystem.h>
 #include <tvm/node/serialization.h>
 #include "dlpack/dlpack.h"
@@ -46,12 +47,21 @@ class TVMOpEnv : public op::OpEnv {
   std::vector<DLTensor> inputs;
   std::vector<DLTensor> outputs;
   registry::PackedFunc f{nullptr};
+  /*! \brief The type codes of the packed arguments, sized once the OpEnv is built. */
+  std::vector<int> arg_codes;
+  /*! \brief Whether the OpEnv is built in the auto scheduler task extraction mode. */
+  bool allow_jit_failure = false;
 
   TVMOpEnv() = default;
   virtual ~TVMOpEnv() = default;
   std::string name() const override {
     return env_name;
   }
+  /*!
+   * \brief Resolve the launch configuration that does not change across calls, after the inputs
+   * and outputs have been collected.
+   */
+  void PrepareLaunch();
   void Execute(const op::CallValues& call) override;
   void Execute(const std::vector<Value>& inputs, Value outputs) override;
 };
@@ -195,6 +205,12 @@ using FRAFArgIndices =
 extern MetaPersistCache<TVMModuleCacheEntry> CacheBuildCpu;
 extern MetaPersistCache<TVMModuleCacheEntry> CacheBuildCuda;
 extern MetaPersistCache<RelayFuncCacheEntry> CacheLoweredFunc;
+/*!
+ * \brief Serializes the lowering and building of TVM ops. They change the current PassContext and
+ * go through TVM passes and schedules that are not thread-safe, while the kernels may be compiled
+ * by multiple threads, e.g. the VM precompilation.
+ */
+extern std::mutex BuildMutex;
 
 }  // namespace tvm_dialect
 }  // namespace op
@@ -206,7 +222,6 @@ extern MetaPersistCache<RelayFuncCacheEntry> CacheLoweredFunc;
   inline RType FUNC##CacheCompile(TVMOpEnv* env, const op::CallValues call,                        \
                                   MetaPersistCache<RType>* cache,                                  \
                                   std::function<RType(const ir::Function&)> f_post_lower) {        \
-    raf::op::tvm_dialect::ForceEnableAutoScheduler();                                              \
     static const auto op = Op::Get(RAF_DIALECT_OP_NAME(tvm, OP));                                  \
     const auto* schema = call->args.as<SCHEMA>();                                                  \
     CHECK(schema != nullptr);                                                                      \
@@ -228,12 +243,18 @@ extern MetaPersistCache<RelayFuncCacheEntry> CacheLoweredFunc;
     RType ret;                                                                                     \
     HashKey key;                                                                                   \
     key << #OP << HASH(param_types, ret_type, schema);                                             \
-    if (const auto* compiled = cache->Get(key.byte_vector)) {                                      \
+    if (const auto* compiled = cache->Get(key)) {                                                  \
+      return *compiled;                                                                            \
+    }                                                                                              \
+    std::lock_guard<std::mutex> lock(raf::op::tvm_dialect::BuildMutex);                            \
+    /* Another thread may have built the op while this one was waiting */                          \
+    if (const auto* compiled = cache->Get(key)) {                                                  \
       ret = *compiled;                                                                             \
     } else {                                                                                       \
+      raf::op::tvm_dialect::ForceEnableAutoScheduler();                                            \
       auto lowered = LowerOp(op, attrs, param_types, ret_type);                                    \
       ret = f_post_lower(lowered);                                                                 \
-      cache->Set(key.byte_vector, ret);                                                            \
+      cache->Set(key, ret);                                                                        \
     }                                                                                              \
     return ret;                                                                                    \
   }                                                                                                \
@@ -282,6 +303,7 @@ extern MetaPersistCache<RelayFuncCacheEntry> CacheLoweredFunc;
         return env;                                                                                \
       }                                                                                            \
     }                                                                                              \
+    env->PrepareLaunch();                                                                          \
     return env;                                                                                    \
   }                                                                                                \
   Attrs FUNC##Attr(const op::CallValues call) {                                                    \
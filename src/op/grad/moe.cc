@@ -0,0 +1,71 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/grad/moe.cc
+ * \brief Declaration of gradients
+ */
+#include "./grad_utils.h"
+#include "raf/pass.h"
+#include "raf/ir_ext.h"
+
+namespace raf {
+namespace op {
+namespace grad {
+
+using namespace raf::ir;
+
+// The routing is not differentiable. The gradient reaches the gate through the probabilities of
+// the chosen experts, which scale the combined outputs.
+RAF_OP_GRAD("raf.op._moe_gate", NoGrads<3>);
+
+Array<Expr> MoEDispatchGrad(const Expr& orig_call, const Array<Expr> orig_args, const Var& y,
+                            const Expr& dy) {
+  static auto op_combine = Op::Get("raf.op._moe_combine");
+  static auto op_sum = Op::Get("raf.op.sum");
+  const CallNode* call = orig_call.as<CallNode>();
+  CHECK(call != nullptr);
+  const Expr& x = call->args[0];
+  const Expr& indices = call->args[1];
+  const Expr& locations = call->args[2];
+  // Dispatch and combine move the same rows in the opposite directions.
+  Expr dx = Call(op_combine, {dy, indices, locations});
+  auto ty = x->checked_type().as<TensorTypeNode>();
+  CHECK(ty != nullptr);
+  if (ty->shape.size() == 2) {
+    // A token of (tokens, hidden) was copied to each of its choices.
+    Expr keep_dims = MakeConstant(BoolValue::make(false));
+    dx = Call(op_sum, {dx, MakeConstant(ScalarValue::make((int64_t)1)), keep_dims,
+                       MakeConstant(BoolValue::make(false))});
+  }
+  return {dx, NullValue<Expr>(), NullValue<Expr>(), NullValue<Expr>(), NullValue<Expr>()};
+}
+
+RAF_OP_GRAD("raf.op._moe_dispatch", MoEDispatchGrad);
+
+Array<Expr> MoECombineGrad(const Expr& orig_call, const Array<Expr> orig_args, const Var& y,
+                           const Expr& dy) {
+  static auto op_dispatch = Op::Get("raf.op._moe_dispatch");
+  const CallNode* call = orig_call.as<CallNode>();
+  CHECK(call != nullptr);
+  const Expr& experts = call->args[0];
+  const Expr& indices = call->args[1];
+  const Expr& locations = call->args[2];
+  auto ty = experts->checked_type().as<TensorTypeNode>();
+  CHECK(ty != nullptr && ty->shape.size() == 3U);
+  auto num_experts = ty->shape[0].as<IntImmNode>();
+  auto capacity = ty->shape[1].as<IntImmNode>();
+  CHECK(num_experts != nullptr && capacity != nullptr) << "_moe_combine requires a static shape";
+  Expr dexperts = Call(op_dispatch, {dy, indices, locations,
+                                     MakeConstant(ScalarValue::make(num_experts->value)),
+                                     MakeConstant(ScalarValue::make(capacity->value))});
+  return {dexperts, NullValue<Expr>(), NullValue<Expr>()};
+}
+
+RAF_OP_GRAD("raf.op._moe_combine", MoECombineGrad);
+
+}  // namespace grad
+}  // namespace op
+}  // namespace raf
@@ -0,0 +1,94 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/regs/schema2key.h
+ * \brief Converters from RAF operator schemas to the key of the interpreter OpEnv cache. They
+ * mirror the converters in schema2value.h without creating the values.
+ */
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+#include "raf/executor.h"
+#include "raf/value.h"
+
+namespace raf {
+namespace op {
+namespace regs {
+namespace schema2key {
+
+using executor::interpreter::AppendOpEnvCacheKey;
+
+inline void ArrayLike(std::ostream* os, const value::Value& a) {
+  AppendOpEnvCacheKey(os, a);
+  *os << ",";
+}
+
+inline void OptionalArrayLike(std::ostream* os, const ir::Optional<value::Value> a) {
+  AppendOpEnvCacheKey(os, a.defined() ? a.value() : value::Value());
+  *os << ",";
+}
+
+inline void Tensor(std::ostream* os, const value::BaseTensorValue& a) {
+  AppendOpEnvCacheKey(os, a);
+  *os << ",";
+}
+
+inline void OptionalTensor(std::ostream* os, const ir::Optional<value::BaseTensorValue> a) {
+  AppendOpEnvCacheKey(os, a.defined() ? a.value() : value::Value());
+  *os << ",";
+}
+
+inline void Int(std::ostream* os, int64_t a) {
+  *os << "i" << a << ",";
+}
+
+inline void Bool(std::ostream* os, bool a) {
+  *os << "b" << a << ",";
+}
+
+inline void Double(std::ostream* os, double a) {
+  *os << "d" << a << ",";
+}
+
+inline void String(std::ostream* os, const std::string& a) {
+  // The length keeps a string with separators from colliding with other arguments.
+  *os << "s" << a.size() << ":" << a << ",";
+}
+
+inline void IntOrTupleInt(std::ostream* os, const std::vector<int64_t>& a) {
+  *os << "(";
+  for (const auto i : a) {
+    *os << i << ",";
+  }
+  *os << "),";
+}
+
+inline void IntArray(std::ostream* os, const ir::Optional<ir::Array<value::IntValue>> a) {
+  if (!a.defined()) {
+    *os << "N,";
+    return;
+  }
+  *os << "(";
+  for (const auto i : a.value()) {
+    *os << i->value << ",";
+  }
+  *os << "),";
+}
+
+inline void TensorOrTupleTensor(std::ostream* os, const std::vector<value::BaseTensorValue>& a) {
+  *os << "(";
+  for (const auto& i : a) {
+    AppendOpEnvCacheKey(os, i);
+    *os << ",";
+  }
+  *os << "),";
+}
+
+}  // namespace schema2key
+}  // namespace regs
+}  // namespace op
+}  // namespace raf
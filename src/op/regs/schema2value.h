@@ -81,6 +81,9 @@ inline value::Value IntOrTupleInt(const std::vector<int64_t>& a) {
 
 inline value::Value IntArray(const ir::Optional<ir::Array<value::IntValue>> a) {
   RAF_PRELUDE();
+  if (!a.defined()) {
+    return {};
+  }
   Array<Value> ret;
   for (const auto i : a.value()) {
     ret.push_back(IntValue::make(i->dtype, i->value));
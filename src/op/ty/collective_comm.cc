@@ -39,6 +39,14 @@ Type IdentityType(const CallValues& value) {
 RAF_OP_TYPE("raf.op._allreduce", "NCCLAllReduce", IdentityType<AllreduceArgs>);
 RAF_OP_TYPE("raf.op._broadcast", "NCCLBroadcast", IdentityType<BroadcastArgs>);
 RAF_OP_TYPE("raf.op._reduce", "NCCLReduce", IdentityType<CommReduceArgs>);
+RAF_OP_TYPE("raf.op._wait_async", "WaitAsync", IdentityType<WaitAsyncArgs>);
+
+Type AllReduceAsyncInfer(const CallValues& value) {
+  // The ticket of the collective.
+  return TensorType::Scalar(DataType::Int(64));
+}
+
+RAF_OP_TYPE("raf.op._allreduce_async", "AllReduceAsync", AllReduceAsyncInfer);
 
 template <typename T>
 Type TensorIdentityType(const CallValues& value) {
@@ -0,0 +1,125 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/ty/grad_compression.cc
+ * \brief Typing of the gradient compression operators of data parallelism
+ */
+#include <tvm/relay/type.h>
+#include <tvm/tir/op.h>
+#include "raf/type.h"
+#include "raf/grad_compression.h"
+#include "../schema/communication.h"
+#include "./utils.h"
+
+namespace raf {
+namespace op {
+
+using namespace raf::ir;
+using namespace raf::value;
+using namespace raf::op::schema;
+using raf::distributed::OneBitBytes;
+using raf::distributed::PowerSGDMatrixShape;
+using raf::distributed::TopKCount;
+
+/*! \brief The static shape of a tensor type, which the compressed gradients require. */
+std::vector<int64_t> GetStaticShape(const TensorTypeNode* ty, const std::string& op_name) {
+  std::vector<int64_t> shape;
+  for (const auto& dim : ty->shape) {
+    const auto* imm = dim.as<IntImmNode>();
+    CHECK(imm != nullptr) << op_name << " requires a static shape";
+    shape.push_back(imm->value);
+  }
+  return shape;
+}
+
+Array<PrimExpr> MakeShape(const std::vector<int64_t>& shape) {
+  Array<PrimExpr> ret;
+  for (int64_t dim : shape) {
+    ret.push_back(Integer(dim));
+  }
+  return ret;
+}
+
+int64_t GetNumel(const std::vector<int64_t>& shape) {
+  int64_t n = 1;
+  for (int64_t dim : shape) {
+    n *= dim;
+  }
+  return n;
+}
+
+Type TopKCompressInfer(const CallValues& value) {
+  const auto* args = value->args.as<TopkCompressArgs>();
+  CHECK(args != nullptr);
+  auto ty = Downcast<TensorType>(GetType(args->x));
+  int64_t k = TopKCount(GetNumel(GetStaticShape(ty.get(), "_topk_compress")), args->ratio);
+  return TupleType({TensorType({Integer(k)}, ty->dtype),
+                    TensorType({Integer(k)}, DataType::Int(32))});
+}
+
+RAF_OP_TYPE("raf.op._topk_compress", "TopKCompress", TopKCompressInfer);
+
+Type TopKDecompressInfer(const CallValues& value) {
+  const auto* args = value->args.as<TopkDecompressArgs>();
+  CHECK(args != nullptr);
+  auto ty = Downcast<TensorType>(GetType(args->values));
+  return TensorType(MakeShape(args->shape), ty->dtype);
+}
+
+RAF_OP_TYPE("raf.op._topk_decompress", "TopKDecompress", TopKDecompressInfer);
+
+Type OneBitCompressInfer(const CallValues& value) {
+  const auto* args = value->args.as<OnebitCompressArgs>();
+  CHECK(args != nullptr);
+  auto ty = Downcast<TensorType>(GetType(args->x));
+  int64_t bytes = OneBitBytes(GetNumel(GetStaticShape(ty.get(), "_onebit_compress")));
+  return TupleType({TensorType({Integer(bytes)}, DataType::UInt(8)),
+                    TensorType({Integer(2)}, ty->dtype)});
+}
+
+RAF_OP_TYPE("raf.op._onebit_compress", "OneBitCompress", OneBitCompressInfer);
+
+Type OneBitDecompressInfer(const CallValues& value) {
+  const auto* args = value->args.as<OnebitDecompressArgs>();
+  CHECK(args != nullptr);
+  auto ty = Downcast<TensorType>(GetType(args->scales));
+  return TensorType(MakeShape(args->shape), ty->dtype);
+}
+
+RAF_OP_TYPE("raf.op._onebit_decompress", "OneBitDecompress", OneBitDecompressInfer);
+
+Type PowerSGDPInfer(const CallValues& value) {
+  const auto* args = value->args.as<PowersgdPArgs>();
+  CHECK(args != nullptr);
+  auto ty = Downcast<TensorType>(GetType(args->x));
+  auto matrix = PowerSGDMatrixShape(GetStaticShape(ty.get(), "_powersgd_p"));
+  return TensorType({Integer(matrix.first), Integer(args->rank)}, ty->dtype);
+}
+
+RAF_OP_TYPE("raf.op._powersgd_p", "PowerSGDP", PowerSGDPInfer);
+
+Type PowerSGDQInfer(const CallValues& value) {
+  const auto* args = value->args.as<PowersgdQArgs>();
+  CHECK(args != nullptr);
+  auto ty = Downcast<TensorType>(GetType(args->p));
+  CHECK_EQ(ty->shape.size(), 2U);
+  auto matrix = PowerSGDMatrixShape(args->shape);
+  return TupleType({ty, TensorType({Integer(matrix.second), ty->shape[1]}, ty->dtype)});
+}
+
+RAF_OP_TYPE("raf.op._powersgd_q", "PowerSGDQ", PowerSGDQInfer);
+
+Type PowerSGDDecompressInfer(const CallValues& value) {
+  const auto* args = value->args.as<PowersgdDecompressArgs>();
+  CHECK(args != nullptr);
+  auto ty = Downcast<TensorType>(GetType(args->p));
+  return TensorType(MakeShape(args->shape), ty->dtype);
+}
+
+RAF_OP_TYPE("raf.op._powersgd_decompress", "PowerSGDDecompress", PowerSGDDecompressInfer);
+
+}  // namespace op
+}  // namespace raf
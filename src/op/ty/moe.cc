@@ -0,0 +1,58 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/op/ty/moe.cc
+ * \brief Typing of the mixture-of-experts operators
+ */
+#include <tvm/relay/type.h>
+#include <tvm/tir/op.h>
+#include "raf/type.h"
+#include "../schema/moe.h"
+#include "./utils.h"
+
+namespace raf {
+namespace op {
+
+using namespace raf::ir;
+using namespace raf::value;
+using namespace raf::op::schema;
+
+Type MoEGateInfer(const CallValues& value) {
+  const auto* args = value->args.as<MoeGateArgs>();
+  CHECK(args != nullptr);
+  auto ty = Downcast<TensorType>(GetType(args->probs));
+  CHECK_EQ(ty->shape.size(), 2U) << "_moe_gate expects the probabilities of (tokens, experts)";
+  auto routing = TensorType({ty->shape[0], Integer(args->k)}, DataType::Int(32));
+  return TupleType({routing, routing});
+}
+
+RAF_OP_TYPE("raf.op._moe_gate", "MoEGate", MoEGateInfer);
+
+Type MoEDispatchInfer(const CallValues& value) {
+  const auto* args = value->args.as<MoeDispatchArgs>();
+  CHECK(args != nullptr);
+  auto ty = Downcast<TensorType>(GetType(args->x));
+  CHECK(ty->shape.size() == 2U || ty->shape.size() == 3U)
+      << "_moe_dispatch expects the tokens of (tokens, hidden) or (tokens, k, hidden)";
+  return TensorType({Integer(args->num_experts), Integer(args->capacity), ty->shape.back()},
+                    ty->dtype);
+}
+
+RAF_OP_TYPE("raf.op._moe_dispatch", "MoEDispatch", MoEDispatchInfer);
+
+Type MoECombineInfer(const CallValues& value) {
+  const auto* args = value->args.as<MoeCombineArgs>();
+  CHECK(args != nullptr);
+  auto ty = Downcast<TensorType>(GetType(args->y));
+  auto routing = Downcast<TensorType>(GetType(args->indices));
+  CHECK_EQ(ty->shape.size(), 3U) << "_moe_combine expects (experts, capacity, hidden)";
+  return TensorType({routing->shape[0], routing->shape[1], ty->shape[2]}, ty->dtype);
+}
+
+RAF_OP_TYPE("raf.op._moe_combine", "MoECombine", MoECombineInfer);
+
+}  // namespace op
+}  // namespace raf
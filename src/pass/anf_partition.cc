@@ -6,7 +6,9 @@
 /*!
  * \file anf_partition.cc
  * \brief Partition ANF program to be multiple functions.
- * Currently we simply make each partition equal or smaller to the given partition size.
+ * PartitionANF makes each partition equal or smaller to the given partition size, and
+ * PartitionANFByCost cuts the program into the given number of partitions with balanced cost,
+ * where the cost of an op is either its estimated FLOPS or its profiled latency.
  * We will introduce more partition strategies (e.g., optimize memory, etc) in the future.
  * e.g.,
  * fn(%x: Tensor[(10, 10), float32]) {
@@ -41,9 +43,12 @@
 #include "raf/binding.h"
 #include "raf/pass.h"
 #include "raf/ir_ext.h"
+#include "raf/op_profiler.h"
+#include <cmath>
 #include <utility>
 #include <vector>
 #include "./common.h"
+#include "./estimate_flops.h"
 #include "./liveness_analysis.h"
 #include "./partition_utils.h"
 
@@ -58,12 +63,28 @@ using binding::BindingEntry;
 using binding::BindNDArray;
 using binding::LookupBinding;
 
+template <typename T>
+using StdMap = std::unordered_map<Var, T, ObjectPtrHash, ObjectPtrEqual>;
+
 class Partitioner final : public ExprMutator {
  public:
   explicit Partitioner(int max_num_ops, Var boundary, liveness_analysis::LivenessAnalyzer& analyzer)
       : max_num_ops_(max_num_ops), boundary_(boundary), analyzer_(analyzer) {
   }
 
+  /*!
+   * \brief Partition the program into num_partitions partitions with balanced cost.
+   * \param costs The cost of each call before the boundary.
+   */
+  explicit Partitioner(const StdMap<float>& costs, int num_partitions, Var boundary,
+                       liveness_analysis::LivenessAnalyzer& analyzer)
+      : costs_(costs), num_partitions_(num_partitions), boundary_(boundary), analyzer_(analyzer) {
+    for (const auto& it : costs_) {
+      total_cost_ += it.second;
+    }
+    num_left_calls_ = costs_.size();
+  }
+
   Expr VisitExpr_(const LetNode* let_node) final {
     int num_visited = 0;
     int partition_id = 0;
@@ -75,7 +96,7 @@ class Partitioner final : public ExprMutator {
       const LetNode* let = curr.as<LetNode>();
       CHECK(let) << "Expect ANF (let-binding), but got " << curr->GetTypeKey();
       if (let->value.as<CallNode>() /* don't partition trivial statement */ &&
-          num_visited >= max_num_ops_) {
+          NeedCut(let->var, num_visited, partition_id - 1)) {
         par_func.TrimOutputs(analyzer_, let->var, false);
         par_func.ExportTo(&ret_ell, intermediate_var_2_func_out);
         par_func = PartitionFunction("func_partition_" + std::to_string(partition_id++));
@@ -116,8 +137,47 @@ class Partitioner final : public ExprMutator {
   }
 
  private:
+  /*!
+   * \brief Whether to start a new partition before the given call.
+   * \param var The var that the call binds to.
+   * \param num_visited The number of bindings in the current partition.
+   * \param curr_partition The index of the current partition.
+   */
+  bool NeedCut(const Var& var, int num_visited, int curr_partition) {
+    if (num_partitions_ == 0) {
+      return num_visited >= max_num_ops_;
+    }
+    auto it = costs_.find(var);
+    if (it == costs_.end()) {
+      // The call is after the boundary.
+      return false;
+    }
+    // A call belongs to the partition where the midpoint of its cost falls.
+    float cost = it->second;
+    int target = static_cast<int>((visited_cost_ + cost / 2) * num_partitions_ / total_cost_);
+    int num_opening = num_partitions_ - 1 - curr_partition;
+    bool cut = num_opening > 0 && num_calls_ > 0 &&
+               (target > curr_partition || num_left_calls_ <= num_opening);
+    visited_cost_ += cost;
+    num_left_calls_--;
+    num_calls_ = cut ? 1 : num_calls_ + 1;
+    return cut;
+  }
+
   /*! \brief max number of operations in a sub-function */
   int max_num_ops_{1};
+  /*! \brief The cost of each call. Only used when partitioning by cost. */
+  StdMap<float> costs_;
+  /*! \brief The number of partitions, or 0 if partitioning by the number of ops. */
+  int num_partitions_{0};
+  /*! \brief The total cost of the calls. */
+  float total_cost_{0};
+  /*! \brief The cost of the visited calls. */
+  float visited_cost_{0};
+  /*! \brief The number of calls that are not visited yet. */
+  int num_left_calls_{0};
+  /*! \brief The number of calls in the current partition. */
+  int num_calls_{0};
   /*! \brief the variable defines the end of partition.
    * If the program combines a set of variables to be tuples in the end,
    * we don't have these operations included in a partitioned function,
@@ -128,6 +188,46 @@ class Partitioner final : public ExprMutator {
   liveness_analysis::LivenessAnalyzer& analyzer_;
 };
 
+/*!
+ * \brief Get the cost of each call before the boundary. Calls without a valid cost (e.g.,
+ * communication ops have no FLOPS) are free. If no call has a cost, every call costs 1.
+ */
+StdMap<float> GetCallCosts(const Function& f, const Var& boundary, const IRModule& mod,
+                           bool use_profiler) {
+  auto device = Device::Current(false);
+  auto ell = ExplicitLetList::make(f->body);
+  StdMap<float> flops;
+  op_profiler::OpProfiler* profiler = nullptr;
+  if (use_profiler) {
+    profiler = op_profiler::OpProfiler::Get(device);
+  } else {
+    flops = estimate_flops::FLOPSEstimater().Run(device, f, mod);
+  }
+  StdMap<float> costs;
+  float total_cost = 0;
+  for (size_t i = 0; i < ell->vars.size(); ++i) {
+    if (ell->exprs[i].as<CallNode>()) {
+      float cost = 0;
+      if (profiler) {
+        cost = profiler->ProfileOp(ell->exprs[i]).first[0];
+      } else if (flops.count(ell->vars[i])) {
+        cost = flops[ell->vars[i]];
+      }
+      costs[ell->vars[i]] = std::isfinite(cost) && cost > 0 ? cost : 0;
+      total_cost += costs[ell->vars[i]];
+    }
+    if (ell->vars[i] == boundary) {
+      break;
+    }
+  }
+  if (total_cost == 0) {
+    for (auto& it : costs) {
+      it.second = 1;
+    }
+  }
+  return costs;
+}
+
 }  // namespace anf_partition
 
 Pass PartitionANF(int max_num_ops) {
@@ -142,7 +242,22 @@ Pass PartitionANF(int max_num_ops) {
   return CreateRAFFunctionPass(pass_func, 0, "PartitionANF", {});
 }
 
+Pass PartitionANFByCost(int num_partitions, bool use_profiler) {
+  TypedPackedFunc<Function(Function, IRModule, PassContext)> pass_func = [=](Function f, IRModule m,
+                                                                             PassContext pc) {
+    Var boundary = pass::GetPartitionBoundary(f);
+    auto analyzer = liveness_analysis::LivenessAnalyzer(f);
+    analyzer.Run();
+    auto costs = anf_partition::GetCallCosts(f, boundary, m, use_profiler);
+    anf_partition::Partitioner partitioner(costs, num_partitions, boundary, analyzer);
+    return Downcast<Function>(partitioner(f));
+  };
+  auto func_pass = CreateRAFFunctionPass(pass_func, 0, "PartitionANFByCostFunc", {});
+  return RAFSequential({InferType(), func_pass}, "PartitionANFByCost");
+}
+
 RAF_REGISTER_GLOBAL("raf.pass_.PartitionANF").set_body_typed(PartitionANF);
+RAF_REGISTER_GLOBAL("raf.pass_.PartitionANFByCost").set_body_typed(PartitionANFByCost);
 
 }  // namespace pass
 }  // namespace raf
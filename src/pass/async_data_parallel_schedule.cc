@@ -0,0 +1,299 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file async_data_parallel_schedule.cc
+ * \brief Overlaps the gradient allreduces with the backward on CPU, where the collectives would
+ * otherwise block the compute. The allreduces inserted by AutoDataParallel are grouped into
+ * buckets of DistConfig::group_bucket_size elements. A bucket is launched with _allreduce_async,
+ * which runs on the communication worker thread, right after the gradient that fills it. It is
+ * waited with _wait_async as late as possible: the bindings that use the reduced gradients (e.g.,
+ * the division of the average and the optimizer update) are deferred, and the waits are placed
+ * right before the first binding that cannot be deferred, or before the return.
+ */
+#include <unordered_set>
+#include "raf/op.h"
+#include "raf/op_utils.h"
+#include "raf/dist_config.h"
+#include "raf/pass.h"
+#include "./common.h"
+#include "./let_list.h"
+
+namespace raf {
+namespace pass {
+namespace async_data_parallel_schedule {
+
+using namespace raf::ir;
+using raf::distributed::DistConfig;
+
+using VarSet = std::unordered_set<Var, ObjectPtrHash, ObjectPtrEqual>;
+
+/*! \brief The allreduces launched together. */
+struct Bucket {
+  /*! \brief The result of each allreduce. */
+  std::vector<Var> members;
+  /*! \brief The number of tensors of each allreduce. */
+  std::vector<int> num_fields;
+  /*! \brief The tensors of all the allreduces. */
+  Array<Expr> fields;
+  /*! \brief The computation and dtype, which must be the same within a bucket. */
+  std::string key;
+  Expr computation;
+  int64_t size = 0;
+  /*! \brief The ticket returned by _allreduce_async, which is defined once launched. */
+  Var handle;
+  Var input;
+};
+
+class AsyncScheduler {
+ public:
+  explicit AsyncScheduler(const Function& func)
+      : func_(func), bucket_size_(DistConfig::Global()->group_bucket_size) {
+  }
+
+  Function Run() {
+    auto ell = ExplicitLetList::make(func_->body);
+    auto& vars = ell->vars;
+    auto& exprs = ell->exprs;
+    ell_ = std::make_unique<ExplicitLetList>();
+    bool scheduled = false;
+    for (size_t i = 0; i < vars.size(); ++i) {
+      if (auto tuple = exprs[i].as<TupleNode>()) {
+        tuples_[vars[i]] = tuple;
+      } else if (auto func = exprs[i].as<FunctionNode>()) {
+        if (func->HasNonzeroAttr(attr::kPrimitive)) {
+          primitives_.insert(vars[i]);
+        }
+      }
+      if (AddToBucket(vars[i], exprs[i])) {
+        scheduled = true;
+        continue;
+      }
+      if (!DependsOnPending(exprs[i])) {
+        ell_->Push(vars[i], exprs[i]);
+      } else if (IsDeferrable(exprs[i])) {
+        deferred_.emplace_back(vars[i], exprs[i]);
+        pending_.insert(vars[i]);
+      } else {
+        WaitAll();
+        ell_->Push(vars[i], exprs[i]);
+      }
+    }
+    if (!scheduled) {
+      return func_;
+    }
+    // Every ticket must be waited, so the remaining buckets are waited before the return even if
+    // the return does not use them.
+    WaitAll();
+    ell_->ret = ell->ret;
+    return Function(func_->params, ell_->AsExpr(), {}, {}, func_->attrs);
+  }
+
+ private:
+  /*!
+   * \brief Add the binding to the open bucket if it is an allreduce of static-shaped tensors of
+   * the same dtype on the global communicator.
+   * \return Whether the binding is moved to a bucket.
+   */
+  bool AddToBucket(const Var& var, const Expr& expr) {
+    static const Op& allreduce_op = Op::Get("raf.op._allreduce");
+    auto call = expr.as<CallNode>();
+    if (call == nullptr || !call->op.as<OpNode>() || call->args.size() != 3) {
+      return false;
+    }
+    auto op = Downcast<Op>(call->op);
+    if ((op::IsDialectOp(op) ? op::GetBaseOp(op) : op) != allreduce_op) {
+      return false;
+    }
+    auto computation = call->args[1].as<ConstantNode>();
+    auto rank_list = call->args[2].as<ConstantNode>();
+    if (computation == nullptr || rank_list == nullptr ||
+        ConstantExtractValue(GetRef<Constant>(rank_list)).defined()) {
+      return false;
+    }
+    // The input is a tuple, either bound to a variable or inlined.
+    const TupleNode* input = call->args[0].as<TupleNode>();
+    if (auto var = call->args[0].as<VarNode>()) {
+      auto it = tuples_.find(GetRef<Var>(var));
+      input = it == tuples_.end() ? nullptr : it->second;
+    }
+    if (input == nullptr || DependsOnPending(GetRef<Tuple>(input))) {
+      return false;
+    }
+    const auto& fields = input->fields;
+    int64_t size = 0;
+    std::string dtype;
+    for (const auto& field : fields) {
+      auto ttype = field->checked_type_.as<TensorTypeNode>();
+      if (ttype == nullptr) {
+        return false;
+      }
+      std::string field_dtype = DLDataType2String(ttype->dtype);
+      if (!dtype.empty() && field_dtype != dtype) {
+        return false;
+      }
+      dtype = field_dtype;
+      int64_t n = 1;
+      for (const auto& dim : ttype->shape) {
+        auto dim_value = tvm::tir::as_const_int(dim);
+        if (dim_value == nullptr) {
+          return false;
+        }
+        n *= dim_value[0];
+      }
+      size += n;
+    }
+    auto value = ConstantExtractValue(GetRef<Constant>(computation)).as<StringValueObj>();
+    if (value == nullptr || fields.empty()) {
+      return false;
+    }
+    std::string key = value->value + "/" + dtype;
+
+    // Like GroupAllgather, a bucket is closed before it exceeds the bucket size.
+    if (!open_.members.empty() && (open_.key != key || open_.size + size > bucket_size_)) {
+      Launch();
+    }
+    open_.members.push_back(var);
+    open_.num_fields.push_back(fields.size());
+    open_.fields.insert(open_.fields.end(), fields.begin(), fields.end());
+    open_.key = key;
+    open_.computation = call->args[1];
+    open_.size += size;
+    pending_.insert(var);
+    if (open_.size >= bucket_size_) {
+      Launch();
+    }
+    return true;
+  }
+
+  /*! \brief Launch the open bucket on the communication worker. */
+  void Launch() {
+    static const Op& allreduce_async_op = Op::Get("raf.op._allreduce_async");
+    if (open_.members.empty()) {
+      return;
+    }
+    open_.input = MakeVar("allreduce_in", {});
+    ell_->Push(open_.input, Tuple(open_.fields));
+    open_.handle = MakeVar("allreduce_handle", {});
+    ell_->Push(open_.handle, Call(allreduce_async_op, {open_.input, open_.computation,
+                                                       MakeConstant(NullValue<Value>())}));
+    launched_.push_back(std::move(open_));
+    open_ = Bucket();
+  }
+
+  /*!
+   * \brief Wait for all the buckets, and then run the deferred bindings. The allreduces are
+   * replaced by the elements of the results. The desired IR is:
+   * let %allreduce_out = _wait_async(%allreduce_handle, %allreduce_in);
+   * let %g_sum = %allreduce_out.0;  // The original allreduce of one tensor
+   * let %g_sum1 = %allreduce_out.1;
+   */
+  void WaitAll() {
+    static const Op& wait_op = Op::Get("raf.op._wait_async");
+    Launch();
+    for (auto& bucket : launched_) {
+      auto wait = Call(wait_op, {bucket.handle, bucket.input});
+      if (bucket.fields.size() == 1) {
+        ell_->Push(bucket.members[0], wait);
+        continue;
+      }
+      auto reduced = MakeVar("allreduce_out", {});
+      ell_->Push(reduced, wait);
+      int index = 0;
+      for (size_t i = 0; i < bucket.members.size(); ++i) {
+        if (bucket.num_fields[i] == 1) {
+          ell_->Push(bucket.members[i], TupleGetItem(reduced, index++));
+          continue;
+        }
+        Array<Expr> fields;
+        for (int j = 0; j < bucket.num_fields[i]; ++j) {
+          auto field = MakeVar("allreduce_out", {});
+          ell_->Push(field, TupleGetItem(reduced, index++));
+          fields.push_back(field);
+        }
+        ell_->Push(bucket.members[i], Tuple(fields));
+      }
+    }
+    launched_.clear();
+    for (const auto& binding : deferred_) {
+      ell_->Push(binding.first, binding.second);
+    }
+    deferred_.clear();
+    pending_.clear();
+  }
+
+  bool DependsOnPending(const Expr& expr) {
+    for (const auto& var : FreeVars(expr)) {
+      if (pending_.count(var)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /*!
+   * \brief Whether the binding is pure and can be moved after the waits. Ops with side effects,
+   * such as the stateful gradient compression, collectives and in-place updates are kept in place,
+   * since moving them changes their order with respect to the launched collectives.
+   */
+  bool IsDeferrable(const Expr& expr) {
+    static auto fside_effect = Op::GetAttrMap<op::TRAFSideEffect>("TRAFSideEffect");
+    static auto fcollective = Op::GetAttrMap<op::TRAFCollective>("TRAFCollective");
+    static auto finplace = Op::GetAttrMap<op::TRAFInplaceUpdate>("TRAFInplaceUpdate");
+    if (expr.as<TupleNode>() || expr.as<TupleGetItemNode>()) {
+      return true;
+    }
+    if (auto call = expr.as<CallNode>()) {
+      if (auto op_node = call->op.as<OpNode>()) {
+        auto op = GetRef<Op>(op_node);
+        return !fside_effect.get(op, false) && !fcollective.get(op, false) &&
+               !finplace.count(op);
+      }
+      if (auto func = call->op.as<FunctionNode>()) {
+        return func->HasNonzeroAttr(attr::kPrimitive);
+      }
+      if (auto var = call->op.as<VarNode>()) {
+        return primitives_.count(GetRef<Var>(var)) > 0;
+      }
+    }
+    return false;
+  }
+
+  /*! \brief The target function. */
+  Function func_;
+  /*! \brief The maximum number of elements of a bucket. */
+  int64_t bucket_size_;
+  /*! \brief The rebuilt let list. */
+  std::unique_ptr<ExplicitLetList> ell_;
+  /*! \brief The tuples bound to variables. */
+  std::unordered_map<Var, const TupleNode*, ObjectPtrHash, ObjectPtrEqual> tuples_;
+  /*! \brief The variables bound to primitive functions. */
+  VarSet primitives_;
+  /*! \brief The bucket that is not launched yet. */
+  Bucket open_;
+  /*! \brief The launched buckets that are not waited yet. */
+  std::vector<Bucket> launched_;
+  /*! \brief The bindings moved after the waits, in the original order. */
+  std::vector<std::pair<Var, Expr>> deferred_;
+  /*! \brief The variables that are not available until the waits. */
+  VarSet pending_;
+};
+
+}  // namespace async_data_parallel_schedule
+
+Pass AsyncDataParallelSchedule() {
+  TypedPackedFunc<Function(Function, IRModule, PassContext)> pass_func = [=](Function f, IRModule m,
+                                                                             PassContext pc) {
+    return async_data_parallel_schedule::AsyncScheduler(f).Run();
+  };
+  auto schedule = CreateRAFFunctionPass(pass_func, 0, "AsyncDataParallelScheduleFunc", {});
+  return RAFSequential({InferType(), schedule, InferType()}, "AsyncDataParallelSchedule");
+}
+
+RAF_REGISTER_GLOBAL("raf.pass_.AsyncDataParallelSchedule")
+    .set_body_typed(AsyncDataParallelSchedule);
+
+}  // namespace pass
+}  // namespace raf
@@ -134,8 +134,7 @@ struct CastCacheHash {
     // Cannot use the object hash because type hints are different objects.
     key << TypeHintHash(pair.second);
 
-    std::string str_key(key.byte_vector.begin(), key.byte_vector.end());
-    return std::hash<std::string>()(str_key);
+    return static_cast<std::size_t>(key.digest());
   }
 };
 
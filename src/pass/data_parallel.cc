@@ -10,10 +10,12 @@
 #include <set>
 #include <sstream>
 #include "raf/op.h"
+#include "raf/op_utils.h"
 #include "raf/ir_ext.h"
 #include "raf/pass.h"
 #include "raf/communicator.h"
 #include "raf/dist_config.h"
+#include "raf/grad_compression.h"
 #include "raf/profiler.h"
 #include "raf/stream_pool.h"
 #include "./common.h"
@@ -32,6 +34,8 @@ using namespace raf::distributed::communicator;
 using profiler::Profiler;
 using profiler::ProfileStat;
 using raf::distributed::DistConfig;
+using raf::distributed::PowerSGDMatrixShape;
+using raf::distributed::TopKCount;
 using raf::value::NoGradValue;
 using stream_pool::StreamTagEnum;
 
@@ -42,6 +46,9 @@ struct DataParallel {
       1) adding communication op after the op which generate the local gradient.
       2) update the returned gradient from local gradient to aggregated global gradient.
       3) adding a stream_sync op before the end of backward closure to ensure communication is done.
+      If DistConfig.grad_compression is set, the float32 gradients are aggregated in a compressed
+      form instead: casted to fp16/bf16, the top-k elements or the signs with error feedback
+      (gathered by allgather), or the PowerSGD low-rank factors (reduced by allreduce).
   Example:
         Backward closure before DataParallel Pass:
         ```
@@ -214,7 +221,6 @@ struct DataParallel {
 
   Function Run() {
     auto dcfg = DistConfig::Global();
-    auto comm = GetGlobalCommunicator();
 
     // If we want to overlap communication and forward pass,
     // we need to analyze the running time of Ops
@@ -247,74 +253,18 @@ struct DataParallel {
     }
     // The map from original local gradient to aggregated global gradient.
     std::map<raf::ir::Expr, raf::ir::Var> var_var_map;
-    // Enlarge the size of bp_ell to fit the allreduce ops.
-    // p1 tracks the processing var/expr (from end to begin)
-    // p2 tracks the next vacant position to paste the processing var/expr or allreduce op.
-    int p1 = bp_n - 1;
-    // If NCCL version is 2.10+, then average allreduce is going to be inserted
-    // otherwise, a sum allreduce is used and then a divied op is followed
-    // So for NCCL version less than 2.10, the let list size is one more item(i.e. divide op)
-    // for each gradient
-
-#if defined RAF_USE_NCCL && NCCL_VERSION_CODE >= 21000
-    bp_ell->vars.resize(bp_n + 2 * gradset.size());
-    bp_ell->exprs.resize(bp_n + 2 * gradset.size());
-    int p2 = bp_n - 1 + 2 * gradset.size();
-#else
-    bp_ell->vars.resize(bp_n + 3 * gradset.size());
-    bp_ell->exprs.resize(bp_n + 3 * gradset.size());
-    int p2 = bp_n - 1 + 3 * gradset.size();
-#endif
-
-    bp_ell->vars[p2] = bp_ell->vars[p1];
-    bp_ell->exprs[p2] = bp_ell->exprs[p1];
-    --p2;
-    --p1;
-
-    for (int i = p1; i >= 0; --i) {
+    // Rebuild the let list with the aggregation of each gradient right after the expr that
+    // generates it. The last expr is the return tuple, which is updated below.
+    auto new_bp_ell = std::make_unique<ExplicitLetList>();
+    for (size_t i = 0; i + 1 < bp_n; ++i) {
+      new_bp_ell->Push(bp_ell->vars[i], bp_ell->exprs[i]);
       if (gradset.find(bp_ell->vars[i].operator->()) != gradset.end()) {
-        // If the current expr is an op-expr which generate local gradient,
-        // we should add a allreduce op after it.
-        static Op op_allreduce = Op::Get("raf.op._allreduce");
-        auto input_var = raf::ir::MakeVar("allreduce_in", {});
-        auto rank_list = MakeConstant(NullValue<Value>());
-
-#if defined RAF_USE_NCCL && NCCL_VERSION_CODE >= 21000
-        bp_ell->vars[p2 - 1] = input_var;
-        bp_ell->exprs[p2 - 1] = Tuple({bp_ell->vars[i]});
-        // Here we name the var as 'g'(global gradient), to help us identify it easier.
-        bp_ell->vars[p2] = raf::ir::MakeVar("g", {});
-        bp_ell->exprs[p2] = Call(op_allreduce, {bp_ell->vars[p2 - 1],
-                                                MakeConstant(StringValue::make("avg")), rank_list});
-        var_var_map.insert({bp_ell->vars[i], bp_ell->vars[p2]});
-        p2 -= 2;
-#else
-        static Op op_div = Op::Get("raf.op.divide");
-        bp_ell->vars[p2 - 2] = input_var;
-        bp_ell->exprs[p2 - 2] = Tuple({bp_ell->vars[i]});
-        bp_ell->vars[p2 - 1] = raf::ir::MakeVar("g_sum", {});
-        bp_ell->exprs[p2 - 1] =
-            Call(op_allreduce,
-                 {bp_ell->vars[p2 - 2], MakeConstant(StringValue::make("sum")), rank_list});
-        bp_ell->vars[p2] = raf::ir::MakeVar("g", {});
-        auto tt = bp_ell->vars[i]->checked_type().as<TensorTypeNode>();
-        if (tt->dtype.code() == kDLFloat) {
-          bp_ell->exprs[p2] = Call(
-              op_div, {bp_ell->vars[p2 - 1], MakeConstant(ScalarValue::make(float(comm->size)))});
-        } else if (tt->dtype.code() == kDLInt) {
-          bp_ell->exprs[p2] = Call(
-              op_div, {bp_ell->vars[p2 - 1], MakeConstant(ScalarValue::make(int64_t(comm->size)))});
-        } else {
-          LOG(FATAL) << "Do not support type other than KDLFloat  and KDLInt. \n";
-        }
-        var_var_map.insert({bp_ell->vars[i], bp_ell->vars[p2]});
-        p2 -= 3;
-#endif
+        var_var_map.insert({bp_ell->vars[i], Aggregate(bp_ell->vars[i], new_bp_ell.get())});
       }
-      bp_ell->vars[p2] = bp_ell->vars[i];
-      bp_ell->exprs[p2] = bp_ell->exprs[i];
-      --p2;
     }
+    new_bp_ell->Push(bp_ell->vars[bp_n - 1], bp_ell->exprs[bp_n - 1]);
+    new_bp_ell->ret = bp_ell->ret;
+    bp_ell = std::move(new_bp_ell);
 
     Array<Expr> new_bp_rt;
     if (const auto* tuple = bp_grads.as<TupleNode>()) {
@@ -348,6 +298,183 @@ struct DataParallel {
     return Function(func->params, fp_ell->AsExpr(), {}, {});
   }
 
+  /*! \brief Aggregate a local gradient into the global gradient, compressed if configured. */
+  Var Aggregate(const Var& grad, ExplicitLetList* ell) {
+    auto dcfg = DistConfig::Global();
+    const std::string& method = dcfg->grad_compression;
+    const auto* ttype = grad->checked_type().as<TensorTypeNode>();
+    // Only float32 gradients of static shapes are compressed, and the others are sent as is.
+    if (method == "none" || ttype == nullptr || DataType(ttype->dtype) != DataType::Float(32)) {
+      return AllReduce(grad, ell);
+    }
+    std::vector<int64_t> shape;
+    for (const auto& dim : ttype->shape) {
+      const auto* imm = dim.as<IntImmNode>();
+      if (imm == nullptr) {
+        return AllReduce(grad, ell);
+      }
+      shape.push_back(imm->value);
+    }
+    int64_t n = 1;
+    for (int64_t dim : shape) {
+      n *= dim;
+    }
+    std::string key = "grad_compression/" + method + "/" + std::to_string(func_hash) + "/" +
+                      std::to_string(num_compressed++) + "/" + grad->name_hint();
+    if (method == "fp16" || method == "bf16") {
+      return CastAllReduce(grad, method == "fp16" ? "float16" : "bfloat16", ell);
+    } else if (method == "topk" && TopKCount(n, dcfg->grad_compression_topk_ratio) < n) {
+      return TopKAllReduce(grad, shape, key, ell);
+    } else if (method == "onebit") {
+      return OneBitAllReduce(grad, shape, key, ell);
+    } else if (method == "powersgd" && shape.size() >= 2) {
+      auto matrix = PowerSGDMatrixShape(shape);
+      int64_t rank = dcfg->grad_compression_powersgd_rank;
+      // Skip the gradients whose factors are not smaller than themselves.
+      if (rank * (matrix.first + matrix.second) < matrix.first * matrix.second) {
+        return PowerSGDAllReduce(grad, shape, key, ell);
+      }
+    }
+    return AllReduce(grad, ell);
+  }
+
+  /*! \brief The averaged allreduce of a gradient at full precision. */
+  Var AllReduce(const Var& grad, ExplicitLetList* ell) {
+    static Op op_allreduce = Op::Get("raf.op._allreduce");
+    auto rank_list = MakeConstant(NullValue<Value>());
+    auto input_var = raf::ir::MakeVar("allreduce_in", {});
+    ell->Push(input_var, Tuple({grad}));
+#if defined RAF_USE_NCCL && NCCL_VERSION_CODE >= 21000
+    // Here we name the var as 'g'(global gradient), to help us identify it easier.
+    auto g = raf::ir::MakeVar("g", {});
+    ell->Push(g, Call(op_allreduce,
+                      {input_var, MakeConstant(StringValue::make("avg")), rank_list}));
+    return g;
+#else
+    static Op op_div = Op::Get("raf.op.divide");
+    auto comm = GetGlobalCommunicator();
+    auto g_sum = raf::ir::MakeVar("g_sum", {});
+    ell->Push(g_sum, Call(op_allreduce,
+                          {input_var, MakeConstant(StringValue::make("sum")), rank_list}));
+    auto g = raf::ir::MakeVar("g", {});
+    auto tt = grad->checked_type().as<TensorTypeNode>();
+    if (tt->dtype.code() == kDLFloat) {
+      ell->Push(g, Call(op_div, {g_sum, MakeConstant(ScalarValue::make(float(comm->size)))}));
+    } else if (tt->dtype.code() == kDLInt) {
+      ell->Push(g, Call(op_div, {g_sum, MakeConstant(ScalarValue::make(int64_t(comm->size)))}));
+    } else {
+      LOG(FATAL) << "Do not support type other than KDLFloat  and KDLInt. \n";
+    }
+    return g;
+#endif
+  }
+
+  /*!
+   * \brief Allreduce a gradient in a 16-bit float. The gradient is divided by the number of ranks
+   * beforehand, so that the sum does not overflow.
+   */
+  Var CastAllReduce(const Var& grad, const std::string& dtype, ExplicitLetList* ell) {
+    static Op op_allreduce = Op::Get("raf.op._allreduce");
+    static Op op_div = Op::Get("raf.op.divide");
+    static Op op_cast = Op::Get("raf.op.cast");
+    auto comm = GetGlobalCommunicator();
+    auto scaled = raf::ir::MakeVar("g_scaled", {});
+    ell->Push(scaled, Call(op_div, {grad, MakeConstant(ScalarValue::make(float(comm->size)))}));
+    auto low = raf::ir::MakeVar("g_low", {});
+    ell->Push(low, Call(op_cast, {scaled, MakeConstant(StringValue::make(dtype))}));
+    auto input_var = raf::ir::MakeVar("allreduce_in", {});
+    ell->Push(input_var, Tuple({low}));
+    auto g_sum = raf::ir::MakeVar("g_sum", {});
+    ell->Push(g_sum, Call(op_allreduce, {input_var, MakeConstant(StringValue::make("sum")),
+                                         MakeConstant(NullValue<Value>())}));
+    auto g = raf::ir::MakeVar("g", {});
+    ell->Push(g, Call(op_cast, {g_sum, MakeConstant(StringValue::make("float32"))}));
+    return g;
+  }
+
+  /*! \brief Allgather the top-k elements of every rank, with the rest fed back locally. */
+  Var TopKAllReduce(const Var& grad, const std::vector<int64_t>& shape, const std::string& key,
+                    ExplicitLetList* ell) {
+    static Op op_compress = Op::Get("raf.op._topk_compress");
+    static Op op_decompress = Op::Get("raf.op._topk_decompress");
+    auto ratio = MakeConstant(ScalarValue::make(DistConfig::Global()->grad_compression_topk_ratio));
+    auto compressed = raf::ir::MakeVar("compressed", {});
+    ell->Push(compressed, Call(op_compress, {grad, ratio, MakeConstant(StringValue::make(key))}));
+    auto values = AllGather(compressed, 0, "g_values", ell);
+    auto indices = AllGather(compressed, 1, "g_indices", ell);
+    auto g = raf::ir::MakeVar("g", {});
+    ell->Push(g, Call(op_decompress, {values, indices, MakeConstant(ArrayToIntTuple(shape)),
+                                      MakeConstant(ScalarValue::make(MeanScale()))}));
+    return g;
+  }
+
+  /*! \brief Allgather the signs and the mean magnitudes of every rank. */
+  Var OneBitAllReduce(const Var& grad, const std::vector<int64_t>& shape, const std::string& key,
+                      ExplicitLetList* ell) {
+    static Op op_compress = Op::Get("raf.op._onebit_compress");
+    static Op op_decompress = Op::Get("raf.op._onebit_decompress");
+    auto compressed = raf::ir::MakeVar("compressed", {});
+    ell->Push(compressed, Call(op_compress, {grad, MakeConstant(StringValue::make(key))}));
+    auto bits = AllGather(compressed, 0, "g_bits", ell);
+    auto scales = AllGather(compressed, 1, "g_scales", ell);
+    auto g = raf::ir::MakeVar("g", {});
+    ell->Push(g, Call(op_decompress, {bits, scales, MakeConstant(ArrayToIntTuple(shape)),
+                                      MakeConstant(ScalarValue::make(MeanScale()))}));
+    return g;
+  }
+
+  /*! \brief Allreduce the low-rank factors of PowerSGD instead of the gradient. */
+  Var PowerSGDAllReduce(const Var& grad, const std::vector<int64_t>& shape,
+                        const std::string& key, ExplicitLetList* ell) {
+    static Op op_allreduce = Op::Get("raf.op._allreduce");
+    static Op op_p = Op::Get("raf.op._powersgd_p");
+    static Op op_q = Op::Get("raf.op._powersgd_q");
+    static Op op_decompress = Op::Get("raf.op._powersgd_decompress");
+    auto dcfg = DistConfig::Global();
+    auto rank = MakeConstant(ScalarValue::make(dcfg->grad_compression_powersgd_rank));
+    auto sum = [&](const Var& x, const std::string& name) {
+      auto input_var = raf::ir::MakeVar("allreduce_in", {});
+      ell->Push(input_var, Tuple({x}));
+      auto out = raf::ir::MakeVar(name, {});
+      ell->Push(out, Call(op_allreduce, {input_var, MakeConstant(StringValue::make("sum")),
+                                         MakeConstant(NullValue<Value>())}));
+      return out;
+    };
+    auto key_const = MakeConstant(StringValue::make(key));
+    auto shape_const = MakeConstant(ArrayToIntTuple(shape));
+    auto p = raf::ir::MakeVar("p", {});
+    ell->Push(p, Call(op_p, {grad, rank, key_const}));
+    // The orthogonalization is invariant to the scale of P, so P is summed up without averaging.
+    auto p_sum = sum(p, "p_sum");
+    auto pq = raf::ir::MakeVar("pq", {});
+    ell->Push(pq, Call(op_q, {p_sum, shape_const, key_const}));
+    auto p_orth = raf::ir::MakeVar("p_orth", {});
+    ell->Push(p_orth, TupleGetItem(pq, 0));
+    auto q = raf::ir::MakeVar("q", {});
+    ell->Push(q, TupleGetItem(pq, 1));
+    auto q_sum = sum(q, "q_sum");
+    auto g = raf::ir::MakeVar("g", {});
+    ell->Push(g, Call(op_decompress, {p_orth, q_sum, shape_const, key_const,
+                                      MakeConstant(ScalarValue::make(MeanScale()))}));
+    return g;
+  }
+
+  /*! \brief Allgather a field of a compressed gradient along the first axis. */
+  Var AllGather(const Var& compressed, int index, const std::string& name, ExplicitLetList* ell) {
+    static Op op_allgather = Op::Get("raf.op._allgather");
+    auto field = raf::ir::MakeVar("compressed_field", {});
+    ell->Push(field, TupleGetItem(compressed, index));
+    auto out = raf::ir::MakeVar(name, {});
+    ell->Push(out, Call(op_allgather, {field, MakeConstant(ScalarValue::make(0)),
+                                       MakeConstant(NullValue<Value>())}));
+    return out;
+  }
+
+  /*! \brief The factor that turns the sum of the gradients of all ranks into their mean. */
+  double MeanScale() {
+    return 1.0 / GetGlobalCommunicator()->size;
+  }
+
  private:
   // initialized in constructor
   const FunctionNode* func;
@@ -358,6 +485,11 @@ struct DataParallel {
   const std::set<std::string> scheduled_communication_ops = {"raf.op._allreduce"};
   // The global gradient set
   std::unordered_set<Var, ObjectPtrHash, ObjectPtrEqual> global_grad;
+  // The structural hash of the function and the number of compressed gradients, which key their
+  // residuals. Recompiling a function reuses the residuals of its gradients instead of leaving
+  // them behind, while different functions do not share them.
+  size_t func_hash = tvm::StructuralHash()(GetRef<Function>(func));
+  int num_compressed = 0;
 };
 
 }  // namespace data_parallel
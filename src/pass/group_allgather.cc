@@ -28,7 +28,13 @@ class CommGrouper : public ExprMutator {
   CommGrouper(const Function& func) : func_(func) {
     auto dcfg = DistConfig::Global();
     auto comm = GetGlobalCommunicator();
-    local_rank_ = comm->local_rank;
+    // The gathered parameters live on the device of the pass, which is the GPU of the rank or CPU.
+    auto device = Device::Current(/*allow_default=*/true);
+    if (device.device_type() == DevType::kCPU()) {
+      device_ = "cpu";
+    } else {
+      device_ = "cuda(" + std::to_string(comm->local_rank) + ")";
+    }
     bucket_size_ = dcfg->group_bucket_size;
     auto ell = ExplicitLetList::make(func->body);
     auto ret = ell->exprs.back().as<TupleNode>();
@@ -101,7 +107,7 @@ class CommGrouper : public ExprMutator {
               Call(zeros_op,
                    {MakeConstant(ArrayToIntTuple(var_type->shape)),
                     MakeConstant(StringValue::make(DLDataType2String(var_type->dtype))),
-                    MakeConstant(StringValue::make("cuda(" + std::to_string(local_rank_) + ")"))}));
+                    MakeConstant(StringValue::make(device_))}));
           allgather_output = zero_input;
         } else {
           allgather_output = add_call->args[2];
@@ -282,8 +288,8 @@ class CommGrouper : public ExprMutator {
   bool cast_allgather_ = false;
   /*! \brief The return var. */
   Var ret_var_;
-  /*! \brief Local rank. */
-  int local_rank_;
+  /*! \brief The device of the gathered parameters. */
+  std::string device_;
   // ops using in this pass
   Op add_op_ = Op::Get("raf.op.add");
   Op allgather_op_ = Op::Get("raf.op._allgather");
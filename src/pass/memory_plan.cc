@@ -8,7 +8,10 @@
  * \brief Optimized allocated memory in the IR.
  */
 #include <algorithm>
+#include <map>
+#include <queue>
 #include <random>
+#include <set>
 #include <vector>
 
 #include "raf/op.h"
@@ -493,13 +496,406 @@ TensorGroups MemoryPlanner::Group() {
   return TensorGrouper(func_, analyzer_).Run();
 }
 
+/*! \brief A tensor generated by alloc_tensor, and its life-cycle in the let list. */
+struct ArenaTensor {
+  /*! \brief The let var binded to alloc_tensor. */
+  Var let_var;
+  /*! \brief The let var binded to the alloc_storage of this tensor. */
+  Var storage;
+  /*! \brief The storage size in bytes. -1 means the size is dynamic. */
+  int64_t size;
+  /*! \brief The alignment of the storage. */
+  int64_t alignment;
+  /*! \brief The device type and device ID of the storage. */
+  std::pair<int64_t, int64_t> device;
+  /*! \brief The indices of the first and the last let bindings this tensor is alive at. */
+  int begin;
+  int end;
+  /*! \brief Whether this tensor or one of its views is a final output. */
+  bool is_output = false;
+  /*! \brief Whether this tensor is the only tensor using its storage. */
+  bool own_storage = true;
+  /*! \brief The offset in the arena, or -1 if this tensor is not placed in the arena. */
+  int64_t offset = -1;
+};
+
+/*! \brief Assign offsets in an arena with the best-fit strategy. Freed ranges are coalesced
+ * with their free neighbors, and the arena grows only when no free range fits.
+ */
+class ArenaAllocator {
+ public:
+  /*! \brief Return the offset of a new range of the given size and alignment. */
+  int64_t Alloc(int64_t nbytes, int64_t alignment) {
+    // The smallest free range that can hold the aligned tensor.
+    for (auto it = gaps_by_size_.lower_bound({nbytes, 0}); it != gaps_by_size_.end(); ++it) {
+      int64_t gap_begin = it->second;
+      int64_t gap_end = it->second + it->first;
+      int64_t offset = AlignUp(gap_begin, alignment);
+      if (offset + nbytes <= gap_end) {
+        RemoveGap(gap_begin);
+        AddGap(gap_begin, offset - gap_begin);
+        AddGap(offset + nbytes, gap_end - offset - nbytes);
+        return offset;
+      }
+    }
+    // Grow the arena. A free range at the end of the arena becomes part of the new range.
+    int64_t gap_begin = size_;
+    if (!gaps_by_offset_.empty()) {
+      auto last = std::prev(gaps_by_offset_.end());
+      if (last->first + last->second == size_) {
+        gap_begin = last->first;
+        RemoveGap(gap_begin);
+      }
+    }
+    int64_t offset = AlignUp(gap_begin, alignment);
+    AddGap(gap_begin, offset - gap_begin);
+    size_ = offset + nbytes;
+    return offset;
+  }
+
+  /*! \brief Release a range allocated by Alloc. */
+  void Free(int64_t offset, int64_t nbytes) {
+    auto next = gaps_by_offset_.lower_bound(offset);
+    if (next != gaps_by_offset_.end() && next->first == offset + nbytes) {
+      nbytes += next->second;
+      RemoveGap(next->first);
+    }
+    auto prev = gaps_by_offset_.lower_bound(offset);
+    if (prev != gaps_by_offset_.begin()) {
+      --prev;
+      if (prev->first + prev->second == offset) {
+        offset = prev->first;
+        nbytes += prev->second;
+        RemoveGap(offset);
+      }
+    }
+    AddGap(offset, nbytes);
+  }
+
+  /*! \brief The total size of the arena in bytes. */
+  int64_t Size() const {
+    return size_;
+  }
+
+ private:
+  static int64_t AlignUp(int64_t offset, int64_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+  }
+
+  void AddGap(int64_t offset, int64_t nbytes) {
+    if (nbytes > 0) {
+      gaps_by_offset_[offset] = nbytes;
+      gaps_by_size_.emplace(nbytes, offset);
+    }
+  }
+
+  void RemoveGap(int64_t offset) {
+    auto it = gaps_by_offset_.find(offset);
+    CHECK(it != gaps_by_offset_.end());
+    gaps_by_size_.erase({it->second, offset});
+    gaps_by_offset_.erase(it);
+  }
+
+  /*! \brief The free ranges ordered by offset, mapping to their sizes. */
+  std::map<int64_t, int64_t> gaps_by_offset_;
+  /*! \brief The free ranges ordered by (size, offset). */
+  std::set<std::pair<int64_t, int64_t>> gaps_by_size_;
+  /*! \brief The arena size. */
+  int64_t size_ = 0;
+};
+
+/*! \brief A planner that places all statically-shaped intermediate tensors on the same device
+ * in one arena, so that only one alloc_storage is needed for them per invocation. It performs
+ * the following tasks:
+ * 1. Compute the life-cycle of each tensor generated by alloc_tensor according to the liveness
+ *    analysis. Views created by set_shape extend the life-cycle of their original tensors.
+ * 2. Assign an offset in the arena to each intermediate tensor with a static size, in the order
+ *    of their definitions, by best-fit packing the ranges of tensors that are no longer alive.
+ * 3. Mutate the first alloc_storage of each arena to allocate the arena, and remove the other
+ *    alloc_storages of the tensors in the arena.
+ * 4. Mutate alloc_tensor to use the arena with the assigned offset.
+ * 5. Insert free(%x) to free the arena and the rest storages at the end of their life-cycles.
+ * Final outputs and tensors with dynamic shapes still use their own storages. Only the top
+ * level let bindings are planned, so the complexity is O(N log N) plus the size of the live
+ * sets, where N is the number of let bindings.
+ */
+class ArenaPlanner {
+ public:
+  ArenaPlanner(const Function& func, liveness_analysis::LivenessAnalyzer* analyzer)
+      : func_(func), analyzer_(analyzer), ell_(ExplicitLetList::make(func->body)) {
+    CHECK(analyzer_->IsSuccess());
+  }
+
+  Expr Run() {
+    if (ell_->vars.empty()) {
+      return func_;
+    }
+    CollectTensors();
+    AnalyzeLifeCycles();
+    AssignOffsets();
+    return Rewrite();
+  }
+
+ private:
+  /*! \brief Arena information of a device. */
+  struct Arena {
+    /*! \brief The let var binded to the alloc_storage of the arena. */
+    Var storage;
+    /*! \brief The arena size in bytes. */
+    int64_t size = 0;
+    /*! \brief The maximum alignment of the tensors in the arena. */
+    int64_t alignment = 0;
+    /*! \brief The index of the last let binding any tensor in the arena is alive at. */
+    int end = -1;
+    /*! \brief The offset assigner of this arena. */
+    ArenaAllocator allocator;
+  };
+
+  /*! \brief Get the dummy output tensor in liveness analyzer. */
+  Var GetTensorVar(const Var& let_var) {
+    auto target_vars = analyzer_->GetTensorVars(let_var);
+    CHECK_EQ(target_vars.size(), 1U);
+    return target_vars[0];
+  }
+
+  static int64_t GetConstInt(const Expr& expr, const std::string& name) {
+    CHECK(expr.as<ConstantNode>()) << "The " << name << " of alloc_storage is not a constant";
+    auto val = expr.as<ConstantNode>()->value;
+    CHECK(val->IsInstance<IntValueObj>());
+    return val.as<IntValueObj>()->value;
+  }
+
+  /*! \brief Collect the tensors generated by alloc_tensor and their views. */
+  void CollectTensors() {
+    static const Op& alloc_storage_op = Op::Get("raf.op.vm.alloc_storage");
+    static const Op& alloc_tensor_op = Op::Get("raf.op.vm.alloc_tensor");
+    static const Op& reshape_tensor_op = Op::Get("raf.op.vm.set_shape");
+    const auto& vars = ell_->vars;
+    const auto& exprs = ell_->exprs;
+    StdMap<const CallNode*> storage_calls;
+    StdMap<int> storage_users;
+
+    for (int i = 0; i < vars.size(); ++i) {
+      const auto* call = exprs[i].as<CallNode>();
+      if (!call || !call->op.as<OpNode>()) {
+        continue;
+      }
+      auto op = Downcast<Op>(call->op);
+      if (op == alloc_storage_op) {
+        storage_calls[vars[i]] = call;
+      } else if (op == alloc_tensor_op) {
+        auto storage_var = Downcast<Var>(call->args[0]);
+        CHECK_GT(storage_calls.count(storage_var), 0U)
+            << "Expected alloc_storage as the first arg of alloc_tensor";
+        auto storage_node = storage_calls[storage_var];
+
+        ArenaTensor tensor;
+        tensor.let_var = vars[i];
+        tensor.storage = storage_var;
+        tensor.size = -1;
+        if (storage_node->args[0].as<ConstantNode>()) {
+          tensor.size = GetConstInt(storage_node->args[0], "size");
+        }
+        tensor.alignment = GetConstInt(storage_node->args[1], "alignment");
+        tensor.device = std::make_pair(GetConstInt(storage_node->args[2], "device type"),
+                                       GetConstInt(storage_node->args[3], "device id"));
+        tensor.begin = tensor.end = i;
+        storage_users[storage_var]++;
+
+        let_ids_[vars[i]] = tensors_.size();
+        tensor_ids_[GetTensorVar(vars[i])] = tensors_.size();
+        tensors_.push_back(tensor);
+      } else if (op == reshape_tensor_op) {
+        // set_shape creates a new view of the original tensor, so the original tensor has to
+        // be alive as long as the view is alive. If the original tensor is not generated by
+        // alloc_tensor (i.e., parameters), we do not need to track it.
+        auto tensor_var = Downcast<Var>(call->args[0]);
+        if (let_ids_.count(tensor_var) > 0) {
+          auto tensor_id = let_ids_[tensor_var];
+          let_ids_[vars[i]] = tensor_id;
+          tensor_ids_[GetTensorVar(vars[i])] = tensor_id;
+        }
+      }
+    }
+
+    for (auto& tensor : tensors_) {
+      tensor.own_storage = storage_users[tensor.storage] == 1;
+    }
+  }
+
+  /*! \brief Find the last let binding each tensor is alive at, and mark the final outputs. */
+  void AnalyzeLifeCycles() {
+    const auto& vars = ell_->vars;
+    for (int i = 0; i < vars.size(); ++i) {
+      for (const auto& live_var : analyzer_->GetLiveVars(vars[i])) {
+        auto it = tensor_ids_.find(live_var);
+        if (it != tensor_ids_.end()) {
+          auto& tensor = tensors_[it->second];
+          tensor.end = std::max(tensor.end, i);
+        }
+      }
+    }
+    for (const auto& out_var : analyzer_->GetOutputTensorVars()) {
+      auto it = tensor_ids_.find(out_var);
+      if (it != tensor_ids_.end()) {
+        tensors_[it->second].is_output = true;
+      }
+    }
+  }
+
+  /*! \brief Assign arena offsets in the order of tensor definitions. */
+  void AssignOffsets() {
+    // Tensors in the arena ordered by the end of their life-cycles.
+    using EndAndId = std::pair<int, size_t>;
+    std::priority_queue<EndAndId, std::vector<EndAndId>, std::greater<EndAndId>> alive;
+    for (size_t i = 0; i < tensors_.size(); ++i) {
+      auto& tensor = tensors_[i];
+      if (!tensor.own_storage || tensor.is_output || tensor.size <= 0) {
+        continue;
+      }
+      // Release the ranges of the tensors that are dead before this tensor is defined.
+      while (!alive.empty() && alive.top().first < tensor.begin) {
+        const auto& dead = tensors_[alive.top().second];
+        arenas_[dead.device].allocator.Free(dead.offset, dead.size);
+        alive.pop();
+      }
+      auto& arena = arenas_[tensor.device];
+      if (!arena.storage.defined()) {
+        // The storage of the first tensor in the arena is defined before all other tensors.
+        arena.storage = tensor.storage;
+      }
+      tensor.offset = arena.allocator.Alloc(tensor.size, tensor.alignment);
+      arena.alignment = std::max(arena.alignment, tensor.alignment);
+      arena.end = std::max(arena.end, tensor.end);
+      alive.emplace(tensor.end, i);
+    }
+    for (auto& kv : arenas_) {
+      kv.second.size = kv.second.allocator.Size();
+      arena_storages_[kv.second.storage] = &kv.second;
+      DLOG(INFO) << "Arena " << kv.second.storage->name_hint() << " on device (" << kv.first.first
+                 << ", " << kv.first.second << "), size " << kv.second.size;
+    }
+  }
+
+  /*! \brief Mutate the let list according to the planned offsets. */
+  Expr Rewrite() {
+    static const Op& alloc_storage_op = Op::Get("raf.op.vm.alloc_storage");
+    static const Op& alloc_tensor_op = Op::Get("raf.op.vm.alloc_tensor");
+    const auto& vars = ell_->vars;
+    const auto& exprs = ell_->exprs;
+    int n = vars.size();
+
+    // The storages to be freed before each let binding.
+    std::vector<std::vector<Var>> frees(n);
+    StdMap<const ArenaTensor*> storage_tensors;
+    for (const auto& tensor : tensors_) {
+      if (!tensor.own_storage) {
+        continue;
+      }
+      storage_tensors[tensor.storage] = &tensor;
+      if (tensor.offset == -1 && !tensor.is_output && tensor.end + 1 < n) {
+        frees[tensor.end + 1].push_back(tensor.storage);
+      }
+    }
+    for (const auto& kv : arenas_) {
+      if (kv.second.end + 1 < n) {
+        frees[kv.second.end + 1].push_back(kv.second.storage);
+      }
+    }
+
+    LetList scope;
+    for (int i = 0; i < n; ++i) {
+      for (const auto& storage : frees[i]) {
+        scope.Push(MakeFreeMemory(storage));
+      }
+
+      Expr value = exprs[i];
+      const auto* call = value.as<CallNode>();
+      const auto* op_node = call ? call->op.as<OpNode>() : nullptr;
+      if (op_node && GetRef<Op>(op_node) == alloc_storage_op) {
+        auto arena_it = arena_storages_.find(vars[i]);
+        auto tensor_it = storage_tensors.find(vars[i]);
+        if (arena_it != arena_storages_.end()) {
+          // Allocate the arena. It never holds a final output, so it can be allocated
+          // asynchronously.
+          Array<Expr> new_args = call->args;
+          new_args.Set(0, MakeConstant(ScalarValue::make(arena_it->second->size)));
+          new_args.Set(1, MakeConstant(ScalarValue::make(arena_it->second->alignment)));
+          if (new_args.size() == 5) {
+            new_args.push_back(MakeConstant(BoolValue::make(true)));
+          } else {
+            CHECK_EQ(new_args.size(), 6U);
+            new_args.Set(5, MakeConstant(BoolValue::make(true)));
+          }
+          value = Call(alloc_storage_op, new_args);
+        } else if (tensor_it != storage_tensors.end() && tensor_it->second->offset != -1) {
+          // The tensor of this storage is placed in the arena.
+          continue;
+        }
+      } else if (op_node && GetRef<Op>(op_node) == alloc_tensor_op) {
+        const auto& tensor = tensors_[let_ids_.at(vars[i])];
+        if (tensor.own_storage) {
+          Array<Expr> new_args = call->args;
+          auto own = MakeConstant(ScalarValue::make(tensor.is_output));
+          if (new_args.size() == 4) {
+            new_args.push_back(own);
+          } else {
+            new_args.Set(4, own);
+          }
+          if (tensor.offset != -1) {
+            new_args.Set(0, arenas_.at(tensor.device).storage);
+            auto offset = MakeConstant(ScalarValue::make(tensor.offset));
+            if (new_args.size() == 5) {
+              new_args.push_back(offset);
+            } else {
+              new_args.Set(5, offset);
+            }
+          }
+          value = Call(alloc_tensor_op, new_args);
+        }
+      }
+      scope.Push(vars[i], value);
+    }
+    auto body = scope.Get(ell_->ret);
+    return Function(func_->params, body, func_->ret_type, func_->type_params, func_->attrs,
+                    func_->span);
+  }
+
+  inline Expr MakeFreeMemory(const Var& memory_var) {
+    static const Op& op = Op::Get("raf.op.vm.free");
+    return Call(op, {memory_var});
+  }
+
+  /*! \brief The function to be optimized. */
+  const Function& func_;
+  /*! \brief The liveness analyzer, including liveness analysis results. */
+  liveness_analysis::LivenessAnalyzer* analyzer_;
+  /*! \brief The let list of the function body. */
+  std::unique_ptr<ExplicitLetList> ell_;
+  /*! \brief The tensors generated by alloc_tensor in the order of their definitions. */
+  std::vector<ArenaTensor> tensors_;
+  /*! \brief A map from the let vars of tensors and their views to the tensor index. */
+  StdMap<size_t> let_ids_;
+  /*! \brief A map from the dummy tensors of liveness analysis to the tensor index. */
+  StdMap<size_t> tensor_ids_;
+  /*! \brief The arena of each device. */
+  std::map<std::pair<int64_t, int64_t>, Arena> arenas_;
+  /*! \brief A map from the storage var of an arena to the arena. */
+  StdMap<Arena*> arena_storages_;
+};
+
 }  // namespace memory_plan
 
 TVM_REGISTER_PASS_CONFIG_OPTION("raf.memory_plan.dump_liveness_stat", Bool);
+TVM_REGISTER_PASS_CONFIG_OPTION("raf.memory_plan.policy", String);
 
 Pass MemoryPlan() {
   PassContext pass_ctx = PassContext::Current();
   Bool dump_stat = pass_ctx->GetConfig("raf.memory_plan.dump_liveness_stat", Bool(false)).value();
+  // "group": tensors with disjoint life-cycles share storages.
+  // "arena": statically-shaped intermediate tensors are placed in one arena with offsets.
+  String policy = pass_ctx->GetConfig("raf.memory_plan.policy", String("group")).value();
+  CHECK(policy == "group" || policy == "arena") << "Unknown memory plan policy " << policy;
   TypedPackedFunc<Function(Function, IRModule, PassContext)> pass_func = [=](Function f, IRModule m,
                                                                              PassContext pc) {
     auto func = f;
@@ -523,6 +919,9 @@ Pass MemoryPlan() {
       LOG(WARNING) << "Memory planning is disabled because liveness analysis was failed";
       return func;
     }
+    if (policy == "arena") {
+      return Downcast<ir::Function>(memory_plan::ArenaPlanner(func, &analyzer).Run());
+    }
     return Downcast<ir::Function>(memory_plan::MemoryPlanner(func, &analyzer).Run());
   };
   return CreateRAFFunctionPass(pass_func, 2, "MemoryPlan", {});
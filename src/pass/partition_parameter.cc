@@ -0,0 +1,185 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file partition_parameter.cc
+ * \brief ZeRO-3: Given a model after AutoDiff, InlineBackward and PartitionGradient, this pass
+ * partitions the given parameters of the function. Each rank only keeps the first-axis slice of a
+ * parameter, and the full parameter is allgathered right before it is first used in the forward
+ * and again in the backward. The gathered parameter dies after its last use in the forward (or
+ * backward), so that MemoryPlan releases it.
+ */
+#include <set>
+#include "raf/pass.h"
+
+#include "./common.h"
+#include "./let_list.h"
+
+namespace raf {
+namespace pass {
+namespace partition_parameter {
+
+class ParameterPartitioner {
+ public:
+  ParameterPartitioner(int n_part, const Array<String>& params, const Function& func)
+      : n_part_(n_part), func_(func) {
+    for (auto name : params) {
+      param_names_.insert(name);
+    }
+  }
+
+  /*! \brief Partition the parameters and insert the allgathers. */
+  Function Partition() {
+    Array<Var> func_params;
+    std::unordered_map<Var, int, ObjectPtrHash, ObjectPtrEqual> param_idx;
+    for (auto param : func_->params) {
+      if (param_names_.count(param->name_hint()) == 0) {
+        func_params.push_back(param);
+        continue;
+      }
+      param_idx[param] = params_.size();
+      params_.push_back(param);
+      shards_.push_back(MakeVar(param->name_hint(), ShardType(param)));
+      func_params.push_back(shards_.back());
+    }
+    if (params_.empty()) {  // No parameters to be partitioned.
+      return func_;
+    }
+
+    auto ell = ExplicitLetList::make(func_->body);
+    auto& vars = ell->vars;
+    auto& exprs = ell->exprs;
+
+    // Assume output is a tuple of (forward out, (grads, ...)). The bindings up to the one of the
+    // forward output belong to the forward, and the others belong to the backward.
+    auto ret = exprs.back().as<TupleNode>();
+    CHECK(ret != nullptr) << "Expected a tuple output, but got " << exprs.back()->GetTypeKey();
+    int fwd_end = -1;
+    for (size_t i = 0; i < vars.size(); ++i) {
+      if (vars[i] == ret->fields[0]) {
+        fwd_end = i;
+        break;
+      }
+    }
+    CHECK_GE(fwd_end, 0) << "Cannot find the binding of the forward output";
+
+    // Find the first use of each partitioned parameter in the forward and in the backward.
+    // A parameter used in both is gathered twice, so that it is not kept alive in between.
+    std::map<std::pair<int, int>, int> first_use;
+    for (size_t i = 0; i < exprs.size(); ++i) {
+      int segment = static_cast<int>(i) <= fwd_end ? 0 : 1;
+      for (auto var : FreeVars(exprs[i])) {
+        auto it = param_idx.find(var);
+        if (it == param_idx.end()) {
+          continue;
+        }
+        auto key = std::make_pair(it->second, segment);
+        if (first_use.count(key) == 0) {
+          first_use[key] = i;
+        }
+      }
+    }
+
+    // The allgathers are synchronous, so each one is issued right before the first use.
+    std::map<int, std::vector<std::pair<int, int>>> issue_at;
+    for (auto& kv : first_use) {
+      issue_at[kv.second].push_back(kv.first);
+    }
+
+    // Rebuild the let list with the allgathers, and let each binding use the gathered parameter
+    // of its segment.
+    std::vector<tvm::Map<Var, Var>> gathered(2);
+    std::unique_ptr<ExplicitLetList> new_ell = std::make_unique<ExplicitLetList>();
+    for (size_t i = 0; i < exprs.size(); ++i) {
+      auto it = issue_at.find(i);
+      if (it != issue_at.end()) {
+        for (auto& unit : it->second) {
+          gathered[unit.second].Set(params_[unit.first], GenAllgather(new_ell.get(), unit.first));
+        }
+      }
+      int segment = static_cast<int>(i) <= fwd_end ? 0 : 1;
+      new_ell->Push(vars[i], VarSubstitutor(gathered[segment]).Substitute(exprs[i]));
+    }
+    new_ell->ret = ell->ret;
+    return Function(func_params, new_ell->AsExpr(), {}, {}, func_->attrs);
+  }
+
+ private:
+  /*! \brief The length of the first axis of a parameter. */
+  int64_t GetDim0(const Var& param) {
+    auto ttype = param->checked_type().as<TensorTypeNode>();
+    CHECK(ttype != nullptr) << "Expected parameter " << param->name_hint()
+                            << " to be a tensor, but got " << param->checked_type();
+    CHECK(!ttype->shape.empty()) << "Cannot partition scalar parameter " << param->name_hint();
+    auto dim0 = tvm::tir::as_const_int(ttype->shape[0]);
+    if (dim0 == nullptr) {
+      LOG(FATAL) << "Do not support dynamic shape yet";
+      throw;
+    }
+    return dim0[0];
+  }
+
+  /*! \brief The type of the slice of a parameter on each rank. Like PartitionGradient, the first
+   * axis is padded to be divisible by the number of ranks. */
+  Type ShardType(const Var& param) {
+    auto ttype = param->checked_type().as<TensorTypeNode>();
+    int64_t dim0 = GetDim0(param);
+    Array<PrimExpr> shape = ttype->shape;
+    shape.Set(0, Integer((dim0 + n_part_ - 1) / n_part_));
+    return TensorType(shape, ttype->dtype);
+  }
+
+  /*!
+   * \brief Allgather the idx-th partitioned parameter. The desired IR is:
+   * let %1 = _allgather(%w, 0);
+   * let %2 = strided_slice(%1, [0], [dim0], [1]); // Only if %w was padded
+   */
+  Var GenAllgather(ExplicitLetList* ell, int idx) {
+    static const Op& allgather_op = Op::Get("raf.op._allgather");
+    static const Op& slice_op = Op::Get("raf.op.strided_slice");
+    const auto& param = params_[idx];
+    auto name = param->name_hint() + "_gathered";
+    auto gathered = MakeVar(name, {});
+    ell->Push(gathered, Call(allgather_op, {shards_[idx], MakeConstant(ScalarValue::make(0)),
+                                            MakeConstant(NullValue<Value>())}));
+    int64_t dim0 = GetDim0(param);
+    if (dim0 % n_part_ != 0) {
+      auto sliced = MakeVar(name, {});
+      ell->Push(sliced,
+                Call(slice_op, {gathered, MakeConstant(TupleValue::make({ScalarValue::make(0)})),
+                                MakeConstant(TupleValue::make({ScalarValue::make(dim0)})),
+                                MakeConstant(TupleValue::make({ScalarValue::make(1)}))}));
+      gathered = sliced;
+    }
+    return gathered;
+  }
+
+  /*! \brief The number of partitions. */
+  int n_part_;
+  /*! \brief The target function. */
+  Function func_;
+  /*! \brief The names of the parameters to be partitioned. */
+  std::set<std::string> param_names_;
+  /*! \brief The parameters to be partitioned. */
+  std::vector<Var> params_;
+  /*! \brief The partitioned parameters that replace params_ in the function signature. */
+  std::vector<Var> shards_;
+};
+
+}  // namespace partition_parameter
+
+Pass PartitionParameter(int n_part, Array<String> params) {
+  TypedPackedFunc<Function(Function, IRModule, PassContext)> pass_func = [=](Function f, IRModule m,
+                                                                             PassContext pc) {
+    return partition_parameter::ParameterPartitioner(n_part, params, f).Partition();
+  };
+  auto partition_parameter = CreateRAFFunctionPass(pass_func, 0, "PartitionParameterFunc", {});
+  return RAFSequential({InferType(), partition_parameter, InferType()}, "PartitionParameter");
+}
+
+RAF_REGISTER_GLOBAL("raf.pass_.PartitionParameter").set_body_typed(PartitionParameter);
+
+}  // namespace pass
+}  // namespace raf
@@ -0,0 +1,320 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file pipeline_stage.cc
+ * \brief Pipeline parallelism. PipelineStage cuts the function into the given number of stages
+ * with PartitionANFByCost, and keeps one stage as the function. The inputs of the stage are the
+ * tensors received from the previous stage followed by the parameters of the original function
+ * used by the stage, and the number of the received tensors is recorded in the
+ * "PipelineInputs" attribute. A stage other than the last one outputs a tuple of the tensors to
+ * be sent to the next stage. e.g., with 2 stages,
+ * fn(%x, %w1, %w2) {
+ *   let %a1 = raf.op.matmul(%x, %w1);
+ *   let %a2 = raf.op.relu(%a1);
+ *   let %a3 = raf.op.matmul(%a2, %w2);
+ *   %a3
+ * }
+ * Stage 0:
+ * fn(%x, %w1) {
+ *   let %a1 = raf.op.matmul(%x, %w1);
+ *   let %a2 = raf.op.relu(%a1);
+ *   let %pipeline_outs = (%a2,);
+ *   %pipeline_outs
+ * }
+ * Stage 1:
+ * fn(%a2, %w2, PipelineInputs=1) {
+ *   let %a3 = raf.op.matmul(%a2, %w2);
+ *   %a3
+ * }
+ *
+ * SplitForwardBackward splits a stage after AutoDiff and InlineBackward, i.e.,
+ * fn(%params..., %dy) -> (%y, %grads), into the forward fn(%params...) -> (%y, %stash...) and the
+ * backward fn(%stash..., %dy, %params...) -> %grads, where the stash is the activations produced
+ * by the forward and used by the backward. In this way, the forward of a micro-batch can be
+ * executed as soon as its inputs arrive, and only its stash is kept until its backward.
+ */
+#include <algorithm>
+#include <set>
+#include <unordered_set>
+#include "raf/pass.h"
+
+#include "./common.h"
+#include "./let_list.h"
+
+namespace raf {
+namespace pass {
+namespace pipeline_stage {
+
+class StageExtractor {
+ public:
+  StageExtractor(int num_stages, int stage, const Function& func)
+      : num_stages_(num_stages), stage_(stage), func_(func) {
+  }
+
+  Function Run() {
+    CHECK(stage_ >= 0 && stage_ < num_stages_)
+        << "Stage " << stage_ << " is out of range [0, " << num_stages_ << ")";
+    Flatten();
+    CHECK_EQ(num_partitions_, num_stages_)
+        << "The model is cut into " << num_partitions_ << " partitions instead of " << num_stages_
+        << " stages, it may have too few ops to be pipelined";
+
+    // A var is live-in of a stage if it is defined by an earlier stage and used by this stage or
+    // a later one, because the stages in between have to pass it along.
+    std::unordered_map<const VarNode*, size_t> def_index;
+    for (size_t i = 0; i < vars_.size(); ++i) {
+      def_index[vars_[i].get()] = i;
+    }
+    std::vector<std::set<size_t>> live_in(num_stages_ + 1);
+    auto add_uses = [&](const Expr& expr, int stage) {
+      for (auto var : FreeVars(expr)) {
+        auto it = def_index.find(var.get());
+        if (it == def_index.end()) {
+          continue;
+        }
+        for (int s = stages_[it->second] + 1; s <= stage; ++s) {
+          live_in[s].insert(it->second);
+        }
+      }
+    };
+    for (size_t i = 0; i < vars_.size(); ++i) {
+      add_uses(exprs_[i], stages_[i]);
+    }
+    add_uses(ret_, num_stages_ - 1);
+
+    // The received tensors followed by the used parameters of the original function.
+    Array<Var> params;
+    Map<Var, Var> recv_map;
+    for (auto idx : live_in[stage_]) {
+      const auto& var = vars_[idx];
+      CHECK(var->checked_type().as<TensorTypeNode>())
+          << "Expected the tensor " << var->name_hint() << " to cross the pipeline stages, but got "
+          << var->checked_type();
+      auto param = MakeVar(var->name_hint(), var->checked_type());
+      recv_map.Set(var, param);
+      params.push_back(param);
+    }
+    int num_inputs = params.size();
+    bool is_last = stage_ == num_stages_ - 1;
+    std::unordered_set<const VarNode*> used;
+    for (size_t i = 0; i < vars_.size(); ++i) {
+      if (stages_[i] == stage_) {
+        for (auto var : FreeVars(exprs_[i])) {
+          used.insert(var.get());
+        }
+      }
+    }
+    if (is_last) {
+      used.insert(ret_.get());
+    }
+    for (auto param : func_->params) {
+      if (used.count(param.get())) {
+        params.push_back(param);
+      }
+    }
+
+    VarSubstitutor substitutor(recv_map);
+    ExplicitLetList ell;
+    for (size_t i = 0; i < vars_.size(); ++i) {
+      if (stages_[i] == stage_) {
+        ell.Push(vars_[i], substitutor.Substitute(exprs_[i]));
+      }
+    }
+    if (is_last) {
+      ell.ret = Downcast<Var>(substitutor.Substitute(ret_));
+    } else {
+      Array<Expr> outs;
+      for (auto idx : live_in[stage_ + 1]) {
+        outs.push_back(substitutor.Substitute(vars_[idx]));
+      }
+      ell.ret = MakeVar("pipeline_outs", {});
+      ell.Push(ell.ret, Tuple(outs));
+    }
+    auto func = Function(params, ell.AsExpr(), {}, {});
+    return WithAttr(std::move(func), attr::kPipelineInputs, Integer(num_inputs));
+  }
+
+ private:
+  /*!
+   * \brief Inline the partition functions created by PartitionANFByCost, and record the
+   * partition (i.e., stage) of each binding. The bindings after the last partition, which only
+   * combine the outputs, belong to the last stage.
+   */
+  void Flatten() {
+    auto ell = ExplicitLetList::make(func_->body);
+    std::unordered_map<const VarNode*, Var> closure_rets;
+    Map<Var, Var> subst;
+    for (size_t i = 0; i < ell->vars.size(); ++i) {
+      const auto& var = ell->vars[i];
+      const auto& expr = ell->exprs[i];
+      if (auto fn = expr.as<FunctionNode>()) {
+        auto inner = ExplicitLetList::make(fn->body);
+        for (size_t j = 0; j < inner->vars.size(); ++j) {
+          Push(inner->vars[j], inner->exprs[j], num_partitions_, subst);
+        }
+        closure_rets[var.get()] = inner->ret;
+        num_partitions_++;
+        continue;
+      }
+      if (auto call = expr.as<CallNode>()) {
+        auto it = closure_rets.find(call->op.as<VarNode>());
+        if (it != closure_rets.end()) {
+          subst.Set(var, it->second);
+          continue;
+        }
+      }
+      if (auto tgi = expr.as<TupleGetItemNode>()) {
+        auto tuple_var = tgi->tuple.as<VarNode>();
+        if (tuple_var && subst.count(GetRef<Var>(tuple_var))) {
+          auto outs = values_.find(subst[GetRef<Var>(tuple_var)].get());
+          if (outs != values_.end() && outs->second.as<TupleNode>()) {
+            subst.Set(var, Downcast<Var>(Downcast<Tuple>(outs->second)->fields[tgi->index]));
+            continue;
+          }
+        }
+      }
+      Push(var, expr, std::max(num_partitions_ - 1, 0), subst);
+    }
+    ret_ = Downcast<Var>(VarSubstitutor(subst).Substitute(ell->ret));
+  }
+
+  void Push(const Var& var, const Expr& expr, int stage, const Map<Var, Var>& subst) {
+    vars_.push_back(var);
+    exprs_.push_back(VarSubstitutor(subst).Substitute(expr));
+    stages_.push_back(stage);
+    values_[var.get()] = expr;
+  }
+
+  /*! \brief The number of stages. */
+  int num_stages_;
+  /*! \brief The stage to be extracted. */
+  int stage_;
+  /*! \brief The partitioned function. */
+  Function func_;
+  /*! \brief The number of partition functions. */
+  int num_partitions_ = 0;
+  /*! \brief The flattened bindings and their stages. */
+  std::vector<Var> vars_;
+  std::vector<Expr> exprs_;
+  std::vector<int> stages_;
+  /*! \brief Mapping from a var to its bound value before substitution. */
+  std::unordered_map<const VarNode*, Expr> values_;
+  /*! \brief The output of the flattened function. */
+  Var ret_;
+};
+
+Array<Function> SplitForwardBackward(const Function& func) {
+  CHECK(!func->params.empty()) << "Expected a function with dy as its last parameter";
+  auto ell = ExplicitLetList::make(func->body);
+  auto& vars = ell->vars;
+  auto& exprs = ell->exprs;
+  auto ret = exprs.back().as<TupleNode>();
+  CHECK(ret != nullptr && ret->fields.size() == 2 && vars.back() == ell->ret)
+      << "Expected a function after InlineBackward, which outputs (y, grads)";
+  Expr y = ret->fields[0];
+  Expr grads = ret->fields[1];
+  size_t n = vars.size() - 1;
+
+  // The forward is the bindings that y depends on, and the others belong to the backward.
+  std::unordered_map<const VarNode*, size_t> def_index;
+  for (size_t i = 0; i < n; ++i) {
+    def_index[vars[i].get()] = i;
+  }
+  std::vector<bool> is_fwd(n, false);
+  std::unordered_set<const VarNode*> needed;
+  for (auto var : FreeVars(y)) {
+    needed.insert(var.get());
+  }
+  for (int i = static_cast<int>(n) - 1; i >= 0; --i) {
+    if (needed.count(vars[i].get())) {
+      is_fwd[i] = true;
+      for (auto var : FreeVars(exprs[i])) {
+        needed.insert(var.get());
+      }
+    }
+  }
+
+  // The forward vars used by the backward are stashed.
+  std::set<size_t> stash_index;
+  auto collect = [&](const Expr& expr) {
+    for (auto var : FreeVars(expr)) {
+      auto it = def_index.find(var.get());
+      if (it != def_index.end() && is_fwd[it->second]) {
+        stash_index.insert(it->second);
+      }
+    }
+  };
+  for (size_t i = 0; i < n; ++i) {
+    if (!is_fwd[i]) {
+      collect(exprs[i]);
+    }
+  }
+  collect(grads);
+
+  Array<Var> params;
+  for (size_t i = 0; i + 1 < func->params.size(); ++i) {
+    params.push_back(func->params[i]);
+  }
+  Var dy = func->params.back();
+  ExplicitLetList fwd_ell;
+  Array<Expr> fwd_outs{y};
+  for (size_t i = 0; i < n; ++i) {
+    if (is_fwd[i]) {
+      fwd_ell.Push(vars[i], exprs[i]);
+    }
+  }
+  Array<Var> bwd_params;
+  Map<Var, Var> stash_map;
+  for (auto idx : stash_index) {
+    fwd_outs.push_back(vars[idx]);
+    auto param = MakeVar(vars[idx]->name_hint(), vars[idx]->checked_type());
+    stash_map.Set(vars[idx], param);
+    bwd_params.push_back(param);
+  }
+  fwd_ell.ret = MakeVar("fwd_outs", {});
+  fwd_ell.Push(fwd_ell.ret, Tuple(fwd_outs));
+
+  bwd_params.push_back(dy);
+  for (auto param : params) {
+    bwd_params.push_back(param);
+  }
+  VarSubstitutor substitutor(stash_map);
+  ExplicitLetList bwd_ell;
+  for (size_t i = 0; i < n; ++i) {
+    if (!is_fwd[i]) {
+      bwd_ell.Push(vars[i], substitutor.Substitute(exprs[i]));
+    }
+  }
+  auto bwd_ret = substitutor.Substitute(grads);
+  if (bwd_ret.as<VarNode>()) {
+    bwd_ell.ret = Downcast<Var>(bwd_ret);
+  } else {
+    bwd_ell.ret = MakeVar("gradient", {});
+    bwd_ell.Push(bwd_ell.ret, bwd_ret);
+  }
+  return {Function(params, fwd_ell.AsExpr(), {}, {}),
+          Function(bwd_params, bwd_ell.AsExpr(), {}, {})};
+}
+
+}  // namespace pipeline_stage
+
+Pass PipelineStage(int num_stages, int stage, bool use_profiler) {
+  TypedPackedFunc<Function(Function, IRModule, PassContext)> pass_func = [=](Function f, IRModule m,
+                                                                             PassContext pc) {
+    return pipeline_stage::StageExtractor(num_stages, stage, f).Run();
+  };
+  auto extract = CreateRAFFunctionPass(pass_func, 0, "PipelineStageFunc", {});
+  return RAFSequential({PartitionANFByCost(num_stages, use_profiler), InferType(), extract,
+                        InferType(), DeadCodeElimination()},
+                       "PipelineStage");
+}
+
+RAF_REGISTER_GLOBAL("raf.pass_.PipelineStage").set_body_typed(PipelineStage);
+RAF_REGISTER_GLOBAL("raf.pass_.SplitForwardBackward")
+    .set_body_typed(pipeline_stage::SplitForwardBackward);
+
+}  // namespace pass
+}  // namespace raf
@@ -0,0 +1,715 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file sharding_propagation.cc
+ * \brief Tensor parallelism: Given the sharding specifications of some parameters, this pass
+ * propagates the sharding through the function with per-op sharding rules, rewrites the function
+ * to compute the local shards of the ranks, and inserts the collectives that keep the shards
+ * consistent. When an op can be computed in several ways (e.g., a matmul with a row-sharded and a
+ * column-sharded operand), the way that needs the cheapest resharding of its inputs under an
+ * alpha-beta communication cost model is chosen.
+ *
+ * Only 1-D device meshes are supported: a tensor is either replicated, sharded along one axis
+ * over all ranks, or a partial sum that is pending an allreduce or a reduce-scatter.
+ */
+#include <algorithm>
+#include <limits>
+#include <set>
+#include "raf/communicator.h"
+#include "raf/op_utils.h"
+#include "raf/pass.h"
+#include "raf/sharding.h"
+
+#include "./common.h"
+#include "./let_list.h"
+#include "../common/shape_utils.h"
+
+namespace raf {
+namespace pass {
+namespace sharding_propagation {
+
+using namespace raf::sharding;
+using namespace raf::distributed::communicator;
+
+/*! \brief The sharding state of a tensor on a 1-D device mesh. */
+struct ShardState {
+  enum Kind { kReplicated, kShard, kPartial };
+  Kind kind;
+  /*! \brief The sharded axis of kShard. */
+  int axis;
+
+  static ShardState Replicated() {
+    return {kReplicated, -1};
+  }
+  static ShardState Shard(int axis) {
+    return {kShard, axis};
+  }
+  static ShardState Partial() {
+    return {kPartial, -1};
+  }
+
+  bool operator==(const ShardState& other) const {
+    return kind == other.kind && axis == other.axis;
+  }
+  bool operator!=(const ShardState& other) const {
+    return !(*this == other);
+  }
+};
+
+/*! \brief A way to compute an op: the states its tensor arguments need and the output state. */
+struct Candidate {
+  std::vector<ShardState> inputs;
+  ShardState output;
+};
+
+/*! \brief The alpha-beta model of the ring collectives, in the same units as the CPU planner. */
+constexpr double kAlpha = 10e-6;
+constexpr double kBeta = 1.0 / 5e9;
+constexpr double kInf = std::numeric_limits<double>::infinity();
+
+static const std::set<std::string> kUnaryOps = {
+    "atan", "negative", "logical_not", "relu",  "gelu",  "tanh",  "copy",       "abs",
+    "ceil", "cos",      "sin",         "sign",  "round", "floor", "log",        "log2",
+    "exp",  "sigmoid",  "erf",         "sqrt",  "rsqrt", "trunc", "reciprocal", "cast",
+    "zeros_like", "ones_like"};
+/*!
+ * \brief The unary ops that are linear, so that they can be applied to a partial sum. cast is not,
+ * since the rounding of the partial sums differs from that of the full sum.
+ */
+static const std::set<std::string> kLinearUnaryOps = {"negative", "copy"};
+static const std::set<std::string> kBinaryOps = {
+    "add",           "subtract",   "multiply",  "divide",      "floor_divide", "power",
+    "mod",           "less",       "greater",   "less_equal",  "greater_equal", "equal",
+    "not_equal",     "maximum",    "minimum",   "logical_and", "logical_or",   "logical_xor"};
+static const std::set<std::string> kReduceOps = {"sum", "mean", "max", "min", "prod", "all", "any"};
+
+class ShardingPropagator {
+ public:
+  ShardingPropagator(const Map<String, BaseShardSpec>& specs, const Function& func)
+      : func_(func) {
+    auto comm = GetGlobalCommunicator();
+    n_ = comm->size;
+    rank_ = comm->rank;
+    for (auto kv : specs) {
+      specs_[kv.first] = kv.second;
+    }
+  }
+
+  /*! \brief Propagate the sharding and rewrite the function to compute the local shards. */
+  Function Run() {
+    Array<Var> params;
+    for (auto param : func_->params) {
+      auto new_param = param;
+      auto it = specs_.find(param->name_hint());
+      if (it != specs_.end()) {
+        auto ttype = GetTensorType(param);
+        CHECK(ttype != nullptr) << "Cannot shard non-tensor parameter " << param->name_hint();
+        auto state = ParseSpec(param->name_hint(), it->second, ttype->shape.size());
+        CHECK(IsValid(state, ttype)) << "Cannot shard " << param->name_hint() << " of shape "
+                                     << ttype->shape << " to " << n_ << " ranks evenly";
+        new_param = MakeVar(param->name_hint(), LocalType(ttype, state));
+        states_[new_param] = state;
+        auto spec = it->second.as<ShardSpecObj>();
+        if (spec != nullptr && !spec->mutable_) {
+          immutable_.insert(new_param);
+        }
+      }
+      global_types_[new_param] = param->checked_type();
+      vmap_.Set(param, new_param);
+      params.push_back(new_param);
+    }
+
+    auto ell = ExplicitLetList::make(func_->body);
+    new_ell_ = std::make_unique<ExplicitLetList>();
+    for (size_t i = 0; i < ell->vars.size(); ++i) {
+      auto var = MakeVar(ell->vars[i]->name_hint(), {});
+      global_types_[var] = ell->vars[i]->checked_type();
+      auto call = ell->exprs[i].as<CallNode>();
+      if (call != nullptr && call->op.as<OpNode>() != nullptr) {
+        VisitCall(var, GetRef<Call>(call));
+      } else {
+        VisitOther(var, ell->exprs[i]);
+      }
+      vmap_.Set(ell->vars[i], var);
+    }
+    // The function returns the full tensors, so that the callers are unaware of the sharding.
+    new_ell_->ret = ToReplicated(ell->ret);
+    return Function(params, new_ell_->AsExpr(), {}, {}, func_->attrs);
+  }
+
+ private:
+  /*! \brief Map a sharding specification to a state on the 1-D mesh of all ranks. */
+  ShardState ParseSpec(const std::string& name, const BaseShardSpec& base, size_t ndim) {
+    auto spec = base.as<ShardSpecObj>();
+    if (spec == nullptr) {  // Unset: leave it to the propagation, which starts from replicated.
+      return ShardState::Replicated();
+    }
+    // The collectives run on the global communicator, so the mesh must be all of its ranks.
+    CHECK_EQ(static_cast<int64_t>(spec->ranks.size()), n_)
+        << "The spec of " << name << " must cover all the " << n_ << " ranks";
+    for (int64_t i = 0; i < n_; ++i) {
+      CHECK_EQ(spec->ranks[i]->value, i)
+          << "The spec of " << name << " must use ranks [0, " << n_ << ")";
+    }
+    CHECK_EQ(spec->ndim_, static_cast<int64_t>(ndim))
+        << "The spec of " << name << " has " << spec->ndim_ << " dimensions, but the tensor has "
+        << ndim;
+    if (spec->nshard_ == 1) {
+      return ShardState::Replicated();
+    }
+    int axis = -1;
+    for (size_t i = 0; i < ndim; ++i) {
+      if (spec->logic_shape[i]->value == 1) {
+        continue;
+      }
+      if (axis != -1 || spec->ngroup_ != 1) {
+        LOG(FATAL) << "Only support sharding along one axis over all ranks, but the spec of "
+                   << name << " has physical shape " << spec->phy_shape << " and subgroup shape "
+                   << spec->subgroup_shape;
+        throw;
+      }
+      axis = i;
+    }
+    return ShardState::Shard(axis);
+  }
+
+  /*! \brief Decide how to compute a call, reshard its arguments, and compute it locally. */
+  void VisitCall(const Var& var, const Call& call) {
+    Array<Expr> args;
+    for (size_t i = 0; i < call->args.size(); ++i) {
+      auto arg = call->args[i];
+      if (auto v = arg.as<VarNode>()) {
+        arg = vmap_.at(GetRef<Var>(v));
+      }
+      args.push_back(arg);
+    }
+
+    std::string name = call->op.as<OpNode>()->name;
+    const std::string prefix = "raf.op.";
+    if (name.compare(0, prefix.size(), prefix) == 0) {
+      name = name.substr(prefix.size());
+    }
+    auto out_type = GetTensorType(var);
+    std::vector<int> operands;
+    std::vector<Candidate> candidates;
+    if (out_type != nullptr) {
+      candidates = GetCandidates(name, args, out_type, &operands);
+    }
+
+    // The fallback computes the op with the full tensors.
+    const Candidate* best = nullptr;
+    double best_cost = kInf;
+    int best_convs = 0;
+    for (const auto& cand : candidates) {
+      if (!IsValid(cand.output, out_type)) {
+        continue;
+      }
+      double cost = 0;
+      int convs = 0;
+      for (size_t i = 0; i < operands.size() && cost < kInf; ++i) {
+        if (!IsValid(cand.inputs[i], GetTensorType(args[operands[i]]))) {
+          cost = kInf;
+          break;
+        }
+        auto state = GetState(args[operands[i]]);
+        if (state != cand.inputs[i]) {
+          cost += ConvertCost(args[operands[i]], state, cand.inputs[i]);
+          convs++;
+        }
+      }
+      if (cost < best_cost || (cost == best_cost && best != nullptr && convs < best_convs)) {
+        best = &cand;
+        best_cost = cost;
+        best_convs = convs;
+      }
+    }
+
+    if (best == nullptr) {
+      for (size_t i = 0; i < args.size(); ++i) {
+        args.Set(i, ToReplicated(args[i]));
+      }
+      new_ell_->Push(var, Call(call->op, args, call->attrs));
+      return;
+    }
+    for (size_t i = 0; i < operands.size(); ++i) {
+      args.Set(operands[i], Convert(Downcast<Var>(args[operands[i]]), best->inputs[i]));
+    }
+    new_ell_->Push(var, Call(call->op, args, call->attrs));
+    if (best->output != ShardState::Replicated()) {
+      states_[var] = best->output;
+    }
+  }
+
+  /*! \brief Tuples, projections and the others work on the full tensors. */
+  void VisitOther(const Var& var, const Expr& expr) {
+    Map<Var, Var> vmap;
+    for (auto v : FreeVars(expr)) {
+      auto it = vmap_.find(v);
+      if (it != vmap_.end()) {
+        auto local = (*it).second;
+        vmap.Set(v, Downcast<Var>(ToReplicated(local)));
+      }
+    }
+    new_ell_->Push(var, VarSubstitutor(vmap).Substitute(expr));
+  }
+
+  /*!
+   * \brief The candidate ways to compute an op. operands is set to the indices of the tensor
+   * arguments that the candidates constrain; the other arguments are left as they are.
+   */
+  std::vector<Candidate> GetCandidates(const std::string& name, const Array<Expr>& args,
+                                       const TensorTypeNode* out_type, std::vector<int>* operands) {
+    std::vector<Candidate> cands;
+    auto R = ShardState::Replicated();
+    auto S = ShardState::Shard;
+    auto P = ShardState::Partial();
+
+    static const std::unordered_map<std::string, std::pair<bool, bool>> matmuls = {
+        {"matmul", {false, false}},       {"matmul_nt", {false, true}},
+        {"matmul_tn", {true, false}},     {"matmul_tt", {true, true}},
+        {"dense", {false, true}},         {"batch_matmul", {false, false}},
+        {"batch_matmul_nt", {false, true}}, {"batch_matmul_tn", {true, false}},
+        {"batch_matmul_tt", {true, true}}};
+    auto mm = matmuls.find(name);
+    if (mm != matmuls.end()) {
+      if (!IsVar(args[0]) || !IsVar(args[1])) {
+        return {};
+      }
+      *operands = {0, 1};
+      int off = name.compare(0, 5, "batch") == 0 ? 1 : 0;
+      bool ta = mm->second.first, tb = mm->second.second;
+      int a_row = off + (ta ? 1 : 0), a_k = off + (ta ? 0 : 1);
+      int b_k = off + (tb ? 1 : 0), b_col = off + (tb ? 0 : 1);
+      cands.push_back({{R, R}, R});
+      cands.push_back({{S(a_row), R}, S(off)});
+      cands.push_back({{R, S(b_col)}, S(off + 1)});
+      cands.push_back({{S(a_k), S(b_k)}, P});
+      if (off == 1) {
+        cands.push_back({{S(0), S(0)}, S(0)});
+      }
+      return cands;
+    }
+
+    if (kUnaryOps.count(name)) {
+      auto ttype = GetTensorType(args[0]);
+      if (!IsVar(args[0]) || ttype == nullptr) {
+        return {};
+      }
+      *operands = {0};
+      cands.push_back({{R}, R});
+      for (size_t d = 0; d < ttype->shape.size(); ++d) {
+        cands.push_back({{S(d)}, S(d)});
+      }
+      if (kLinearUnaryOps.count(name)) {
+        cands.push_back({{P}, P});
+      }
+      return cands;
+    }
+
+    if (kBinaryOps.count(name)) {
+      // Only the first two arguments are operands. The others (e.g., out and where of add) are
+      // left as they are.
+      int out_ndim = out_type->shape.size();
+      for (int i = 0; i < 2; ++i) {
+        if (IsVar(args[i])) {
+          operands->push_back(i);
+        }
+      }
+      // The state of an operand when the output is sharded along the given axis. Broadcast axes
+      // are replicated. A constant operand can only be replicated.
+      auto align = [&](int i, int axis, ShardState* state) {
+        auto ttype = GetTensorType(args[i]);
+        int ndim = ttype != nullptr ? ttype->shape.size() : 0;
+        int d = axis - (out_ndim - ndim);
+        auto dim = d >= 0 ? tvm::tir::as_const_int(ttype->shape[d]) : nullptr;
+        *state = (dim == nullptr || *dim == 1) ? R : S(d);
+        return IsVar(args[i]) || *state == R;
+      };
+      for (int axis = -1; axis < out_ndim; ++axis) {
+        Candidate cand{{}, axis == -1 ? R : S(axis)};
+        bool ok = true;
+        for (int i = 0; i < 2 && ok; ++i) {
+          ShardState state = R;
+          ok = axis == -1 || align(i, axis, &state);
+          if (IsVar(args[i])) {
+            cand.inputs.push_back(state);
+          }
+        }
+        if (ok) {
+          cands.push_back(cand);
+        }
+      }
+      // Partial sums are closed under addition, and under scaling by a replicated operand.
+      if (operands->size() == 2 && (name == "add" || name == "subtract")) {
+        cands.push_back({{P, P}, P});
+      }
+      if (name == "multiply" || name == "divide") {
+        for (int i = 0; i < (name == "multiply" ? 2 : 1); ++i) {
+          if (!IsVar(args[i])) {
+            continue;
+          }
+          Candidate cand{{}, P};
+          for (int j : *operands) {
+            cand.inputs.push_back(j == i ? P : R);
+          }
+          cands.push_back(cand);
+        }
+      }
+      return cands;
+    }
+
+    if (kReduceOps.count(name)) {
+      auto ttype = GetTensorType(args[0]);
+      auto axis = args[1].as<ConstantNode>();
+      auto exclude = args.size() > 3 ? args[3].as<ConstantNode>() : nullptr;
+      if (!IsVar(args[0]) || ttype == nullptr || axis == nullptr) {
+        return {};
+      }
+      int ndim = ttype->shape.size();
+      std::vector<bool> reduced(ndim, false);
+      auto axes = axis->value.defined() ? GetShapeVecFromValue(Downcast<Value>(axis->value))
+                                        : std::vector<int64_t>();
+      for (auto a : axes) {
+        reduced[(a + ndim) % ndim] = true;
+      }
+      if (axes.empty()) {
+        reduced.assign(ndim, true);
+      }
+      if (exclude != nullptr && exclude->value.defined() &&
+          GetScalarValueData<bool>(Downcast<Value>(exclude->value))) {
+        reduced.flip();
+      }
+      // The output keeps the reduced axes iff it has as many dimensions as the input.
+      bool keepdims = static_cast<int>(out_type->shape.size()) == ndim;
+      *operands = {0};
+      cands.push_back({{R}, R});
+      for (int d = 0; d < ndim; ++d) {
+        if (!reduced[d]) {
+          int before = std::count(reduced.begin(), reduced.begin() + d, true);
+          cands.push_back({{S(d)}, S(keepdims ? d : d - before)});
+        } else if (name == "sum") {
+          cands.push_back({{S(d)}, P});
+        }
+      }
+      if (name == "sum" || name == "mean") {
+        cands.push_back({{P}, P});
+      }
+      return cands;
+    }
+
+    if (name == "softmax" || name == "log_softmax" || name == "layer_norm") {
+      auto ttype = GetTensorType(args[0]);
+      int axis_idx = name == "layer_norm" ? 3 : 1;
+      auto axis = static_cast<int>(args.size()) > axis_idx
+                      ? args[axis_idx].as<ConstantNode>()
+                      : nullptr;
+      if (!IsVar(args[0]) || ttype == nullptr || axis == nullptr || !axis->value.defined()) {
+        return {};
+      }
+      int ndim = ttype->shape.size();
+      int64_t norm_axis = GetScalarValueData<int64_t>(Downcast<Value>(axis->value));
+      norm_axis = (norm_axis + ndim) % ndim;
+      std::vector<ShardState> rest;
+      if (name == "layer_norm") {
+        // The scale and the bias are along the normalized axis, so they are replicated.
+        for (int i = 1; i < 3; ++i) {
+          if (IsVar(args[i])) {
+            operands->push_back(i);
+            rest.push_back(R);
+          }
+        }
+      }
+      operands->insert(operands->begin(), 0);
+      std::vector<ShardState> inputs = {R};
+      inputs.insert(inputs.end(), rest.begin(), rest.end());
+      cands.push_back({inputs, R});
+      for (int d = 0; d < ndim; ++d) {
+        if (d != norm_axis) {
+          inputs[0] = S(d);
+          cands.push_back({inputs, S(d)});
+        }
+      }
+      return cands;
+    }
+    return {};
+  }
+
+  /*! \brief The cost to convert a tensor from one state to another. */
+  double ConvertCost(const Expr& expr, const ShardState& from, const ShardState& to) {
+    if (!IsVar(expr) || immutable_.count(Downcast<Var>(expr))) {
+      return kInf;
+    }
+    auto ttype = GetTensorType(expr);
+    double bytes = common::shape_utils::BytesCompactTensor(ttype);
+    double n = n_;
+    if (from.kind == ShardState::kReplicated && to.kind == ShardState::kShard) {
+      return 0;  // Local slicing.
+    }
+    if (from.kind == ShardState::kShard && to.kind == ShardState::kReplicated) {
+      return (n - 1) * kAlpha + (n - 1) / n * bytes * kBeta;  // Allgather.
+    }
+    if (from.kind == ShardState::kPartial && to.kind == ShardState::kReplicated) {
+      return 2 * (n - 1) * kAlpha + 2 * (n - 1) / n * bytes * kBeta;  // Allreduce.
+    }
+    if (from.kind == ShardState::kPartial && to.kind == ShardState::kShard) {
+      return (n - 1) * kAlpha + (n - 1) / n * bytes * kBeta;  // Reduce-scatter.
+    }
+    if (from.kind == ShardState::kShard && to.kind == ShardState::kShard) {
+      return (n - 1) * kAlpha + (n - 1) / (n * n) * bytes * kBeta;  // All-to-all.
+    }
+    return kInf;
+  }
+
+  /*! \brief Convert a tensor to the given state. The converted tensors are memoized. */
+  Var Convert(const Var& var, const ShardState& to) {
+    auto from = GetState(var);
+    if (from == to) {
+      return var;
+    }
+    CHECK(!immutable_.count(var)) << "Cannot reshard " << var->name_hint()
+                                   << ", whose sharding specification is immutable";
+    auto& memo = converted_[var];
+    for (auto& kv : memo) {
+      if (kv.first == to) {
+        return kv.second;
+      }
+    }
+    static const Op& allgather_op = Op::Get("raf.op._allgather");
+    static const Op& allreduce_op = Op::Get("raf.op._allreduce");
+    static const Op& reduce_scatter_op = Op::Get("raf.op._reduce_scatter");
+    static const Op& all_to_all_op = Op::Get("raf.op._all_to_all");
+    static const Op& slice_op = Op::Get("raf.op.strided_slice");
+    static const Op& reshape_op = Op::Get("raf.op.reshape");
+    auto ttype = GetTensorType(var);
+    auto shape = GetShape(ttype);
+    int ndim = shape.size();
+    auto null = MakeConstant(NullValue<Value>());
+    auto sum = MakeConstant(StringValue::make("sum"));
+    auto name = var->name_hint();
+    Var out;
+
+    if (from.kind == ShardState::kReplicated && to.kind == ShardState::kShard) {
+      // Every rank keeps its own slice.
+      Array<Value> begin, end, strides;
+      for (int d = 0; d < ndim; ++d) {
+        int64_t chunk = shape[d] / n_;
+        begin.push_back(ScalarValue::make(d == to.axis ? rank_ * chunk : 0));
+        end.push_back(ScalarValue::make(d == to.axis ? (rank_ + 1) * chunk : shape[d]));
+        strides.push_back(ScalarValue::make(1));
+      }
+      out = Push(name + "_slice", Call(slice_op, {var, MakeConstant(TupleValue::make(begin)),
+                                                  MakeConstant(TupleValue::make(end)),
+                                                  MakeConstant(TupleValue::make(strides))}));
+    } else if (from.kind == ShardState::kShard && to.kind == ShardState::kReplicated) {
+      // The collectives work on the first axis, so the sharded axis is moved to the front.
+      auto perm = MoveToFront(ndim, from.axis);
+      auto front = Transpose(var, perm);
+      auto axis = MakeConstant(ScalarValue::make(0));
+      auto gathered = Push(name + "_gathered", Call(allgather_op, {front, axis, null}));
+      out = Transpose(gathered, Inverse(perm));
+    } else if (from.kind == ShardState::kPartial && to.kind == ShardState::kReplicated) {
+      auto tuple = Push(name + "_tuple", Tuple({var}));
+      out = Push(name + "_reduced", Call(allreduce_op, {tuple, sum, null}));
+    } else if (from.kind == ShardState::kPartial && to.kind == ShardState::kShard) {
+      auto perm = MoveToFront(ndim, to.axis);
+      auto front = Transpose(var, perm);
+      auto scattered = Push(name + "_scattered", Call(reduce_scatter_op, {front, sum, null}));
+      out = Transpose(scattered, Inverse(perm));
+    } else if (from.kind == ShardState::kShard && to.kind == ShardState::kShard) {
+      // Split the target axis into [n, chunk] and exchange the n chunks, so that the chunk j of
+      // the source shards is received from rank j. Then merge the received chunks into the source
+      // axis, which becomes complete.
+      auto perm = MoveToFront(ndim, to.axis);
+      auto front = Transpose(var, perm);
+      std::vector<int64_t> local_shape;  // The local shape in the order of perm.
+      for (int d : perm) {
+        local_shape.push_back(d == from.axis ? shape[d] / n_ : shape[d]);
+      }
+      std::vector<int64_t> split = {n_, local_shape[0] / n_};
+      split.insert(split.end(), local_shape.begin() + 1, local_shape.end());
+      auto reshaped =
+          Push(name + "_split", Call(reshape_op, {front, MakeConstant(ArrayToIntTuple(split))}));
+      auto exchanged = Push(name + "_exchanged", Call(all_to_all_op, {reshaped, null}));
+      // The position of the source axis in the split layout, which is after [n, chunk].
+      int src = std::find(perm.begin(), perm.end(), from.axis) - perm.begin() + 1;
+      std::vector<int> merge_perm;
+      for (int d = 1; d < ndim + 1; ++d) {
+        if (d == src) {
+          merge_perm.push_back(0);
+        }
+        merge_perm.push_back(d);
+      }
+      auto moved = Transpose(exchanged, merge_perm);
+      std::vector<int64_t> merged_shape = {local_shape[0] / n_};
+      for (int d = 1; d < ndim; ++d) {
+        merged_shape.push_back(perm[d] == from.axis ? shape[perm[d]] : local_shape[d]);
+      }
+      auto merged = Push(name + "_merged",
+                         Call(reshape_op, {moved, MakeConstant(ArrayToIntTuple(merged_shape))}));
+      out = Transpose(merged, Inverse(perm));
+    } else {
+      LOG(FATAL) << "Cannot convert " << name << " to a partial sum";
+      throw;
+    }
+    states_[out] = to;
+    global_types_[out] = ttype;
+    memo.emplace_back(to, out);
+    return out;
+  }
+
+  /*! \brief Convert a tensor to replicated. Non-tensor values are always replicated. */
+  Expr ToReplicated(const Expr& expr) {
+    if (auto v = expr.as<VarNode>()) {
+      auto var = GetRef<Var>(v);
+      auto it = vmap_.find(var);
+      if (it != vmap_.end()) {
+        var = (*it).second;
+      }
+      return Convert(var, ShardState::Replicated());
+    }
+    return expr;
+  }
+
+  /*! \brief Transpose a tensor unless the permutation is the identity. */
+  Var Transpose(const Var& var, const std::vector<int>& perm) {
+    static const Op& transpose_op = Op::Get("raf.op.transpose");
+    bool identity = true;
+    for (size_t i = 0; i < perm.size(); ++i) {
+      identity &= perm[i] == static_cast<int>(i);
+    }
+    if (identity) {
+      return var;
+    }
+    std::vector<int64_t> axes(perm.begin(), perm.end());
+    return Push(var->name_hint() + "_t",
+                Call(transpose_op, {var, MakeConstant(ArrayToIntTuple(axes))}));
+  }
+
+  Var Push(const std::string& name, const Expr& expr) {
+    auto var = MakeVar(name, {});
+    new_ell_->Push(var, expr);
+    return var;
+  }
+
+  static std::vector<int> MoveToFront(int ndim, int axis) {
+    std::vector<int> perm = {axis};
+    for (int d = 0; d < ndim; ++d) {
+      if (d != axis) {
+        perm.push_back(d);
+      }
+    }
+    return perm;
+  }
+
+  static std::vector<int> Inverse(const std::vector<int>& perm) {
+    std::vector<int> inv(perm.size());
+    for (size_t i = 0; i < perm.size(); ++i) {
+      inv[perm[i]] = i;
+    }
+    return inv;
+  }
+
+  static std::vector<int64_t> GetShape(const TensorTypeNode* ttype) {
+    std::vector<int64_t> shape;
+    for (auto dim : ttype->shape) {
+      auto value = tvm::tir::as_const_int(dim);
+      if (value == nullptr) {
+        LOG(FATAL) << "Do not support dynamic shape yet";
+        throw;
+      }
+      shape.push_back(*value);
+    }
+    return shape;
+  }
+
+  /*! \brief Whether a tensor of the (global) type can be in the state. */
+  bool IsValid(const ShardState& state, const TensorTypeNode* ttype) {
+    if (state.kind != ShardState::kShard) {
+      return true;
+    }
+    if (ttype == nullptr || state.axis >= static_cast<int>(ttype->shape.size())) {
+      return false;
+    }
+    auto dim = tvm::tir::as_const_int(ttype->shape[state.axis]);
+    return dim != nullptr && *dim % n_ == 0;
+  }
+
+  /*! \brief The type of the local shard of a tensor. */
+  Type LocalType(const TensorTypeNode* ttype, const ShardState& state) {
+    if (state.kind != ShardState::kShard) {
+      return GetRef<TensorType>(ttype);
+    }
+    auto shape = ttype->shape;
+    shape.Set(state.axis, Integer(*tvm::tir::as_const_int(shape[state.axis]) / n_));
+    return TensorType(shape, ttype->dtype);
+  }
+
+  /*! \brief The global tensor type of a value, or nullptr if it is not a tensor. */
+  const TensorTypeNode* GetTensorType(const Expr& expr) {
+    if (auto v = expr.as<VarNode>()) {
+      auto it = global_types_.find(GetRef<Var>(v));
+      if (it != global_types_.end()) {
+        return it->second.as<TensorTypeNode>();
+      }
+    }
+    if (!expr->checked_type_.defined()) {
+      return nullptr;
+    }
+    return expr->checked_type().as<TensorTypeNode>();
+  }
+
+  ShardState GetState(const Expr& expr) {
+    if (auto v = expr.as<VarNode>()) {
+      auto it = states_.find(GetRef<Var>(v));
+      if (it != states_.end()) {
+        return it->second;
+      }
+    }
+    return ShardState::Replicated();
+  }
+
+  static bool IsVar(const Expr& expr) {
+    return expr.as<VarNode>() != nullptr;
+  }
+
+  /*! \brief The number of ranks. */
+  int64_t n_;
+  /*! \brief The current rank. */
+  int64_t rank_;
+  /*! \brief The target function. */
+  Function func_;
+  /*! \brief The sharding specifications of the parameters by name. */
+  std::unordered_map<std::string, BaseShardSpec> specs_;
+  /*! \brief The rewritten let list. */
+  std::unique_ptr<ExplicitLetList> new_ell_;
+  /*! \brief Map from the variables of the original function to the rewritten ones. */
+  Map<Var, Var> vmap_;
+  /*! \brief The global types of the rewritten variables. */
+  std::unordered_map<Var, Type, ObjectPtrHash, ObjectPtrEqual> global_types_;
+  /*! \brief The states of the rewritten variables. Missing ones are replicated. */
+  std::unordered_map<Var, ShardState, ObjectPtrHash, ObjectPtrEqual> states_;
+  /*! \brief The parameters whose specs are immutable. */
+  std::unordered_set<Var, ObjectPtrHash, ObjectPtrEqual> immutable_;
+  /*! \brief The converted tensors of each variable by state. */
+  std::unordered_map<Var, std::vector<std::pair<ShardState, Var>>, ObjectPtrHash, ObjectPtrEqual>
+      converted_;
+};
+
+}  // namespace sharding_propagation
+
+Pass ShardingPropagation(Map<String, sharding::BaseShardSpec> specs) {
+  TypedPackedFunc<Function(Function, IRModule, PassContext)> pass_func = [=](Function f, IRModule m,
+                                                                             PassContext pc) {
+    return sharding_propagation::ShardingPropagator(specs, f).Run();
+  };
+  auto sharding_propagation = CreateRAFFunctionPass(pass_func, 0, "ShardingPropagationFunc", {});
+  return RAFSequential({InferType(), sharding_propagation, InferType()}, "ShardingPropagation");
+}
+
+RAF_REGISTER_GLOBAL("raf.pass_.ShardingPropagation").set_body_typed(ShardingPropagation);
+
+}  // namespace pass
+}  // namespace raf
@@ -12,7 +12,11 @@
 #include "raf/ir_ext.h"
 #include "../op/dialect/tvm/tvm_utils.h"
 #include "../requests.h"
+#include <cctype>
 #include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
 
 namespace raf {
 namespace op_profiler {
@@ -35,6 +39,29 @@ OpProfiler* OpProfiler::Get(const Device& device) {
   }
 }
 
+ProfileCacheEntry ProfileCacheEntry::Load(const std::string& path) {
+  std::ifstream ifs(path + "/profile.txt");
+  ProfileCacheEntry entry;
+  size_t num_samples = 0;
+  ifs >> entry.workspace_size >> num_samples;
+  entry.latency.resize(num_samples);
+  for (size_t i = 0; i < num_samples; ++i) {
+    ifs >> entry.latency[i];
+  }
+  CHECK(!ifs.fail()) << "Cannot read the profiling results from " << path;
+  return entry;
+}
+
+bool ProfileCacheEntry::Save(const std::string& path) {
+  std::ofstream ofs(path + "/profile.txt");
+  ofs << workspace_size << " " << latency.size() << std::setprecision(9);
+  for (float lat : latency) {
+    ofs << " " << lat;
+  }
+  ofs << std::endl;
+  return ofs.good();
+}
+
 OpWithData::OpWithData(const Device device, const Expr& op, const int stream_id)
     : stream_id(stream_id) {
   // Nothing to do with non-call nodes.
@@ -62,8 +89,16 @@ OpWithData::OpWithData(const Device device, const Expr& op, const int stream_id)
   for (int k : op_env->arg_indices) {
     inputs.push_back(temp_inputs[k]);
   }
+  AllocWorkspace();
+}
+
+OpWithData::OpWithData(const OpEnvPtr& op_env, const std::vector<Value>& inputs,
+                       const Value& output)
+    : op_env(op_env), inputs(inputs), output(output) {
+  AllocWorkspace();
+}
 
-  // Allocate the workspace.
+void OpWithData::AllocWorkspace() {
   workspace_size = 0;
   std::shared_ptr<requests::Requests> requests = op_env->GetRequests();
   for (size_t i = 0; i < requests->workspace.size(); i++) {
@@ -98,6 +133,35 @@ OpWithData::~OpWithData() {
   }
 }
 
+ProfileDBT* OpProfiler::GetProfileDB() {
+  const char* enable_persist = getenv("RAF_PERSIST_CACHE");
+  if (enable_persist == nullptr || strcmp(enable_persist, "1") != 0) {
+    return nullptr;
+  }
+  if (profile_db_ == nullptr) {
+    // The results are only valid on the same class of device, so each device model has its own
+    // database.
+    std::string device_name = GetDeviceName();
+    for (auto& c : device_name) {
+      if (!isalnum(c) && c != '-') {
+        c = '_';
+      }
+    }
+    std::string name = "op_profiler_v" + std::to_string(kProfileDBVersion) + "_" +
+                       device_.device_type().c_str() + "_" + device_name;
+    profile_db_ = std::make_unique<ProfileDBT>(name);
+  }
+  return profile_db_.get();
+}
+
+bool OpProfiler::LookupProfileDB(const HashKey& db_key, const std::string& key) {
+  if (const auto* entry = GetProfileDB()->Get(db_key)) {
+    latency_and_workspace_size_cache_[key] = std::make_pair(entry->latency, entry->workspace_size);
+    return true;
+  }
+  return false;
+}
+
 OpEnvPtr OpProfiler::GetOpEnv(const Expr& op) {
   if (auto call_node = op.as<CallNode>()) {
     auto call = GetRef<Call>(call_node);
@@ -121,6 +185,17 @@ std::pair<std::vector<float>, float> OpProfiler::ProfileOpGroup(const std::vecto
     return latency_and_workspace_size_cache_[key];
   }
 
+  // Reuse the results profiled by previous compiles on the same class of device. As in
+  // ProfileOp, this is skipped when nothing is measured.
+  const bool use_db = exec_number > 0 && repeat > 0 && GetProfileDB() != nullptr;
+  HashKey db_key;
+  if (use_db) {
+    db_key = HashGroup(ops, stream_ids, true) << warmup << exec_number << repeat;
+    if (LookupProfileDB(db_key, key)) {
+      return latency_and_workspace_size_cache_[key];
+    }
+  }
+
   // Prepare ops for profiling.
   std::vector<OpWithDataPtr> ops_with_data;
   int64_t total_workspace_size = 0;
@@ -138,11 +213,21 @@ std::pair<std::vector<float>, float> OpProfiler::ProfileOpGroup(const std::vecto
   std::vector<float> cost = RunOpGroup(ops_with_data, warmup, exec_number, repeat);
 
   // Add the result to the cache.
+  if (use_db) {
+    GetProfileDB()->Set(db_key, ProfileCacheEntry(cost, total_workspace_size));
+  }
   latency_and_workspace_size_cache_[key] =
       std::move(std::make_pair(std::move(cost), total_workspace_size));
   return latency_and_workspace_size_cache_[key];
 }
 
+std::vector<float> OpProfiler::ProfileOpEnv(const OpEnvPtr& op_env,
+                                            const std::vector<Value>& inputs, const Value& output,
+                                            int32_t warmup, int32_t exec_number, int32_t repeat) {
+  OpWithDataPtr op_with_data = std::make_shared<OpWithData>(op_env, inputs, output);
+  return RunOp(op_with_data, warmup, exec_number, repeat);
+}
+
 // Profile one op and return its latency in microseconds on the target device.
 std::pair<std::vector<float>, float> OpProfiler::ProfileOp(const Expr& op, int32_t warmup,
                                                            int32_t exec_number, int32_t repeat) {
@@ -157,6 +242,21 @@ std::pair<std::vector<float>, float> OpProfiler::ProfileOp(const Expr& op, int32
       return latency_and_workspace_size_cache_[key];
     }
 
+    // Reuse the results profiled by previous compiles on the same class of device. This is
+    // skipped when nothing is measured, because the caller only needs the built OpEnv.
+    const bool use_db = exec_number > 0 && repeat > 0 && GetProfileDB() != nullptr;
+    HashKey db_key;
+    if (use_db) {
+      db_key = HashCall(call, true) << warmup << exec_number << repeat;
+      if (LookupProfileDB(db_key, key)) {
+        // The OpEnv is still built for GetOpEnv, which mostly hits the kernel caches.
+        if (!op_env_cache_.count(call_key_str)) {
+          op_env_cache_[call_key_str] = Dispatch(CreateDummyCallValues(call, device_));
+        }
+        return latency_and_workspace_size_cache_[key];
+      }
+    }
+
     // Build the op and generate dummy input data for profiling.
     OpWithDataPtr op_with_data = std::make_shared<OpWithData>(device_, op);
 
@@ -169,6 +269,9 @@ std::pair<std::vector<float>, float> OpProfiler::ProfileOp(const Expr& op, int32
     int64_t workspace_size = op_with_data->workspace_size;
 
     // Add the profiled cost to the cache.
+    if (use_db) {
+      GetProfileDB()->Set(db_key, ProfileCacheEntry(cost, workspace_size));
+    }
     latency_and_workspace_size_cache_[key] =
         std::move(std::make_pair(std::move(cost), workspace_size));
     return latency_and_workspace_size_cache_[key];
@@ -179,6 +282,20 @@ std::pair<std::vector<float>, float> OpProfiler::ProfileOp(const Expr& op, int32
   return std::make_pair(std::vector<float>(repeat, 0.0), 0.0f);
 }
 
+std::string CPUOpProfiler::GetDeviceName() {
+  std::ifstream ifs("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(ifs, line)) {
+    if (line.compare(0, 10, "model name") == 0) {
+      auto pos = line.find(':');
+      if (pos != std::string::npos && pos + 2 <= line.size()) {
+        return line.substr(pos + 2);
+      }
+    }
+  }
+  return "unknown";
+}
+
 std::vector<float> CPUOpProfiler::RunOp(const OpWithDataPtr& op_with_data, int32_t warmup,
                                         int32_t exec_number, int32_t repeat) {
   if (!op_with_data->profilable()) {
@@ -239,6 +356,12 @@ std::vector<float> CPUOpProfiler::RunOpGroup(const std::vector<OpWithDataPtr>& o
 }
 
 #ifdef RAF_USE_CUDA
+std::string CUDAOpProfiler::GetDeviceName() {
+  cudaDeviceProp prop;
+  CUDA_CALL(cudaGetDeviceProperties(&prop, device_.device_id()));
+  return std::string(prop.name);
+}
+
 // Run the op on the CUDA device, return the profiled execution time in microseconds
 std::vector<float> CUDAOpProfiler::RunOp(const OpWithDataPtr& op_with_data, int32_t warmup,
                                          int32_t exec_number, int32_t repeat) {
@@ -394,6 +517,15 @@ RAF_REGISTER_GLOBAL("raf.op_profiler.ResetCache").set_body_typed([](const Device
   return profiler->Reset();
 });
 
+RAF_REGISTER_GLOBAL("raf.op_profiler.DumpDBMetric").set_body_typed([](const Device& device) {
+  auto profiler = OpProfiler::Get(device);
+  PackedMetricMap ret;
+  for (const auto& it : profiler->GetDBMetric()) {
+    ret.Set(it.first, it.second);
+  }
+  return ret;
+});
+
 RAF_REGISTER_GLOBAL("raf.op_profiler.GetCacheSize").set_body_typed([](const Device& device) {
   auto profiler = OpProfiler::Get(device);
   return profiler->GetLatencyCacheSize();
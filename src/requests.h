@@ -9,6 +9,7 @@
  */
 #pragma once
 #include <memory>
+#include <mutex>
 #include <vector>
 #include "raf/device.h"
 #include "raf/memory_pool.h"
@@ -52,6 +53,11 @@ class Requests {
   std::vector<WorkspaceRequest> workspace;
   std::vector<StreamRequest> stream;
   std::vector<DistributedRequest> distributed;
+  /*!
+   * \brief The lock to bind per-call resources (e.g., workspace) exclusively when the owner
+   * OpEnv may be executed concurrently.
+   */
+  std::mutex mu;
 };
 
 }  // namespace requests
@@ -0,0 +1,254 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <raf/cache.h>
+#include <raf/file.h>
+
+using raf::op::FNV1aHash;
+using raf::op::HashKey;
+using raf::op::MetaCache;
+using raf::op::MetaPersistCache;
+
+class IntCacheEntry {
+ public:
+  IntCacheEntry() = default;
+  explicit IntCacheEntry(int value) : value(value) {
+  }
+  static IntCacheEntry Load(const std::string path) {
+    std::string content;
+    CHECK(raf::ReadFile(path + "/value", &content));
+    return IntCacheEntry(std::stoi(content));
+  }
+  bool Save(const std::string& path) {
+    return raf::WriteFile(path + "/value", std::to_string(value));
+  }
+  int value = 0;
+};
+
+TEST(HashKey, Digest) {
+  HashKey key;
+  key << std::string("matmul") << int64_t(1) << 2.0f;
+  const std::string key_str = key.str();
+  ASSERT_EQ(key.size(), key_str.size());
+  ASSERT_EQ(key.digest(), FNV1aHash(key_str.data(), key_str.size()));
+  // The same content appended in pieces gives the same key.
+  HashKey other;
+  other << std::string("matmul");
+  other << int64_t(1);
+  other << 2.0f;
+  ASSERT_EQ(other.str(), key_str);
+  ASSERT_EQ(other.digest(), key.digest());
+}
+
+TEST(HashKey, SpillToHeap) {
+  HashKey key;
+  std::vector<int64_t> shape(100);
+  for (int i = 0; i < 100; ++i) {
+    shape[i] = i;
+  }
+  // 100 dims do not fit in the inline buffer.
+  key << std::string("reshape") << shape;
+  HashKey copy(key);
+  HashKey assigned;
+  assigned << std::string("relu");
+  assigned = key;
+  ASSERT_GT(key.size(), 800);
+  ASSERT_EQ(copy.str(), key.str());
+  ASSERT_EQ(assigned.str(), key.str());
+  ASSERT_EQ(copy.digest(), key.digest());
+  ASSERT_EQ(assigned.digest(), FNV1aHash(key.data(), key.size()));
+}
+
+TEST(MetaCache, ByteAndStringKeys) {
+  MetaCache<int> cache;
+  HashKey key;
+  key << std::string("conv2d") << std::vector<int64_t>{1, 3, 224, 224};
+  const std::string key_str = key.str();
+  const std::vector<uint8_t> key_bytes(key_str.begin(), key_str.end());
+  ASSERT_FALSE(cache.Has(key));
+  cache.Set(key, 1);
+  // Hash, byte and string keys with the same content refer to the same entry.
+  ASSERT_TRUE(cache.Has(key_str));
+  ASSERT_EQ(*cache.Get(key_bytes), 1);
+  ASSERT_EQ(*cache.Get(key), 1);
+  bool inserted = true;
+  ASSERT_EQ(*cache.SetIfAbsent(key_str, 2, &inserted), 1);
+  ASSERT_FALSE(inserted);
+}
+
+TEST(MetaCache, Concurrent) {
+  MetaCache<int> cache;
+  constexpr int kNumThreads = 8;
+  constexpr int kNumKeys = 1000;
+  std::vector<std::thread> threads;
+  std::atomic<int> num_errors{0};
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < kNumKeys; ++i) {
+        const std::string key = std::to_string(i);
+        cache.SetIfAbsent(key, i);
+        const int* val = cache.Get(std::vector<uint8_t>(key.begin(), key.end()));
+        if (val == nullptr || *val != i) {
+          num_errors++;
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(num_errors.load(), 0);
+}
+
+TEST(MetaPersistCache, Metric) {
+  MetaPersistCache<IntCacheEntry> cache("cpptest_metric");
+  HashKey key;
+  key << std::string("relu");
+  ASSERT_EQ(cache.Get(key), nullptr);
+  cache.Set(key, IntCacheEntry(1));
+  ASSERT_EQ(cache.Get(key)->value, 1);
+  auto metric = cache.GetMetric();
+  ASSERT_EQ(metric["CacheGet"], 2);
+  ASSERT_EQ(metric["CacheHit"], 1);
+  ASSERT_EQ(metric["CacheMiss"], 1);
+  ASSERT_EQ(metric["CacheSet"], 1);
+}
+
+/*! \brief Enable the persistent cache under a fresh directory for the scope of a test. */
+class ScopedPersistCache {
+ public:
+  explicit ScopedPersistCache(const std::string& max_bytes = "",
+                              const std::string& touch_interval_ms = "") {
+    path_ = "/tmp/raf_cpptest_cache_" + std::to_string(getpid());
+    raf::RemoveDir(path_);
+    setenv("RAF_PERSIST_CACHE", "1", 1);
+    setenv("RAF_PERSIST_CACHE_PATH", path_.c_str(), 1);
+    if (!max_bytes.empty()) {
+      setenv("RAF_PERSIST_CACHE_MAX_BYTES", max_bytes.c_str(), 1);
+    }
+    if (!touch_interval_ms.empty()) {
+      setenv("RAF_PERSIST_CACHE_TOUCH_INTERVAL_MS", touch_interval_ms.c_str(), 1);
+    }
+  }
+  ~ScopedPersistCache() {
+    unsetenv("RAF_PERSIST_CACHE");
+    unsetenv("RAF_PERSIST_CACHE_PATH");
+    unsetenv("RAF_PERSIST_CACHE_MAX_BYTES");
+    unsetenv("RAF_PERSIST_CACHE_TOUCH_INTERVAL_MS");
+    raf::RemoveDir(path_);
+  }
+  const std::string& path() const {
+    return path_;
+  }
+
+ private:
+  std::string path_;
+};
+
+TEST(MetaPersistCache, Reload) {
+  ScopedPersistCache scope;
+  {
+    MetaPersistCache<IntCacheEntry> cache("cpptest_reload");
+    cache.Set(std::string("relu"), IntCacheEntry(1));
+    cache.Set(std::string("gelu"), IntCacheEntry(2));
+  }
+  // A new cache, as in another process, loads the persisted entries.
+  MetaPersistCache<IntCacheEntry> cache("cpptest_reload");
+  ASSERT_EQ(cache.Get(std::string("relu"))->value, 1);
+  ASSERT_EQ(cache.Get(std::string("gelu"))->value, 2);
+  ASSERT_EQ(cache.Get(std::string("tanh")), nullptr);
+  auto metric = cache.GetMetric();
+  ASSERT_EQ(metric["PersistCacheHit"], 2);
+  ASSERT_EQ(metric["PersistCacheMiss"], 1);
+}
+
+TEST(MetaPersistCache, Collision) {
+  ScopedPersistCache scope;
+  {
+    MetaPersistCache<IntCacheEntry> cache("cpptest_collision");
+    cache.Set(std::string("relu"), IntCacheEntry(1));
+  }
+  // Pretend that the entry of "relu" belongs to another key with the same hash.
+  const std::string dir = scope.path() + "/cpptest_collision";
+  std::string entry;
+  for (const auto& name : raf::ListDir(dir)) {
+    if (name != "lock") {
+      entry = dir + "/" + name;
+    }
+  }
+  ASSERT_TRUE(raf::WriteFile(entry + "/key", "another_key"));
+  MetaPersistCache<IntCacheEntry> cache("cpptest_collision");
+  ASSERT_EQ(cache.Get(std::string("relu")), nullptr);
+  // The key is persisted to the next slot, and the colliding entry is kept.
+  cache.Set(std::string("relu"), IntCacheEntry(2));
+  ASSERT_TRUE(raf::DirExists(entry + ".1"));
+  ASSERT_TRUE(raf::DirExists(entry));
+  ASSERT_GE(cache.GetMetric()["PersistCacheCollision"], 1);
+}
+
+TEST(MetaPersistCache, Eviction) {
+  constexpr int64_t kMaxBytes = 1024;
+  ScopedPersistCache scope(std::to_string(kMaxBytes));
+  {
+    MetaPersistCache<IntCacheEntry> cache("cpptest_eviction");
+    for (int i = 0; i < 100; ++i) {
+      cache.Set(std::to_string(i), IntCacheEntry(i));
+      // Make sure the entries have distinct timestamps.
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    ASSERT_GT(cache.GetMetric()["PersistCacheEviction"], 0);
+  }
+  ASSERT_LE(raf::DirSize(scope.path() + "/cpptest_eviction"), kMaxBytes);
+  // The least recently used entries are evicted first.
+  MetaPersistCache<IntCacheEntry> cache("cpptest_eviction");
+  ASSERT_EQ(cache.Get(std::string("99"))->value, 99);
+  ASSERT_EQ(cache.Get(std::string("0")), nullptr);
+}
+
+TEST(MetaPersistCache, EvictionKeepsMemoryHits) {
+  constexpr int64_t kMaxBytes = 1024;
+  ScopedPersistCache scope(std::to_string(kMaxBytes), "0");
+  {
+    MetaPersistCache<IntCacheEntry> cache("cpptest_eviction_hit");
+    cache.Set(std::string("hot"), IntCacheEntry(-1));
+    for (int i = 0; i < 100; ++i) {
+      cache.Set(std::to_string(i), IntCacheEntry(i));
+      // The hot entry is the oldest one published, but it is only read from memory.
+      ASSERT_EQ(cache.Get(std::string("hot"))->value, -1);
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    ASSERT_GT(cache.GetMetric()["PersistCacheEviction"], 0);
+  }
+  MetaPersistCache<IntCacheEntry> cache("cpptest_eviction_hit");
+  ASSERT_EQ(cache.Get(std::string("hot"))->value, -1);
+  ASSERT_EQ(cache.Get(std::string("0")), nullptr);
+}
+
+// Persisted cache entries are looked up by the key bytes, so the layout must not change.
+TEST(HashKey, ByteLayout) {
+  HashKey key;
+  key << std::string("ab") << std::vector<int64_t>{2, 3} << int32_t(-1);
+  std::vector<uint8_t> expected = {16, 'a', 'b', 0, 0, 0, 0, 0, 0, 0, 0};
+  expected.push_back(13);
+  for (uint8_t dim : {2, 3, 0}) {
+    std::vector<uint8_t> bytes(8, 0);
+    bytes[0] = dim;
+    expected.insert(expected.end(), bytes.begin(), bytes.end());
+  }
+  expected.insert(expected.end(), {0xff, 0xff, 0xff, 0xff});
+  ASSERT_EQ(std::vector<uint8_t>(key.data(), key.data() + key.size()), expected);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include <raf/device.h>
+#include <raf/device_api.h>
+
+#include "../../src/device_api/cpu/cpu_stream.h"
+
+using raf::Device;
+using raf::DevType;
+using raf::device_api::DeviceAPI;
+using raf::device_api::cpu::CPUStream;
+
+TEST(CPUStream, InOrder) {
+  Device dev{DevType::kCPU(), 0};
+  auto api = DeviceAPI::Get(DevType::kCPU());
+  auto stream = static_cast<CPUStream*>(api->CreateStream(dev));
+  std::atomic<int> last{0};
+  bool in_order = true;
+  for (int i = 1; i <= 100; ++i) {
+    stream->Launch([&last, &in_order, i]() { in_order &= last.exchange(i) == i - 1; });
+  }
+  api->WaitStream(stream);
+  ASSERT_TRUE(in_order);
+  ASSERT_EQ(last.load(), 100);
+  api->FreeStream(dev, stream);
+}
+
+TEST(CPUStream, EventWaitOrdersStreams) {
+  Device dev{DevType::kCPU(), 0};
+  auto api = DeviceAPI::Get(DevType::kCPU());
+  auto producer = static_cast<CPUStream*>(api->CreateStream(dev));
+  auto consumer = static_cast<CPUStream*>(api->CreateStream(dev));
+  void* event = api->CreateEvent(dev, 0);
+  for (int iter = 0; iter < 10; ++iter) {
+    std::atomic<int> produced{0};
+    int observed = -1;
+    // Without the event, the consumer would run first because the producer is sleeping.
+    producer->Launch([&produced]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      produced.store(1);
+    });
+    api->EventRecordOnStream(event, producer);
+    api->StreamWaitEvent(consumer, event);
+    consumer->Launch([&produced, &observed]() { observed = produced.load(); });
+    api->WaitStream(consumer);
+    ASSERT_EQ(observed, 1);
+    api->WaitStream(producer);
+  }
+  api->FreeEvent(dev, event);
+  api->FreeStream(dev, consumer);
+  api->FreeStream(dev, producer);
+}
+
+TEST(CPUStream, WaitReleasesTasks) {
+  Device dev{DevType::kCPU(), 0};
+  auto api = DeviceAPI::Get(DevType::kCPU());
+  auto stream = static_cast<CPUStream*>(api->CreateStream(dev));
+  for (int iter = 0; iter < 100; ++iter) {
+    // The task holds the only other reference, which must be released once it is waited.
+    auto held = std::make_shared<int>(iter);
+    stream->Launch([held]() {});
+    api->WaitStream(stream);
+    ASSERT_EQ(held.use_count(), 1);
+  }
+  api->FreeStream(dev, stream);
+}
@@ -5,6 +5,10 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include <raf/device.h>
 #include <raf/memory_pool.h>
 
@@ -44,7 +48,7 @@ TEST(PageUnitPool, CPU) {
   for (int memory : {11, 19, 2019, 1024124}) {
     for (int align : {(int)kDefaultMemoryAlignment, 512, 1024, 4096}) {
       std::shared_ptr<Memory> result = Memory::Alloc(dev, memory, align);
-      ASSERT_EQ(result.use_count(), 2);
+      ASSERT_EQ(result.use_count(), 1);
       int64_t address = (int64_t)result->data;
       ASSERT_EQ(address % align, 0);
     }
@@ -57,9 +61,103 @@ TEST(PageUnitPool, CPU) {
   auto used_size = pool_size.first * 1048576.0;
   auto abs_diff = (used_size > 4096) ? used_size - 4096 : 4096 - used_size;
   ASSERT_LE(abs_diff, 1);
+  void* data = result->data;
   result.reset();
   pool_size = Memory::GetPoolSize(dev);
   ASSERT_EQ(pool_size.first, 0);
+
+  // The released chunk goes back to the free list and is reused by the next request.
+  result = Memory::Alloc(dev, 4096, kDefaultMemoryAlignment);
+  ASSERT_EQ(result->data, data);
+  ASSERT_EQ(result.use_count(), 1);
+  // The chunk outlives the pool.
+  Memory::RemovePool(dev);
+  static_cast<char*>(result->data)[0] = 1;
+  result.reset();
+}
+
+TEST(PageUnitPool, CPUConcurrent) {
+  Device dev{DevType::kCPU(), 0};
+  Memory::InitPool(dev, "page_unit_pool");
+  constexpr int kNumThreads = 8;
+  constexpr int kNumIters = 1000;
+  std::vector<std::thread> threads;
+  std::atomic<int> num_conflicts{0};
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < kNumIters; ++i) {
+        // All threads request the same size class, so they compete for the same free chunks.
+        std::shared_ptr<Memory> a = Memory::Alloc(dev, 4096);
+        std::shared_ptr<Memory> b = Memory::Alloc(dev, 4096);
+        if (a->data == b->data) {
+          num_conflicts++;
+        }
+        // A chunk must not be handed out to another thread while we hold it.
+        static_cast<char*>(a->data)[0] = 1;
+        static_cast<char*>(b->data)[0] = 2;
+        if (static_cast<char*>(a->data)[0] != 1) {
+          num_conflicts++;
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(num_conflicts.load(), 0);
+  ASSERT_EQ(Memory::GetPoolSize(dev).first, 0);
+  Memory::RemovePool(dev);
+}
+
+TEST(BFCPool, CPU) {
+  Device dev{DevType::kCPU(), 0};
+  Memory::InitPool(dev, "bfc_pool");
+  {
+    std::shared_ptr<Memory> result = Memory::Alloc(dev, 0);
+    ASSERT_EQ(result.use_count(), 1);
+    ASSERT_EQ(result->data, nullptr);
+  }
+  for (int memory : {11, 19, 2019, 1024124}) {
+    for (int align : {(int)kDefaultMemoryAlignment, 512, 1024, 4096}) {
+      std::shared_ptr<Memory> result = Memory::Alloc(dev, memory, align);
+      ASSERT_EQ(result.use_count(), 1);
+      int64_t address = (int64_t)result->data;
+      ASSERT_EQ(address % align, 0);
+    }
+  }
+  auto pool_size = Memory::GetPoolSize(dev);
+  ASSERT_EQ(pool_size.first, 0);  // No chunk is used.
+
+  std::shared_ptr<Memory> result = Memory::Alloc(dev, 4096, kDefaultMemoryAlignment);
+  pool_size = Memory::GetPoolSize(dev);
+  auto used_size = pool_size.first * 1048576.0;
+  auto abs_diff = (used_size > 4096) ? used_size - 4096 : 4096 - used_size;
+  ASSERT_LE(abs_diff, 1);
+  result.reset();
+  pool_size = Memory::GetPoolSize(dev);
+  ASSERT_EQ(pool_size.first, 0);
+  Memory::RemovePool(dev);
+}
+
+TEST(BFCPool, CPUCoalesce) {
+  Device dev{DevType::kCPU(), 0};
+  Memory::InitPool(dev, "bfc_pool");
+  std::shared_ptr<Memory> a = Memory::Alloc(dev, 4096);
+  std::shared_ptr<Memory> b = Memory::Alloc(dev, 8192);
+  std::shared_ptr<Memory> c = Memory::Alloc(dev, 4096);
+  void* base = a->data;
+  auto reserved = Memory::GetPoolSize(dev).second;
+  // The adjacent chunks of a and b are merged once both are freed, so a larger request fits in
+  // them without growing the pool.
+  a.reset();
+  b.reset();
+  std::shared_ptr<Memory> d = Memory::Alloc(dev, 12288);
+  ASSERT_EQ(d->data, base);
+  ASSERT_EQ(Memory::GetPoolSize(dev).second, reserved);
+  // A freed chunk is split to serve a smaller request.
+  d.reset();
+  std::shared_ptr<Memory> e = Memory::Alloc(dev, 1000);
+  ASSERT_EQ(e->data, base);
   Memory::RemovePool(dev);
 }
 
@@ -0,0 +1,35 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+import numpy as np
+import pytest
+import raf
+from raf._core.executor import set_interpreter_sync
+from raf._op.dialect import DialectPreference
+from raf.testing import get_testable_devices, randn, check
+
+
+@pytest.mark.parametrize("device", get_testable_devices())
+@pytest.mark.parametrize("sync", [True, False])
+def test_repeated_eager_ops(device, sync):
+    set_interpreter_sync(sync)
+    try:
+        for shape in [(3, 4), (3, 4), (5, 2), (3, 4)]:
+            m_x, n_x = randn(shape, device=device)
+            m_y, n_y = randn(shape, device=device)
+            # The OpEnvs are reused by the calls with the same signature.
+            m_z = raf.add(raf.relu(m_x), m_y)
+            n_z = np.maximum(n_x, 0) + n_y
+            check(m_z, n_z)
+            # The attributes are part of the signature.
+            check(raf.sum(m_z, axis=0), np.sum(n_z, axis=0))
+            check(raf.sum(m_z, axis=1), np.sum(n_z, axis=1))
+            # The dialect preference is part of the signature as well.
+            with DialectPreference(["tvm"]):
+                check(raf.add(raf.relu(m_x), m_y), n_z)
+    finally:
+        set_interpreter_sync(True)
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
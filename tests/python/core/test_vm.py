@@ -1,6 +1,8 @@
 # Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
 # SPDX-License-Identifier: Apache-2.0
 
+import threading
+
 import pytest
 import numpy as np
 import raf
@@ -187,6 +189,157 @@ def test_split_fusion(device):
     check_e2e(model, device, [m_x])
 
 
+@pytest.mark.parametrize("device", get_testable_devices())
+@pytest.mark.parametrize("enable_inline_cache", [True, False])
+def test_inline_cache(device, enable_inline_cache):
+    # pylint: disable=protected-access, attribute-defined-outside-init, no-self-use
+    class Model(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x):
+            y = raf.add(x, x)
+            z = raf.split(y, indices_or_sections=2, axis=0)
+            return raf.multiply(z[0], z[1])
+
+    model = Model()
+    model.infer_mode()
+    m_x, _ = randn([4, 4], device=device)
+    mod = model._internal(m_x).mod
+    with raf.ir.PassContext(disabled_pass=["FuseTVM", "FuseDialect"]):
+        executor = VMExecutor(mod, device, enable_inline_cache=enable_inline_cache)
+    ref_z = model(m_x).numpy()
+    # The first run fills the inline cache, and the following runs hit it.
+    for _ in range(3):
+        m_z = executor.vm.run(m_x).numpy()
+        np.testing.assert_allclose(m_z, ref_z, rtol=1e-5, atol=1e-5)
+
+
+@pytest.mark.parametrize("device", get_testable_devices())
+def test_inline_cache_shape_change(device):
+    # pylint: disable=protected-access, attribute-defined-outside-init, no-self-use
+    class Model(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x):
+            y = raf.argwhere(x)
+            return raf.add(y, y)
+
+    model = Model()
+    model.infer_mode()
+    n_xs = [
+        np.array([[1, 0], [0, 1]], dtype="float32"),
+        np.array([[1, 1], [0, 1]], dtype="float32"),
+        np.array([[1, 0], [0, 1]], dtype="float32"),
+    ]
+    mod = model._internal(raf.array(n_xs[0], device=device)).mod
+    with raf.ir.PassContext(disabled_pass=["FuseTVM", "FuseDialect"]):
+        executor = VMExecutor(mod, device)
+    # The add at the same instruction sees (2, 2), then (3, 2), and then (2, 2) again, so its
+    # inline cache misses and is updated each time.
+    for n_x in n_xs:
+        m_z = executor.vm.run(raf.array(n_x, device=device)).numpy()
+        np.testing.assert_equal(m_z, np.argwhere(n_x) * 2)
+
+
+def test_concurrent_run():
+    # pylint: disable=protected-access, attribute-defined-outside-init, no-self-use
+    class Model(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x):
+            y = raf.add(x, x)
+            z = raf.relu(y)
+            return raf.multiply(z, x)
+
+    device = "cpu"
+    model = Model()
+    model.infer_mode()
+    m_x, _ = randn([8, 8], device=device)
+    mod = model._internal(m_x).mod
+    executor = VMExecutor(mod, device)
+
+    inputs = [randn([8, 8], device=device)[0] for _ in range(8)]
+    refs = [model(x).numpy() for x in inputs]
+    outs = [None] * len(inputs)
+
+    def worker(idx):
+        for _ in range(10):
+            outs[idx] = executor.vm.run(inputs[idx]).numpy()
+
+    threads = [threading.Thread(target=worker, args=(i,)) for i in range(len(inputs))]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    for out, ref in zip(outs, refs):
+        np.testing.assert_allclose(out, ref, rtol=1e-5, atol=1e-5)
+
+    assert executor.vm.profile_throughput(m_x, num_threads=4, number=5) > 0
+
+
+@pytest.mark.parametrize("device", get_testable_devices())
+def test_dispatch_by_profiling(device, monkeypatch):
+    # pylint: disable=protected-access, attribute-defined-outside-init, no-self-use
+    class Model(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x, w):
+            y = raf.matmul(x, w)
+            return raf.relu(y)
+
+    monkeypatch.setenv("RAF_DISPATCH_BY_PROFILING", "1")
+    model = Model()
+    model.infer_mode()
+    m_x, _ = randn([16, 8], device=device)
+    m_w, _ = randn([8, 4], device=device)
+    mod = model._internal(m_x, m_w).mod
+    ref_y = model(m_x, m_w).numpy()
+    # The first executor profiles the dialects and records the decisions, and the second one
+    # reuses them.
+    for _ in range(2):
+        with raf.ir.PassContext(disabled_pass=["FuseTVM", "FuseDialect"]):
+            executor = VMExecutor(mod, device)
+        m_y = executor.make_executor()(m_x, m_w).numpy()
+        np.testing.assert_allclose(m_y, ref_y, rtol=1e-4, atol=1e-4)
+    metric = raf._ffi.cache.DumpDispatchCacheMetric()
+    assert metric["CacheHit"] > 0
+
+
+@pytest.mark.parametrize("device", get_testable_devices())
+def test_precompile(device):
+    # pylint: disable=protected-access, attribute-defined-outside-init, no-self-use
+    class Model(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x):
+            y = raf.add(x, x)
+            z = raf.relu(y)
+            z = raf.multiply(z, y)
+            return raf.softmax(z)
+
+    model = Model()
+    model.infer_mode()
+    m_x, _ = randn([6, 6], device=device)
+    mod = model._internal(m_x).mod
+    ref_z = model(m_x).numpy()
+    # The ops after the first one have static input shapes and are built in the background. The
+    # run waits for the kernels that are still being compiled.
+    executor = VMExecutor(mod, device, num_compile_threads=2)
+    for _ in range(2):
+        m_z = executor.vm.run(m_x).numpy()
+        np.testing.assert_allclose(m_z, ref_z, rtol=1e-5, atol=1e-5)
+
+
 def test_reshape():
     # pylint: disable=protected-access, attribute-defined-outside-init, no-self-use
     shape = [3, 4, 5]
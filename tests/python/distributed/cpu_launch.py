@@ -0,0 +1,79 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# pylint: disable=import-outside-toplevel
+"""Run a test function on local processes that form one CPU communicator, so that the distributed
+tests on CPU do not need mpirun. Each function takes (rank, size, *args) and raises on failure.
+"""
+import os
+import sys
+import socket
+import multiprocessing as mp
+
+import pytest
+
+NUM_RANKS = 3
+SKIP_REASON = "The CPU communicators are only available on Linux"
+COMMUNICATORS = ["shm", "tcp"]
+
+# Skip a test where the CPU communicators are not available.
+linux_only = pytest.mark.skipif(not sys.platform.startswith("linux"), reason=SKIP_REASON)
+
+
+def with_communicators(func):
+    """Run a test on each CPU communicator, which is passed as its communicator argument."""
+    return linux_only(pytest.mark.parametrize("communicator", COMMUNICATORS)(func))
+
+
+def init_rank(rank, size):
+    """Configure the global communicator of a spawned process."""
+    from raf import distributed as dist
+
+    comm = dist.get_communicator()
+    comm.size = size
+    comm.rank = rank
+    comm.local_size = size
+    comm.local_rank = rank
+
+
+def worker(rank, size, env, func, args, queue):
+    os.environ.update(env)
+    try:
+        init_rank(rank, size)
+        func(rank, size, *args)
+        queue.put((rank, None))
+    except Exception as err:  # pylint: disable=broad-except
+        queue.put((rank, repr(err)))
+
+
+def free_port():
+    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as sock:
+        sock.bind(("127.0.0.1", 0))
+        return sock.getsockname()[1]
+
+
+def launch(communicator, func, *args, size=NUM_RANKS, extra_env=None, host_ids=None):
+    """Run func on size local processes that form one communicator over loopback. host_ids
+    assigns the ranks to emulated hosts of the TCP communicator."""
+    ctx = mp.get_context("spawn")
+    queue = ctx.Queue()
+    env = {"RAF_CPU_COMMUNICATOR": communicator}
+    env.update(extra_env or {})
+    if communicator == "shm":
+        env["RAF_SHM_SESSION"] = "test_%d_%s" % (os.getpid(), func.__name__)
+    else:
+        env["RAF_TCP_ADDR"] = "127.0.0.1:%d" % free_port()
+    rank_envs = [dict(env) for _ in range(size)]
+    for rank, host_id in enumerate(host_ids or []):
+        rank_envs[rank]["RAF_TCP_HOST_ID"] = str(host_id)
+    procs = [
+        ctx.Process(target=worker, args=(rank, size, rank_envs[rank], func, args, queue))
+        for rank in range(size)
+    ]
+    for proc in procs:
+        proc.start()
+    errors = [queue.get(timeout=600) for _ in procs]
+    for proc in procs:
+        proc.join()
+    for rank, err in errors:
+        assert err is None, "Rank %d failed: %s" % (rank, err)
@@ -0,0 +1,105 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# pylint: disable=invalid-name, protected-access, too-many-locals, import-outside-toplevel
+"""Test the gradient allreduces overlapped by AsyncDataParallelSchedule on CPU. The order of the
+scheduled ops is tested in tests/python/pass/test_pass_async_data_parallel_schedule.py.
+"""
+import pytest
+import numpy as np
+
+from cpu_launch import launch, with_communicators
+
+
+def run_async_data_parallel(rank, size):
+    import raf
+    from raf import distributed as dist
+    from raf._core.executor import VMExecutor
+    from raf.testing import check
+
+    class TestModel(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x):
+            a = raf.relu(x)
+            ga = raf.allreduce(a, computation="avg")
+            b = raf.matmul(a, a)
+            gb = raf.allreduce(b, computation="avg")
+            c = raf.matmul(b, b)
+            gc = raf.allreduce(c, computation="avg")
+            return raf.concatenate([raf.add(ga, gb), gc])
+
+    # The CPU VM schedules the allreduces asynchronously when data parallel is enabled.
+    dcfg = dist.get_config()
+    dcfg.group_bucket_size = 32
+    n_x = np.linspace(-1, 1, 16, dtype="float32").reshape(4, 4) * (rank + 1)
+    model = TestModel()
+    model.to(device="cpu")
+    x = raf.array(n_x, device="cpu")
+    dcfg.enable_data_parallel = True
+    out = VMExecutor(model._internal(x).mod, "cpu").make_executor()(x)
+    dcfg.enable_data_parallel = False
+    xs = [np.linspace(-1, 1, 16, dtype="float32").reshape(4, 4) * (i + 1) for i in range(size)]
+    a_s = [np.maximum(n, 0) for n in xs]
+    b_s = [n @ n for n in a_s]
+    c_s = [n @ n for n in b_s]
+    target = [np.mean(a_s, axis=0) + np.mean(b_s, axis=0), np.mean(c_s, axis=0)]
+    check(out, np.concatenate(target), rtol=1e-4, atol=1e-4)
+
+
+def run_async_compressed(rank, size):
+    import raf
+    from raf import distributed as dist
+    from raf._core.executor import VMExecutor
+    from raf._op import sym
+    from raf.testing import check
+
+    class TestModel(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x):
+            a = raf.relu(x)
+            ga = raf.allreduce(a, computation="avg")
+            b = raf.matmul(ga, ga)
+            compressed = sym._topk_compress(b, 0.5, "test")
+            values = raf.allgather(compressed[0], axis=0)
+            indices = raf.allgather(compressed[1], axis=0)
+            gb = sym._topk_decompress(values, indices, (4, 4), 1.0 / size)
+            c = raf.matmul(a, a)
+            gc = raf.allreduce(c, computation="avg")
+            return raf.concatenate([gb, gc])
+
+    # The compression keeps its residuals across iterations, so two iterations with the
+    # asynchronous allreduces must match those with the synchronous ones.
+    dcfg = dist.get_config()
+    model = TestModel()
+    model.to(device="cpu")
+    xs = [np.linspace(-1, 1, 16, dtype="float32").reshape(4, 4) * (rank + i + 1) for i in range(2)]
+    xs = [raf.array(n_x, device="cpu") for n_x in xs]
+    outs = []
+    for enable in [False, True]:
+        raf.distributed.ResetGradCompression()
+        dcfg.enable_data_parallel = enable
+        executor = VMExecutor(model._internal(xs[0]).mod, "cpu").make_executor()
+        outs.append([executor(x).numpy() for x in xs])
+    dcfg.enable_data_parallel = False
+    for sync, overlapped in zip(*outs):
+        check(overlapped, sync, rtol=1e-5, atol=1e-5)
+
+
+@with_communicators
+def test_async_data_parallel(communicator):
+    launch(communicator, run_async_data_parallel)
+
+
+@with_communicators
+def test_async_compressed(communicator):
+    launch(communicator, run_async_compressed)
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
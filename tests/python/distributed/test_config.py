@@ -7,7 +7,12 @@ from raf import distributed as dist
 
 def test_dumps():
     dcfg = dist.get_config()
-    expected = {"enable_data_parallel": 0, "zero_opt_level": 0, "enable_auto_dp_profiling": 0}
+    expected = {
+        "enable_data_parallel": 0,
+        "zero_opt_level": 0,
+        "enable_auto_dp_profiling": 0,
+        "grad_compression": "none",
+    }
     actual = dcfg.dumps()
     for key, val in expected.items():
         assert actual[key] == val
@@ -0,0 +1,266 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# pylint: disable=invalid-name, protected-access, too-many-locals, import-outside-toplevel
+"""Test collective communication operators on CPU with the shared-memory and TCP communicators.
+The ranks are local processes spawned by the test, so this test does not need mpirun.
+"""
+import pytest
+import numpy as np
+
+from cpu_launch import launch, linux_only, with_communicators
+
+
+def run_allreduce(rank, size, computation):
+    import raf
+    from raf.testing import check
+
+    class TestModel(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x, y):
+            z = raf.allreduce(x, computation=computation)
+            out = raf.allreduce([x, y], computation=computation)
+            return raf.concatenate([z, out[0], out[1]])
+
+    ranks = np.arange(1, size + 1, dtype="float32").reshape(size, 1, 1)
+    reduce = {"sum": np.sum, "prod": np.prod, "min": np.min, "max": np.max, "avg": np.mean}
+    n_x = np.ones((4, 4), dtype="float32") * (rank + 1)
+    n_y = np.ones((2, 4), dtype="float32") * (rank + 1)
+    model = TestModel()
+    model.to(device="cpu")
+    out = model(raf.array(n_x, device="cpu"), raf.array(n_y, device="cpu"))
+    target_x = reduce[computation](np.ones((size, 4, 4), dtype="float32") * ranks, axis=0)
+    target_y = reduce[computation](np.ones((size, 2, 4), dtype="float32") * ranks, axis=0)
+    check(out, np.concatenate([target_x, target_x, target_y]))
+
+
+def run_allreduce_fp16(rank, size):
+    import raf
+    from raf.testing import check
+
+    class TestModel(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x):
+            return raf.allreduce(x, computation="avg")
+
+    n_x = np.linspace(-1, 1, 12, dtype="float16").reshape(3, 4) * (rank + 1)
+    model = TestModel()
+    model.to(device="cpu")
+    out = model(raf.array(n_x, device="cpu"))
+    target = np.linspace(-1, 1, 12, dtype="float32").reshape(3, 4) * (size + 1) / 2
+    check(out, target.astype("float16"), rtol=1e-2, atol=1e-2)
+
+
+def run_allgather(rank, size):
+    import raf
+    from raf.testing import check
+
+    class TestModel(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x):
+            return raf.allgather(x, axis=1)
+
+    n_x = np.ones((2, 3), dtype="float32") * (rank + 1)
+    model = TestModel()
+    model.to(device="cpu")
+    out = model(raf.array(n_x, device="cpu"))
+    target = np.concatenate([np.ones((2, 3), dtype="float32") * (i + 1) for i in range(size)], 1)
+    check(out, target)
+
+
+def run_reduce_scatter(rank, size):
+    import raf
+    from raf.testing import check
+
+    class TestModel(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x):
+            return raf.reduce_scatter(x, computation="sum")
+
+    n_x = np.arange(size * 8, dtype="float32").reshape(size * 2, 4) * (rank + 1)
+    model = TestModel()
+    model.to(device="cpu")
+    out = model(raf.array(n_x, device="cpu"))
+    scale = sum(range(1, size + 1))
+    target = np.arange(size * 8, dtype="float32").reshape(size * 2, 4) * scale
+    check(out, target[rank * 2 : (rank + 1) * 2])
+
+
+def run_broadcast(rank, size):
+    import raf
+    from raf.testing import check
+
+    class TestModel(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x):
+            return raf.broadcast(x, root=size - 1)
+
+    n_x = np.ones((3, 5), dtype="float32") * (rank + 1)
+    model = TestModel()
+    model.to(device="cpu")
+    out = model(raf.array(n_x, device="cpu"))
+    check(out, np.ones((3, 5), dtype="float32") * size)
+
+
+def run_all_to_all(rank, size):
+    import raf
+    from raf.testing import check
+
+    class TestModel(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x):
+            return raf.all_to_all(x)
+
+    # Block i of rank r holds 10 * r + i, so block i of the output of rank r holds 10 * i + r.
+    n_x = np.repeat(np.arange(size, dtype="float32") + 10 * rank, 2).reshape(size * 2, 1)
+    model = TestModel()
+    model.to(device="cpu")
+    out = model(raf.array(n_x, device="cpu"))
+    target = np.repeat(np.arange(size, dtype="float32") * 10 + rank, 2).reshape(size * 2, 1)
+    check(out, target)
+
+
+def run_send_recv(rank, size):
+    import raf
+    from raf._core.ndarray import Symbol
+    from raf.testing import check
+
+    shape = [2, 2]
+    dtype = "float32"
+    nxt, prv = (rank + 1) % size, (rank - 1) % size
+
+    class TestModel(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x):
+            if rank == 0:
+                t = raf.send(x, peer=nxt)
+                y = raf.recv(peer=prv, shape=shape, dtype=dtype, token=t)
+            else:
+                y = raf.recv(peer=prv, shape=shape, dtype=dtype)
+                t = raf.send(x, peer=nxt, token=y)
+            return Symbol.make_tuple([raf.add(x, y), t])
+
+    n_x = np.ones(shape, dtype=dtype) * (rank + 1)
+    model = TestModel()
+    model.to(device="cpu")
+    out = model(raf.array(n_x, device="cpu"))
+    check(out[0], np.ones(shape, dtype=dtype) * (rank + 1 + prv + 1))
+
+
+def run_tune(rank, size, path):
+    from raf._ffi.distributed import TuneCPUCollectives
+
+    TuneCPUCollectives(path, 1 << 12, 2)
+    if rank == 0:
+        with open(path) as table:
+            keys = {line.split()[0] for line in table if not line.startswith("#")}
+        # The ranks run on two emulated hosts of a power-of-two size, so every algorithm applies.
+        expected = {
+            "allreduce/ring",
+            "allreduce/tree",
+            "allreduce/hierarchical",
+            "reduce_scatter/ring",
+            "reduce_scatter/halving",
+        }
+        assert {key.rsplit("/", 1)[0] for key in keys} == expected, keys
+    # The tuned table drives the planner of the following collectives.
+    run_allreduce(rank, size, "sum")
+    run_reduce_scatter(rank, size)
+
+
+def run_planner(rank, size):
+    from raf._ffi.distributed import PlanCPUCollective
+
+    # Under the network model, two hosts of two ranks favor the hierarchical allreduce, and four
+    # ranks favor the recursive-halving reduce-scatter, which takes two steps instead of three.
+    assert PlanCPUCollective("allreduce", 1 << 20) == "hierarchical"
+    assert PlanCPUCollective("reduce_scatter", 1 << 20) == "halving"
+    for computation in ["sum", "avg", "max"]:
+        run_allreduce(rank, size, computation)
+    run_reduce_scatter(rank, size)
+
+
+@with_communicators
+@pytest.mark.parametrize("computation", ["sum", "prod", "min", "max", "avg"])
+def test_allreduce(communicator, computation):
+    launch(communicator, run_allreduce, computation)
+
+
+@linux_only
+@pytest.mark.parametrize("algo", ["ring", "tree"])
+@pytest.mark.parametrize("computation", ["sum", "avg"])
+def test_tcp_allreduce_algo(algo, computation):
+    launch("tcp", run_allreduce, computation, extra_env={"RAF_CPU_ALLREDUCE_ALGO": algo})
+
+
+@linux_only
+@pytest.mark.parametrize("computation", ["sum", "avg"])
+def test_tcp_power_of_two(computation):
+    # The recursive-halving reduce-scatter is only a candidate for power-of-two groups.
+    launch("tcp", run_reduce_scatter, size=4)
+    launch("tcp", run_allreduce, computation, size=4)
+
+
+@linux_only
+def test_tcp_tune(tmp_path):
+    launch("tcp", run_tune, str(tmp_path / "collectives.txt"), size=4, host_ids=[0, 0, 1, 1])
+
+
+@linux_only
+def test_tcp_planner():
+    launch("tcp", run_planner, size=4, host_ids=[0, 0, 1, 1])
+
+
+@with_communicators
+def test_allreduce_fp16(communicator):
+    launch(communicator, run_allreduce_fp16)
+
+
+@with_communicators
+def test_allgather(communicator):
+    launch(communicator, run_allgather)
+
+
+@with_communicators
+def test_reduce_scatter(communicator):
+    launch(communicator, run_reduce_scatter)
+
+
+@with_communicators
+def test_broadcast(communicator):
+    launch(communicator, run_broadcast)
+
+
+@with_communicators
+def test_all_to_all(communicator):
+    launch(communicator, run_all_to_all)
+
+
+@with_communicators
+def test_send_recv(communicator):
+    launch(communicator, run_send_recv)
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
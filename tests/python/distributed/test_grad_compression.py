@@ -0,0 +1,157 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# pylint: disable=invalid-name, protected-access, too-many-locals, import-outside-toplevel
+"""Test the gradient compression operators on CPU against NumPy over several iterations, so that
+the residual feedback is covered. The compression inserted by AutoDataParallel is tested in
+tests/python/pass/test_pass_data_parallel.py.
+"""
+import pytest
+import numpy as np
+
+from cpu_launch import launch, with_communicators
+
+
+def run_topk_compression(rank, size):
+    import raf
+    from raf._op import sym
+    from raf.testing import check
+
+    class TestModel(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x):
+            compressed = sym._topk_compress(x, 0.5, "test")
+            values = raf.allgather(compressed[0], axis=0)
+            indices = raf.allgather(compressed[1], axis=0)
+            return sym._topk_decompress(values, indices, (2, 4), 1.0 / size)
+
+    # Every rank keeps its 4 largest elements, and the others are sent in the next iteration.
+    n_x = np.arange(8, dtype="float32").reshape(2, 4) * (rank + 1)
+    mean = np.arange(8, dtype="float32").reshape(2, 4) * (size + 1) / 2
+    model = TestModel()
+    model.to(device="cpu")
+    out = model(raf.array(n_x, device="cpu"))
+    check(out, np.where(mean >= mean[1, 0], mean, 0))
+    out = model(raf.array(np.zeros_like(n_x), device="cpu"))
+    check(out, np.where(mean < mean[1, 0], mean, 0))
+    # A reset drops the residuals, so nothing is left to send in the next iteration.
+    model(raf.array(n_x, device="cpu"))
+    raf.distributed.ResetGradCompression()
+    out = model(raf.array(np.zeros_like(n_x), device="cpu"))
+    check(out, np.zeros_like(mean))
+
+
+def compression_inputs(size, iteration, shape):
+    """The gradients of all the ranks at an iteration, which every rank generates alike."""
+    return [
+        np.random.RandomState(iteration * size + r).randn(*shape).astype("float32")
+        for r in range(size)
+    ]
+
+
+def run_onebit_compression(rank, size):
+    import raf
+    from raf._op import sym
+    from raf.testing import check
+
+    class TestModel(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x):
+            compressed = sym._onebit_compress(x, "test_onebit")
+            bits = raf.allgather(compressed[0], axis=0)
+            scales = raf.allgather(compressed[1], axis=0)
+            return sym._onebit_decompress(bits, scales, (3, 5), 1.0 / size)
+
+    def decode(acc):
+        # The positive and the negative elements are restored to their mean magnitudes.
+        pos = acc[acc >= 0].mean() if (acc >= 0).any() else 0
+        neg = acc[acc < 0].mean() if (acc < 0).any() else 0
+        return np.where(acc >= 0, pos, neg).astype("float32")
+
+    model = TestModel()
+    model.to(device="cpu")
+    # 15 elements take 2 bytes of signs, so the padding bits are covered as well.
+    residuals = [np.zeros((3, 5), dtype="float32")] * size
+    for iteration in range(2):
+        grads = compression_inputs(size, iteration, (3, 5))
+        accs = [residual + grad for residual, grad in zip(residuals, grads)]
+        decoded = [decode(acc) for acc in accs]
+        residuals = [acc - dec for acc, dec in zip(accs, decoded)]
+        out = model(raf.array(grads[rank], device="cpu"))
+        check(out, np.mean(decoded, axis=0), rtol=1e-5, atol=1e-5)
+
+
+def run_powersgd_compression(rank, size):
+    import raf
+    from raf._op import sym
+    from raf.testing import check
+
+    rows, cols, approx_rank = 8, 4, 2
+
+    class TestModel(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x):
+            p = sym._powersgd_p(x, approx_rank, "test_powersgd")
+            p_sum = raf.allreduce(p, computation="sum")
+            pq = sym._powersgd_q(p_sum, (rows, cols), "test_powersgd")
+            q_sum = raf.allreduce(pq[1], computation="sum")
+            out = sym._powersgd_decompress(pq[0], q_sum, (rows, cols), "test_powersgd", 1.0 / size)
+            return p_sum, out
+
+    def orthonormalize(p):
+        p = p.astype("float64")
+        for r in range(p.shape[1]):
+            for prev in range(r):
+                p[:, r] -= np.dot(p[:, r], p[:, prev]) * p[:, prev]
+            p[:, r] /= np.linalg.norm(p[:, r])
+        return p
+
+    model = TestModel()
+    model.to(device="cpu")
+    residuals = [np.zeros((rows, cols), dtype="float32")] * size
+    q = None
+    for iteration in range(2):
+        grads = compression_inputs(size, iteration, (rows, cols))
+        ms = [residual + grad for residual, grad in zip(residuals, grads)]
+        m_p_sum, m_out = model(raf.array(grads[rank], device="cpu"))
+        m_sum = np.sum(ms, axis=0)
+        if q is None:
+            # The initial Q is drawn in C++, so it is recovered from P = M Q, where M has full
+            # column rank.
+            q = np.linalg.lstsq(m_sum, m_p_sum.numpy(), rcond=None)[0]
+        p_sum = m_sum @ q
+        p_orth = orthonormalize(p_sum)
+        # Q is warm-started by the average of this iteration.
+        q = sum(m.T @ p_orth for m in ms) / size
+        out = p_orth @ q.T
+        residuals = [(m - out).astype("float32") for m in ms]
+        check(m_p_sum, p_sum, rtol=1e-4, atol=1e-4)
+        check(m_out, out, rtol=1e-4, atol=1e-4)
+
+
+@with_communicators
+def test_topk_compression(communicator):
+    launch(communicator, run_topk_compression)
+
+
+@with_communicators
+def test_onebit_compression(communicator):
+    launch(communicator, run_onebit_compression)
+
+
+@with_communicators
+def test_powersgd_compression(communicator):
+    launch(communicator, run_powersgd_compression)
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
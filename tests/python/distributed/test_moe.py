@@ -0,0 +1,123 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# pylint: disable=invalid-name, too-many-locals, import-outside-toplevel
+"""Test the expert-parallel mixture-of-experts layer on CPU, whose experts are partitioned across
+local processes. Expert e scales its tokens by e + 1, so that the output tells which expert
+processed a token.
+"""
+import pytest
+import numpy as np
+
+from cpu_launch import launch, with_communicators
+
+
+def route(probs, k, capacity):
+    """The top-k experts of the tokens and whether each choice is admitted. The first choices of
+    all the tokens are admitted before their second choices, and an expert admits at most
+    capacity tokens in the order of the tokens."""
+    num_tokens, num_experts = probs.shape
+    choices = np.argsort(-probs, axis=1, kind="stable")[:, :k]
+    admitted = np.zeros((num_tokens, k), dtype="bool")
+    counts = np.zeros(num_experts, dtype="int32")
+    for j in range(k):
+        for t in range(num_tokens):
+            if counts[choices[t, j]] < capacity:
+                counts[choices[t, j]] += 1
+                admitted[t, j] = True
+    return choices, admitted
+
+
+def make_model(num_experts, capacity, k):
+    import raf
+    from raf.distributed import moe_layer
+
+    class TestModel(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x, logits, scale):
+            return moe_layer(x, logits, lambda h: raf.multiply(h, scale), num_experts, capacity, k)
+
+    model = TestModel()
+    model.to(device="cpu")
+    return model
+
+
+def run_moe(rank, size):
+    import raf
+    from raf.testing import check
+
+    num_tokens, num_experts, hidden, k, capacity = 8, 2 * size, 4, 2, 2
+    rng = np.random.RandomState(rank)
+    n_x = rng.uniform(-1, 1, (num_tokens, hidden)).astype("float32")
+    n_logits = rng.uniform(-1, 1, (num_tokens, num_experts)).astype("float32")
+    n_scale = np.arange(2 * rank, 2 * rank + 2, dtype="float32").reshape(2, 1, 1) + 1
+    model = make_model(num_experts, capacity, k)
+    out = model(*[raf.array(n, device="cpu") for n in (n_x, n_logits, n_scale)])
+
+    probs = np.exp(n_logits) / np.sum(np.exp(n_logits), axis=1, keepdims=True)
+    choices, admitted = route(probs, k, capacity)
+    target = np.zeros((num_tokens, hidden), dtype="float32")
+    for t, j in zip(*np.nonzero(admitted)):
+        expert = choices[t, j]
+        target[t] += probs[t, expert] * n_x[t] * (expert + 1)
+    assert not admitted.all(), "Expected some tokens to be dropped"
+    check(out, target, rtol=1e-4, atol=1e-4)
+
+
+def run_moe_grad(rank, size):
+    import raf
+    from raf.testing import check
+
+    num_tokens, num_experts, hidden, k, capacity = 8, 2 * size, 4, 2, 2
+    # The (first, second) choices of the tokens. Experts 0 and 1 are full after the first choices
+    # of tokens 0-3, so the second choices of tokens 1 and 3 are the only admitted ones, and both
+    # choices of tokens 6 and 7 are dropped.
+    preferences = [(0, 1), (0, 2), (1, 0), (1, 3), (2, 3), (3, 2), (0, 1), (1, 0)]
+    rng = np.random.RandomState(rank)
+    n_logits = rng.uniform(-1, 0, (num_tokens, num_experts)).astype("float32")
+    for t, (first, second) in enumerate(preferences):
+        n_logits[t, first] += 3
+        n_logits[t, second] += 2
+    n_x = rng.uniform(-1, 1, (num_tokens, hidden)).astype("float32")
+    n_dy = rng.uniform(-1, 1, (num_tokens, hidden)).astype("float32")
+    n_scale = np.arange(2 * rank, 2 * rank + 2, dtype="float32").reshape(2, 1, 1) + 1
+    m_x = raf.array(n_x, device="cpu")
+    m_logits = raf.array(n_logits, device="cpu")
+    m_x.requires_grad = True
+    m_logits.requires_grad = True
+    model = make_model(num_experts, capacity, k)
+    out = model(m_x, m_logits, raf.array(n_scale, device="cpu"))
+    out.backward(raf.array(n_dy, device="cpu"))
+
+    probs = np.exp(n_logits) / np.sum(np.exp(n_logits), axis=1, keepdims=True)
+    choices, admitted = route(probs, k, capacity)
+    assert admitted[[1, 3]].all() and not admitted[[6, 7]].any()
+    # out[t] = sum_j gate[t, j] * (choices[t, j] + 1) * x[t] over the admitted choices j, where the
+    # gates are gathered from the probabilities.
+    scales = (choices + 1) * admitted
+    gates = np.take_along_axis(probs, choices, axis=1)
+    dx = np.sum(gates * scales, axis=1, keepdims=True) * n_dy
+    dgates = scales * np.sum(n_x * n_dy, axis=1, keepdims=True)
+    dprobs = np.zeros_like(probs)
+    np.put_along_axis(dprobs, choices, dgates, axis=1)
+    dlogits = probs * (dprobs - np.sum(dprobs * probs, axis=1, keepdims=True))
+    check(m_x.grad, dx, rtol=1e-4, atol=1e-4)
+    check(m_logits.grad, dlogits, rtol=1e-4, atol=1e-4)
+    assert not np.any(m_x.grad.numpy()[6:])
+
+
+@with_communicators
+def test_moe(communicator):
+    launch(communicator, run_moe)
+
+
+@with_communicators
+def test_moe_grad(communicator):
+    launch(communicator, run_moe_grad)
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
@@ -0,0 +1,69 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# pylint: disable=invalid-name, too-many-locals, import-outside-toplevel
+"""Test pipeline-parallel training on CPU, whose stages run on local processes."""
+import pytest
+import numpy as np
+
+from cpu_launch import launch, with_communicators
+
+
+def run_pipeline(rank, size):
+    import raf
+    from raf.distributed.pipeline import PipelineParallel
+    from raf.testing import check
+
+    num_micro_batches = 4
+    rand = np.random.RandomState(0)
+    n_ws = [rand.randn(16, 16).astype("float32") for _ in range(size)]
+    n_xs = [rand.randn(4, 16).astype("float32") for _ in range(num_micro_batches)]
+
+    class TestModel(raf.Model):
+        def build(self):
+            for i, n_w in enumerate(n_ws):
+                setattr(self, "w%d" % i, raf.array(n_w, device="cpu"))
+
+        @raf.model.trace
+        def forward(self, x):
+            for i in range(size):
+                x = raf.relu(raf.matmul(x, getattr(self, "w%d" % i)))
+            return raf.sum(x)
+
+    model = TestModel()
+    model.to(device="cpu")
+    for i in range(size):
+        getattr(model, "w%d" % i).requires_grad = True
+    pipeline = PipelineParallel(model, num_micro_batches)
+    losses, grads = pipeline([(raf.array(n_x, device="cpu"),) for n_x in n_xs])
+
+    # Each matmul dominates the cost of a layer, so each stage owns the weight of one layer.
+    assert list(grads.keys()) == ["w%d" % rank], grads.keys()
+    ref_losses, ref_grad = [], np.zeros_like(n_ws[rank])
+    for n_x in n_xs:
+        hs, acts = [], [n_x]
+        for n_w in n_ws:
+            hs.append(acts[-1] @ n_w)
+            acts.append(np.maximum(hs[-1], 0))
+        ref_losses.append(np.sum(acts[-1]))
+        d_act = np.full_like(acts[-1], 1.0 / num_micro_batches)
+        for i in reversed(range(size)):
+            d_h = d_act * (hs[i] > 0)
+            if i == rank:
+                ref_grad += acts[i].T @ d_h
+            d_act = d_h @ n_ws[i].T
+    check(grads["w%d" % rank], ref_grad, rtol=1e-4, atol=1e-4)
+    if rank == size - 1:
+        for loss, ref_loss in zip(losses, ref_losses):
+            check(loss, ref_loss, rtol=1e-4, atol=1e-4)
+    else:
+        assert losses is None
+
+
+@with_communicators
+def test_pipeline(communicator):
+    launch(communicator, run_pipeline)
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
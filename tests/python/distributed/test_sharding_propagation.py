@@ -0,0 +1,140 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# pylint: disable=invalid-name, protected-access, too-many-locals, import-outside-toplevel
+"""Test the functions rewritten by ShardingPropagation on CPU against NumPy. Every rank feeds
+its own shards of the sharded inputs and gets the full outputs.
+"""
+import pytest
+import numpy as np
+
+from cpu_launch import launch, with_communicators
+
+
+def make_case(name, size):
+    """The forward function, the inputs by name, the sharded axes of the inputs by name and the
+    NumPy reference of a test case. The sharded axes are divisible by size."""
+    import raf
+
+    rand = np.random.RandomState(0)
+
+    def randn(*shape):
+        return rand.randn(*shape).astype("float32")
+
+    def softmax(x, axis):
+        e = np.exp(x - x.max(axis=axis, keepdims=True))
+        return e / e.sum(axis=axis, keepdims=True)
+
+    n = size
+    if name in ["column_row", "row_row"]:
+        inputs = {"x": randn(2 * n, 4 * n), "w0": randn(4 * n, 2 * n), "w1": randn(2 * n, 4 * n)}
+        axes = {"w0": 1, "w1": 0} if name == "column_row" else {"w0": 0, "w1": 0}
+        forward = lambda x, w0, w1: raf.matmul(raf.relu(raf.matmul(x, w0)), w1)
+        ref = lambda x, w0, w1: np.maximum(x @ w0, 0) @ w1
+    elif name == "softmax":
+        inputs = {"x": randn(2 * n, 4 * n)}
+        axes = {"x": 1}
+        forward = lambda x: raf.softmax(x, axis=-1)
+        ref = lambda x: softmax(x, -1)
+    elif name == "layer_norm":
+        inputs = {"x": randn(2 * n, 6), "w0": randn(6), "w1": randn(6)}
+        axes = {"x": 0}
+        forward = lambda x, w0, w1: raf.layer_norm(x, w0, w1, axis=-1, eps=1e-5)
+
+        def ref(x, w0, w1):
+            mean = x.mean(axis=-1, keepdims=True)
+            var = x.var(axis=-1, keepdims=True)
+            return (x - mean) / np.sqrt(var + 1e-5) * w0 + w1
+
+    elif name == "sum_mean_partial":
+        inputs = {"x": randn(2, 4 * n), "w0": randn(4 * n, 3)}
+        axes = {"w0": 0}
+
+        def forward(x, w0):
+            h = raf.matmul(x, w0)
+            return raf.add(raf.sum(h, axis=1, keepdims=True), raf.mean(h, axis=0, keepdims=True))
+
+        def ref(x, w0):
+            h = x @ w0
+            return h.sum(axis=1, keepdims=True) + h.mean(axis=0, keepdims=True)
+
+    elif name == "broadcast":
+        inputs = {"x": randn(2 * n, 4), "w0": randn(4), "w1": randn(2 * n, 1), "w2": randn(1, 4)}
+        axes = {"x": 0, "w1": 0}
+        forward = lambda x, w0, w1, w2: raf.add(raf.multiply(raf.add(x, w0), w1), w2)
+        ref = lambda x, w0, w1, w2: (x + w0) * w1 + w2
+    elif name == "all_to_all_3d":
+        # The softmax along the sharded axis reshards the input to the other divisible axis.
+        inputs = {"x": randn(2 * n, 2 * n, 5)}
+        axes = {"x": 0}
+        forward = lambda x: raf.softmax(x, axis=0)
+        ref = lambda x: softmax(x, 0)
+    elif name == "all_to_all_3d_last":
+        inputs = {"x": randn(2 * n, 5, 2 * n)}
+        axes = {"x": 2}
+        forward = lambda x: raf.softmax(x, axis=2)
+        ref = lambda x: softmax(x, 2)
+    else:
+        raise ValueError("Unknown case " + name)
+    return forward, inputs, axes, ref
+
+
+def run_sharding_propagation(rank, size, case):
+    import raf
+    from raf._core.executor import VMExecutor
+    from raf._ffi.pass_ import ShardingPropagation
+    from raf.distributed.sharding import make_shard_spec
+    from raf.testing import check
+
+    forward, inputs, axes, ref = make_case(case, size)
+    num_weights = len(inputs) - 1
+
+    class TestModel(raf.Model):
+        def build(self):
+            for i in range(num_weights):
+                setattr(self, "w%d" % i, raf.array(inputs["w%d" % i], device="cpu"))
+
+        @raf.model.trace
+        def forward(self, x):
+            return forward(x, *[getattr(self, "w%d" % i) for i in range(num_weights)])
+
+    model = TestModel()
+    model.to(device="cpu")
+    record = model._internal(raf.array(inputs["x"], device="cpu"))
+    specs = {}
+    for name, axis in axes.items():
+        phy_shape = [size if i == axis else 1 for i in range(inputs[name].ndim)]
+        specs[name] = make_shard_spec(phy_shape, ranks=size)
+    mod = ShardingPropagation(specs)(record.mod)
+
+    # Each rank only feeds its own shards of the sharded inputs.
+    args = []
+    for name in ["x"] + list(record.named_params.keys()):
+        n_in = inputs[name]
+        if name in axes:
+            n_in = np.split(n_in, size, axis=axes[name])[rank]
+        args.append(raf.array(n_in, device="cpu"))
+    out = VMExecutor(mod, "cpu").make_executor()(*args)
+    check(out, ref(**inputs), rtol=1e-4, atol=1e-4)
+
+
+@with_communicators
+@pytest.mark.parametrize(
+    "case",
+    [
+        "column_row",
+        "row_row",
+        "softmax",
+        "layer_norm",
+        "sum_mean_partial",
+        "broadcast",
+        "all_to_all_3d",
+        "all_to_all_3d_last",
+    ],
+)
+def test_sharding_propagation(communicator, case):
+    launch(communicator, run_sharding_propagation, case)
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
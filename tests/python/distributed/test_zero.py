@@ -0,0 +1,84 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# pylint: disable=invalid-name, too-many-locals, import-outside-toplevel
+"""Test ZeRO-3 data-parallel training with SGD on CPU against the training without partitioning.
+The IR of the partitioned parameters is tested in tests/python/pass/test_pass_partition_gradient.py.
+"""
+import pytest
+import numpy as np
+
+from cpu_launch import launch, with_communicators
+
+
+def run_zero3(rank, size):
+    import raf
+    from raf import distributed as dist
+    from raf.model import Linear
+    from raf.optim.sgd import with_sgd
+    from raf.optim.utils import split_ndarray_with_padding
+    from raf.testing import check, run_vm_model
+
+    class TestModel(raf.Model):
+        def build(self):
+            self.linear1 = Linear(8, 10)
+            self.linear2 = Linear(10, 3)
+
+        @raf.model.trace
+        def forward(self, x):
+            out = raf.relu(self.linear1(x))
+            out = self.linear2(out)
+            return raf.sum(out)
+
+    # The first axes of 10 and 3 are not divisible by the ranks, so the partitions are padded.
+    rand = np.random.RandomState(0)
+    n_params = {
+        "linear1.w": rand.randn(10, 8).astype("float32"),
+        "linear1.b": rand.randn(10).astype("float32"),
+        "linear2.w": rand.randn(3, 10).astype("float32"),
+        "linear2.b": rand.randn(3).astype("float32"),
+    }
+    # Each rank trains on its own data.
+    rand = np.random.RandomState(rank + 1)
+    n_xs = [rand.randn(4, 8).astype("float32") for _ in range(2)]
+
+    def train(zero_opt_level):
+        dcfg.zero_opt_level = zero_opt_level
+        model = TestModel()
+        model.to(device="cpu")
+        model.train_mode()
+        for name, param in model.state().items():
+            param.update(raf.array(n_params[name], device="cpu"))
+        trainer = with_sgd(learning_rate=0.1, momentum=0.01)(model)
+        dy = raf.array(np.ones((), dtype="float32"), device="cpu")
+        losses = []
+        for n_x in n_xs:
+            x = raf.array(n_x, device="cpu")
+            losses.append(run_vm_model(trainer, "cpu", [dy, x])[0].numpy())
+        return model, trainer, losses
+
+    dcfg = dist.get_config()
+    saved = dcfg.enable_data_parallel, dcfg.zero_opt_level
+    dcfg.enable_data_parallel = True
+    try:
+        model, _, ref_losses = train(0)
+        ref_params = {name: param.numpy() for name, param in model.state().items()}
+        _, trainer, losses = train(3)
+    finally:
+        dcfg.enable_data_parallel, dcfg.zero_opt_level = saved
+
+    # Each rank keeps the partition of the parameters trained with the averaged gradients.
+    for name, ref_param in ref_params.items():
+        shard = getattr(trainer.ad_model, f"{name}.zero3")
+        check(shard, split_ndarray_with_padding(ref_param, size)[rank], rtol=1e-4, atol=1e-4)
+    for loss, ref_loss in zip(losses, ref_losses):
+        check(loss, ref_loss, rtol=1e-4, atol=1e-4)
+
+
+@with_communicators
+def test_zero3(communicator):
+    launch(communicator, run_zero3)
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
@@ -0,0 +1,16 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+"""Fixtures shared by the tests of the native CPU dialect."""
+import pytest
+
+from raf._core.backends import cpu as cpu_config
+
+
+@pytest.fixture(params=["scalar", "sse4.1", "avx2", "avx512"])
+def isa(request):
+    """Run the test with each ISA. An ISA the host does not support falls back to a lower one."""
+    prev = cpu_config.isa
+    cpu_config.isa = request.param
+    yield cpu_config.isa
+    cpu_config.isa = prev
@@ -0,0 +1,85 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# pylint: disable=protected-access,attribute-defined-outside-init,no-self-use
+import numpy as np
+import pytest
+
+import raf
+from raf._op.dialect import DialectPreference
+from raf.testing import randn, check, run_vm_model, with_seed
+
+
+class GemmModel(raf.Model):
+    def build(self, op):
+        self.op = op
+
+    @raf.model.trace
+    def forward(self, x1, x2):
+        return self.op(x1, x2)
+
+
+def verify_gemm(op, a_shape, b_shape, ref):
+    m_a, n_a = randn(a_shape)
+    m_b, n_b = randn(b_shape)
+    model = GemmModel(getattr(raf._op.sym, op))
+    with DialectPreference(["cpu"]):
+        m_y = model(m_a, m_b)
+        v_y = run_vm_model(model, "cpu", [m_a, m_b])
+    n_y = ref(n_a, n_b)
+    check(m_y, n_y, rtol=1e-4, atol=1e-4)
+    check(v_y, n_y, rtol=1e-4, atol=1e-4)
+
+
+def transpose_last(x, transpose):
+    return np.swapaxes(x, -1, -2) if transpose else x
+
+
+@with_seed(0)
+@pytest.mark.parametrize("mnk", [(1, 1, 1), (7, 5, 3), (64, 64, 64), (129, 67, 300)])
+@pytest.mark.parametrize("trans", [(False, False), (False, True), (True, False), (True, True)])
+def test_matmul(isa, mnk, trans):  # pylint: disable=unused-argument
+    m, n, k = mnk
+    ta, tb = trans
+    op = "matmul" + ("_" + ("t" if ta else "n") + ("t" if tb else "n") if ta or tb else "")
+    a_shape = (k, m) if ta else (m, k)
+    b_shape = (n, k) if tb else (k, n)
+    ref = lambda a, b: np.matmul(transpose_last(a, ta), transpose_last(b, tb))
+    verify_gemm(op, a_shape, b_shape, ref)
+
+
+@with_seed(0)
+@pytest.mark.parametrize("mnk", [(8, 16, 32), (33, 1000, 129)])
+def test_dense(isa, mnk):  # pylint: disable=unused-argument
+    m, n, k = mnk
+    verify_gemm("dense", (m, k), (n, k), lambda a, b: np.matmul(a, b.T))
+
+
+@with_seed(0)
+@pytest.mark.parametrize("batches", [(1, 1), (3, 3), (1, 4), (4, 1)])
+@pytest.mark.parametrize("trans", [(False, False), (False, True), (True, False), (True, True)])
+def test_batch_matmul(isa, batches, trans):  # pylint: disable=unused-argument
+    m, n, k = 17, 33, 40
+    ta, tb = trans
+    op = "batch_matmul" + ("_" + ("t" if ta else "n") + ("t" if tb else "n") if ta or tb else "")
+    a_shape = (batches[0],) + ((k, m) if ta else (m, k))
+    b_shape = (batches[1],) + ((n, k) if tb else (k, n))
+    ref = lambda a, b: np.matmul(transpose_last(a, ta), transpose_last(b, tb))
+    verify_gemm(op, a_shape, b_shape, ref)
+
+
+@pytest.mark.parametrize(
+    "op,a_shape,b_shape",
+    [
+        ("matmul", (5, 0), (0, 7)),
+        ("dense", (5, 0), (7, 0)),
+        ("batch_matmul", (2, 5, 0), (2, 0, 7)),
+    ],
+)
+def test_empty_reduction(op, a_shape, b_shape):
+    # An empty sum is zero, so the output must be filled even though no block is multiplied.
+    verify_gemm(op, a_shape, b_shape, lambda a, b: np.zeros(a.shape[:-1] + (7,), dtype="float32"))
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
@@ -0,0 +1,149 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# pylint: disable=protected-access,attribute-defined-outside-init,no-self-use
+import numpy as np
+import pytest
+
+import raf
+from raf._core.backends import cpu as cpu_config
+from raf._op.dialect import DialectPreference
+from raf.testing import randn, randint, check, run_vm_model, with_seed
+
+
+class UnaryModel(raf.Model):
+    def build(self, op):
+        self.op = op
+
+    @raf.model.trace
+    def forward(self, x):
+        return self.op(x)
+
+
+class BinaryModel(raf.Model):
+    def build(self, op):
+        self.op = op
+
+    @raf.model.trace
+    def forward(self, x1, x2):
+        return self.op(x1, x2)
+
+
+def run_with_dialect(dialect, model, args):
+    """Run the model with the interpreter and the VM, both dispatching to the given dialect."""
+    with DialectPreference([dialect]):
+        m_y = model(*args)
+        v_y = run_vm_model(model, "cpu", args)
+    return m_y, v_y
+
+
+def verify_against_tvm(model, args, rtol=1e-5, atol=1e-5):
+    t_y, _ = run_with_dialect("tvm", model, args)
+    m_y, v_y = run_with_dialect("cpu", model, args)
+    check(m_y, t_y, rtol=rtol, atol=atol)
+    check(v_y, t_y, rtol=rtol, atol=atol)
+
+
+@with_seed(0)
+@pytest.mark.parametrize("shape", [(), (1,), (7,), (3, 17), (2, 3, 4, 5), (65537,)])
+@pytest.mark.parametrize(
+    "op",
+    [
+        "copy",
+        "negative",
+        "abs",
+        "relu",
+        "sqrt",
+        "rsqrt",
+        "reciprocal",
+        "ceil",
+        "floor",
+        "trunc",
+    ],
+)
+def test_vectorized_unary(isa, op, shape):  # pylint: disable=unused-argument
+    positive = op in ["sqrt", "rsqrt", "reciprocal"]
+    m_x, _ = randn(shape, positive=positive)
+    verify_against_tvm(UnaryModel(getattr(raf._op.sym, op)), [m_x])
+
+
+@with_seed(0)
+@pytest.mark.parametrize("shape", [(), (7,), (3, 17), (65537,)])
+@pytest.mark.parametrize("dtype", ["float32", "float64"])
+@pytest.mark.parametrize(
+    "op", ["exp", "log", "log2", "sin", "cos", "atan", "tanh", "erf", "sigmoid", "gelu", "sign"]
+)
+def test_scalar_unary(op, shape, dtype):
+    m_x, _ = randn(shape, dtype=dtype, positive=op in ["log", "log2"])
+    verify_against_tvm(UnaryModel(getattr(raf._op.sym, op)), [m_x], rtol=1e-4, atol=1e-4)
+
+
+@pytest.mark.parametrize("shape", [(3, 4), (65537,)])
+@pytest.mark.parametrize("dtype", ["int32", "int64"])
+@pytest.mark.parametrize("op", ["copy", "negative", "abs", "relu", "zeros_like", "ones_like"])
+def test_integer_unary(op, shape, dtype):
+    m_x, _ = randint(shape, low=-100, high=100, dtype=dtype)
+    verify_against_tvm(UnaryModel(getattr(raf._op.sym, op)), [m_x])
+
+
+@with_seed(0)
+@pytest.mark.parametrize(
+    "shapes",
+    [
+        [(), ()],
+        [(5,), (5,)],
+        [(3, 4), (4,)],
+        [(3, 1), (1, 4)],
+        [(4,), (3, 4)],
+        [(2, 3, 4, 5), (3, 1, 5)],
+        [(2, 1, 3, 1), (1, 5, 1, 4)],
+        [(), (6, 7)],
+        [(256, 1, 300), (1, 3, 300)],
+    ],
+)
+@pytest.mark.parametrize(
+    "op", ["add", "subtract", "multiply", "divide", "maximum", "minimum", "power"]
+)
+def test_broadcast_binary(isa, op, shapes):  # pylint: disable=unused-argument
+    m_x1, _ = randn(shapes[0], positive=op == "power")
+    m_x2, _ = randn(shapes[1], positive=op == "divide")
+    verify_against_tvm(BinaryModel(getattr(raf._op.sym, op)), [m_x1, m_x2], rtol=1e-4, atol=1e-4)
+
+
+@with_seed(0)
+@pytest.mark.parametrize("shapes", [[(3, 4), (4,)], [(2, 1, 3), (5, 1)]])
+@pytest.mark.parametrize("dtype", ["float64", "int32", "int64"])
+@pytest.mark.parametrize("op", ["add", "subtract", "multiply", "maximum", "minimum"])
+def test_typed_binary(op, shapes, dtype):
+    if dtype.startswith("int"):
+        m_x1, _ = randint(shapes[0], low=-100, high=100, dtype=dtype)
+        m_x2, _ = randint(shapes[1], low=-100, high=100, dtype=dtype)
+    else:
+        m_x1, _ = randn(shapes[0], dtype=dtype)
+        m_x2, _ = randn(shapes[1], dtype=dtype)
+    verify_against_tvm(BinaryModel(getattr(raf._op.sym, op)), [m_x1, m_x2])
+
+
+def test_fallback_to_tvm():
+    # int8 is not supported by the CPU kernels, so the call falls back to the tvm dialect.
+    m_x1, n_x1 = randint((3, 4), low=-10, high=10, dtype="int8")
+    m_x2, n_x2 = randint((3, 4), low=-10, high=10, dtype="int8")
+    model = BinaryModel(raf._op.sym.add)
+    with DialectPreference(["cpu", "tvm"]):
+        m_y = model(m_x1, m_x2)
+        v_y = run_vm_model(model, "cpu", [m_x1, m_x2])
+    check(m_y, np.add(n_x1, n_x2))
+    check(v_y, np.add(n_x1, n_x2))
+
+
+def test_isa_config():
+    prev = cpu_config.isa
+    assert prev in ["scalar", "sse4.1", "avx2", "avx512"]
+    cpu_config.isa = "scalar"
+    assert cpu_config.isa == "scalar"
+    cpu_config.isa = prev
+    assert cpu_config.isa == prev
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
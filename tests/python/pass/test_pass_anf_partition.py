@@ -8,7 +8,8 @@ import numpy as np
 import tvm
 import raf
 from raf.ir import RAFSequential, ScopeBuilder
-from raf._ffi.pass_ import InferType, PartitionANF
+from raf._ffi.pass_ import InferType, PartitionANF, PartitionANFByCost, PipelineStage
+from raf._core.device import Device
 from raf._core.executor import VMExecutor
 from raf._core.ir_ext import extended_var
 from raf._core.module import IRModule
@@ -198,5 +199,75 @@ def test_tuple(device):
     check(m_z, ref_z)
 
 
+MLP_SHAPES = [(8, 64), (64, 64), (64, 64)]
+
+
+class MLP(raf.Model):
+    def build(self):
+        pass
+
+    @raf.model.trace
+    def forward(self, x, w1, w2):
+        a1 = raf.matmul(x, w1)
+        a2 = raf.relu(a1)
+        a3 = raf.matmul(a2, w2)
+        a4 = raf.relu(a3)
+        return a4
+
+
+def test_partition_by_cost():
+    model = MLP()
+    args = [raf.array(np.random.randn(*shape), dtype="float32") for shape in MLP_SHAPES]
+    ref_z = model(*args)
+
+    mod = model._internal(*args).mod
+    with Device("cpu"):
+        mod = PartitionANFByCost(2, False)(mod)
+
+    # The matmuls dominate the cost, so each partition gets one matmul and one relu.
+    partitions = [
+        value for value in _let_values(mod["main"].body) if isinstance(value, tvm.relay.Function)
+    ]
+    assert len(partitions) == 2
+    for func in partitions:
+        calls = [value for value in _let_values(func.body) if isinstance(value, tvm.relay.Call)]
+        ops = [call.op.name for call in calls]
+        assert ops == ["raf.op.matmul", "raf.op.relu"], ops
+
+    executor = VMExecutor(mod, "cpu")
+    m_z = executor.make_executor()(*args)
+    check(m_z, ref_z)
+
+
+def test_pipeline_stage():
+    model = MLP()
+    args = [raf.array(np.random.randn(*shape), dtype="float32") for shape in MLP_SHAPES]
+    mod = model._internal(*args).mod
+
+    with Device("cpu"):
+        stage_0 = PipelineStage(2, 0, False)(mod)["main"]
+        stage_1 = PipelineStage(2, 1, False)(mod)["main"]
+    assert int(stage_0.attrs["PipelineInputs"]) == 0
+    assert [param.name_hint for param in stage_0.params] == ["x", "w1"]
+    assert len(stage_0.checked_type.ret_type.fields) == 1
+    assert int(stage_1.attrs["PipelineInputs"]) == 1
+    assert [param.name_hint for param in stage_1.params[1:]] == ["w2"]
+
+    # Running the stages one after another is equivalent to running the model.
+    ref_z = model(*args)
+    a2 = VMExecutor(IRModule.from_expr(stage_0), "cpu").make_executor()(args[0], args[1])[0]
+    a2 = raf._core.ndarray.ndarray.from_tensor_value(a2)
+    m_z = VMExecutor(IRModule.from_expr(stage_1), "cpu").make_executor()(a2, args[2])
+    check(m_z, ref_z)
+
+
+def _let_values(body):
+    values = []
+    while isinstance(body, tvm.relay.Let):
+        values.append(body.value)
+        body = body.body
+    return values
+
+
 if __name__ == "__main__":
     pytest.main([__file__])
@@ -0,0 +1,138 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# pylint: disable=missing-function-docstring, missing-class-docstring, invalid-name
+# pylint: disable=protected-access, redefined-outer-name
+"""Test the order of the ops scheduled by AsyncDataParallelSchedule. The numeric results on
+multiple ranks are tested in tests/python/distributed/test_async_data_parallel.py.
+"""
+import re
+
+import pytest
+import numpy as np
+
+import raf
+from raf import distributed as dist
+from raf._op import sym
+from raf._ffi.pass_ import AsyncDataParallelSchedule, AutoDataParallel, AutoDiff, InferType
+from raf.ir import RAFSequential
+from raf.testing import randn
+
+
+@pytest.fixture
+def dcfg():
+    """Restore the global config that the tests change."""
+    config = dist.get_config()
+    fields = [
+        "enable_data_parallel",
+        "group_bucket_size",
+        "grad_compression",
+        "grad_compression_powersgd_rank",
+    ]
+    saved = {field: getattr(config, field) for field in fields}
+    yield config
+    for field, value in saved.items():
+        setattr(config, field, value)
+
+
+def get_ops(mod):
+    return re.findall(r"raf\.op\.([a-z_]+)\(", raf.ir.AsText(mod))
+
+
+def test_bucket(dcfg):
+    class TestModel(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x):
+            a = raf.relu(x)
+            ga = raf.allreduce(a, computation="avg")
+            b = raf.matmul(a, a)
+            gb = raf.allreduce(b, computation="avg")
+            c = raf.matmul(b, b)
+            gc = raf.allreduce(c, computation="avg")
+            return raf.concatenate([raf.add(ga, gb), gc])
+
+    # The first bucket is full after two gradients and overlaps with the last matmul, while the
+    # uses of the reduced gradients are deferred after the waits.
+    dcfg.group_bucket_size = 32
+    x = raf.array(np.ones((4, 4), dtype="float32"), device="cpu")
+    mod = AsyncDataParallelSchedule()(TestModel()._internal(x).mod)
+    expected = ["relu", "matmul", "_allreduce_async", "matmul", "_allreduce_async"]
+    expected += ["_wait_async", "_wait_async", "add", "concatenate"]
+    assert get_ops(mod) == expected
+
+
+def test_compressed_allreduce(dcfg):
+    class TestModel(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, x):
+            a = raf.relu(x)
+            ga = raf.allreduce(a, computation="avg")
+            b = raf.matmul(ga, ga)
+            compressed = sym._topk_compress(b, 0.5, "test")
+            values = raf.allgather(compressed[0], axis=0)
+            indices = raf.allgather(compressed[1], axis=0)
+            gb = sym._topk_decompress(values, indices, (4, 4), 1.0)
+            c = raf.matmul(a, a)
+            gc = raf.allreduce(c, computation="avg")
+            return raf.concatenate([gb, gc])
+
+    # The stateful compression of a reduced gradient and its allgathers must not be deferred
+    # behind the later ops, so the bucket is waited before them.
+    dcfg.group_bucket_size = 1 << 20
+    x = raf.array(np.ones((4, 4), dtype="float32"), device="cpu")
+    mod = AsyncDataParallelSchedule()(TestModel()._internal(x).mod)
+    expected = ["relu", "_allreduce_async", "_wait_async", "matmul", "_topk_compress"]
+    expected += ["_allgather", "_allgather", "_topk_decompress", "matmul", "_allreduce_async"]
+    expected += ["_wait_async", "concatenate"]
+    assert get_ops(mod) == expected
+
+
+def test_powersgd(dcfg):
+    dcfg.enable_data_parallel = True
+    dcfg.grad_compression = "powersgd"
+    dcfg.grad_compression_powersgd_rank = 2
+    const, _ = randn([16, 16], device="cpu")
+
+    class TestModel(raf.Model):
+        # pylint: disable=attribute-defined-outside-init
+        def build(self):
+            self.c = const
+
+        # pylint: enable=attribute-defined-outside-init
+
+        @raf.model.trace
+        def forward(self, x, y_true):
+            y_pred = raf.matmul(x, self.c)
+            return raf.nll_loss(y_true=y_true, y_pred=y_pred)
+
+    model = TestModel()
+    model.to(device="cpu")
+    model.train_mode()
+    m_x, _ = randn([4, 16], device="cpu", requires_grad=True)
+    m_y = raf.array(np.random.randint(0, 16, size=4), device="cpu")
+    record = model._internal(m_x, m_y)
+    passes = [InferType(), AutoDiff(record.requires_grads), InferType(), AutoDataParallel()]
+    mod = RAFSequential(passes + [InferType()])(record.mod)
+    scheduled = AsyncDataParallelSchedule()(mod)
+
+    # The Q factor depends on the reduced P factor, so the compression ops and the other
+    # collectives keep their order while the allreduces become asynchronous.
+    def others(ops):
+        skipped = ["_allreduce", "_allreduce_async", "_wait_async"]
+        return [op for op in ops if op.startswith("_") and op not in skipped]
+
+    before, after = get_ops(mod), get_ops(scheduled)
+    assert "_powersgd_q" in before
+    assert others(after) == others(before)
+    assert "_allreduce" not in after
+    assert after.count("_allreduce_async") == after.count("_wait_async") > 0
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
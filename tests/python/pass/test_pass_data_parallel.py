@@ -1,7 +1,7 @@
 # Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
 # SPDX-License-Identifier: Apache-2.0
 
-# pylint: disable=attribute-defined-outside-init,invalid-name,protected-access,too-many-locals,too-many-statements
+# pylint: disable=attribute-defined-outside-init,invalid-name,protected-access,too-many-locals,too-many-statements,redefined-outer-name
 import pytest
 import numpy as np
 
@@ -217,5 +217,72 @@ def test_dp(config):
     dcfg.enable_data_parallel = False
 
 
+@pytest.fixture
+def compression_config():
+    """Restore the global config that the compression tests change."""
+    dcfg = dist.get_config()
+    fields = [
+        "enable_data_parallel",
+        "grad_compression",
+        "grad_compression_topk_ratio",
+        "grad_compression_powersgd_rank",
+    ]
+    saved = {field: getattr(dcfg, field) for field in fields}
+    yield dcfg
+    for field, value in saved.items():
+        setattr(dcfg, field, value)
+
+
+@pytest.mark.parametrize(
+    "method,ops",
+    [
+        ("fp16", ["raf.op.cast", "raf.op._allreduce"]),
+        ("topk", ["raf.op._topk_compress", "raf.op._allgather", "raf.op._topk_decompress"]),
+        ("onebit", ["raf.op._onebit_compress", "raf.op._allgather", "raf.op._onebit_decompress"]),
+        ("powersgd", ["raf.op._powersgd_p", "raf.op._powersgd_q", "raf.op._powersgd_decompress"]),
+    ],
+)
+def test_dp_grad_compression(compression_config, method, ops):
+    dcfg = compression_config
+    dcfg.enable_data_parallel = True
+    dcfg.grad_compression = method
+    dcfg.grad_compression_topk_ratio = 0.25
+    dcfg.grad_compression_powersgd_rank = 2
+    device = "cpu"
+    const, _ = randn([16, 16], device=device)
+
+    class TestModel(raf.Model):
+        # pylint: disable=attribute-defined-outside-init
+        def build(self):
+            self.c = const
+
+        # pylint: enable=attribute-defined-outside-init
+
+        @raf.model.trace
+        def forward(self, x, y_true):
+            y_pred = raf.matmul(x, self.c)
+            return raf.nll_loss(y_true=y_true, y_pred=y_pred)
+
+    m_model = TestModel()
+    m_model.to(device=device)
+    m_model.train_mode()
+    m_x, _ = randn([4, 16], device=device, requires_grad=True)
+    m_y = one_hot(batch_size=4, num_classes=16, device=device)
+
+    record = m_model._internal(m_x, m_y)
+    passes = [
+        InferType(),
+        AutoDiff(record.requires_grads),
+        InferType(),
+        AutoDataParallel(),
+        InferType(),
+    ]
+    text = RAFSequential(passes)(record.mod)["main"].astext()
+    for op in ops:
+        assert op in text, op
+    # The int64 gradient of the labels is not compressed.
+    assert "raf.op._allreduce" in text
+
+
 if __name__ == "__main__":
     pytest.main([__file__])
@@ -9,12 +9,13 @@ from raf._lib import tvm
 from raf.testing import get_testable_devices, randn, check, run_vm_model
 
 
-def optimize(mod, device, fusion=False):
+def optimize(mod, device, fusion=False, policy="group"):
     device_name = device if device != "cpu" else "llvm"
     disabled_pass = []
     if not fusion:
         disabled_pass = ["FuseDialect", "FuseTVM"]
-    with tvm.transform.PassContext(opt_level=3, disabled_pass=disabled_pass):
+    config = {"raf.memory_plan.policy": policy}
+    with tvm.transform.PassContext(opt_level=3, disabled_pass=disabled_pass, config=config):
         opt_mod, _ = raf._core.vm.VMCompiler().optimize(mod, device=device_name, params={})
     return opt_mod
 
@@ -56,9 +57,9 @@ def verify_alloc_num(
     )
 
 
-def verify_correctness(model, device, args, fusion):
+def verify_correctness(model, device, args, fusion, policy="group"):
     # A helper function to verify the correctness
-    outs = run_vm_model(model, device, args, disable_fusion=not fusion)
+    outs = run_vm_model(model, device, args, disable_fusion=not fusion, memory_plan_policy=policy)
     outs = outs if isinstance(outs, (tuple, list)) else (outs,)
 
     ref_outs = model(*args)
@@ -167,5 +168,37 @@ def test_set_shape():
     verify_correctness(model, "cpu", args, fusion=False)
 
 
+@pytest.mark.parametrize("device", get_testable_devices())
+def test_memory_plan_arena(device):
+    class Model(raf.Model):
+        def build(self):
+            pass
+
+        @raf.model.trace
+        def forward(self, a, b, c, d):
+            t0 = raf.add(a, a)
+            t1 = raf.add(t0, b)
+            t2 = raf.add(t1, c)
+            t3 = raf.add(t2, t0)
+            t4 = raf.add(t3, d)
+            return t4
+
+    shape = (5, 5)
+    model_before = Model()
+    model_before.infer_mode()
+    m_a, _ = randn(shape, device=device)
+    m_b, _ = randn(shape, device=device)
+    m_c, _ = randn(shape, device=device)
+    m_d, _ = randn(shape, device=device)
+    args = [m_a, m_b, m_c, m_d]
+
+    mod = model_before._internal(*args).mod
+    mod = optimize(mod, device, policy="arena")
+    # t0-t3 share one arena and t4 owns its storage. t3 reuses the range of t1, so the arena
+    # has 3 ranges of 100 bytes at offsets 0, 128 and 256.
+    verify_alloc_num(mod["main"], 2, 5, 1, 1, 456)
+    verify_correctness(model_before, device, args, fusion=False, policy="arena")
+
+
 if __name__ == "__main__":
     pytest.main([__file__])
@@ -8,7 +8,7 @@ from unittest.mock import patch
 import pytest
 
 import raf
-from raf._ffi.pass_ import PartitionGradient, InferType
+from raf._ffi.pass_ import PartitionGradient, PartitionParameter, InferType
 from raf.frontend.model import FrameworkModel
 from raf.model import BatchNorm, Conv2d, Linear
 from raf.optim.optim import with_autodiff
@@ -153,5 +153,85 @@ def test_basic(mock_get_config, mock_get_comm, opt_level, batch):
         verify_ir(opt_level, ad_model, [m_dy, m_x, m_ytrue], 4, 1, 9, 9)
 
 
+def test_partition_parameter():
+    class Model(raf.Model):
+        def build(self):
+            self.linear1 = Linear(16, 10)
+            self.linear2 = Linear(10, 3)
+
+        @raf.model.trace
+        def forward(self, x):
+            out = raf.relu(self.linear1(x))
+            out = self.linear2(out)
+            return raf.sum(out)
+
+    model = Model()
+    model.train_mode()
+    ad_model = with_autodiff(model)
+    m_x, _ = randn((4, 16), dtype="float32")
+    m_dy, _ = randn((), dtype="float32")
+    record = ad_model._internal(m_dy, m_x)
+    mod = InferType()(record.mod)
+    params = [p.name_hint for p in mod["main"].params if p.name_hint.startswith("model.")]
+    n_part = 4
+    mod = PartitionGradient(3, n_part, 0, 1)(mod)
+    mod = PartitionParameter(n_part, params)(mod)
+    text = raf.ir.AsText(mod)
+
+    # The first axis of each partitioned parameter is padded to a multiple of n_part and split.
+    func_def = [line for line in text.split("\n") if line.startswith("def @main")][0]
+    shard_dims = dict(re.findall(r"%(model\.[^:]+): Tensor\[\((\d+)", func_def))
+    expected = {"linear1.w": 3, "linear1.b": 3, "linear2.w": 1, "linear2.b": 1}
+    assert {name: int(dim) for name, dim in shard_dims.items()} == {
+        f"model.{name}": dim for name, dim in expected.items()
+    }, func_def
+    orig_dims = {"linear1": 10, "linear2": 3}
+
+    # The partitioned parameters are only consumed by allgathers, which are issued at most once
+    # for the forward and once for the backward.
+    body = [line.strip() for line in text.split("\n") if line.strip().startswith("let ")]
+    for name in params:
+        uses = [line for line in body if re.search(rf"%{re.escape(name)}(?![\w.])", line)]
+        assert 1 <= len(uses) <= 2, text
+        assert all("raf.op._allgather" in line for line in uses), text
+
+    # None of the first axes is divisible by n_part, so every allgather is followed by the
+    # strided_slice that removes the padding. Then record, for each allgather, the position of
+    # the binding it is issued before and the first use of the gathered parameter.
+    def get_var(line):
+        return re.match(r"let (%[^ ]+) = ", line).group(1)
+
+    def uses_var(line, var):
+        return re.search(rf"{re.escape(var)}(?![\w.])", line.split(" = ", 1)[1]) is not None
+
+    gathers = {name: [] for name in params}
+    i = 0
+    while i < len(body):
+        if "raf.op._allgather" not in body[i]:
+            i += 1
+            continue
+        # A group of consecutive allgathers is issued before the binding that follows it.
+        group = []
+        while "raf.op._allgather" in body[i]:
+            name = re.search(r"raf\.op\._allgather\(%([^,]+),", body[i]).group(1)
+            slice_line = body[i + 1]
+            assert "raf.op.strided_slice" in slice_line and uses_var(slice_line, get_var(body[i]))
+            dim0 = orig_dims[name.split(".")[1]]
+            assert re.search(r"\[0\]|\(0,?\)", slice_line), slice_line
+            assert re.search(rf"\[{dim0}\]|\({dim0},?\)", slice_line), slice_line
+            group.append((name, get_var(slice_line)))
+            i += 2
+        for name, var in group:
+            first_use = next(j for j in range(i, len(body)) if uses_var(body[j], var))
+            gathers[name].append((i, first_use))
+
+    # Each parameter is gathered right before its first use, once for the forward and, if it is
+    # used there as well, once for the backward.
+    for positions in gathers.values():
+        assert positions, text
+        for issue, first_use in positions:
+            assert first_use == issue, text
+
+
 if __name__ == "__main__":
     pytest.main([__file__])
@@ -0,0 +1,132 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# pylint: disable=missing-function-docstring, missing-class-docstring, invalid-name
+# pylint: disable=protected-access, redefined-outer-name, unused-argument
+"""Test the collectives inserted by ShardingPropagation. The numeric results on multiple ranks
+are tested in tests/python/distributed/test_sharding_propagation.py.
+"""
+import re
+
+import pytest
+import numpy as np
+
+import raf
+from raf import distributed as dist
+from raf._ffi.pass_ import ShardingPropagation
+from raf.distributed.communicator import VoidCommunicator
+from raf.distributed.sharding import make_shard_spec
+
+SIZE = 4
+
+
+@pytest.fixture
+def mesh():
+    """Pretend to be rank 1 of SIZE ranks, so that the rewritten IR can be checked in one
+    process."""
+    comm = dist.get_communicator()
+    if not isinstance(comm, VoidCommunicator):
+        pytest.skip("The mesh can only be faked on the void communicator")
+    saved = comm.size, comm.rank
+    comm.size, comm.rank = SIZE, 1
+    yield SIZE
+    comm.size, comm.rank = saved
+
+
+def propagate(forward, shapes, axes):
+    """Shard the inputs named in axes along the given axis and return the ops of the rewritten
+    function in order. The first shape is that of x and the others are those of w0, w1, ..."""
+
+    class TestModel(raf.Model):
+        def build(self):
+            for i, shape in enumerate(shapes[1:]):
+                setattr(self, "w%d" % i, raf.array(np.zeros(shape, dtype="float32")))
+
+        @raf.model.trace
+        def forward(self, x):
+            return forward(x, *[getattr(self, "w%d" % i) for i in range(len(shapes) - 1)])
+
+    model = TestModel()
+    record = model._internal(raf.array(np.zeros(shapes[0], dtype="float32")))
+    specs = {}
+    for name, axis in axes.items():
+        ndim = len(shapes[0 if name == "x" else int(name[1:]) + 1])
+        specs[name] = make_shard_spec([SIZE if i == axis else 1 for i in range(ndim)], ranks=SIZE)
+    text = raf.ir.AsText(ShardingPropagation(specs)(record.mod)["main"])
+    return re.findall(r"raf\.op\.(\w+)\(", text)
+
+
+def collectives(ops):
+    names = ["_allreduce", "_allgather", "_reduce_scatter", "_all_to_all"]
+    return [op for op in ops if op in names]
+
+
+@pytest.mark.parametrize(
+    "axes,expected",
+    [
+        ({"w0": 1, "w1": 0}, {"_allreduce"}),
+        ({"w0": 0, "w1": 0}, {"_reduce_scatter", "_all_to_all", "_allreduce"}),
+    ],
+)
+def test_matmul_chain(mesh, axes, expected):
+    # The column-parallel matmul feeds the row-parallel one without communication, so only the
+    # final partial sum is reduced.
+    forward = lambda x, w0, w1: raf.matmul(raf.relu(raf.matmul(x, w0)), w1)
+    ops = propagate(forward, [(8, 16), (16, 8), (8, 16)], axes)
+    assert set(collectives(ops)) == expected
+
+
+def test_reduce_partial(mesh):
+    # sum and mean are linear, so they are applied to the partial sums and reduced once.
+    def forward(x, w0):
+        h = raf.matmul(x, w0)
+        return raf.add(raf.sum(h, axis=1, keepdims=True), raf.mean(h, axis=0, keepdims=True))
+
+    ops = propagate(forward, [(2, 16), (16, 3)], {"w0": 0})
+    assert collectives(ops) == ["_allreduce"]
+    assert ops.index("_allreduce") > ops.index("mean")
+
+
+def test_cast_partial(mesh):
+    # cast rounds, so the partial sums must be reduced before it.
+    forward = lambda x, w0: raf.cast(raf.matmul(x, w0), "float16")
+    ops = propagate(forward, [(8, 16), (16, 8)], {"w0": 0})
+    assert ops.index("cast") > ops.index(collectives(ops)[0])
+
+
+def test_broadcast_align(mesh):
+    # The operands are aligned from the last axis, so the replicated (4,) and (1, 4) operands
+    # are not sliced along the sharded axis 0.
+    forward = lambda x, w0, w1, w2: raf.add(raf.multiply(raf.add(x, w0), w1), w2)
+    ops = propagate(forward, [(8, 4), (4,), (8, 1), (1, 4)], {"x": 0, "w1": 0})
+    assert collectives(ops) == ["_allgather"]
+    assert "strided_slice" not in ops
+
+
+def test_layer_norm(mesh):
+    forward = lambda x, w0, w1: raf.layer_norm(x, w0, w1, axis=-1, eps=1e-5)
+    ops = propagate(forward, [(8, 6), (6,), (6,)], {"x": 0})
+    assert collectives(ops) == ["_allgather"]
+    assert "strided_slice" not in ops
+
+
+@pytest.mark.parametrize(
+    "shape,axis",
+    [
+        ((8, 16), 1),
+        ((8, 8, 5), 0),
+        ((8, 5, 8), 2),
+    ],
+)
+def test_softmax_all_to_all(mesh, shape, axis):
+    # The softmax along the sharded axis reshards the input to another axis instead of
+    # gathering it.
+    forward = lambda x: raf.softmax(x, axis=axis)
+    ops = propagate(forward, [shape], {"x": axis})
+    assert collectives(ops) == ["_all_to_all", "_allgather"]
+    if len(shape) == 3:
+        assert "transpose" in ops and "reshape" in ops
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
@@ -5,7 +5,7 @@
 import pytest
 
 import raf
-from raf._ffi.op_profiler import Profile, ProfileGroup, ResetCache, GetCacheSize
+from raf._ffi.op_profiler import Profile, ProfileGroup, ResetCache, GetCacheSize, DumpDBMetric
 from raf.testing import get_testable_devices, run_infer_type, randn
 
 
@@ -40,6 +40,40 @@ def test_single_op(device_str):
     assert GetCacheSize(device) == 2
 
 
+def test_persisted_db(monkeypatch, tmp_path):
+    data = raf.ir.var("x", shape=(16, 16))
+    expr = raf.ir.op.softmax(data)
+    expr = run_infer_type(expr).body
+    device = raf.Device("cpu")
+
+    monkeypatch.setenv("RAF_PERSIST_CACHE", "1")
+    monkeypatch.setenv("RAF_PERSIST_CACHE_PATH", str(tmp_path))
+    ResetCache(device)
+    lat = Profile(expr, device)["latency"]
+    metric = DumpDBMetric(device)
+    assert metric["CacheMiss"] == 1 and metric["CacheSet"] == 1
+
+    # A later compile loads the results from the database instead of profiling again.
+    ResetCache(device)
+    res = Profile(expr, device)
+    assert [l.value for l in res["latency"]] == pytest.approx([l.value for l in lat])
+    assert res["workspace_size"].value == 0
+    assert GetCacheSize(device) == 1
+    metric = DumpDBMetric(device)
+    assert metric["PersistCacheHit"] == 1 and "CacheSet" not in metric
+
+    # Results of different configs are not reused.
+    Profile(expr, device, 1, 1, 2)
+    assert "CacheSet" in DumpDBMetric(device)
+
+    # Without persistence, the results are only kept in the latency cache.
+    monkeypatch.delenv("RAF_PERSIST_CACHE")
+    ResetCache(device)
+    Profile(expr, device)
+    assert len(DumpDBMetric(device)) == 0
+    ResetCache(device)
+
+
 def test_no_compute_op():
     data = raf.ir.var("x", shape=(16, 16))
     expr = run_infer_type(data)  # expr is a var so no way to profile it.